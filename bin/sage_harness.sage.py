@@ -1,13 +0,0 @@
-
-# This file was *autogenerated* from the file /home/berkeley/stoke2/bin/sage_harness.sage
-from sage.all_cmdline import *   # import sage library
-
-import fileinput
-import sys
-
-for line in fileinput.input():
-	execfile(line.strip())
-	print "OK"
-	sys.stdout.flush()
-
-
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include <cassert>
+#include <mutex>
 #include <set>
 #include <setjmp.h>
 #include <signal.h>
@@ -38,7 +39,11 @@ set<Opcode> unsupported_ {{
   }
 };
 
-sigjmp_buf buf_;
+// SIGFPE is delivered to the thread that faulted, so each thread that runs a
+// sandbox has its own place to return to.
+thread_local sigjmp_buf buf_;
+once_flag sigfpe_handler_once_;
+
 void sigfpe_handler(int signum, siginfo_t* si, void* data) {
   siglongjmp(buf_, 1);
 }
@@ -118,10 +123,7 @@ void Sandbox::init() {
   signal_trap_ = emit_signal_trap();
   reset();
 
-  static bool once = false;
-  if (!once) {
-    once = true;
-
+  call_once(sigfpe_handler_once_, [] {
     struct sigaction sa;
     sa.sa_sigaction = sigfpe_handler;
     sigemptyset(&sa.sa_mask);
@@ -130,7 +132,7 @@ void Sandbox::init() {
     const auto res = sigaction(SIGFPE, &sa, 0);
     (void) res;
     assert(res != -1 && "Unable to install sigfpe handler!");
-  }
+  });
 }
 
 Sandbox& Sandbox::insert_input(const CpuState& input) {
@@ -46,6 +46,18 @@ public:
     return new ParallelSolver(new_solvers);
   }
 
+  SMTSolver& set_incremental(bool b) {
+    for (auto it : solvers_)
+      it->set_incremental(b);
+    return *this;
+  }
+  bool get_incremental() const {
+    for (auto it : solvers_)
+      if (it->get_incremental())
+        return true;
+    return false;
+  }
+
   /** Check if a query is satisfiable given constraints */
   bool is_sat(const std::vector<SymBool>& constraints) {
 
@@ -22,11 +22,10 @@
 
 #include "src/solver/solver.h"
 #include "src/ext/cpputil/include/container/bit_vector.h"
+#include "src/symstate/bool.h"
 
 namespace stoke {
 
-class SymBool;
-
 class SMTSolver {
 
 public:
@@ -54,6 +53,31 @@ public:
   /** Check if a query is satisfiable given constraints */
   virtual bool is_sat(const std::vector<SymBool>& constraints) = 0;
 
+  /** Keep solver state between queries, when the solver supports it. */
+  virtual SMTSolver& set_incremental(bool b) {
+    return *this;
+  }
+  /** Is solver state kept between queries? */
+  virtual bool get_incremental() const {
+    return false;
+  }
+
+  /** Start a session of queries that share a set of constraints. */
+  virtual void start_session(const std::vector<SymBool>& constraints) {
+    session_ = constraints;
+  }
+  /** Check if the session constraints are satisfiable together with an
+    assumption.  The assumption does not persist to later queries. */
+  virtual bool is_sat_assuming(const SymBool& assumption) {
+    auto constraints = session_;
+    constraints.push_back(assumption);
+    return is_sat(constraints);
+  }
+  /** End the current session. */
+  virtual void end_session() {
+    session_.clear();
+  }
+
   /** Check if a satisfying assignment is available. */
   virtual bool has_model() const = 0;
   /** Get the satisfying assignment for a bit-vector from the model.
@@ -89,6 +113,8 @@ protected:
   uint64_t timeout_;
   /** Current error message */
   std::string error_;
+  /** Constraints shared by the queries of the current session */
+  std::vector<SymBool> session_;
 
 };
 
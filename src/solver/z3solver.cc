@@ -66,10 +66,34 @@ bool Z3Solver::is_sat(const vector<SymBool>& constraints) {
   number_queries_++;
 #endif
 
-  /* Reset state. */
+  if (incremental_) {
+    error_ = "";
+    if (model_ != NULL)
+      delete model_;
+    model_ = NULL;
+    stop_now_.store(false);
+
+    if (!converter_ || is_stale() || literals_.size() > max_literals_)
+      reset_converter();
+    add_sources();
+
+    if (!assert_axioms(constraints))
+      return false;
+
+    vector<z3::expr> assumptions;
+    for (auto it : split_constraints(constraints)) {
+      assumptions.push_back(track(it));
+      if (has_error())
+        return false;
+    }
+    return check_and_get_model(assumptions);
+  }
+
+  /* Reset state.  This also discards the solver state of any session. */
   error_ = "";
   model_ = 0;
   stop_now_.store(false);
+  drop_converter();
   solver_.reset();
 
   /** Get all the axioms we need. */
@@ -148,12 +172,21 @@ bool Z3Solver::is_sat(const vector<SymBool>& constraints) {
   }
   delete current;
 
+  if (check_abort()) return false;
+  return check_and_get_model({});
+}
+
+bool Z3Solver::check_and_get_model(const vector<z3::expr>& assumptions) {
+
   /* Run the solver and see */
   try {
 #if defined(DEBUG_Z3_INTERFACE_PERFORMANCE) || defined(DEBUG_Z3_PERFORMANCE)
     microseconds solver_start = duration_cast<microseconds>(system_clock::now().time_since_epoch());
 #endif
-    if (check_abort()) return false;
+    if (stop_now_) {
+      error_ = "External interrupt.";
+      return false;
+    }
 
     DEBUG_Z3(
       static int debug_count = 0;
@@ -170,7 +203,10 @@ bool Z3Solver::is_sat(const vector<SymBool>& constraints) {
     last_text_ = smt;
 #endif
 
-    auto result = solver_.check();
+    z3::expr_vector literals(context_);
+    for (auto it : assumptions)
+      literals.push_back(it);
+    auto result = assumptions.size() ? solver_.check(literals) : solver_.check();
 #if defined(DEBUG_Z3_INTERFACE_PERFORMANCE) || defined(DEBUG_Z3_PERFORMANCE)
     microseconds solver_end = duration_cast<microseconds>(system_clock::now().time_since_epoch());
 #endif
@@ -218,6 +254,189 @@ bool Z3Solver::is_sat(const vector<SymBool>& constraints) {
   return false;
 }
 
+void Z3Solver::reset_converter() {
+  drop_converter();
+  solver_.reset();
+  converter_ = new ExprConverter(context_, pending_);
+  sources_.clear();
+}
+
+bool Z3Solver::is_stale() const {
+  for (auto& it : sources_)
+    if (it.first->load() != it.second)
+      return true;
+  return false;
+}
+
+void Z3Solver::add_sources() {
+  for (auto manager : { SymBitVector::get_memory_manager(), SymBool::get_memory_manager(),
+                        SymArray::get_memory_manager()
+                      }) {
+    if (!manager)
+      continue;
+    auto collections = manager->get_collections();
+    bool seen = false;
+    for (auto& it : sources_)
+      seen |= it.first == collections;
+    if (!seen)
+      sources_.push_back({ collections, collections->load() });
+  }
+}
+
+void Z3Solver::drop_converter() {
+  if (converter_)
+    delete converter_;
+  converter_ = NULL;
+  pending_.clear();
+  literals_.clear();
+  session_literals_.clear();
+  in_session_ = false;
+}
+
+bool Z3Solver::assert_constraints(const vector<SymBool>& constraints) {
+  SymTypecheckVisitor tc;
+  pending_.insert(pending_.end(), constraints.begin(), constraints.end());
+
+  // Converting may generate more constraints; keep going until there are none.
+  while (pending_.size()) {
+    vector<SymBool> current;
+    current.swap(pending_);
+
+    for (auto it : current) {
+      if (stop_now_) {
+        error_ = "External interrupt.";
+        return false;
+      }
+
+      if (tc(it) != 1) {
+        stringstream ss;
+        ss << "Typechecking failed for constraint: " << it << endl;
+        if (tc.has_error())
+          ss << "error: " << tc.error() << endl;
+        else
+          ss << "(no typechecking error message given)" << endl;
+        error_ = ss.str();
+        return false;
+      }
+
+      auto constraint = (*converter_)(it);
+      if (converter_->has_error()) {
+        error_ = converter_->error();
+        return false;
+      }
+      solver_.add(constraint);
+    }
+  }
+  return true;
+}
+
+bool Z3Solver::assert_axioms(const vector<SymBool>& constraints) {
+  SymAxiomVisitor av;
+  for (auto it : constraints)
+    av(it);
+  return assert_constraints(av.get_axioms());
+}
+
+z3::expr Z3Solver::track(const SymBool& constraint) {
+  auto it = literals_.find(constraint.ptr);
+  if (it != literals_.end())
+    return it->second;
+
+  SymTypecheckVisitor tc;
+  if (tc(constraint) != 1) {
+    stringstream ss;
+    ss << "Typechecking failed for constraint: " << constraint << endl;
+    if (tc.has_error())
+      ss << "error: " << tc.error() << endl;
+    else
+      ss << "(no typechecking error message given)" << endl;
+    error_ = ss.str();
+    return context_.bool_val(true);
+  }
+
+  auto expr = (*converter_)(constraint);
+  if (converter_->has_error()) {
+    error_ = converter_->error();
+    return context_.bool_val(true);
+  }
+  if (!assert_constraints({}))
+    return context_.bool_val(true);
+
+  stringstream name;
+  name << "__track_" << literals_.size();
+  auto literal = context_.bool_const(name.str().c_str());
+  solver_.add(implies(literal, expr));
+  literals_.insert(make_pair(constraint.ptr, literal));
+  return literal;
+}
+
+void Z3Solver::start_session(const vector<SymBool>& constraints) {
+  end_session();
+  SMTSolver::start_session(constraints);
+
+  error_ = "";
+  if (model_ != NULL)
+    delete model_;
+  model_ = NULL;
+  stop_now_.store(false);
+
+  if (!incremental_ || !converter_ || is_stale() || literals_.size() > max_literals_)
+    reset_converter();
+  add_sources();
+  in_session_ = true;
+
+  if (assert_axioms(constraints)) {
+    for (auto it : split_constraints(constraints)) {
+      session_literals_.push_back(track(it));
+      if (has_error())
+        break;
+    }
+  }
+  session_error_ = error_;
+}
+
+bool Z3Solver::is_sat_assuming(const SymBool& assumption) {
+  // If the solver was reset since the session began, fall back to a full query.
+  if (!in_session_)
+    return SMTSolver::is_sat_assuming(assumption);
+  // The session's constraints are still alive, but earlier assumptions may
+  // not be; translate the session again.
+  if (is_stale()) {
+    auto constraints = session_;
+    start_session(constraints);
+  }
+
+  add_sources();
+
+  error_ = session_error_;
+  if (model_ != NULL)
+    delete model_;
+  model_ = NULL;
+  if (has_error())
+    return false;
+
+  /** Axioms hold regardless of the assumption. */
+  if (!assert_axioms({ assumption }))
+    return false;
+
+  auto literal = track(assumption);
+  if (has_error())
+    return false;
+
+  auto assumptions = session_literals_;
+  assumptions.push_back(literal);
+  return check_and_get_model(assumptions);
+}
+
+void Z3Solver::end_session() {
+  in_session_ = false;
+  session_literals_.clear();
+  session_error_ = "";
+  if (!incremental_)
+    drop_converter();
+  SMTSolver::end_session();
+}
+
 /** Get the satisfying assignment for a bit-vector from the model.
     NOTE: This function is very brittle right now.  If you pass in the wrong
     variable/size, there's no way to know and the result you get back is
@@ -36,6 +36,9 @@ public:
   /** Instantiate a new Z3 solver */
   Z3Solver() : SMTSolver(), solver_(context_) {
     model_ = NULL;
+    incremental_ = false;
+    in_session_ = false;
+    converter_ = NULL;
 
     context_.set("timeout", (int)timeout_);
     context_.set("smt.phase_selection", 5);
@@ -45,6 +48,9 @@ public:
   /** Create a Z3 solver from another one. */
   Z3Solver(const Z3Solver& s) : SMTSolver(), solver_(context_) {
     model_ = NULL;
+    incremental_ = s.incremental_;
+    in_session_ = false;
+    converter_ = NULL;
     timeout_ = s.get_timeout();
     context_.set("timeout", (int)timeout_);
     context_.set("smt.phase_selection", 5);
@@ -53,9 +59,11 @@ public:
 
   /** Copy assignment */
   Z3Solver& operator=(const Z3Solver& s) {
+    end_session();
     error_ = "";
     model_ = NULL;
     set_timeout(s.get_timeout());
+    set_incremental(s.incremental_);
     return *this;
   }
 
@@ -67,6 +75,8 @@ public:
   }
 
   ~Z3Solver() {
+    end_session();
+    drop_converter();
     if (model_ != NULL)
       delete model_;
   }
@@ -83,6 +93,29 @@ public:
   /** Check if a query is satisfiable given constraints */
   bool is_sat(const std::vector<SymBool>& constraints);
 
+  /** In incremental mode, the solver and the translation of every
+    constraint persist across queries.  Each constraint is asserted once,
+    guarded by a literal, and queries are checked under the literals of their
+    constraints.  Translations are cached by node address, so they're thrown
+    out whenever a SymMemoryManager frees nodes. */
+  SMTSolver& set_incremental(bool b) {
+    incremental_ = b;
+    if (!b)
+      drop_converter();
+    return *this;
+  }
+  bool get_incremental() const {
+    return incremental_;
+  }
+
+  /** Start a session of queries.  The shared constraints are translated and
+    asserted only once. */
+  void start_session(const std::vector<SymBool>& constraints);
+  /** Check the session constraints together with an assumption. */
+  bool is_sat_assuming(const SymBool& assumption);
+  /** End the current session. */
+  void end_session();
+
   /** Check if a satisfying assignment is available. */
   bool has_model() const {
     return model_ && (model_->num_funcs() == 0);
@@ -310,6 +343,46 @@ private:
     std::string error_;
   };
 
+  /** Are we keeping state between queries? */
+  bool incremental_;
+  /** Are we in a session? */
+  bool in_session_;
+  /** Converter shared by queries, in incremental mode or during a session. */
+  ExprConverter* converter_;
+  /** Constraints generated during conversion that still need asserting. */
+  std::vector<SymBool> pending_;
+  /** The literal guarding each constraint asserted so far. */
+  std::map<const SymBoolAbstract*, z3::expr> literals_;
+  /** Literals of the constraints shared by the current session. */
+  std::vector<z3::expr> session_literals_;
+  /** Error encountered when starting the session. */
+  std::string session_error_;
+  /** Collection counts of the memory managers installed while the
+    converter has been in use, and their values when first seen. */
+  std::vector<std::pair<std::shared_ptr<const std::atomic<uint64_t>>, uint64_t>> sources_;
+
+  /** Once this many constraints are tracked, the solver starts over. */
+  static const size_t max_literals_ = 20000;
+
+  /** Start over with an empty solver and a fresh converter. */
+  void reset_converter();
+  /** Discard the converter and everything asserted with it. */
+  void drop_converter();
+  /** Has a manager whose nodes the converter may have seen freed them?  If
+    so, its caches may map a new node to the translation of an old one.
+    Other managers, such as those of other threads, don't matter. */
+  bool is_stale() const;
+  /** Remember the managers installed now, before translating with them. */
+  void add_sources();
+  /** Translate constraints and assert them unconditionally. */
+  bool assert_constraints(const std::vector<SymBool>& constraints);
+  /** Assert the axioms needed by some constraints. */
+  bool assert_axioms(const std::vector<SymBool>& constraints);
+  /** Get the literal guarding a constraint, asserting it if needed. */
+  z3::expr track(const SymBool& constraint);
+  /** Run the solver under the given assumption literals and save any model. */
+  bool check_and_get_model(const std::vector<z3::expr>& assumptions);
+
 #ifdef DEBUG_Z3_INTERFACE_PERFORMANCE
   static uint64_t number_queries_;
   static uint64_t typecheck_time_;
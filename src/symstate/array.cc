@@ -23,7 +23,7 @@ using namespace std;
 using namespace stoke;
 
 thread_local SymMemoryManager* SymArray::memory_manager_ = NULL;
-uint64_t SymArray::tmp_counter_ = 0;
+std::atomic<uint64_t> SymArray::tmp_counter_(0);
 
 /* Various constructors */
 SymArray SymArray::var(uint16_t key_size, uint16_t val_size, string name) {
@@ -31,8 +31,7 @@ SymArray SymArray::var(uint16_t key_size, uint16_t val_size, string name) {
 }
 SymArray SymArray::tmp_var(uint16_t key_size, uint16_t val_size) {
   stringstream name;
-  name << "TMP_ARR_" << key_size << "_" << val_size << "_" << tmp_counter_;
-  tmp_counter_++;
+  name << "TMP_ARR_" << key_size << "_" << val_size << "_" << tmp_counter_++;
   return SymArray(new SymArrayVar(key_size, val_size, name.str()));
 }
 
@@ -60,10 +59,12 @@ SymArray::Type SymArray::type() const {
 }
 /* equality */
 bool SymArray::equals(const SymArray& other) const {
+  // within a memory manager, equal nodes are the same node
+  if (ptr == other.ptr)
+    return true;
   if (ptr && other.ptr)
     return ptr->equals(other.ptr);
-  else
-    return ptr == other.ptr;
+  return false;
 }
 
 /* Output overload */
@@ -16,6 +16,7 @@
 #ifndef _STOKE_SRC_SYMSTATE_SYM_ARRAY_H
 #define _STOKE_SRC_SYMSTATE_SYM_ARRAY_H
 
+#include <atomic>
 #include <iostream>
 #include <vector>
 
@@ -72,7 +73,7 @@ public:
   /** Constructs a new SymArray from a pointer to the AST hierarchy */
   SymArray(const SymArrayAbstract * ptr_) : ptr(ptr_) {
     if (memory_manager_)
-      memory_manager_->add(ptr_);
+      ptr = memory_manager_->add(ptr_);
   }
 
   /** Set a memory manager */
@@ -89,8 +90,8 @@ private:
 
   /** Memory Manager */
   static thread_local SymMemoryManager* memory_manager_;
-  /** Counter for temporaries. */
-  static uint64_t tmp_counter_;
+  /** Counter for temporaries; shared by all threads. */
+  static std::atomic<uint64_t> tmp_counter_;
 
 };
 
@@ -103,6 +104,12 @@ public:
 
   virtual ~SymArrayAbstract() = 0;
 
+  /** Nodes go in the arena of the installed memory manager, if any. */
+  static void* operator new(size_t size) {
+    return SymMemoryManager::allocate(SymArray::get_memory_manager(), size);
+  }
+  static void operator delete(void*) { }
+
   const uint16_t key_size_;
   const uint16_t value_size_;
 
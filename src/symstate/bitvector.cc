@@ -22,12 +22,54 @@ using namespace std;
 using namespace stoke;
 
 thread_local SymMemoryManager* SymBitVector::memory_manager_ = NULL;
-uint64_t SymBitVector::tmp_counter_ = 0;
+std::atomic<uint64_t> SymBitVector::tmp_counter_(0);
 
 #ifdef STOKE_UF_MULTIPLICATION
 std::map<size_t, SymFunction*> SymBitVector::multiplication_functions_;
 #endif
 
+namespace {
+
+/** The low 'width' bits set; only meaningful up to 64 bits. */
+uint64_t mask(uint16_t width) {
+  return width >= 64 ? (uint64_t)(-1) : (1ull << width) - 1;
+}
+
+/** Is this a constant we can compute with?  Constants wider than 64 bits
+  are left alone. */
+bool is_constant(const SymBitVectorAbstract* bv) {
+  return bv->type() == SymBitVector::CONSTANT && bv->width_ > 0 && bv->width_ <= 64;
+}
+
+/** The value of a constant, with the bits past its width masked off. */
+uint64_t read_const(const SymBitVectorAbstract* bv) {
+  return static_cast<const SymBitVectorConstant*>(bv)->constant_ & mask(bv->width_);
+}
+
+/** The value of a constant, sign extended to 64 bits. */
+int64_t read_sconst(const SymBitVectorAbstract* bv) {
+  auto shift = 64 - bv->width_;
+  return (int64_t)(read_const(bv) << shift) >> shift;
+}
+
+/** Is this a constant with the given value, truncated to its width? */
+bool is_value(const SymBitVectorAbstract* bv, uint64_t value) {
+  return is_constant(bv) && read_const(bv) == (value & mask(bv->width_));
+}
+
+/** Both operands are constants of the same width. */
+bool both_const(const SymBitVectorAbstract* a, const SymBitVectorAbstract* b) {
+  return is_constant(a) && is_constant(b) && a->width_ == b->width_;
+}
+
+/** Operands a binary operator can be simplified over; anything ill-typed is
+  built as is so that type checking still catches it. */
+bool same_width(const SymBitVectorAbstract* a, const SymBitVectorAbstract* b) {
+  return a->width_ == b->width_;
+}
+
+} // namespace
+
 
 /* Various constructors */
 SymBitVector SymBitVector::constant(uint16_t size, uint64_t value) {
@@ -46,11 +88,15 @@ SymBitVector SymBitVector::var(uint16_t size, string name) {
 }
 SymBitVector SymBitVector::tmp_var(uint16_t size) {
   stringstream name;
-  name << "TMP_BV_" << size << "_" << tmp_counter_;
-  tmp_counter_++;
+  name << "TMP_BV_" << size << "_" << tmp_counter_++;
   return SymBitVector(new SymBitVectorVar(size, name.str()));
 }
 SymBitVector SymBitVector::from_bool(const SymBool& b) {
+  if (b.type() == SymBool::TRUE)
+    return SymBitVector::constant(1, 1);
+  if (b.type() == SymBool::FALSE)
+    return SymBitVector::constant(1, 0);
+
   auto c0 = SymBitVector::constant(1,0);
   auto c1 = SymBitVector::constant(1,1);
   return SymBitVector(new SymBitVectorIte(b.ptr, c1.ptr, c0.ptr));
@@ -58,6 +104,18 @@ SymBitVector SymBitVector::from_bool(const SymBool& b) {
 
 /* Bit Vector Operators */
 SymBitVector SymBitVector::operator&(const SymBitVector& other) const {
+  if (!same_width(ptr, other.ptr))
+    return SymBitVector(new SymBitVectorAnd(ptr, other.ptr));
+  if (both_const(ptr, other.ptr))
+    return constant(width(), read_const(ptr) & read_const(other.ptr));
+  // constants go on the right
+  if (is_constant(ptr))
+    return other & *this;
+
+  if (is_value(other.ptr, 0) || ptr == other.ptr)
+    return other;
+  if (is_value(other.ptr, -1))
+    return *this;
   return SymBitVector(new SymBitVectorAnd(ptr, other.ptr));
 }
 
@@ -68,6 +126,19 @@ SymBitVector SymBitVector::operator||(const SymBitVector& other) const {
   if (!ptr) {
     return other;
   }
+
+  if (is_constant(ptr) && is_constant(other.ptr) && width() + other.width() <= 64)
+    return constant(width() + other.width(),
+                    (read_const(ptr) << other.width()) | read_const(other.ptr));
+
+  // x[h:m+1] || x[m:l] is x[h:l]
+  if (type() == EXTRACT && other.type() == EXTRACT) {
+    auto a = static_cast<const SymBitVectorExtract*>(ptr);
+    auto b = static_cast<const SymBitVectorExtract*>(other.ptr);
+    if (a->bv_ == b->bv_ && a->low_bit_ == b->high_bit_ + 1)
+      return SymBitVector(a->bv_)[a->high_bit_][b->low_bit_];
+  }
+
   return SymBitVector(new SymBitVectorConcat(ptr, other.ptr));
 }
 
@@ -76,6 +147,13 @@ SymBitVector SymBitVector::operator/(const SymBitVector& other) const {
 }
 
 SymBitVector SymBitVector::operator-(const SymBitVector& other) const {
+  if (!same_width(ptr, other.ptr))
+    return SymBitVector(new SymBitVectorMinus(ptr, other.ptr));
+  if (both_const(ptr, other.ptr))
+    return constant(width(), (read_const(ptr) - read_const(other.ptr)) & mask(width()));
+
+  if (is_value(other.ptr, 0))
+    return *this;
   return SymBitVector(new SymBitVectorMinus(ptr, other.ptr));
 }
 
@@ -95,19 +173,54 @@ SymBitVector SymBitVector::operator*(const SymBitVector& other) const {
   }
   return (*mf)(*this, other);
 #else
+  if (!same_width(ptr, other.ptr))
+    return SymBitVector(new SymBitVectorMult(ptr, other.ptr));
+  if (both_const(ptr, other.ptr))
+    return constant(width(), (read_const(ptr) * read_const(other.ptr)) & mask(width()));
+  if (is_constant(ptr))
+    return other * *this;
+
+  if (is_value(other.ptr, 0))
+    return other;
+  if (is_value(other.ptr, 1))
+    return *this;
   return SymBitVector(new SymBitVectorMult(ptr, other.ptr));
 #endif
 }
 
 SymBitVector SymBitVector::operator!() const {
+  if (is_constant(ptr))
+    return constant(width(), ~read_const(ptr) & mask(width()));
+  if (type() == NOT)
+    return SymBitVector(static_cast<const SymBitVectorNot*>(ptr)->bv_);
   return SymBitVector(new SymBitVectorNot(ptr));
 }
 
 SymBitVector SymBitVector::operator|(const SymBitVector& other) const {
+  if (!same_width(ptr, other.ptr))
+    return SymBitVector(new SymBitVectorOr(ptr, other.ptr));
+  if (both_const(ptr, other.ptr))
+    return constant(width(), read_const(ptr) | read_const(other.ptr));
+  if (is_constant(ptr))
+    return other | *this;
+
+  if (is_value(other.ptr, 0) || ptr == other.ptr)
+    return *this;
+  if (is_value(other.ptr, -1))
+    return other;
   return SymBitVector(new SymBitVectorOr(ptr, other.ptr));
 }
 
 SymBitVector SymBitVector::operator+(const SymBitVector& other) const {
+  if (!same_width(ptr, other.ptr))
+    return SymBitVector(new SymBitVectorPlus(ptr, other.ptr));
+  if (both_const(ptr, other.ptr))
+    return constant(width(), (read_const(ptr) + read_const(other.ptr)) & mask(width()));
+  if (is_constant(ptr))
+    return other + *this;
+
+  if (is_value(other.ptr, 0))
+    return *this;
   return SymBitVector(new SymBitVectorPlus(ptr, other.ptr));
 }
 
@@ -120,10 +233,28 @@ SymBitVector SymBitVector::ror(const SymBitVector& other) const {
 }
 
 SymBitVector SymBitVector::operator<<(const SymBitVector& other) const {
+  if (!same_width(ptr, other.ptr))
+    return SymBitVector(new SymBitVectorShiftLeft(ptr, other.ptr));
+  if (both_const(ptr, other.ptr)) {
+    auto shift = read_const(other.ptr);
+    return constant(width(), shift >= width() ? 0 : (read_const(ptr) << shift) & mask(width()));
+  }
+
+  if (is_value(other.ptr, 0))
+    return *this;
   return SymBitVector(new SymBitVectorShiftLeft(ptr, other.ptr));
 }
 
 SymBitVector SymBitVector::operator>>(const SymBitVector& other) const {
+  if (!same_width(ptr, other.ptr))
+    return SymBitVector(new SymBitVectorShiftRight(ptr, other.ptr));
+  if (both_const(ptr, other.ptr)) {
+    auto shift = read_const(other.ptr);
+    return constant(width(), shift >= width() ? 0 : read_const(ptr) >> shift);
+  }
+
+  if (is_value(other.ptr, 0))
+    return *this;
   return SymBitVector(new SymBitVectorShiftRight(ptr, other.ptr));
 }
 
@@ -151,6 +282,8 @@ SymBitVector SymBitVector::extend(uint16_t size) const {
 SymBitVector SymBitVector::sign_extend(uint16_t size) const {
   if (size <= width())
     return *this;
+  if (is_constant(ptr) && size <= 64)
+    return constant(size, (uint64_t)read_sconst(ptr) & mask(size));
   return SymBitVector(new SymBitVectorSignExtend(ptr, size));
 }
 
@@ -173,10 +306,23 @@ SymBitVector SymBitVector::s_shr(const SymBitVector& other) const {
 }
 
 SymBitVector SymBitVector::operator-() const {
+  if (is_constant(ptr))
+    return constant(width(), (0 - read_const(ptr)) & mask(width()));
+  if (type() == U_MINUS)
+    return SymBitVector(static_cast<const SymBitVectorUMinus*>(ptr)->bv_);
   return SymBitVector(new SymBitVectorUMinus(ptr));
 }
 
 SymBitVector SymBitVector::operator^(const SymBitVector& other) const {
+  if (!same_width(ptr, other.ptr))
+    return SymBitVector(new SymBitVectorXor(ptr, other.ptr));
+  if (both_const(ptr, other.ptr))
+    return constant(width(), read_const(ptr) ^ read_const(other.ptr));
+  if (is_constant(ptr))
+    return other ^ *this;
+
+  if (is_value(other.ptr, 0))
+    return *this;
   return SymBitVector(new SymBitVectorXor(ptr, other.ptr));
 }
 
@@ -198,7 +344,37 @@ SymBool SymBitVector::parity() const {
 
 /* Indexing */
 SymBitVector SymBitVector::IndexHelper::operator[](uint16_t index) const {
-  return SymBitVector(new SymBitVectorExtract(bv_.ptr, index_, index));
+  auto bv = bv_.ptr;
+  uint16_t high = index_;
+  uint16_t low = index;
+  if (low > high || high >= bv->width_)
+    return SymBitVector(new SymBitVectorExtract(bv, high, low));
+
+  if (low == 0 && high + 1 == bv->width_)
+    return bv_;
+  if (is_constant(bv))
+    return constant(high - low + 1, (read_const(bv) >> low) & mask(high - low + 1));
+
+  switch (bv->type()) {
+  case EXTRACT: {
+    // x[h:l][h':l'] is x[l+h':l+l']
+    auto inner = static_cast<const SymBitVectorExtract*>(bv);
+    return SymBitVector(inner->bv_)[inner->low_bit_ + high][inner->low_bit_ + low];
+  }
+  case CONCAT: {
+    // an extract that falls on one side of a concatenation
+    auto concat = static_cast<const SymBitVectorConcat*>(bv);
+    auto split = concat->b_->width_;
+    if (low >= split)
+      return SymBitVector(concat->a_)[high - split][low - split];
+    if (high < split)
+      return SymBitVector(concat->b_)[high][low];
+    break;
+  }
+  default:
+    break;
+  }
+  return SymBitVector(new SymBitVectorExtract(bv, high, low));
 }
 
 SymBitVector::IndexHelper::operator SymBool() const {
@@ -207,22 +383,47 @@ SymBitVector::IndexHelper::operator SymBool() const {
 
 /* Bit Vector Comparison Operators */
 SymBool SymBitVector::operator==(const SymBitVector& other) const {
+  if (both_const(ptr, other.ptr)) {
+    auto l = read_const(ptr);
+    auto r = read_const(other.ptr);
+    return SymBool::constant(l == r);
+  }
   return SymBool(new SymBoolEq(ptr, other.ptr));
 }
 
 SymBool SymBitVector::operator>=(const SymBitVector& other) const {
+  if (both_const(ptr, other.ptr)) {
+    auto l = read_const(ptr);
+    auto r = read_const(other.ptr);
+    return SymBool::constant(l >= r);
+  }
   return SymBool(new SymBoolGe(ptr, other.ptr));
 }
 
 SymBool SymBitVector::operator>(const SymBitVector& other) const {
+  if (both_const(ptr, other.ptr)) {
+    auto l = read_const(ptr);
+    auto r = read_const(other.ptr);
+    return SymBool::constant(l > r);
+  }
   return SymBool(new SymBoolGt(ptr, other.ptr));
 }
 
 SymBool SymBitVector::operator<=(const SymBitVector& other) const {
+  if (both_const(ptr, other.ptr)) {
+    auto l = read_const(ptr);
+    auto r = read_const(other.ptr);
+    return SymBool::constant(l <= r);
+  }
   return SymBool(new SymBoolLe(ptr, other.ptr));
 }
 
 SymBool SymBitVector::operator<(const SymBitVector& other) const {
+  if (both_const(ptr, other.ptr)) {
+    auto l = read_const(ptr);
+    auto r = read_const(other.ptr);
+    return SymBool::constant(l < r);
+  }
   return SymBool(new SymBoolLt(ptr, other.ptr));
 }
 
@@ -231,18 +432,38 @@ SymBool SymBitVector::operator!=(const SymBitVector& other) const {
 }
 
 SymBool SymBitVector::s_ge(const SymBitVector& other) const {
+  if (both_const(ptr, other.ptr)) {
+    auto l = read_sconst(ptr);
+    auto r = read_sconst(other.ptr);
+    return SymBool::constant(l >= r);
+  }
   return SymBool(new SymBoolSignGe(ptr, other.ptr));
 }
 
 SymBool SymBitVector::s_gt(const SymBitVector& other) const {
+  if (both_const(ptr, other.ptr)) {
+    auto l = read_sconst(ptr);
+    auto r = read_sconst(other.ptr);
+    return SymBool::constant(l > r);
+  }
   return SymBool(new SymBoolSignGt(ptr, other.ptr));
 }
 
 SymBool SymBitVector::s_le(const SymBitVector& other) const {
+  if (both_const(ptr, other.ptr)) {
+    auto l = read_sconst(ptr);
+    auto r = read_sconst(other.ptr);
+    return SymBool::constant(l <= r);
+  }
   return SymBool(new SymBoolSignLe(ptr, other.ptr));
 }
 
 SymBool SymBitVector::s_lt(const SymBitVector& other) const {
+  if (both_const(ptr, other.ptr)) {
+    auto l = read_sconst(ptr);
+    auto r = read_sconst(other.ptr);
+    return SymBool::constant(l < r);
+  }
   return SymBool(new SymBoolSignLt(ptr, other.ptr));
 }
 
@@ -264,10 +485,12 @@ uint16_t SymBitVector::width() const {
 
 /* equality */
 bool SymBitVector::equals(const SymBitVector& other) const {
+  // within a memory manager, equal nodes are the same node
+  if (ptr == other.ptr)
+    return true;
   if (ptr && other.ptr)
     return ptr->equals(other.ptr);
-  else
-    return ptr == other.ptr;
+  return false;
 }
 
 bool SymBitVectorArrayLookup::equals(const SymBitVectorAbstract * other) const {
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 
+#include <atomic>
 #include <iostream>
 #include <map>
 #include <vector>
@@ -234,7 +235,7 @@ public:
   SymBitVector(const SymBitVectorAbstract * ptr_) : ptr(ptr_) {
     assert(ptr_ != NULL);
     if (memory_manager_)
-      memory_manager_->add(ptr_);
+      ptr = memory_manager_->add(ptr_);
   }
   /** Constructs a new SymBitVector from a bool */
   SymBitVector(const SymBool& b) {
@@ -268,8 +269,8 @@ private:
 
   /** Memory Manager */
   static thread_local SymMemoryManager* memory_manager_;
-  /** Counter for temporaries. */
-  static uint64_t tmp_counter_;
+  /** Counter for temporaries; shared by all threads. */
+  static std::atomic<uint64_t> tmp_counter_;
 
 };
 
@@ -283,6 +284,13 @@ public:
 
   virtual ~SymBitVectorAbstract() = 0;
 
+  /** Nodes go in the arena of the installed memory manager, if any.  They're
+    never deleted one at a time; the manager frees them all at once. */
+  static void* operator new(size_t size) {
+    return SymMemoryManager::allocate(SymBitVector::get_memory_manager(), size);
+  }
+  static void operator delete(void*) { }
+
   /** The width of this bitvector (number of bits). */
   const uint16_t width_ = 0;
 
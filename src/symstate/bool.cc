@@ -22,7 +22,25 @@ using namespace std;
 using namespace stoke;
 
 thread_local SymMemoryManager* SymBool::memory_manager_ = NULL;
-uint64_t SymBool::tmp_counter_ = 0;
+std::atomic<uint64_t> SymBool::tmp_counter_(0);
+
+namespace {
+
+bool is_true(const SymBool& b) {
+  return b.type() == SymBool::TRUE;
+}
+
+bool is_false(const SymBool& b) {
+  return b.type() == SymBool::FALSE;
+}
+
+/** Should the operands of a commutative operator be swapped to put the
+  constant on the right? */
+bool swap_operands(const SymBool& a, const SymBool& b) {
+  return (is_true(a) || is_false(a)) && !is_true(b) && !is_false(b);
+}
+
+} // namespace
 
 /* Bool constructors */
 SymBool SymBool::_false() {
@@ -38,6 +56,12 @@ SymBool SymBool::ite(const SymBool t, const SymBool f) const {
 }
 
 SymBitVector SymBool::ite(const SymBitVector t, const SymBitVector f) const {
+  if (is_true(*this))
+    return t;
+  if (is_false(*this))
+    return f;
+  if (t.ptr == f.ptr)
+    return t;
   return SymBitVector(new SymBitVectorIte(ptr, t.ptr, f.ptr));
 }
 
@@ -46,8 +70,7 @@ SymBool SymBool::var(std::string name) {
 }
 SymBool SymBool::tmp_var() {
   stringstream name;
-  name << "TMP_BOOL_" << tmp_counter_;
-  tmp_counter_++;
+  name << "TMP_BOOL_" << tmp_counter_++;
   return SymBool(new SymBoolVar(name.str()));
 }
 
@@ -62,26 +85,63 @@ SymBool SymBool::forall(const std::vector<SymBitVector>& vars, const std::vector
 
 /* Bool Operators */
 SymBool SymBool::operator&(const SymBool other) const {
+  // constants go on the right
+  if (swap_operands(*this, other))
+    return other & *this;
+  if (is_true(other) || ptr == other.ptr)
+    return *this;
+  if (is_false(other))
+    return other;
   return SymBool(new SymBoolAnd(ptr, other.ptr));
 }
 
 SymBool SymBool::operator==(const SymBool other) const {
+  if (swap_operands(*this, other))
+    return other == *this;
+  if (is_true(other))
+    return *this;
+  if (is_false(other))
+    return !*this;
   return SymBool(new SymBoolIff(ptr, other.ptr));
 }
 
 SymBool SymBool::implies(const SymBool other) const {
+  if (is_true(*this))
+    return other;
+  if (is_false(*this) || is_true(other))
+    return _true();
+  if (is_false(other))
+    return !*this;
   return SymBool(new SymBoolImplies(ptr, other.ptr));
 }
 
 SymBool SymBool::operator!() const {
+  if (is_true(*this))
+    return _false();
+  if (is_false(*this))
+    return _true();
+  if (type() == NOT)
+    return SymBool(static_cast<const SymBoolNot*>(ptr)->b_);
   return SymBool(new SymBoolNot(ptr));
 }
 
 SymBool SymBool::operator|(const SymBool other) const {
+  if (swap_operands(*this, other))
+    return other | *this;
+  if (is_false(other) || ptr == other.ptr)
+    return *this;
+  if (is_true(other))
+    return other;
   return SymBool(new SymBoolOr(ptr, other.ptr));
 }
 
 SymBool SymBool::operator^(const SymBool other) const {
+  if (swap_operands(*this, other))
+    return other ^ *this;
+  if (is_false(other))
+    return *this;
+  if (is_true(other))
+    return !*this;
   return SymBool(new SymBoolXor(ptr, other.ptr));
 }
 
@@ -98,10 +158,12 @@ SymBool::Type SymBool::type() const {
 }
 /* equality */
 bool SymBool::equals(const SymBool other) const {
+  // within a memory manager, equal nodes are the same node
+  if (ptr == other.ptr)
+    return true;
   if (ptr && other.ptr)
     return ptr->equals(other.ptr);
-  else
-    return ptr == other.ptr;
+  return false;
 }
 
 /* Output overload */
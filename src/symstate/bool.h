@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <atomic>
 #include <string>
 #include <vector>
 
@@ -131,7 +132,7 @@ public:
   /** Constructs a new SymBool from a pointer to the AST hierarchy */
   SymBool(const SymBoolAbstract * ptr_) : ptr(ptr_) {
     if (memory_manager_)
-      memory_manager_->add(ptr_);
+      ptr = memory_manager_->add(ptr_);
   }
 
   /** Set a memory manager */
@@ -148,8 +149,8 @@ private:
 
   /** Memory Manager */
   static thread_local SymMemoryManager* memory_manager_;
-  /** Counter for temporaries. */
-  static uint64_t tmp_counter_;
+  /** Counter for temporaries; shared by all threads. */
+  static std::atomic<uint64_t> tmp_counter_;
 
 };
 
@@ -160,6 +161,12 @@ public:
   virtual bool equals(const SymBoolAbstract * const) const = 0;
 
   virtual ~SymBoolAbstract() = 0;
+
+  /** Nodes go in the arena of the installed memory manager, if any. */
+  static void* operator new(size_t size) {
+    return SymMemoryManager::allocate(SymBool::get_memory_manager(), size);
+  }
+  static void operator delete(void*) { }
 };
 
 inline SymBoolAbstract::~SymBoolAbstract() {}
@@ -12,23 +12,331 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <functional>
+
+#include "src/symstate/array.h"
 #include "src/symstate/bitvector.h"
+#include "src/symstate/bool.h"
 #include "src/symstate/memory_manager.h"
 
 using namespace std;
 using namespace stoke;
 
-void SymMemoryManager::collect() {
-  for (const SymBitVectorAbstract* bv : bitvectors_) {
-    delete bv;
-  }
-  for (const SymBoolAbstract* b : bools_) {
-    delete b;
+namespace {
+
+/** Blocks start at 64k and double up to 4M. */
+const size_t min_block_size = 1 << 16;
+const size_t max_block_size = 1 << 22;
+
+/** Every node is allocated at this alignment. */
+const size_t alignment = alignof(max_align_t);
+
+size_t combine(size_t seed, size_t value) {
+  return seed ^ (value + 0x9e3779b97f4a7c15ul + (seed << 6) + (seed >> 2));
+}
+
+size_t hash_ptr(const void* p) {
+  return hash<const void*>()(p);
+}
+
+} // namespace
+
+void* SymMemoryManager::allocate(size_t size) {
+  size = (size + alignment - 1) & ~(alignment - 1);
+
+  if (blocks_.empty() || used_ + size > blocks_.back().size()) {
+    size_t block_size = blocks_.empty() ? min_block_size : 2*blocks_.back().size();
+    if (block_size > max_block_size)
+      block_size = max_block_size;
+    if (block_size < size)
+      block_size = size;
+    blocks_.emplace_back(block_size);
+    used_ = 0;
   }
-  for (const SymArrayAbstract* a : arrays_) {
-    delete a;
+
+  void* p = blocks_.back().data() + used_;
+  used_ += size;
+  pending_ = p;
+  return p;
+}
+
+template <typename T, typename Table>
+const T* SymMemoryManager::intern(const T* p, Table& table, bool& fresh) {
+  assert(p);
+  fresh = false;
+
+  // Anything else is already interned, or isn't ours to look after.
+  if (p != pending_)
+    return p;
+  pending_ = NULL;
+
+  auto it = table.find(p);
+  if (it != table.end()) {
+    // p is the last thing allocated, so its memory can be handed back.
+    p->~T();
+    used_ = (const char*)p - blocks_.back().data();
+    return *it;
   }
+
+  table.insert(p);
+  fresh = true;
+  return p;
+}
+
+const SymBitVectorAbstract* SymMemoryManager::add(const SymBitVectorAbstract* bv) {
+  bool fresh;
+  auto result = intern(bv, bitvectors_, fresh);
+  if (fresh && (bv->type() == SymBitVector::VAR || bv->type() == SymBitVector::FUNCTION))
+    destroy_bitvectors_.push_back(bv);
+  return result;
+}
+
+const SymBoolAbstract* SymMemoryManager::add(const SymBoolAbstract* b) {
+  bool fresh;
+  auto result = intern(b, bools_, fresh);
+  if (fresh && (b->type() == SymBool::VAR || b->type() == SymBool::FOR_ALL))
+    destroy_bools_.push_back(b);
+  return result;
+}
+
+const SymArrayAbstract* SymMemoryManager::add(const SymArrayAbstract* a) {
+  bool fresh;
+  auto result = intern(a, arrays_, fresh);
+  if (fresh && a->type() == SymArray::VAR)
+    destroy_arrays_.push_back(a);
+  return result;
+}
+
+void SymMemoryManager::collect() {
+  if (blocks_.empty())
+    return;
+  (*collections_)++;
+
+  for (auto bv : destroy_bitvectors_)
+    bv->~SymBitVectorAbstract();
+  for (auto b : destroy_bools_)
+    b->~SymBoolAbstract();
+  for (auto a : destroy_arrays_)
+    a->~SymArrayAbstract();
+
+  destroy_bitvectors_.clear();
+  destroy_bools_.clear();
+  destroy_arrays_.clear();
   bitvectors_.clear();
   bools_.clear();
   arrays_.clear();
+
+  blocks_.clear();
+  used_ = 0;
+  pending_ = NULL;
+}
+
+size_t SymMemoryManager::BitVectorHash::operator()(const SymBitVectorAbstract* bv) const {
+  size_t h = combine(bv->type(), bv->width_);
+
+  switch (bv->type()) {
+  case SymBitVector::NOT:
+  case SymBitVector::U_MINUS:
+    return combine(h, hash_ptr(static_cast<const SymBitVectorUnop*>(bv)->bv_));
+
+  case SymBitVector::ARRAY_LOOKUP: {
+    auto lookup = static_cast<const SymBitVectorArrayLookup*>(bv);
+    return combine(combine(h, hash_ptr(lookup->a_)), hash_ptr(lookup->key_));
+  }
+  case SymBitVector::CONSTANT:
+    return combine(h, static_cast<const SymBitVectorConstant*>(bv)->constant_);
+
+  case SymBitVector::EXTRACT: {
+    auto extract = static_cast<const SymBitVectorExtract*>(bv);
+    return combine(combine(h, hash_ptr(extract->bv_)), extract->low_bit_);
+  }
+  case SymBitVector::FUNCTION: {
+    auto function = static_cast<const SymBitVectorFunction*>(bv);
+    h = combine(h, hash<string>()(function->f_.name));
+    for (auto arg : function->args_)
+      h = combine(h, hash_ptr(arg));
+    return h;
+  }
+  case SymBitVector::ITE: {
+    auto ite = static_cast<const SymBitVectorIte*>(bv);
+    h = combine(h, hash_ptr(ite->cond_));
+    return combine(combine(h, hash_ptr(ite->a_)), hash_ptr(ite->b_));
+  }
+  case SymBitVector::SIGN_EXTEND:
+    return combine(h, hash_ptr(static_cast<const SymBitVectorSignExtend*>(bv)->bv_));
+
+  case SymBitVector::VAR:
+    return combine(h, hash<string>()(static_cast<const SymBitVectorVar*>(bv)->name_));
+
+  default: {
+    auto binop = static_cast<const SymBitVectorBinop*>(bv);
+    return combine(combine(h, hash_ptr(binop->a_)), hash_ptr(binop->b_));
+  }
+  }
+}
+
+bool SymMemoryManager::BitVectorEqual::operator()(const SymBitVectorAbstract* x,
+    const SymBitVectorAbstract* y) const {
+  if (x == y)
+    return true;
+  if (x->type() != y->type() || x->width_ != y->width_)
+    return false;
+
+  switch (x->type()) {
+  case SymBitVector::NOT:
+  case SymBitVector::U_MINUS:
+    return static_cast<const SymBitVectorUnop*>(x)->bv_ ==
+           static_cast<const SymBitVectorUnop*>(y)->bv_;
+
+  case SymBitVector::ARRAY_LOOKUP: {
+    auto a = static_cast<const SymBitVectorArrayLookup*>(x);
+    auto b = static_cast<const SymBitVectorArrayLookup*>(y);
+    return a->a_ == b->a_ && a->key_ == b->key_;
+  }
+  case SymBitVector::CONSTANT:
+    return static_cast<const SymBitVectorConstant*>(x)->constant_ ==
+           static_cast<const SymBitVectorConstant*>(y)->constant_;
+
+  case SymBitVector::EXTRACT: {
+    auto a = static_cast<const SymBitVectorExtract*>(x);
+    auto b = static_cast<const SymBitVectorExtract*>(y);
+    return a->bv_ == b->bv_ && a->low_bit_ == b->low_bit_ && a->high_bit_ == b->high_bit_;
+  }
+  case SymBitVector::FUNCTION: {
+    auto a = static_cast<const SymBitVectorFunction*>(x);
+    auto b = static_cast<const SymBitVectorFunction*>(y);
+    return a->f_ == b->f_ && a->args_ == b->args_;
+  }
+  case SymBitVector::ITE: {
+    auto a = static_cast<const SymBitVectorIte*>(x);
+    auto b = static_cast<const SymBitVectorIte*>(y);
+    return a->cond_ == b->cond_ && a->a_ == b->a_ && a->b_ == b->b_;
+  }
+  case SymBitVector::SIGN_EXTEND:
+    return static_cast<const SymBitVectorSignExtend*>(x)->bv_ ==
+           static_cast<const SymBitVectorSignExtend*>(y)->bv_;
+
+  case SymBitVector::VAR:
+    return static_cast<const SymBitVectorVar*>(x)->name_ ==
+           static_cast<const SymBitVectorVar*>(y)->name_;
+
+  default: {
+    auto a = static_cast<const SymBitVectorBinop*>(x);
+    auto b = static_cast<const SymBitVectorBinop*>(y);
+    return a->a_ == b->a_ && a->b_ == b->b_;
+  }
+  }
+}
+
+size_t SymMemoryManager::BoolHash::operator()(const SymBoolAbstract* b) const {
+  size_t h = b->type();
+
+  switch (b->type()) {
+  case SymBool::AND:
+  case SymBool::IFF:
+  case SymBool::IMPLIES:
+  case SymBool::OR:
+  case SymBool::XOR: {
+    auto binop = static_cast<const SymBoolBinop*>(b);
+    return combine(combine(h, hash_ptr(binop->a_)), hash_ptr(binop->b_));
+  }
+  case SymBool::ARRAY_EQ: {
+    auto eq = static_cast<const SymBoolArrayEq*>(b);
+    return combine(combine(h, hash_ptr(eq->a_)), hash_ptr(eq->b_));
+  }
+  case SymBool::FALSE:
+  case SymBool::TRUE:
+    return h;
+
+  case SymBool::FOR_ALL:
+    return combine(h, hash_ptr(static_cast<const SymBoolForAll*>(b)->a_));
+
+  case SymBool::NOT:
+    return combine(h, hash_ptr(static_cast<const SymBoolNot*>(b)->b_));
+
+  case SymBool::VAR:
+    return combine(h, hash<string>()(static_cast<const SymBoolVar*>(b)->name_));
+
+  default: {
+    auto compare = static_cast<const SymBoolCompare*>(b);
+    return combine(combine(h, hash_ptr(compare->a_)), hash_ptr(compare->b_));
+  }
+  }
+}
+
+bool SymMemoryManager::BoolEqual::operator()(const SymBoolAbstract* x,
+    const SymBoolAbstract* y) const {
+  if (x == y)
+    return true;
+  if (x->type() != y->type())
+    return false;
+
+  switch (x->type()) {
+  case SymBool::AND:
+  case SymBool::IFF:
+  case SymBool::IMPLIES:
+  case SymBool::OR:
+  case SymBool::XOR: {
+    auto a = static_cast<const SymBoolBinop*>(x);
+    auto b = static_cast<const SymBoolBinop*>(y);
+    return a->a_ == b->a_ && a->b_ == b->b_;
+  }
+  case SymBool::ARRAY_EQ: {
+    auto a = static_cast<const SymBoolArrayEq*>(x);
+    auto b = static_cast<const SymBoolArrayEq*>(y);
+    return a->a_ == b->a_ && a->b_ == b->b_;
+  }
+  case SymBool::FALSE:
+  case SymBool::TRUE:
+    return true;
+
+  case SymBool::FOR_ALL: {
+    auto a = static_cast<const SymBoolForAll*>(x);
+    auto b = static_cast<const SymBoolForAll*>(y);
+    if (a->a_ != b->a_ || !(a->vars_ == b->vars_) ||
+        a->patterns_.size() != b->patterns_.size())
+      return false;
+    for (size_t i = 0; i < a->patterns_.size(); ++i)
+      if (a->patterns_[i].ptr != b->patterns_[i].ptr)
+        return false;
+    return true;
+  }
+  case SymBool::NOT:
+    return static_cast<const SymBoolNot*>(x)->b_ == static_cast<const SymBoolNot*>(y)->b_;
+
+  case SymBool::VAR:
+    return static_cast<const SymBoolVar*>(x)->name_ == static_cast<const SymBoolVar*>(y)->name_;
+
+  default: {
+    auto a = static_cast<const SymBoolCompare*>(x);
+    auto b = static_cast<const SymBoolCompare*>(y);
+    return a->a_ == b->a_ && a->b_ == b->b_;
+  }
+  }
+}
+
+size_t SymMemoryManager::ArrayHash::operator()(const SymArrayAbstract* a) const {
+  size_t h = combine(combine(a->type(), a->key_size_), a->value_size_);
+  if (a->type() == SymArray::VAR)
+    return combine(h, hash<string>()(static_cast<const SymArrayVar*>(a)->name_));
+
+  auto store = static_cast<const SymArrayStore*>(a);
+  h = combine(h, hash_ptr(store->a_));
+  return combine(combine(h, hash_ptr(store->key_)), hash_ptr(store->value_));
+}
+
+bool SymMemoryManager::ArrayEqual::operator()(const SymArrayAbstract* x,
+    const SymArrayAbstract* y) const {
+  if (x == y)
+    return true;
+  if (x->type() != y->type() || x->key_size_ != y->key_size_ ||
+      x->value_size_ != y->value_size_)
+    return false;
+
+  if (x->type() == SymArray::VAR)
+    return static_cast<const SymArrayVar*>(x)->name_ == static_cast<const SymArrayVar*>(y)->name_;
+
+  auto a = static_cast<const SymArrayStore*>(x);
+  auto b = static_cast<const SymArrayStore*>(y);
+  return a->a_ == b->a_ && a->key_ == b->key_ && a->value_ == b->value_;
 }
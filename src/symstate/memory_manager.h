@@ -16,8 +16,14 @@
 #ifndef _STOKE_SRC_SYMSTATE_SYM_MEMORY_MANAGER_H
 #define _STOKE_SRC_SYMSTATE_SYM_MEMORY_MANAGER_H
 
-#include <set>
+#include <atomic>
 #include <cassert>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <unordered_set>
+#include <vector>
 
 namespace stoke {
 
@@ -25,38 +31,103 @@ class SymArrayAbstract;
 class SymBitVectorAbstract;
 class SymBoolAbstract;
 
+/** Owns the symbolic nodes built while it is installed.  Nodes are bump
+  allocated out of an arena and hash-consed: building a node that is
+  structurally the same as one this manager already holds (same type, width,
+  constants and child pointers) gives back the existing node.  So within one
+  manager, two nodes are equal exactly when their pointers are. */
 class SymMemoryManager {
 
 public:
 
-  /** Collect bitvector */
-  void add(const SymBitVectorAbstract* bv) {
-    assert(bv);
-    bitvectors_.insert(bv);
-  }
-  /** Collect bool */
-  void add(const SymBoolAbstract* b) {
-    assert(b);
-    bools_.insert(b);
-  }
-  /** Collect array */
-  void add(const SymArrayAbstract* b) {
-    assert(b);
-    arrays_.insert(b);
+  SymMemoryManager() : used_(0), pending_(NULL),
+    collections_(std::make_shared<std::atomic<uint64_t>>(0)) { }
+  SymMemoryManager(const SymMemoryManager&) = delete;
+  SymMemoryManager& operator=(const SymMemoryManager&) = delete;
+
+  ~SymMemoryManager() {
+    collect();
   }
 
-  /** Cache a binop.  Whenever we need a new binary operator constructed, see if we've
-    already constructed it. */
+  /** Memory for a new node: from the arena if there's a manager, otherwise
+    from the heap.  Used by the node classes' operator new. */
+  static void* allocate(SymMemoryManager* mm, size_t size) {
+    if (mm)
+      return mm->allocate(size);
+    return ::operator new(size);
+  }
 
+  /** Collect bitvector; returns the node to use in its place. */
+  const SymBitVectorAbstract* add(const SymBitVectorAbstract* bv);
+  /** Collect bool; returns the node to use in its place. */
+  const SymBoolAbstract* add(const SymBoolAbstract* b);
+  /** Collect array; returns the node to use in its place. */
+  const SymArrayAbstract* add(const SymArrayAbstract* a);
 
   /** Free all the junk */
   void collect();
 
+  /** Number of distinct nodes held. */
+  size_t size() const {
+    return bitvectors_.size() + bools_.size() + arrays_.size();
+  }
+
+  /** Number of times this manager has freed its nodes.  Their addresses
+    may be reused, so anything that caches by node address must be dropped
+    when this changes.  The count can still be read once the manager is
+    gone; destroying it counts as a collection. */
+  std::shared_ptr<const std::atomic<uint64_t>> get_collections() const {
+    return collections_;
+  }
+
 private:
 
-  std::set<const SymBitVectorAbstract*> bitvectors_;
-  std::set<const SymBoolAbstract*> bools_;
-  std::set<const SymArrayAbstract*> arrays_;
+  /** Bump allocate from the current block, starting a new one if needed. */
+  void* allocate(size_t size);
+
+  /** Hash-cons the node at p, if it's the one just allocated here.  Sets
+    fresh if p went into the table as a new node. */
+  template <typename T, typename Table>
+  const T* intern(const T* p, Table& table, bool& fresh);
+
+  struct BitVectorHash {
+    size_t operator()(const SymBitVectorAbstract* bv) const;
+  };
+  struct BitVectorEqual {
+    bool operator()(const SymBitVectorAbstract* a, const SymBitVectorAbstract* b) const;
+  };
+  struct BoolHash {
+    size_t operator()(const SymBoolAbstract* b) const;
+  };
+  struct BoolEqual {
+    bool operator()(const SymBoolAbstract* a, const SymBoolAbstract* b) const;
+  };
+  struct ArrayHash {
+    size_t operator()(const SymArrayAbstract* a) const;
+  };
+  struct ArrayEqual {
+    bool operator()(const SymArrayAbstract* a, const SymArrayAbstract* b) const;
+  };
+
+  /** The unique tables. */
+  std::unordered_set<const SymBitVectorAbstract*, BitVectorHash, BitVectorEqual> bitvectors_;
+  std::unordered_set<const SymBoolAbstract*, BoolHash, BoolEqual> bools_;
+  std::unordered_set<const SymArrayAbstract*, ArrayHash, ArrayEqual> arrays_;
+
+  /** Nodes with members that own heap memory (names, argument lists); only
+    these need their destructors run. */
+  std::vector<const SymBitVectorAbstract*> destroy_bitvectors_;
+  std::vector<const SymBoolAbstract*> destroy_bools_;
+  std::vector<const SymArrayAbstract*> destroy_arrays_;
+
+  /** Arena blocks; only the last one is being allocated from. */
+  std::vector<std::vector<char>> blocks_;
+  /** Bytes used in the last block. */
+  size_t used_;
+  /** The last allocation, until it has been added. */
+  const void* pending_;
+
+  std::shared_ptr<std::atomic<uint64_t>> collections_;
 
 };
 
@@ -46,17 +46,26 @@ public:
     }
   }
 
-  void add_to_memory_manager(const SymBitVectorAbstract* ptr) {
+  const SymBitVectorAbstract* add_node(const SymBitVectorAbstract* ptr) {
     if (SymBitVector::get_memory_manager())
-      SymBitVector::get_memory_manager()->add(ptr);
+      return SymBitVector::get_memory_manager()->add(ptr);
+    return ptr;
   }
-  void add_to_memory_manager(const SymBoolAbstract* ptr) {
+  const SymBoolAbstract* add_node(const SymBoolAbstract* ptr) {
     if (SymBool::get_memory_manager())
-      SymBool::get_memory_manager()->add(ptr);
+      return SymBool::get_memory_manager()->add(ptr);
+    return ptr;
   }
-  void add_to_memory_manager(const SymArrayAbstract* ptr) {
+  const SymArrayAbstract* add_node(const SymArrayAbstract* ptr) {
     if (SymArray::get_memory_manager())
-      SymArray::get_memory_manager()->add(ptr);
+      return SymArray::get_memory_manager()->add(ptr);
+    return ptr;
+  }
+  /** Adds a new node to the memory manager; returns the node to use in its
+    place, which is an existing one if an identical node was built before. */
+  template <typename T>
+  T* add_to_memory_manager(T* ptr) {
+    return (T*)add_node(ptr);
   }
 
   SymBitVectorAbstract* cache(const SymBitVectorAbstract* const bv, SymBitVectorAbstract* res) {
@@ -158,8 +167,7 @@ public:
                 << " in " << __FILE__ << ":" << __LINE__ << std::endl;
       assert(false);
     }
-    add_to_memory_manager(res);
-    return res;
+    return add_to_memory_manager(res);
   }
 
   SymBoolBinop* make_binop(SymBool::Type type, SymBoolAbstract* lhs, SymBoolAbstract* rhs) {
@@ -185,8 +193,7 @@ public:
                 << " in " << __FILE__ << ":" << __LINE__ << std::endl;
       assert(false);
     }
-    add_to_memory_manager(res);
-    return res;
+    return add_to_memory_manager(res);
   }
 
   SymBitVectorUnop* make_unop(SymBitVector::Type type, SymBitVectorAbstract* lhs) {
@@ -203,8 +210,7 @@ public:
                 << " in " << __FILE__ << ":" << __LINE__ << std::endl;
       assert(false);
     }
-    add_to_memory_manager(res);
-    return res;
+    return add_to_memory_manager(res);
   }
 
   SymBoolCompare* make_compare(SymBool::Type type, SymBitVectorAbstract* lhs, SymBitVectorAbstract* rhs) {
@@ -242,29 +248,24 @@ public:
                 << " in " << __FILE__ << ":" << __LINE__ << std::endl;
       assert(false);
     }
-    add_to_memory_manager(res);
-    return res;
+    return add_to_memory_manager(res);
   }
 
   SymBoolArrayEq* make_array_eq(const SymArrayAbstract * const a, const SymArrayAbstract * const b) {
     auto res = new SymBoolArrayEq(a, b);
-    add_to_memory_manager(res);
-    return res;
+    return add_to_memory_manager(res);
   }
   SymBitVectorArrayLookup* make_bitvector_array_lookup(const SymArrayAbstract * const a, const SymBitVectorAbstract * const key) {
     auto res = new SymBitVectorArrayLookup(a, key);
-    add_to_memory_manager(res);
-    return res;
+    return add_to_memory_manager(res);
   }
   SymBitVectorConstant* make_bitvector_constant(uint16_t size, uint64_t constant) {
     auto res = new SymBitVectorConstant(size, constant);
-    add_to_memory_manager(res);
-    return res;
+    return add_to_memory_manager(res);
   }
   SymBitVectorExtract* make_bitvector_extract(const SymBitVectorAbstract * const bv, uint16_t high_bit, uint16_t low_bit) {
     auto res = new SymBitVectorExtract(bv, high_bit, low_bit);
-    add_to_memory_manager(res);
-    return res;
+    return add_to_memory_manager(res);
   }
   SymBitVectorFunction* make_bitvector_function(const SymFunction& f, const std::vector<SymBitVectorAbstract *>& args) {
     SymBitVectorFunction* res = NULL;
@@ -279,60 +280,49 @@ public:
     } else {
       assert(false);
     }
-    add_to_memory_manager(res);
-    return res;
+    return add_to_memory_manager(res);
   }
   SymBitVectorIte* make_bitvector_ite(const SymBoolAbstract * const cond, const SymBitVectorAbstract * const a, const SymBitVectorAbstract * const b) {
     auto res = new SymBitVectorIte(cond, a, b);
-    add_to_memory_manager(res);
-    return res;
+    return add_to_memory_manager(res);
   }
   SymBitVectorSignExtend* make_bitvector_sign_extend(const SymBitVectorAbstract * const bv, uint16_t size) {
     auto res = new SymBitVectorSignExtend(bv, size);
-    add_to_memory_manager(res);
-    return res;
+    return add_to_memory_manager(res);
   }
   SymBitVectorVar* make_bitvector_var(uint16_t size, const std::string name) {
     auto res = new SymBitVectorVar(size, name);
-    add_to_memory_manager(res);
-    return res;
+    return add_to_memory_manager(res);
   }
 
   SymBoolFalse* make_bool_false() {
     auto res = new SymBoolFalse();
-    add_to_memory_manager(res);
-    return res;
+    return add_to_memory_manager(res);
   }
   SymBoolForAll* make_forall(const SymBoolAbstract* const b, const std::vector<SymBitVectorVar>& vars, const std::vector<SymBitVector>& patterns) {
     auto res = new SymBoolForAll(b, vars, patterns);
-    add_to_memory_manager(res);
-    return res;
+    return add_to_memory_manager(res);
   }
   SymBoolNot* make_bool_not(const SymBoolAbstract* b) {
     auto res = new SymBoolNot(b);
-    add_to_memory_manager(res);
-    return res;
+    return add_to_memory_manager(res);
   }
   SymBoolTrue* make_bool_true() {
     auto res = new SymBoolTrue();
-    add_to_memory_manager(res);
-    return res;
+    return add_to_memory_manager(res);
   }
   SymBoolVar* make_bool_var(const std::string name) {
     auto res = new SymBoolVar(name);
-    add_to_memory_manager(res);
-    return res;
+    return add_to_memory_manager(res);
   }
 
   SymArrayVar* make_array_var(uint16_t key_size, uint16_t value_size, const std::string name) {
     auto res = new SymArrayVar(key_size, value_size, name);
-    add_to_memory_manager(res);
-    return res;
+    return add_to_memory_manager(res);
   }
   SymArrayStore* make_array_store(const SymArrayAbstract * a, const SymBitVectorAbstract * key, const SymBitVectorAbstract * value) {
     auto res = new SymArrayStore(a, key, value);
-    add_to_memory_manager(res);
-    return res;
+    return add_to_memory_manager(res);
   }
 
   SymBitVectorAbstract* visit_binop(const SymBitVectorBinop * const bv) {
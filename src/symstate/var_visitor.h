@@ -0,0 +1,168 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef _STOKE_SRC_SYMSTATE_VAR_VISITOR
+#define _STOKE_SRC_SYMSTATE_VAR_VISITOR
+
+#include <set>
+#include <string>
+#include <unordered_set>
+
+#include "src/symstate/visitor.h"
+
+namespace stoke {
+
+/** Collects the names of the free symbols of formulas: bit-vector, bool and
+  array variables, and uninterpreted functions.  Shared subterms are visited
+  once. */
+class SymVarVisitor : public SymVisitor<void, void, void> {
+
+public:
+  SymVarVisitor() {}
+
+  /** The names seen so far. */
+  const std::set<std::string>& get_vars() const {
+    return vars_;
+  }
+
+  using SymVisitor<void, void, void>::operator();
+
+  void operator()(const SymBitVectorAbstract * const bv) override {
+    if (seen_.insert(bv).second)
+      SymVisitor<void, void, void>::operator()(bv);
+  }
+
+  void operator()(const SymBoolAbstract * const b) override {
+    if (seen_.insert(b).second)
+      SymVisitor<void, void, void>::operator()(b);
+  }
+
+  void operator()(const SymArrayAbstract * const a) override {
+    if (seen_.insert(a).second)
+      SymVisitor<void, void, void>::operator()(a);
+  }
+
+  void visit_binop(const SymBitVectorBinop * const e) override {
+    (*this)(e->a_);
+    (*this)(e->b_);
+  }
+
+  /* Visit a binop on a bool */
+  void visit_binop(const SymBoolBinop * const e) override {
+    (*this)(e->a_);
+    (*this)(e->b_);
+  }
+
+  void visit_unop(const SymBitVectorUnop * const bv) override {
+    (*this)(bv->bv_);
+  }
+
+  void visit_compare(const SymBoolCompare * const e) override {
+    (*this)(e->a_);
+    (*this)(e->b_);
+  }
+
+  /** Visit a bit-vector array lookup */
+  void visit(const SymBitVectorArrayLookup * const bv) override {
+    (*this)(bv->a_);
+    (*this)(bv->key_);
+  }
+
+  /** Visit a bit-vector constant */
+  void visit(const SymBitVectorConstant * const bv) override {
+    return;
+  }
+
+  /** Visit a bit-vector extract */
+  void visit(const SymBitVectorExtract * const bv) override {
+    (*this)(bv->bv_);
+  }
+
+  /** Visit a bit-vector function */
+  void visit(const SymBitVectorFunction * const bv) override {
+    vars_.insert(bv->f_.name);
+    for (auto it : bv->args_)
+      (*this)(it);
+  }
+
+  /** Visit a bit-vector if-then-else */
+  void visit(const SymBitVectorIte * const bv) override {
+    (*this)(bv->cond_);
+    (*this)(bv->a_);
+    (*this)(bv->b_);
+  }
+
+  /** Visit a bit-vector sign-extend */
+  void visit(const SymBitVectorSignExtend * const bv) override {
+    (*this)(bv->bv_);
+  }
+
+  /** Visit a bit-vector variable */
+  void visit(const SymBitVectorVar * const bv) override {
+    vars_.insert(bv->name_);
+  }
+
+  /** Visit a boolean ARRAY_EQ */
+  void visit(const SymBoolArrayEq * const b) override {
+    (*this)(b->a_);
+    (*this)(b->b_);
+  }
+
+  /** Visit a boolean FALSE */
+  void visit(const SymBoolFalse * const b) override {
+    return;
+  }
+
+  /** Visit a boolean FOR_ALL */
+  void visit(const SymBoolForAll * const b) override {
+    (*this)(b->a_);
+  }
+
+  /** Visit a boolean NOT */
+  void visit(const SymBoolNot * const b) override {
+    (*this)(b->b_);
+  }
+
+  /** Visit a boolean TRUE */
+  void visit(const SymBoolTrue * const b) override {
+    return;
+  }
+
+  /** Visit a boolean VAR */
+  void visit(const SymBoolVar * const b) override {
+    vars_.insert(b->name_);
+  }
+
+  /** Visit an array STORE */
+  void visit(const SymArrayStore * const a) override {
+    (*this)(a->a_);
+    (*this)(a->key_);
+    (*this)(a->value_);
+  }
+
+  /** Visit an array VAR */
+  void visit(const SymArrayVar * const a) override {
+    vars_.insert(a->name_);
+  }
+
+private:
+
+  std::set<std::string> vars_;
+  std::unordered_set<const void*> seen_;
+
+};
+
+} //namespace
+
+#endif
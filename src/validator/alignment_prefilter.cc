@@ -0,0 +1,183 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <set>
+
+#include "src/validator/alignment_prefilter.h"
+#include "src/validator/invariants/conjunction.h"
+
+using namespace std;
+using namespace stoke;
+
+namespace {
+
+bool has_repeated_block(const CompactTrace& trace) {
+  set<Cfg::id_type> seen;
+  for (size_t i = 0; i < trace.size(); ++i) {
+    if (seen.count(trace.get_block(i)))
+      return true;
+    seen.insert(trace.get_block(i));
+  }
+  return false;
+}
+
+} // namespace
+
+void AlignmentPrefilter::reset(const vector<CompactTrace>& target_traces,
+                               const vector<CompactTrace>& rewrite_traces,
+                               size_t limit) {
+  assert(target_traces.size() == rewrite_traces.size());
+  target_traces_ = &target_traces;
+  rewrite_traces_ = &rewrite_traces;
+  trace_limit_ = limit;
+  columns_.clear();
+}
+
+shared_ptr<EqualityInvariant> AlignmentPrefilter::get_linear_part(shared_ptr<Invariant> inv) {
+  auto equality = dynamic_pointer_cast<EqualityInvariant>(inv);
+  if (equality)
+    return equality;
+
+  auto conj = dynamic_pointer_cast<ConjunctionInvariant>(inv);
+  if (!conj)
+    return NULL;
+  for (size_t i = 0; i < conj->size(); ++i) {
+    equality = dynamic_pointer_cast<EqualityInvariant>((*conj)[i]);
+    if (equality)
+      return equality;
+  }
+  return NULL;
+}
+
+const vector<uint64_t>& AlignmentPrefilter::get_column(const Variable& v, size_t trace) {
+  auto key = make_pair(trace, v);
+  key.second.coefficient = 1;
+  auto it = columns_.find(key);
+  if (it != columns_.end())
+    return it->second;
+
+  // states are rebuilt one after the other in a single buffer
+  auto& points = v.is_rewrite ? (*rewrite_traces_)[trace] : (*target_traces_)[trace];
+  vector<uint64_t> column(points.size());
+  CpuState cs;
+  for (size_t i = 0; i < points.size(); ++i) {
+    points.next_state(i, cs);
+    column[i] = v.from_state(cs, cs);
+  }
+  return columns_.emplace(key, column).first->second;
+}
+
+bool AlignmentPrefilter::get_sums(const EqualityInvariant& inv, size_t trace,
+                                  vector<uint64_t>& target_sum, vector<uint64_t>& rewrite_sum) {
+  if (!target_traces_ || trace >= target_traces_->size())
+    return false;
+
+  // the left hand side is a sum over target variables plus one over rewrite
+  // variables; both wrap around at 64 bits, as in EqualityInvariant::check
+  target_sum.assign((*target_traces_)[trace].size(), 0);
+  rewrite_sum.assign((*rewrite_traces_)[trace].size(), 0);
+  for (auto& term : inv.get_terms()) {
+    if (term.coefficient == 0)
+      continue;
+    auto& column = get_column(term, trace);
+    auto& sum = term.is_rewrite ? rewrite_sum : target_sum;
+    uint64_t coefficient = term.coefficient;
+    for (size_t i = 0; i < sum.size(); ++i)
+      sum[i] += coefficient*column[i];
+  }
+  return true;
+}
+
+bool AlignmentPrefilter::get_matches(const EqualityInvariant& inv, size_t trace, vector<uint8_t>& matches) {
+  if (inv.get_modulus() != 0)
+    return false;
+
+  vector<uint64_t> target_sum;
+  vector<uint64_t> rewrite_sum;
+  if (!get_sums(inv, trace, target_sum, rewrite_sum))
+    return false;
+  size_t n = target_sum.size();
+  size_t m = rewrite_sum.size();
+
+  // one compare per pair, on contiguous arrays, so the compiler vectorizes it
+  uint64_t constant = inv.get_constant();
+  matches.resize(n*m);
+  const uint64_t* rewrite_values = rewrite_sum.data();
+  for (size_t i = 0; i < n; ++i) {
+    uint64_t wanted = constant - target_sum[i];
+    uint8_t* row = matches.data() + i*m;
+    for (size_t j = 0; j < m; ++j)
+      row[j] = rewrite_values[j] == wanted;
+  }
+  return true;
+}
+
+bool AlignmentPrefilter::has_chain(const vector<uint8_t>& matches, size_t n, size_t m) const {
+  // the ends of the traces always line up
+  vector<uint8_t> reached(n*m, 0);
+  reached[0] = 1;
+
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t j = 0; j < m; ++j) {
+      bool last = (i == n-1 && j == m-1);
+      if ((i == 0 && j == 0) || (!matches[i*m + j] && !last))
+        continue;
+
+      size_t first_i = i > target_bound_ ? i - target_bound_ : 0;
+      size_t first_j = j > rewrite_bound_ ? j - rewrite_bound_ : 0;
+      for (size_t pi = first_i; pi <= i && !reached[i*m + j]; ++pi)
+        for (size_t pj = first_j; pj <= j; ++pj)
+          if ((pi != i || pj != j) && reached[pi*m + pj]) {
+            reached[i*m + j] = 1;
+            break;
+          }
+    }
+  }
+  return reached[n*m - 1];
+}
+
+bool AlignmentPrefilter::keep(shared_ptr<Invariant> inv) {
+  auto linear = get_linear_part(inv);
+  if (!linear || !target_traces_)
+    return true;
+  bool exact = (linear == inv);
+
+  vector<uint8_t> matches;
+  for (size_t i = 0; i < target_traces_->size() && i <= trace_limit_; ++i) {
+    auto& target_trace = (*target_traces_)[i];
+    auto& rewrite_trace = (*rewrite_traces_)[i];
+    size_t n = target_trace.size();
+    size_t m = rewrite_trace.size();
+    if (n < 2 || m < 2)
+      continue;
+
+    if (!get_matches(*linear, i, matches))
+      return true;
+
+    // build_paa_for_alignment_predicate gives up on these; with more conjuncts,
+    // the predicate could still fail somewhere
+    if (exact && (has_repeated_block(target_trace) || has_repeated_block(rewrite_trace))) {
+      bool everywhere = true;
+      for (auto it : matches)
+        everywhere &= (it != 0);
+      if (everywhere)
+        return false;
+    }
+
+    if (!has_chain(matches, n, m))
+      return false;
+  }
+
+  return true;
+}
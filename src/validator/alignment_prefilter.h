@@ -0,0 +1,97 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef STOKE_SRC_VALIDATOR_ALIGNMENT_PREFILTER_H
+#define STOKE_SRC_VALIDATOR_ALIGNMENT_PREFILTER_H
+
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "src/validator/compact_trace.h"
+#include "src/validator/invariant.h"
+#include "src/validator/invariants/equality.h"
+#include "src/validator/variable.h"
+
+namespace stoke {
+
+/** Evaluates the linear part of candidate alignment predicates over every
+  pair of trace points at once.  The value of each variable over a trace is
+  read out of the CpuStates once, into a column; after that a predicate costs
+  a few passes over contiguous arrays per trace, with no virtual calls and no
+  copies of states.  Used to discard candidates before any PAA is built, and
+  to answer the linear part of the pairwise checks when one is. */
+class AlignmentPrefilter {
+
+public:
+
+  AlignmentPrefilter() :
+    target_traces_(NULL), rewrite_traces_(NULL), trace_limit_(0),
+    target_bound_(0), rewrite_bound_(0) { }
+
+  /** Use a new pair of trace sets.  Like build_paa_for_alignment_predicate,
+    only traces 0 through limit are looked at by keep(). */
+  void reset(const std::vector<CompactTrace>& target_traces,
+             const std::vector<CompactTrace>& rewrite_traces,
+             size_t limit);
+
+  /** Set the most blocks a PAA edge may cover in each program. */
+  AlignmentPrefilter& set_bound(size_t target_bound, size_t rewrite_bound) {
+    target_bound_ = target_bound;
+    rewrite_bound_ = rewrite_bound;
+    return *this;
+  }
+
+  /** The equality among the conjuncts of an alignment predicate, or NULL. */
+  static std::shared_ptr<EqualityInvariant> get_linear_part(std::shared_ptr<Invariant> inv);
+
+  /** Evaluate the target and rewrite halves of the left hand side of an
+    equality at each point of a trace.  Returns false if there's no such trace. */
+  bool get_sums(const EqualityInvariant& inv, size_t trace,
+                std::vector<uint64_t>& target_sum, std::vector<uint64_t>& rewrite_sum);
+
+  /** Find whether an equality holds at each pair of points of a trace, row by
+    row of target points.  Returns false if it can't be evaluated this way. */
+  bool get_matches(const EqualityInvariant& inv, size_t trace, std::vector<uint8_t>& matches);
+
+  /** Returns false if a predicate can't align some trace: either
+    build_paa_for_alignment_predicate would reject it outright, or the pairs of
+    points where it holds can't be chained from start to end of the trace
+    without some step going over the bounds, leaving the PAA to cover the
+    trace with edges learned from other traces alone. */
+  bool keep(std::shared_ptr<Invariant> inv);
+
+private:
+
+  /** The values of a variable over a trace. */
+  const std::vector<uint64_t>& get_column(const Variable& v, size_t trace);
+
+  /** Can the matching pairs be chained from the first to the last? */
+  bool has_chain(const std::vector<uint8_t>& matches, size_t n, size_t m) const;
+
+  const std::vector<CompactTrace>* target_traces_;
+  const std::vector<CompactTrace>* rewrite_traces_;
+  size_t trace_limit_;
+  size_t target_bound_;
+  size_t rewrite_bound_;
+
+  /** Columns by trace and variable, with the coefficient cleared. */
+  std::map<std::pair<size_t, Variable>, std::vector<uint64_t>> columns_;
+
+};
+
+} // namespace stoke
+
+#endif
@@ -0,0 +1,204 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <functional>
+#include <sstream>
+
+#include "src/symstate/transform_visitor.h"
+#include "src/validator/block_summary_cache.h"
+
+using namespace std;
+using namespace stoke;
+using namespace x64asm;
+
+namespace {
+
+/** Substitutes the input variables of a summary with the values of a state.
+  Temporaries introduced by handlers are replaced by fresh ones, so that two
+  applications of one summary never share them. */
+class SummaryApplier : public SymTransformVisitor {
+public:
+  SummaryApplier(const map<const SymBitVectorAbstract*, SymBitVectorAbstract*>& bv_inputs,
+                 const map<const SymBoolAbstract*, SymBoolAbstract*>& bool_inputs) :
+    bv_inputs_(bv_inputs), bool_inputs_(bool_inputs) {}
+
+  SymBitVectorAbstract* visit(const SymBitVectorVar * const bv) {
+    auto it = bv_inputs_.find(bv);
+    if (it != bv_inputs_.end())
+      return it->second;
+
+    if (bv->get_name().find("TMP_BV_") == 0) {
+      if (!tmp_bv_.count(bv))
+        tmp_bv_[bv] = (SymBitVectorAbstract*)SymBitVector::tmp_var(bv->get_size()).ptr;
+      return tmp_bv_[bv];
+    }
+    return (SymBitVectorAbstract*)bv;
+  }
+
+  SymBoolAbstract* visit(const SymBoolVar * const b) {
+    auto it = bool_inputs_.find(b);
+    if (it != bool_inputs_.end())
+      return it->second;
+
+    if (b->get_name().find("TMP_BOOL_") == 0) {
+      if (!tmp_bool_.count(b))
+        tmp_bool_[b] = (SymBoolAbstract*)SymBool::tmp_var().ptr;
+      return tmp_bool_[b];
+    }
+    return (SymBoolAbstract*)b;
+  }
+
+private:
+  const map<const SymBitVectorAbstract*, SymBitVectorAbstract*>& bv_inputs_;
+  const map<const SymBoolAbstract*, SymBoolAbstract*>& bool_inputs_;
+
+  map<const SymBitVectorAbstract*, SymBitVectorAbstract*> tmp_bv_;
+  map<const SymBoolAbstract*, SymBoolAbstract*> tmp_bool_;
+};
+
+} // namespace
+
+bool BlockSummaryCache::is_summarizable(const Cfg& cfg, Cfg::id_type bb) {
+  if (cfg.num_instrs(bb) == 0)
+    return false;
+
+  size_t start_index = cfg.get_index(std::pair<Cfg::id_type, size_t>(bb, 0));
+  size_t end_index = start_index + cfg.num_instrs(bb);
+
+  for (size_t i = start_index; i < end_index; ++i) {
+    auto instr = cfg.get_code()[i];
+    if (instr.is_label_defn() || instr.is_nop() || instr.is_any_jump())
+      continue;
+    if (instr.is_memory_dereference() || instr.is_explicit_memory_dereference() ||
+        instr.is_any_return() || instr.is_any_call())
+      return false;
+  }
+  return true;
+}
+
+string BlockSummaryCache::get_key(const Cfg& cfg, Cfg::id_type bb, ObligationChecker::JumpType jump,
+                                  const LineMap& line_map, size_t line_no, bool ignore_last_line) {
+  size_t start_index = cfg.get_index(std::pair<Cfg::id_type, size_t>(bb, 0));
+  size_t end_index = start_index + cfg.num_instrs(bb);
+
+  stringstream ss;
+  ss << (int)jump << " " << ignore_last_line << endl;
+  for (size_t i = start_index; i < end_index; ++i, ++line_no) {
+    ss << cfg.get_code()[i] << " @" << line_map.at(line_no).rip_offset << endl;
+  }
+  return ss.str();
+}
+
+const SymState* BlockSummaryCache::find(const string& key) {
+  auto it = summaries_.find(key);
+  if (it == summaries_.end())
+    return NULL;
+  hits_++;
+  return &it->second->output;
+}
+
+SymState& BlockSummaryCache::begin(const string& key) {
+  assert(!summaries_.count(key));
+
+  previous_bv_manager_ = SymBitVector::get_memory_manager();
+  previous_bool_manager_ = SymBool::get_memory_manager();
+  SymBitVector::set_memory_manager(&memory_manager_);
+  SymBool::set_memory_manager(&memory_manager_);
+
+  auto summary = new Summary();
+  summaries_[key] = summary;
+  return summary->output;
+}
+
+void BlockSummaryCache::end(const string& key, bool keep) {
+  SymBitVector::set_memory_manager(previous_bv_manager_);
+  SymBool::set_memory_manager(previous_bool_manager_);
+
+  if (keep) {
+    misses_++;
+    return;
+  }
+
+  // The nodes stay with our memory manager until the next clear(); they
+  // count towards the maximum.
+  auto it = summaries_.find(key);
+  assert(it != summaries_.end());
+  delete it->second;
+  summaries_.erase(it);
+}
+
+void BlockSummaryCache::apply(const string& key, SymState& state) const {
+  auto summary = summaries_.at(key);
+  auto& input = summary->input;
+  auto& output = summary->output;
+
+  map<const SymBitVectorAbstract*, SymBitVectorAbstract*> bv_inputs;
+  map<const SymBoolAbstract*, SymBoolAbstract*> bool_inputs;
+
+  for (size_t i = 0; i < input.gp.size(); ++i)
+    bv_inputs[input.gp[i].ptr] = (SymBitVectorAbstract*)state.gp[i].ptr;
+  for (size_t i = 0; i < input.sse.size(); ++i)
+    bv_inputs[input.sse[i].ptr] = (SymBitVectorAbstract*)state.sse[i].ptr;
+  bv_inputs[input.rip.ptr] = (SymBitVectorAbstract*)state.rip.ptr;
+
+  for (size_t i = 0; i < input.rf.size(); ++i)
+    bool_inputs[input.rf[i].ptr] = (SymBoolAbstract*)state.rf[i].ptr;
+  bool_inputs[input.sigbus.ptr] = (SymBoolAbstract*)state.sigbus.ptr;
+  bool_inputs[input.sigfpe.ptr] = (SymBoolAbstract*)state.sigfpe.ptr;
+  bool_inputs[input.sigsegv.ptr] = (SymBoolAbstract*)state.sigsegv.ptr;
+
+  // The substitution is simultaneous, so read everything before writing.
+  SummaryApplier applier(bv_inputs, bool_inputs);
+
+  vector<SymBitVector> gp;
+  for (size_t i = 0; i < output.gp.size(); ++i)
+    gp.push_back(SymBitVector(applier(output.gp[i])));
+  vector<SymBitVector> sse;
+  for (size_t i = 0; i < output.sse.size(); ++i)
+    sse.push_back(SymBitVector(applier(output.sse[i])));
+  array<SymBool, 6> rf;
+  for (size_t i = 0; i < output.rf.size(); ++i)
+    rf[i] = SymBool(applier(output.rf[i]));
+  auto sigbus = SymBool(applier(output.sigbus));
+  auto sigfpe = SymBool(applier(output.sigfpe));
+  auto sigsegv = SymBool(applier(output.sigsegv));
+  auto rip = SymBitVector(applier(output.rip));
+
+  for (auto constraint : output.constraints)
+    state.constraints.push_back(SymBool(applier(constraint)));
+
+  for (size_t i = 0; i < gp.size(); ++i)
+    state.gp[i] = gp[i];
+  for (size_t i = 0; i < sse.size(); ++i)
+    state.sse[i] = sse[i];
+  state.rf = rf;
+  state.sigbus = sigbus;
+  state.sigfpe = sigfpe;
+  state.sigsegv = sigsegv;
+  state.rip = rip;
+}
+
+bool BlockSummaryCache::trim() {
+  if (memory_manager_.size() <= max_nodes_)
+    return false;
+  clear();
+  return true;
+}
+
+void BlockSummaryCache::clear() {
+  for (auto it : summaries_)
+    delete it.second;
+  summaries_.clear();
+  memory_manager_.collect();
+}
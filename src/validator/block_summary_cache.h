@@ -0,0 +1,117 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef STOKE_SRC_VALIDATOR_BLOCK_SUMMARY_CACHE_H
+#define STOKE_SRC_VALIDATOR_BLOCK_SUMMARY_CACHE_H
+
+#include <map>
+#include <string>
+
+#include "src/cfg/cfg.h"
+#include "src/symstate/memory_manager.h"
+#include "src/symstate/state.h"
+#include "src/validator/line_info.h"
+#include "src/validator/obligation_checker.h"
+
+namespace stoke {
+
+/** Caches the symbolic transfer function of a basic block.  A summary is the
+  state obtained by executing the block from a fresh, fully symbolic input
+  state; it is applied to a concrete path position by substituting the
+  incoming state's values for the input variables.  Only blocks that never
+  touch memory can be summarized, since the memory models are stateful. */
+class BlockSummaryCache {
+
+public:
+
+  BlockSummaryCache() : max_nodes_(1 << 20), hits_(0), misses_(0) {}
+
+  /** Copies start out empty; summaries are owned by their cache. */
+  BlockSummaryCache(const BlockSummaryCache& c) : max_nodes_(c.max_nodes_), hits_(0), misses_(0) {}
+
+  ~BlockSummaryCache() {
+    clear();
+  }
+
+  /** Can this basic block be summarized? */
+  static bool is_summarizable(const Cfg& cfg, Cfg::id_type bb);
+
+  /** Build the key identifying the transfer function of a block.  The key is
+    content-addressed, so identical blocks share one summary. */
+  static std::string get_key(const Cfg& cfg, Cfg::id_type bb, ObligationChecker::JumpType jump,
+                             const LineMap& line_map, size_t line_no, bool ignore_last_line);
+
+  /** Find a summary; returns NULL if there is none. */
+  const SymState* find(const std::string& key);
+
+  /** Start building a summary.  Returns a fresh input state; while the summary
+    is being built, new symbolic nodes are owned by this cache. */
+  SymState& begin(const std::string& key);
+  /** Finish building a summary.  If keep is false the summary is discarded. */
+  void end(const std::string& key, bool keep);
+
+  /** Compose a summary onto a symbolic state. */
+  void apply(const std::string& key, SymState& state) const;
+
+  /** Discard all summaries. */
+  void clear();
+
+  /** Most symbolic nodes to hold before trim() discards the summaries. */
+  BlockSummaryCache& set_max_nodes(size_t n) {
+    max_nodes_ = n;
+    return *this;
+  }
+  /** Discard all summaries if they hold more than the maximum number of
+    nodes; returns whether they were.  The nodes can only be freed all at
+    once, and states built by apply() may share them, so call this only when
+    no such state is in use. */
+  bool trim();
+
+  /** Number of summaries reused. */
+  size_t get_hits() const {
+    return hits_;
+  }
+  /** Number of summaries built. */
+  size_t get_misses() const {
+    return misses_;
+  }
+
+private:
+
+  struct Summary {
+    /** The fresh state the block was executed from. */
+    SymState input;
+    /** The state after executing the block. */
+    SymState output;
+
+    Summary() : input("BBSUM"), output(input) {}
+  };
+
+  /** Summaries, by key. */
+  std::map<std::string, Summary*> summaries_;
+  /** Owns the symbolic nodes of all summaries. */
+  SymMemoryManager memory_manager_;
+  /** The memory managers that were installed before begin() was called. */
+  SymMemoryManager* previous_bv_manager_;
+  SymMemoryManager* previous_bool_manager_;
+
+  size_t max_nodes_;
+  size_t hits_;
+  size_t misses_;
+
+};
+
+} // namespace stoke
+
+#endif
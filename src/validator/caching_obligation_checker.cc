@@ -0,0 +1,136 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cassert>
+#include <iostream>
+#include <sstream>
+
+#include "src/validator/caching_obligation_checker.h"
+#include "tools/common/version_info.h"
+
+using namespace std;
+using namespace stoke;
+
+string CachingObligationChecker::get_key(const Cfg& target, const Cfg& rewrite,
+    Cfg::id_type target_block, Cfg::id_type rewrite_block,
+    const CfgPath& p, const CfgPath& q,
+    std::shared_ptr<Invariant> assume, std::shared_ptr<Invariant> prove,
+    bool override_separate_stack) {
+
+  auto hash = hash_obligation(target, rewrite, target_block, rewrite_block, p, q,
+                              assume, prove, separate_stack_ || override_separate_stack);
+  return ResultStore::make_key(hash, solver_, get_alias_strategy(), get_settings());
+}
+
+string CachingObligationChecker::get_settings() {
+  stringstream ss;
+  ss << "nacl " << nacl_ << endl;
+  ss << "basic_block_ghosts " << basic_block_ghosts_ << endl;
+  ss << "fixpoint_up " << fixpoint_up_ << endl;
+  ss << "filter " << get_filter().get_config() << endl;
+  ss << "version " << version_info << endl;
+  return ss.str();
+}
+
+bool CachingObligationChecker::lookup(const string& key, Callback& callback, void* optional) {
+  Result result;
+  if (!store_.get(key, result))
+    return false;
+
+  hits_++;
+  result.comments = "from result store";
+  callback(result, optional);
+  return true;
+}
+
+CachingObligationChecker::Pending* CachingObligationChecker::make_pending(const string& key,
+    Callback& callback, void* optional) {
+  misses_++;
+  auto pending = new Pending();
+  pending->key = key;
+  pending->callback = &callback;
+  pending->optional = optional;
+  pending_.insert(pending);
+  return pending;
+}
+
+void CachingObligationChecker::record(Result& result, void* optional) {
+  auto pending = (Pending*)optional;
+
+  // Errors (e.g. a solver timeout) may go away on another run; don't keep them.
+  if (!result.has_error && (result.verified || result.has_ceg)) {
+    if (!store_.put(pending->key, result))
+      cout << "[result store] " << store_.get_error() << endl;
+  }
+
+  auto callback = pending->callback;
+  auto real_optional = pending->optional;
+  pending_.erase(pending);
+  delete pending;
+
+  (*callback)(result, real_optional);
+}
+
+void CachingObligationChecker::check(const Cfg& target, const Cfg& rewrite,
+                                     Cfg::id_type target_block, Cfg::id_type rewrite_block,
+                                     const CfgPath& p, const CfgPath& q,
+                                     std::shared_ptr<Invariant> assume, std::shared_ptr<Invariant> prove,
+                                     const std::vector<std::pair<CpuState, CpuState>>& testcases,
+                                     Callback& callback,
+                                     bool override_separate_stack,
+                                     void* optional) {
+
+  auto key = get_key(target, rewrite, target_block, rewrite_block, p, q,
+                     assume, prove, override_separate_stack);
+  if (lookup(key, callback, optional))
+    return;
+
+  auto pending = make_pending(key, callback, optional);
+  child_.check(target, rewrite, target_block, rewrite_block, p, q,
+               assume, prove, testcases, record_callback_, override_separate_stack, pending);
+}
+
+void CachingObligationChecker::check_batch(const Cfg& target, const Cfg& rewrite,
+    Cfg::id_type target_block, Cfg::id_type rewrite_block,
+    const CfgPath& p, const CfgPath& q,
+    std::shared_ptr<Invariant> assume, std::shared_ptr<ConjunctionInvariant> prove,
+    const std::vector<std::pair<CpuState, CpuState>>& testcases,
+    Callback& callback,
+    bool override_separate_stack,
+    const std::vector<void*>& optionals) {
+
+  assert(prove->size() == optionals.size());
+
+  // Only the conjuncts the store can't answer go to the wrapped checker.
+  auto remaining = make_shared<ConjunctionInvariant>();
+  vector<void*> remaining_optionals;
+
+  for (size_t i = 0; i < prove->size(); ++i) {
+    auto conjunct = (*prove)[i];
+    auto key = get_key(target, rewrite, target_block, rewrite_block, p, q,
+                       assume, conjunct, override_separate_stack);
+    if (lookup(key, callback, optionals[i]))
+      continue;
+
+    remaining->add_invariant(conjunct);
+    remaining_optionals.push_back(make_pending(key, callback, optionals[i]));
+  }
+
+  if (remaining->size() == 0)
+    return;
+
+  child_.check_batch(target, rewrite, target_block, rewrite_block, p, q,
+                     assume, remaining, testcases, record_callback_,
+                     override_separate_stack, remaining_optionals);
+}
@@ -0,0 +1,172 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef STOKE_SRC_VALIDATOR_CACHING_OBLIGATION_CHECKER_H
+#define STOKE_SRC_VALIDATOR_CACHING_OBLIGATION_CHECKER_H
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "src/solver/solver.h"
+#include "src/validator/obligation_checker.h"
+#include "src/validator/result_store.h"
+
+namespace stoke {
+
+/** Answers obligations from a persistent ResultStore when it can, and
+  otherwise forwards them to another checker and records the definitive
+  (verified or counterexample) results.  The store is shared across runs, so
+  keys include the checker's settings and the source version. */
+class CachingObligationChecker : public ObligationChecker {
+
+public:
+
+  /** The solver is part of the key, because the wrapped checker doesn't expose it. */
+  CachingObligationChecker(ObligationChecker& child, ResultStore& store, Solver solver) :
+    ObligationChecker(), child_(child), store_(store), solver_(solver), hits_(0), misses_(0)
+  {
+    record_callback_ = [this] (Result& result, void* optional) {
+      record(result, optional);
+    };
+  }
+
+  ~CachingObligationChecker() {
+    delete_all();
+  }
+
+  ObligationChecker& set_alias_strategy(AliasStrategy as) override {
+    child_.set_alias_strategy(as);
+    return *this;
+  }
+
+  AliasStrategy get_alias_strategy() override {
+    return child_.get_alias_strategy();
+  }
+
+  ObligationChecker& set_fixpoint_up(bool b) override {
+    child_.set_fixpoint_up(b);
+    fixpoint_up_ = b;
+    return *this;
+  }
+
+  ObligationChecker& set_separate_stack(bool b) override {
+    child_.set_separate_stack(b);
+    separate_stack_ = b;
+    return *this;
+  }
+
+  ObligationChecker& set_nacl(bool b) override {
+    child_.set_nacl(b);
+    nacl_ = b;
+    return *this;
+  }
+
+  ObligationChecker& set_basic_block_ghosts(bool b) override {
+    child_.set_basic_block_ghosts(b);
+    basic_block_ghosts_ = b;
+    return *this;
+  }
+
+  void check(const Cfg& target, const Cfg& rewrite,
+             Cfg::id_type target_block, Cfg::id_type rewrite_block,
+             const CfgPath& p, const CfgPath& q,
+             std::shared_ptr<Invariant> assume, std::shared_ptr<Invariant> prove,
+             const std::vector<std::pair<CpuState, CpuState>>& testcases,
+             Callback& callback,
+             bool override_separate_stack,
+             void* optional) override;
+
+  void check_batch(const Cfg& target, const Cfg& rewrite,
+                   Cfg::id_type target_block, Cfg::id_type rewrite_block,
+                   const CfgPath& p, const CfgPath& q,
+                   std::shared_ptr<Invariant> assume, std::shared_ptr<ConjunctionInvariant> prove,
+                   const std::vector<std::pair<CpuState, CpuState>>& testcases,
+                   Callback& callback,
+                   bool override_separate_stack,
+                   const std::vector<void*>& optionals) override;
+
+  void check_for_callbacks() override {
+    child_.check_for_callbacks();
+  }
+
+  void block_until_complete() override {
+    child_.block_until_complete();
+  }
+
+  void delete_all() override {
+    child_.delete_all();
+    for (auto it : pending_)
+      delete it;
+    pending_.clear();
+  }
+
+  Filter& get_filter() override {
+    return child_.get_filter();
+  }
+
+  /** Number of obligations answered from the store. */
+  size_t get_hits() const {
+    return hits_;
+  }
+  /** Number of obligations forwarded to the wrapped checker. */
+  size_t get_misses() const {
+    return misses_;
+  }
+
+private:
+
+  /** A forwarded obligation waiting for its result. */
+  struct Pending {
+    std::string key;
+    Callback* callback;
+    void* optional;
+  };
+
+  /** Compute the store key of an obligation. */
+  std::string get_key(const Cfg& target, const Cfg& rewrite,
+                      Cfg::id_type target_block, Cfg::id_type rewrite_block,
+                      const CfgPath& p, const CfgPath& q,
+                      std::shared_ptr<Invariant> assume, std::shared_ptr<Invariant> prove,
+                      bool override_separate_stack);
+
+  /** Describe everything besides the obligation that changes its verdict:
+    the checker's options, the filter and the source version. */
+  std::string get_settings();
+
+  /** Look up an obligation; on a hit, invoke the callback. */
+  bool lookup(const std::string& key, Callback& callback, void* optional);
+  /** Make the bookkeeping for a forwarded obligation. */
+  Pending* make_pending(const std::string& key, Callback& callback, void* optional);
+
+  /** Store a result from the wrapped checker and pass it on. */
+  void record(Result& result, void* optional);
+
+  ObligationChecker& child_;
+  ResultStore& store_;
+  Solver solver_;
+
+  /** Callback handed to the wrapped checker. */
+  Callback record_callback_;
+  /** Obligations forwarded and not yet answered. */
+  std::set<Pending*> pending_;
+
+  size_t hits_;
+  size_t misses_;
+
+};
+
+} // namespace stoke
+
+#endif
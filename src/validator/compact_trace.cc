@@ -0,0 +1,281 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cassert>
+#include <cstring>
+
+#include "src/serialize/serialize.h"
+#include "src/validator/compact_trace.h"
+
+using namespace std;
+using namespace stoke;
+
+constexpr size_t CompactTrace::page_size;
+
+namespace {
+
+/** Memory only hands out its buffers through non-const accessors; these
+  are only ever read from. */
+uint8_t* contents(const Memory& m) {
+  return (uint8_t*)const_cast<Memory&>(m).data();
+}
+uint8_t* valid_bits(const Memory& m) {
+  return (uint8_t*)const_cast<Memory&>(m).valid_mask();
+}
+
+/** Bytes in the buffer of a memory, including headroom. */
+size_t buffer_size(const Memory& m) {
+  return m.size() + 32;
+}
+
+void write_regs(ostream& os, const Regs& regs) {
+  for (size_t i = 0; i < regs.size(); ++i)
+    for (size_t j = 0; j < regs[i].num_fixed_bytes()/8; ++j)
+      os << regs[i].get_fixed_quad(j) << " ";
+}
+
+void read_regs(istream& is, Regs& regs) {
+  for (size_t i = 0; i < regs.size(); ++i)
+    for (size_t j = 0; j < regs[i].num_fixed_bytes()/8; ++j)
+      is >> regs[i].get_fixed_quad(j);
+}
+
+} // namespace
+
+CompactTrace::Registers::Registers(const CpuState& cs) :
+  code(cs.code), gp(cs.gp), sse(cs.sse), rf(cs.rf), shadow(cs.shadow),
+  jumps_seen(cs.jumps_seen), latency_seen(cs.latency_seen) { }
+
+void CompactTrace::Registers::copy_to(CpuState& cs) const {
+  cs.code = code;
+  cs.gp = gp;
+  cs.sse = sse;
+  cs.rf = rf;
+  cs.shadow = shadow;
+  cs.jumps_seen = jumps_seen;
+  cs.latency_seen = latency_seen;
+}
+
+void CompactTrace::Registers::write(ostream& os) const {
+  os << (int)code << " " << jumps_seen << " " << latency_seen << " ";
+  write_regs(os, gp);
+  write_regs(os, sse);
+  for (size_t i = 0; i < rf.size(); ++i)
+    os << rf.is_set(i);
+  os << " " << shadow.size() << endl;
+  for (auto& it : shadow)
+    os << it.first << " " << it.second << endl;
+}
+
+void CompactTrace::Registers::read(istream& is) {
+  int c;
+  is >> c >> jumps_seen >> latency_seen;
+  code = (ErrorCode)c;
+  read_regs(is, gp);
+  read_regs(is, sse);
+  string flags;
+  is >> flags;
+  for (size_t i = 0; i < rf.size() && i < flags.size(); ++i)
+    rf.set(i, flags[i] == '1');
+  size_t n;
+  is >> n;
+  shadow.clear();
+  for (size_t i = 0; i < n; ++i) {
+    string name;
+    is >> name;
+    is >> shadow[name];
+  }
+}
+
+vector<Memory*> CompactTrace::get_regions(CpuState& cs) {
+  vector<Memory*> regions = { &cs.stack, &cs.heap, &cs.data };
+  for (auto& it : cs.segments)
+    regions.push_back(&it);
+  return regions;
+}
+
+bool CompactTrace::same_layout(CpuState& a, CpuState& b) {
+  auto a_regions = get_regions(a);
+  auto b_regions = get_regions(b);
+  if (a_regions.size() != b_regions.size())
+    return false;
+  for (size_t i = 0; i < a_regions.size(); ++i) {
+    if (a_regions[i]->lower_bound() != b_regions[i]->lower_bound() ||
+        a_regions[i]->size() != b_regions[i]->size())
+      return false;
+  }
+  return true;
+}
+
+void CompactTrace::push_back(Cfg::id_type block_id, size_t line_number, const CpuState& cs) {
+  assert(!finished_);
+
+  Point point;
+  point.block_id = block_id;
+  point.line_number = line_number;
+  point.registers = Registers(cs);
+  point.snapshot = -1;
+  point.first_page = pages_.size();
+  point.page_count = 0;
+
+  auto& current = const_cast<CpuState&>(cs);
+  if (points_.empty() || !same_layout(last_, current)) {
+    point.snapshot = snapshots_.size();
+    snapshots_.push_back(cs);
+    last_ = cs;
+    points_.push_back(point);
+    return;
+  }
+
+  auto last_regions = get_regions(last_);
+  auto current_regions = get_regions(current);
+  for (size_t r = 0; r < current_regions.size(); ++r) {
+    size_t total = buffer_size(*current_regions[r]);
+    uint8_t* old_bytes = contents(*last_regions[r]);
+    uint8_t* new_bytes = contents(*current_regions[r]);
+    uint8_t* old_valid = valid_bits(*last_regions[r]);
+    uint8_t* new_valid = valid_bits(*current_regions[r]);
+
+    for (size_t offset = 0; offset < total; offset += page_size) {
+      // buffers are a whole number of quads, so valid bits come in whole bytes
+      size_t length = total - offset < page_size ? total - offset : page_size;
+      if (!memcmp(old_bytes + offset, new_bytes + offset, length) &&
+          !memcmp(old_valid + offset/8, new_valid + offset/8, length/8))
+        continue;
+
+      Page page;
+      page.region = r;
+      page.offset = offset;
+      page.length = length;
+      page.position = pool_.size();
+      pool_.insert(pool_.end(), new_bytes + offset, new_bytes + offset + length);
+      pool_.insert(pool_.end(), new_valid + offset/8, new_valid + (offset + length)/8);
+      pages_.push_back(page);
+      point.page_count++;
+    }
+  }
+
+  points_.push_back(point);
+
+  // bring the working copy up to date the cheap way
+  point.registers.copy_to(last_);
+  apply_pages(point, last_);
+}
+
+void CompactTrace::finish() {
+  finished_ = true;
+  last_ = CpuState();
+}
+
+CfgPath CompactTrace::get_path() const {
+  CfgPath path;
+  for (auto& it : points_)
+    path.push_back(it.block_id);
+  return path;
+}
+
+void CompactTrace::apply_pages(const Point& point, CpuState& cs) const {
+  auto regions = get_regions(cs);
+  for (size_t i = point.first_page; i < point.first_page + point.page_count; ++i) {
+    auto& page = pages_[i];
+    auto region = regions[page.region];
+    const uint8_t* data = pool_.data() + page.position;
+    memcpy(contents(*region) + page.offset, data, page.length);
+    memcpy(valid_bits(*region) + page.offset/8, data + page.length, page.length/8);
+  }
+}
+
+void CompactTrace::next_state(size_t i, CpuState& cs) const {
+  auto& point = points_[i];
+  if (point.snapshot >= 0) {
+    cs = snapshots_[point.snapshot];
+    return;
+  }
+  point.registers.copy_to(cs);
+  apply_pages(point, cs);
+}
+
+void CompactTrace::get_state(size_t i, CpuState& cs) const {
+  size_t start = i;
+  while (points_[start].snapshot < 0)
+    start--;
+  cs = snapshots_[points_[start].snapshot];
+  for (size_t j = start + 1; j <= i; ++j)
+    next_state(j, cs);
+}
+
+size_t CompactTrace::get_memory_bytes() const {
+  size_t total = pool_.size();
+  for (auto& it : snapshots_) {
+    auto& state = const_cast<CpuState&>(it);
+    for (auto region : get_regions(state))
+      total += buffer_size(*region) + buffer_size(*region)/8;
+  }
+  return total;
+}
+
+void CompactTrace::serialize(ostream& os) const {
+  assert(finished_);
+
+  os << points_.size() << endl;
+  for (auto& it : points_) {
+    os << it.block_id << " " << it.line_number << " " << it.snapshot << " "
+       << it.first_page << " " << it.page_count << " ";
+    it.registers.write(os);
+  }
+
+  os << snapshots_.size() << endl;
+  for (auto& it : snapshots_)
+    stoke::serialize<CpuState>(os, it);
+
+  os << pages_.size() << endl;
+  for (auto& it : pages_)
+    os << it.region << " " << it.offset << " " << it.length << " " << it.position << endl;
+
+  os << pool_.size() << endl;
+  os.write((const char*)pool_.data(), pool_.size());
+  os << endl;
+}
+
+CompactTrace CompactTrace::deserialize(istream& is) {
+  CompactTrace trace;
+  trace.finished_ = true;
+
+  size_t n;
+  is >> n;
+  trace.points_.resize(n);
+  for (auto& it : trace.points_) {
+    is >> it.block_id >> it.line_number >> it.snapshot >> it.first_page >> it.page_count;
+    it.registers.read(is);
+  }
+
+  is >> n;
+  // CpuState::deserialize reads whole lines
+  string rest;
+  getline(is, rest);
+  for (size_t i = 0; i < n; ++i)
+    trace.snapshots_.push_back(stoke::deserialize<CpuState>(is));
+
+  is >> n;
+  trace.pages_.resize(n);
+  for (auto& it : trace.pages_)
+    is >> it.region >> it.offset >> it.length >> it.position;
+
+  is >> n;
+  is.get();
+  trace.pool_.resize(n);
+  is.read((char*)trace.pool_.data(), n);
+
+  return trace;
+}
@@ -0,0 +1,134 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef STOKE_SRC_VALIDATOR_COMPACT_TRACE_H
+#define STOKE_SRC_VALIDATOR_COMPACT_TRACE_H
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "src/cfg/cfg.h"
+#include "src/cfg/paths.h"
+#include "src/state/cpu_state.h"
+
+namespace stoke {
+
+/** The states a testcase passes through at each block entry, kept as full
+  snapshots only where the memory layout changes (normally just the first
+  point).  Every other point keeps its registers and the 64 byte pages of
+  memory that differ from the point before; states are rebuilt on demand. */
+class CompactTrace {
+
+public:
+
+  CompactTrace() : finished_(false) { }
+
+  /** Size of the memory pages compared between points, in bytes. */
+  static constexpr size_t page_size = 64;
+
+  /** Add a point to the end of the trace. */
+  void push_back(Cfg::id_type block_id, size_t line_number, const CpuState& cs);
+  /** Call once the last point is in, to release the working copy kept for
+    computing differences. */
+  void finish();
+
+  /** Number of points. */
+  size_t size() const {
+    return points_.size();
+  }
+  /** Block at a point. */
+  Cfg::id_type get_block(size_t i) const {
+    return points_[i].block_id;
+  }
+  /** Line number at a point. */
+  size_t get_line_number(size_t i) const {
+    return points_[i].line_number;
+  }
+  /** The blocks of the trace, in order. */
+  CfgPath get_path() const;
+
+  /** Rebuild the state at a point. */
+  void get_state(size_t i, CpuState& cs) const;
+  /** Turn the state at point i-1 into the state at point i. */
+  void next_state(size_t i, CpuState& cs) const;
+
+  /** Bytes of memory held in snapshots and pages; registers not included. */
+  size_t get_memory_bytes() const;
+
+  /** Write a finished trace; the pages are written as raw bytes. */
+  void serialize(std::ostream& os) const;
+  static CompactTrace deserialize(std::istream& is);
+
+private:
+
+  /** Everything in a CpuState but memory. */
+  struct Registers {
+    ErrorCode code;
+    Regs gp;
+    Regs sse;
+    RFlags rf;
+    std::map<std::string, uint64_t> shadow;
+    uint64_t jumps_seen;
+    uint64_t latency_seen;
+
+    Registers() : gp(16, 64), sse(16, 256) { }
+    Registers(const CpuState& cs);
+    void copy_to(CpuState& cs) const;
+
+    void write(std::ostream& os) const;
+    void read(std::istream& is);
+  };
+
+  /** One page of one memory region that changed. */
+  struct Page {
+    size_t region;
+    size_t offset;
+    size_t length;
+    /** Where the contents, then the valid bits, are in pool_. */
+    size_t position;
+  };
+
+  struct Point {
+    Cfg::id_type block_id;
+    size_t line_number;
+    Registers registers;
+    /** Index in snapshots_, or -1 for a point stored as pages. */
+    long snapshot;
+    size_t first_page;
+    size_t page_count;
+  };
+
+  /** The stack, heap, data and other segments of a state. */
+  static std::vector<Memory*> get_regions(CpuState& cs);
+  /** Do two states have the same memory regions at the same places? */
+  static bool same_layout(CpuState& a, CpuState& b);
+  /** Copy the pages of a point into a state. */
+  void apply_pages(const Point& point, CpuState& cs) const;
+
+  std::vector<Point> points_;
+  std::vector<CpuState> snapshots_;
+  std::vector<Page> pages_;
+  std::vector<uint8_t> pool_;
+
+  /** The state at the last point, while the trace is being built. */
+  CpuState last_;
+  bool finished_;
+
+};
+
+} // namespace stoke
+
+#endif
@@ -0,0 +1,229 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cassert>
+
+#include "src/validator/compiled_invariant.h"
+
+using namespace std;
+using namespace stoke;
+
+namespace {
+
+/** Compare two columns after casting each side to T. */
+template <typename T>
+void compare_rows(const vector<uint64_t>& a, uint64_t a_constant,
+                  const vector<uint64_t>& b, bool strict, vector<uint8_t>& out) {
+  for (size_t i = 0; i < out.size(); ++i) {
+    T lhs = (T)(a[i] + a_constant);
+    T rhs = (T)b[i];
+    out[i] = strict ? lhs < rhs : lhs <= rhs;
+  }
+}
+
+} // namespace
+
+CompiledInvariant::CompiledInvariant(shared_ptr<Invariant> invariant) : invariant_(invariant) {
+  invariant->compile(*this);
+}
+
+void CompiledInvariant::linear(const vector<Variable>& terms, uint64_t constant, uint64_t modulus) {
+  Op op(Op::LINEAR);
+  op.vars = terms;
+  op.constant = constant;
+  op.modulus = modulus;
+  ops_.push_back(op);
+}
+
+void CompiledInvariant::compare(const Variable& a, uint64_t a_constant, const Variable& b,
+                                size_t signed_bits, bool strict) {
+  assert(signed_bits == 0 || signed_bits == 8 || signed_bits == 16 ||
+         signed_bits == 32 || signed_bits == 64);
+  Op op(Op::COMPARE);
+  op.vars = { a, b };
+  op.constant = a_constant;
+  op.bits = signed_bits;
+  op.flag = strict;
+  ops_.push_back(op);
+}
+
+void CompiledInvariant::bound(const Variable& v, uint64_t bound, bool upper, bool is_signed) {
+  Op op(Op::BOUND);
+  op.vars = { v };
+  op.constant = bound;
+  op.flag = upper;
+  op.is_signed = is_signed;
+  ops_.push_back(op);
+}
+
+void CompiledInvariant::mask_zero(const Variable& v, uint64_t mask) {
+  Op op(Op::MASK_ZERO);
+  op.vars = { v };
+  op.constant = mask;
+  ops_.push_back(op);
+}
+
+void CompiledInvariant::constant(bool b) {
+  Op op(Op::CONSTANT);
+  op.flag = b;
+  ops_.push_back(op);
+}
+
+void CompiledInvariant::fallback(const Invariant& inv) {
+  Op op(Op::FALLBACK);
+  op.invariant = &inv;
+  ops_.push_back(op);
+}
+
+void CompiledInvariant::conjoin(size_t n) {
+  Op op(Op::AND);
+  op.bits = n;
+  ops_.push_back(op);
+}
+
+void CompiledInvariant::disjoin(size_t n) {
+  Op op(Op::OR);
+  op.bits = n;
+  ops_.push_back(op);
+}
+
+void CompiledInvariant::negate() {
+  ops_.push_back(Op(Op::NOT));
+}
+
+size_t CompiledInvariant::fallbacks() const {
+  size_t count = 0;
+  for (auto& op : ops_)
+    if (op.kind == Op::FALLBACK)
+      count++;
+  return count;
+}
+
+void CompiledInvariant::evaluate_op(const Op& op, StateColumns& data, vector<uint8_t>& out) {
+  switch (op.kind) {
+  case Op::LINEAR: {
+    vector<uint64_t> sum(out.size(), 0);
+    for (auto& v : op.vars) {
+      auto& column = data.get(v);
+      uint64_t coefficient = v.coefficient;
+      for (size_t i = 0; i < sum.size(); ++i)
+        sum[i] += coefficient*column[i];
+    }
+    for (size_t i = 0; i < out.size(); ++i) {
+      if (op.modulus == 0)
+        out[i] = sum[i] == op.constant;
+      else
+        out[i] = (op.constant - sum[i]) % op.modulus == 0;
+    }
+    break;
+  }
+
+  case Op::COMPARE: {
+    auto& a = data.get(op.vars[0]);
+    auto& b = data.get(op.vars[1]);
+    switch (op.bits) {
+    case 0:
+      compare_rows<uint64_t>(a, op.constant, b, op.flag, out);
+      break;
+    case 8:
+      compare_rows<int8_t>(a, op.constant, b, op.flag, out);
+      break;
+    case 16:
+      compare_rows<int16_t>(a, op.constant, b, op.flag, out);
+      break;
+    case 32:
+      compare_rows<int32_t>(a, op.constant, b, op.flag, out);
+      break;
+    default:
+      compare_rows<int64_t>(a, op.constant, b, op.flag, out);
+      break;
+    }
+    break;
+  }
+
+  case Op::BOUND: {
+    auto& column = data.get(op.vars[0]);
+    for (size_t i = 0; i < out.size(); ++i) {
+      if (op.is_signed)
+        out[i] = op.flag ? (int64_t)column[i] <= (int64_t)op.constant
+                 : (int64_t)op.constant <= (int64_t)column[i];
+      else
+        out[i] = op.flag ? column[i] <= op.constant : op.constant <= column[i];
+    }
+    break;
+  }
+
+  case Op::MASK_ZERO: {
+    auto& column = data.get(op.vars[0]);
+    for (size_t i = 0; i < out.size(); ++i)
+      out[i] = (column[i] & op.constant) == 0;
+    break;
+  }
+
+  case Op::CONSTANT:
+    for (size_t i = 0; i < out.size(); ++i)
+      out[i] = op.flag;
+    break;
+
+  case Op::FALLBACK:
+    for (size_t i = 0; i < out.size(); ++i)
+      out[i] = op.invariant->check(data.target(i), data.rewrite(i));
+    break;
+
+  default:
+    assert(false);
+  }
+}
+
+void CompiledInvariant::evaluate(StateColumns& data, vector<uint8_t>& holds) const {
+  size_t rows = data.rows();
+  vector<vector<uint8_t>> stack;
+
+  for (auto& op : ops_) {
+    if (op.kind == Op::AND || op.kind == Op::OR) {
+      bool is_and = op.kind == Op::AND;
+      assert(op.bits <= stack.size());
+      if (op.bits == 0) {
+        stack.push_back(vector<uint8_t>(rows, is_and));
+        continue;
+      }
+      size_t first = stack.size() - op.bits;
+      auto& result = stack[first];
+      for (size_t j = first + 1; j < stack.size(); ++j) {
+        for (size_t i = 0; i < rows; ++i)
+          result[i] = is_and ? result[i] & stack[j][i] : result[i] | stack[j][i];
+      }
+      stack.resize(first + 1);
+    } else if (op.kind == Op::NOT) {
+      assert(stack.size());
+      for (auto& it : stack.back())
+        it = !it;
+    } else {
+      stack.push_back(vector<uint8_t>(rows));
+      evaluate_op(op, data, stack.back());
+    }
+  }
+
+  assert(stack.size() == 1);
+  holds = stack.back();
+}
+
+bool CompiledInvariant::check(StateColumns& data) const {
+  vector<uint8_t> holds;
+  evaluate(data, holds);
+  for (auto it : holds)
+    if (!it)
+      return false;
+  return true;
+}
@@ -0,0 +1,114 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef STOKE_SRC_VALIDATOR_COMPILED_INVARIANT_H
+#define STOKE_SRC_VALIDATOR_COMPILED_INVARIANT_H
+
+#include <memory>
+#include <vector>
+
+#include "src/validator/invariant.h"
+#include "src/validator/state_columns.h"
+#include "src/validator/variable.h"
+
+namespace stoke {
+
+/** An invariant flattened into a straight-line list of operations over the
+  columns of a StateColumns, so that it's evaluated over a whole batch of
+  state pairs at once: no virtual call per pair, and each variable is read
+  out of the states only once.  Invariants emit their operations through
+  Invariant::compile; those that don't know how are checked pair by pair.
+  The invariant must not change while this is in use. */
+class CompiledInvariant {
+
+public:
+
+  CompiledInvariant(std::shared_ptr<Invariant> invariant);
+
+  /** Set holds[k] to whether the invariant holds on the k-th pair. */
+  void evaluate(StateColumns& data, std::vector<uint8_t>& holds) const;
+  /** Does the invariant hold on every pair? */
+  bool check(StateColumns& data) const;
+
+  /** Number of parts that are checked pair by pair. */
+  size_t fallbacks() const;
+
+  /** The operations below are for Invariant::compile.  Each condition pushes
+    its truth values; a connective replaces the values on top with one. */
+
+  /** The sum of the terms, with their coefficients, is the constant; or is
+    congruent to it if the modulus isn't 0. */
+  void linear(const std::vector<Variable>& terms, uint64_t constant, uint64_t modulus);
+  /** a + a_constant < b, or <= if not strict.  A signed comparison is over
+    the low signed_bits of each side; 0 is unsigned. */
+  void compare(const Variable& a, uint64_t a_constant, const Variable& b,
+               size_t signed_bits, bool strict);
+  /** v <= bound if upper, otherwise bound <= v, as 64-bit values. */
+  void bound(const Variable& v, uint64_t bound, bool upper, bool is_signed);
+  /** v & mask is 0. */
+  void mask_zero(const Variable& v, uint64_t mask);
+  /** Always (or never) holds. */
+  void constant(bool b);
+  /** Call inv.check for each pair. */
+  void fallback(const Invariant& inv);
+
+  /** All of the top n. */
+  void conjoin(size_t n);
+  /** Any of the top n. */
+  void disjoin(size_t n);
+  /** Not the top one. */
+  void negate();
+
+private:
+
+  struct Op {
+    enum Kind {
+      LINEAR,
+      COMPARE,
+      BOUND,
+      MASK_ZERO,
+      CONSTANT,
+      FALLBACK,
+      AND,
+      OR,
+      NOT
+    } kind;
+
+    std::vector<Variable> vars;
+    /** Constant term, bound or mask. */
+    uint64_t constant;
+    uint64_t modulus;
+    /** Bits of a signed comparison, or operands of a connective. */
+    size_t bits;
+    /** Strict comparison, upper bound, or constant truth value. */
+    bool flag;
+    bool is_signed;
+    const Invariant* invariant;
+
+    Op(Kind k) : kind(k), constant(0), modulus(0), bits(0), flag(false),
+      is_signed(false), invariant(NULL) { }
+  };
+
+  /** Keeps the invariant of the fallbacks alive. */
+  std::shared_ptr<Invariant> invariant_;
+  std::vector<Op> ops_;
+
+  /** Compute the truth values of a condition. */
+  static void evaluate_op(const Op& op, StateColumns& data, std::vector<uint8_t>& out);
+
+};
+
+} // namespace stoke
+
+#endif
@@ -0,0 +1,213 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cassert>
+
+#include "src/sandbox/sandbox.h"
+#include "src/validator/concrete_falsifier.h"
+#include "src/validator/invariants/flag.h"
+#include "src/validator/line_info.h"
+#include "src/validator/obligation_checker.h"
+#include "src/validator/path_unroller.h"
+
+using namespace std;
+using namespace stoke;
+using namespace x64asm;
+
+namespace {
+
+/** A conditional jump of a path, checked when the sandbox gets to it. */
+struct JumpCheck {
+  shared_ptr<Invariant> taken;
+  bool* on_path;
+};
+
+void jump_callback(const StateCallbackData& data, void* arg) {
+  auto check = (JumpCheck*)arg;
+  if (!check->taken->check(data.state, data.state))
+    *check->on_path = false;
+}
+
+/** Runs one program along a path.  The unrolled code has its jumps replaced
+  by nops, so each conditional jump is checked against the path instead. */
+class PathRunner {
+
+public:
+
+  PathRunner(const Cfg& cfg, Cfg::id_type end_block, const CfgPath& P, bool is_rewrite) {
+    LineMap linemap;
+    Code unroll;
+    PathUnroller::generate_linemap(cfg, P, linemap, is_rewrite, unroll);
+
+    Cfg unroll_cfg(unroll, cfg.def_ins(), cfg.live_outs());
+    auto label = unroll_cfg.get_function().get_leading_label();
+    sandbox_.set_abi_check(false);
+    sandbox_.set_stack_check(false);
+    sandbox_.set_linemap(linemap);
+    sandbox_.insert_function(unroll_cfg);
+    sandbox_.set_entrypoint(label);
+
+    // A conditional jump can only end a block, so the ones along the path
+    // come up in the unrolled code in the same order.
+    auto& code = cfg.get_code();
+    vector<ObligationChecker::JumpType> jumps;
+    for (size_t i = 0; i < P.size(); ++i) {
+      auto count = cfg.num_instrs(P[i]);
+      if (count && code[cfg.get_index(Cfg::loc_type(P[i], count - 1))].is_jcc())
+        jumps.push_back(ObligationChecker::is_jump(cfg, end_block, P, i));
+    }
+
+    size_t next = 0;
+    vector<size_t> lines;
+    for (size_t i = 0; i + 1 < unroll.size(); ++i) {
+      auto& instr = code[linemap[i].line_number];
+      if (unroll[i].is_label_defn() || !instr.is_jcc())
+        continue;
+      assert(next < jumps.size());
+      auto type = jumps[next++];
+      if (type == ObligationChecker::JumpType::NONE)
+        continue;
+
+      bool fallthrough = type == ObligationChecker::JumpType::FALL_THROUGH;
+      checks_.push_back({ make_shared<FlagInvariant>(instr, is_rewrite, fallthrough), &on_path_ });
+      lines.push_back(i);
+    }
+    for (size_t i = 0; i < lines.size(); ++i)
+      sandbox_.insert_before(label, lines[i], jump_callback, &checks_[i]);
+  }
+
+  PathRunner(const PathRunner&) = delete;
+  PathRunner& operator=(const PathRunner&) = delete;
+
+  /** Run from a start state.  Returns whether the run stays on the path and
+    ends normally. */
+  bool run(const CpuState& start, CpuState& end) {
+    sandbox_.clear_inputs();
+    sandbox_.insert_input(start);
+    on_path_ = true;
+    sandbox_.run(0);
+    end = *sandbox_.get_output(0);
+    return on_path_ && end.code == ErrorCode::NORMAL;
+  }
+
+private:
+
+  Sandbox sandbox_;
+  vector<JumpCheck> checks_;
+  bool on_path_;
+
+};
+
+/** One of a few ways to change a value; arg picks among the choices. */
+uint64_t mutate_value(uint64_t value, size_t op, uint64_t arg) {
+  switch (op) {
+  case 0:
+    return arg;
+  case 1:
+    return value + (arg % 17) - 8;
+  case 2:
+    return value ^ ((uint64_t)1 << (arg % 64));
+  default:
+    return arg % 3 - 1;
+  }
+}
+
+} // namespace
+
+void ConcreteFalsifier::add(const CpuState& target_start, const CpuState& rewrite_start) {
+  if (capacity_ == 0)
+    return;
+  pool_.push_back(make_pair(target_start, rewrite_start));
+  if (pool_.size() > capacity_)
+    pool_.pop_front();
+}
+
+void ConcreteFalsifier::mutate(CpuState& target, CpuState& rewrite) {
+  // Moving the stack away only makes the run fault
+  R64 r = rsp;
+  while (r == rsp)
+    r = r64s[gen_() % r64s.size()];
+
+  size_t op = gen_() % 4;
+  uint64_t arg = gen_();
+  size_t sides = gen_() % 3;
+  if (sides != 1)
+    target.gp[r].get_fixed_quad(0) = mutate_value(target.gp[r].get_fixed_quad(0), op, arg);
+  if (sides != 0)
+    rewrite.gp[r].get_fixed_quad(0) = mutate_value(rewrite.gp[r].get_fixed_quad(0), op, arg);
+}
+
+map<size_t, ConcreteFalsifier::Counterexample> ConcreteFalsifier::falsify(
+  const Cfg& target, const Cfg& rewrite,
+  Cfg::id_type target_block, Cfg::id_type rewrite_block,
+  const CfgPath& P, const CfgPath& Q,
+  shared_ptr<Invariant> assume,
+  const vector<shared_ptr<Invariant>>& proves,
+  const vector<pair<CpuState, CpuState>>& testcases) {
+
+  map<size_t, Counterexample> found;
+  if (trials_ == 0 || proves.empty())
+    return found;
+
+  auto seeds = testcases;
+  seeds.insert(seeds.end(), pool_.begin(), pool_.end());
+  if (seeds.empty())
+    return found;
+
+  PathRunner target_runner(target, target_block, P, false);
+  PathRunner rewrite_runner(rewrite, rewrite_block, Q, true);
+
+  // The seeds go first, as they are; then mutants of them.  Mutants that
+  // fail the assumption aren't run, but there's a bound on those too.
+  size_t runs = 0;
+  for (size_t attempt = 0; runs < trials_ && attempt < 4*trials_; ++attempt) {
+    if (found.size() == proves.size())
+      break;
+
+    Counterexample ceg;
+    if (attempt < seeds.size()) {
+      ceg.target_start = seeds[attempt].first;
+      ceg.rewrite_start = seeds[attempt].second;
+    } else {
+      auto& seed = seeds[gen_() % seeds.size()];
+      ceg.target_start = seed.first;
+      ceg.rewrite_start = seed.second;
+      for (size_t i = gen_() % 3; i < 3; ++i)
+        mutate(ceg.target_start, ceg.rewrite_start);
+    }
+
+    if (!assume->check(ceg.target_start, ceg.rewrite_start))
+      continue;
+    runs++;
+
+    if (!target_runner.run(ceg.target_start, ceg.target_end) ||
+        !rewrite_runner.run(ceg.rewrite_start, ceg.rewrite_end))
+      continue;
+
+    bool hit = false;
+    for (size_t i = 0; i < proves.size(); ++i) {
+      if (found.count(i) || proves[i]->check(ceg.target_end, ceg.rewrite_end))
+        continue;
+      found[i] = ceg;
+      hit = true;
+    }
+
+    // the pool already has its own seeds
+    bool from_pool = attempt >= testcases.size() && attempt < seeds.size();
+    if (hit && !from_pool)
+      add(ceg.target_start, ceg.rewrite_start);
+  }
+
+  return found;
+}
@@ -0,0 +1,98 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef STOKE_SRC_VALIDATOR_CONCRETE_FALSIFIER_H
+#define STOKE_SRC_VALIDATOR_CONCRETE_FALSIFIER_H
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "src/cfg/cfg.h"
+#include "src/cfg/paths.h"
+#include "src/state/cpu_state.h"
+#include "src/validator/invariant.h"
+
+namespace stoke {
+
+/** Looks for counterexamples to proof obligations by running the paths of
+  the target and rewrite on concrete start states that satisfy the assumed
+  invariant.  Start states come from the testcases of the obligation, from
+  the start states of earlier counterexamples, and from random mutations of
+  both.  A run only counts if the sandbox takes every jump the way the path
+  does and ends normally, so anything found is a real counterexample. */
+class ConcreteFalsifier {
+
+public:
+
+  struct Counterexample {
+    CpuState target_start;
+    CpuState rewrite_start;
+    CpuState target_end;
+    CpuState rewrite_end;
+  };
+
+  ConcreteFalsifier() : trials_(1000), capacity_(64), gen_(0) { }
+
+  /** Set the most start states to run per obligation; 0 turns it off. */
+  ConcreteFalsifier& set_trials(size_t n) {
+    trials_ = n;
+    return *this;
+  }
+  size_t get_trials() const {
+    return trials_;
+  }
+
+  /** Set the number of counterexample start states kept; the oldest go
+    first. */
+  ConcreteFalsifier& set_capacity(size_t n) {
+    capacity_ = n;
+    while (pool_.size() > capacity_)
+      pool_.pop_front();
+    return *this;
+  }
+
+  /** Remember the start states of a counterexample to try on later
+    obligations. */
+  void add(const CpuState& target_start, const CpuState& rewrite_start);
+
+  /** Look for counterexamples to each invariant to prove.  The result maps
+    the index of each refuted invariant to its counterexample. */
+  std::map<size_t, Counterexample> falsify(const Cfg& target, const Cfg& rewrite,
+      Cfg::id_type target_block, Cfg::id_type rewrite_block,
+      const CfgPath& P, const CfgPath& Q,
+      std::shared_ptr<Invariant> assume,
+      const std::vector<std::shared_ptr<Invariant>>& proves,
+      const std::vector<std::pair<CpuState, CpuState>>& testcases);
+
+private:
+
+  size_t trials_;
+  size_t capacity_;
+
+  /** Start states of earlier counterexamples, oldest first. */
+  std::deque<std::pair<CpuState, CpuState>> pool_;
+
+  std::mt19937_64 gen_;
+
+  /** Change a general purpose register in one or both states. */
+  void mutate(CpuState& target, CpuState& rewrite);
+
+};
+
+} // namespace stoke
+
+#endif
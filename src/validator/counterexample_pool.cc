@@ -0,0 +1,100 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+
+#include "src/validator/compiled_invariant.h"
+#include "src/validator/counterexample_pool.h"
+
+using namespace std;
+using namespace stoke;
+
+void CounterexamplePool::add(const ProgramAlignmentAutomata::Edge& edge, const ObligationChecker::Result& result) {
+  if (!result.has_ceg || capacity_ == 0)
+    return;
+
+  Counterexample ceg;
+  ceg.edge = edge;
+  ceg.target_start = result.target_ceg;
+  ceg.rewrite_start = result.rewrite_ceg;
+  ceg.target_end = result.target_final_ceg;
+  ceg.rewrite_end = result.rewrite_final_ceg;
+
+  auto& cegs = pool_[edge.to];
+  cegs.push_back(ceg);
+  if (cegs.size() > capacity_)
+    cegs.pop_front();
+}
+
+set<size_t> CounterexamplePool::refuted(const ProgramAlignmentAutomata& paa,
+                                        const ProgramAlignmentAutomata::State& state,
+                                        const vector<shared_ptr<Invariant>>& assume) const {
+  set<size_t> output;
+  if (!pool_.count(state))
+    return output;
+
+  auto edges = paa.prev_edges(state);
+  auto inv = paa.get_invariant(state);
+
+  // only counterexamples to a hoare triple of this paa count; they're grouped
+  // by the state their edge starts from, which has the precondition.
+  map<ProgramAlignmentAutomata::State, vector<const Counterexample*>> by_start;
+  for (auto& ceg : pool_.at(state)) {
+    if (find(edges.begin(), edges.end(), ceg.edge) != edges.end())
+      by_start[ceg.edge.from].push_back(&ceg);
+  }
+
+  for (auto& group : by_start) {
+    if (output.size() == inv->size())
+      break;
+
+    vector<CpuState> target_starts;
+    vector<CpuState> rewrite_starts;
+    for (auto ceg : group.second) {
+      target_starts.push_back(ceg->target_start);
+      rewrite_starts.push_back(ceg->rewrite_start);
+    }
+
+    StateColumns starts(target_starts, rewrite_starts);
+    vector<uint8_t> holds;
+    CompiledInvariant(paa.get_invariant(group.first)).evaluate(starts, holds);
+    for (auto it : assume) {
+      vector<uint8_t> assumed;
+      CompiledInvariant(it).evaluate(starts, assumed);
+      for (size_t k = 0; k < holds.size(); ++k)
+        holds[k] &= assumed[k];
+    }
+
+    vector<CpuState> target_ends;
+    vector<CpuState> rewrite_ends;
+    for (size_t k = 0; k < holds.size(); ++k) {
+      if (holds[k]) {
+        target_ends.push_back(group.second[k]->target_end);
+        rewrite_ends.push_back(group.second[k]->rewrite_end);
+      }
+    }
+    if (target_ends.empty())
+      continue;
+
+    StateColumns ends(target_ends, rewrite_ends);
+    for (size_t i = 0; i < inv->size(); ++i) {
+      if (output.count(i))
+        continue;
+      if (!CompiledInvariant((*inv)[i]).check(ends))
+        output.insert(i);
+    }
+  }
+
+  return output;
+}
@@ -0,0 +1,85 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef STOKE_SRC_VALIDATOR_COUNTEREXAMPLE_POOL_H
+#define STOKE_SRC_VALIDATOR_COUNTEREXAMPLE_POOL_H
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include "src/state/cpu_state.h"
+#include "src/validator/invariant.h"
+#include "src/validator/obligation_checker.h"
+#include "src/validator/paa.h"
+
+namespace stoke {
+
+/** Counterexamples returned by the obligation checker, kept by the PAA state
+  they lead to.  A stored counterexample refutes a conjunct at that state
+  whenever its start states still satisfy the invariant at the start of its
+  edge, so conjuncts can be thrown out without asking the solver again.
+  States are pairs of blocks, so the pool carries over to PAAs built for
+  other alignment predicates. */
+class CounterexamplePool {
+
+public:
+
+  struct Counterexample {
+    ProgramAlignmentAutomata::Edge edge;
+    CpuState target_start;
+    CpuState rewrite_start;
+    CpuState target_end;
+    CpuState rewrite_end;
+  };
+
+  CounterexamplePool() : capacity_(256) { }
+
+  /** Set the number of counterexamples kept per state; the oldest go first. */
+  CounterexamplePool& set_capacity(size_t n) {
+    capacity_ = n;
+    return *this;
+  }
+
+  /** Add the counterexample of a result for an edge. */
+  void add(const ProgramAlignmentAutomata::Edge& edge, const ObligationChecker::Result& result);
+
+  /** Find the conjuncts of the invariant at a state that are refuted by a
+    counterexample for one of the paa's edges into the state.  The
+    assumptions are added to the invariant at the start of the edge. */
+  std::set<size_t> refuted(const ProgramAlignmentAutomata& paa, const ProgramAlignmentAutomata::State& state,
+                           const std::vector<std::shared_ptr<Invariant>>& assume) const;
+
+  /** Number of counterexamples stored for a state. */
+  size_t size(const ProgramAlignmentAutomata::State& state) const {
+    return pool_.count(state) ? pool_.at(state).size() : 0;
+  }
+
+  /** Forget everything. */
+  void clear() {
+    pool_.clear();
+  }
+
+private:
+
+  std::map<ProgramAlignmentAutomata::State, std::deque<Counterexample>> pool_;
+  size_t capacity_;
+
+};
+
+} // namespace stoke
+
+#endif
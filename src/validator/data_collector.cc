@@ -25,8 +25,15 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include <unistd.h>
+
 #include "src/serialize/serialize.h"
 #include "src/validator/data_collector.h"
+#include "src/validator/md5.h"
 
 #define MAX(a,b) ((a) > (b) ? (a) : (b))
 
@@ -38,28 +45,129 @@ using namespace std;
 using namespace stoke;
 using namespace x64asm;
 
+constexpr const char* DataCollector::cache_file_version_;
 
 
-const std::vector<DataCollector::Trace>& DataCollector::get_traces(Cfg& cfg) {
+string DataCollector::get_cache_key(const Cfg& cfg) const {
+  // The sandbox changes between calls, so nothing here is remembered.
+  stringstream ss;
+  ss << cfg.get_code() << endl;
+  for (size_t i = 0; i < sandbox_.size(); ++i)
+    sandbox_.get_input(i)->write_text(ss);
 
-  if (cache_.count(&cfg)) {
-    return cache_[&cfg];
+  // The traced function is inserted into the sandbox by mine_data; the
+  // others are the functions it may call.  Sort them so the key doesn't
+  // depend on the order they were inserted in.
+  auto label = cfg.get_function().get_leading_label();
+  map<string, string> functions;
+  for (auto it = sandbox_.function_begin(); it != sandbox_.function_end(); ++it) {
+    auto other = it->get_function().get_leading_label();
+    if (other == label)
+      continue;
+    stringstream code;
+    code << it->get_code();
+    functions[other.get_text()] = code.str();
   }
+  for (auto& it : functions)
+    ss << it.first << endl << it.second << endl;
 
-  vector<Trace> traces;
-  cout << "COLLECTING DATA..." << endl;
-  for (size_t i = 0; i < sandbox_.size(); ++i) {
-    Trace trace;
-    mine_data(cfg, i, trace);
-    for (auto& tp : trace) {
-      tp.cs.shadow.clear();
+  return md5(ss.str());
+}
+
+bool DataCollector::read_cache_file(const string& key, vector<CompactTrace>& traces) const {
+  if (cache_dir_ == "")
+    return false;
+
+  ifstream ifs(cache_dir_ + "/" + key + ".traces");
+  if (!ifs.good())
+    return false;
+
+  string version;
+  size_t n;
+  ifs >> version >> n;
+  if (version != cache_file_version_ || n != sandbox_.size())
+    return false;
+  for (size_t i = 0; i < n; ++i)
+    traces.push_back(CompactTrace::deserialize(ifs));
+  return !ifs.fail();
+}
+
+void DataCollector::write_cache_file(const string& key, const vector<CompactTrace>& traces) const {
+  if (cache_dir_ == "")
+    return;
+
+  // other processes may be reading the same file, so it appears all at once
+  auto path = cache_dir_ + "/" + key + ".traces";
+  stringstream tmp;
+  tmp << path << ".tmp." << getpid();
+  ofstream ofs(tmp.str());
+  ofs << cache_file_version_ << endl;
+  ofs << traces.size() << endl;
+  for (auto& it : traces)
+    it.serialize(ofs);
+  ofs.close();
+  if (ofs.fail() || rename(tmp.str().c_str(), path.c_str()) == -1) {
+    cout << "[data_collector] could not write " << path << endl;
+    unlink(tmp.str().c_str());
+  }
+}
+
+const std::vector<CompactTrace>& DataCollector::get_compact_traces(Cfg& cfg) {
+
+  auto key = get_cache_key(cfg);
+  if (cache_.count(key)) {
+    cache_order_.remove(key);
+    cache_order_.push_front(key);
+    return cache_[key];
+  }
+
+  vector<CompactTrace> traces;
+  if (read_cache_file(key, traces)) {
+    cout << "READ DATA FROM CACHE" << endl;
+  } else {
+    traces.clear();
+    cout << "COLLECTING DATA..." << endl;
+    for (size_t i = 0; i < sandbox_.size(); ++i) {
+      CompactTrace trace;
+      mine_data(cfg, i, trace);
+      trace.finish();
+      traces.push_back(trace);
     }
-    traces.push_back(trace);
+    cout << "... DONE" << endl;
+    write_cache_file(key, traces);
   }
-  cout << "... DONE" << endl;
-  cache_[&cfg] = traces;
-  return cache_[&cfg];
 
+  cache_[key] = traces;
+  cache_order_.push_front(key);
+  while (cache_order_.size() > cache_size_) {
+    cache_.erase(cache_order_.back());
+    cache_order_.pop_back();
+  }
+  return cache_[key];
+}
+
+vector<DataCollector::Trace> DataCollector::get_traces(Cfg& cfg) {
+  vector<Trace> traces;
+  for (auto& it : get_compact_traces(cfg))
+    traces.push_back(expand(it));
+  return traces;
+}
+
+DataCollector::Trace DataCollector::expand(const CompactTrace& compact) {
+  Trace trace(compact.size());
+  for (size_t i = 0; i < compact.size(); ++i) {
+    auto& tp = trace[i];
+    tp.block_id = compact.get_block(i);
+    tp.line_number = compact.get_line_number(i);
+    tp.index = i;
+    if (i == 0)
+      compact.get_state(0, tp.cs);
+    else {
+      tp.cs = trace[i-1].cs;
+      compact.next_state(i, tp.cs);
+    }
+  }
+  return trace;
 }
 
 
@@ -137,7 +245,7 @@ std::vector<DataCollector::Trace> DataCollector::get_detailed_traces(const Cfg&
   return traces;
 }
 
-void DataCollector::mine_data(const Cfg& cfg, size_t testcase, std::vector<TracePoint>& trace) {
+void DataCollector::mine_data(const Cfg& cfg, size_t testcase, CompactTrace& trace) {
 
   size_t index;
   auto label = cfg.get_function().get_leading_label();
@@ -153,7 +261,7 @@ void DataCollector::mine_data(const Cfg& cfg, size_t testcase, std::vector<Trace
     to_free.push_back(cp);
 
     cp->block_id = block;
-    cp->trace = &trace;
+    cp->compact_trace = &trace;
 
     //bool has_jump = ends_with_jump(cfg, block);
     bool has_label = begins_with_label(cfg, block);
@@ -161,12 +269,9 @@ void DataCollector::mine_data(const Cfg& cfg, size_t testcase, std::vector<Trace
     if (block == cfg.get_entry()) {
       // Don't run sandbox; callback manually.  This is to avoid repeated calls to the callback for jumps back to the
       // beginning of the loop... which is not what we want in general.
-      TracePoint tp;
-      tp.block_id = block;
-      tp.cs = *sandbox_.get_input(testcase);
-      tp.line_number = 0;
-      tp.index = trace.size();
-      trace.push_back(tp);
+      auto cs = *sandbox_.get_input(testcase);
+      cs.shadow.clear();
+      trace.push_back(block, 0, cs);
 
     } else if (has_label) {
       index = cfg.get_index(Cfg::loc_type(block, 0));
@@ -187,12 +292,8 @@ void DataCollector::mine_data(const Cfg& cfg, size_t testcase, std::vector<Trace
     cout << "Test case " << testcase << " seemed to fail with an exception." << endl;
   }
 
-  TracePoint tp;
-  tp.block_id = cfg.get_exit();
-  tp.cs = *sandbox_.get_output(testcase);
-  tp.line_number = cfg.get_code().size()-1;
-  tp.index = trace.size();
-  trace.push_back(tp);
+  output.shadow.clear();
+  trace.push_back(cfg.get_exit(), cfg.get_code().size()-1, output);
 
 
   for (auto it : to_free)
@@ -223,6 +324,17 @@ bool DataCollector::ends_with_jump(const Cfg& cfg, Cfg::id_type block) {
 void DataCollector::callback(const StateCallbackData& data, void* arg) {
   auto args = (CallbackParam*)(arg);
 
+  if (args->compact_trace) {
+    if (data.state.shadow.empty()) {
+      args->compact_trace->push_back(args->block_id, args->line_number, data.state);
+    } else {
+      auto cs = data.state;
+      cs.shadow.clear();
+      args->compact_trace->push_back(args->block_id, args->line_number, cs);
+    }
+    return;
+  }
+
   TracePoint tp;
   tp.cs = data.state;
   tp.block_id = args->block_id;
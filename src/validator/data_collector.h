@@ -18,11 +18,15 @@
 #include "src/cfg/cfg.h"
 #include "src/cfg/paths.h"
 #include "src/sandbox/sandbox.h"
+#include "src/validator/compact_trace.h"
 #include "src/validator/int_matrix.h"
 #include "src/validator/int_vector.h"
 #include "src/validator/line_info.h"
 
+#include <cassert>
 #include <functional>
+#include <list>
+#include <string>
 #include <vector>
 #include <map>
 
@@ -56,19 +60,49 @@ public:
   typedef std::vector<TracePoint> Trace;
 
   /** Setup a sandbox (along with test cases) to use to extract data. */
-  DataCollector(Sandbox& sandbox) : sandbox_(sandbox) {
+  DataCollector(Sandbox& sandbox) : sandbox_(sandbox), cache_size_(16) {
     set_collect_before(false);
   }
 
   /** Returns traces for the given function.  Each trace starts with the
     entry block (0) and ends with the exit block, and contains data found at the
-    entry to each basic block in between. */
-  const std::vector<Trace>& get_traces(Cfg& target);
+    entry to each basic block in between.  The traces are stored compactly; use
+    expand() to get the states of one.
+
+    Traces are cached by the code of the function and the testcases, so a copy
+    of a Cfg hits the cache and a Cfg whose code changed doesn't.  The result
+    stays valid until the traces of cache size other functions are asked for. */
+  const std::vector<CompactTrace>& get_compact_traces(Cfg& target);
+
+  /** Keep the traces of up to n functions in memory, dropping the least
+    recently used first.  Must be at least 2. */
+  DataCollector& set_cache_size(size_t n) {
+    assert(n >= 2);
+    cache_size_ = n;
+    return *this;
+  }
+  /** Also keep traces in files under this directory, to be reused by later
+    runs with the same testcases.  Empty for none. */
+  DataCollector& set_cache_dir(const std::string& dir) {
+    cache_dir_ = dir;
+    return *this;
+  }
+  std::string get_cache_dir() const {
+    return cache_dir_;
+  }
+
+  /** Returns the traces of get_compact_traces() with every state filled in.
+    This takes a full copy of every state of every testcase; prefer expanding
+    one trace at a time. */
+  std::vector<Trace> get_traces(Cfg& target);
+
+  /** Fill in the states of a trace. */
+  static Trace expand(const CompactTrace& trace);
 
   std::vector<Trace> get_detailed_traces(const Cfg& target,
                                          const LineMap * const linemap = nullptr);
 
-  static CfgPath project_states(Trace& trace) {
+  static CfgPath project_states(const Trace& trace) {
     CfgPath p;
     for (auto s : trace) {
       p.push_back(s.block_id);
@@ -91,7 +125,14 @@ public:
 private:
 
   /** Get a complete trace from running the Cfg on a testcase and save into 'trace' */
-  void mine_data(const Cfg& cfg, size_t testcase, Trace& trace);
+  void mine_data(const Cfg& cfg, size_t testcase, CompactTrace& trace);
+
+  /** Hash of the code of a function, the testcases and the other functions
+    in the sandbox, to key the cache. */
+  std::string get_cache_key(const Cfg& cfg) const;
+  /** Read or write the traces for a key under cache_dir_. */
+  bool read_cache_file(const std::string& key, std::vector<CompactTrace>& traces) const;
+  void write_cache_file(const std::string& key, const std::vector<CompactTrace>& traces) const;
 
   /** Helper: Check if a basic block ends with a jump or not. */
   static bool ends_with_jump(const Cfg& cfg, Cfg::id_type block);
@@ -102,14 +143,25 @@ private:
   Sandbox sandbox_;
 
   /** Cache */
-  std::map<Cfg*, std::vector<Trace>> cache_;
+  std::map<std::string, std::vector<CompactTrace>> cache_;
+  /** Keys in cache_, most recently used first. */
+  std::list<std::string> cache_order_;
+  size_t cache_size_;
+  std::string cache_dir_;
+  /** First line of the files under cache_dir_; change it whenever the format
+    of CompactTrace or of the key changes. */
+  static constexpr const char* cache_file_version_ = "traces-v2";
 
   /** Callbacks */
 
   struct CallbackParam {
     Cfg::id_type block_id;
     size_t line_number;
+    /** One of these is filled in. */
     Trace* trace;
+    CompactTrace* compact_trace;
+
+    CallbackParam() : trace(NULL), compact_trace(NULL) { }
   };
 
   /** The callback used for gathering data from each of the cutpoints */
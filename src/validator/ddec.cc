@@ -19,6 +19,7 @@
 #include "src/validator/data_collector.h"
 #include "src/validator/paa.h"
 #include "src/validator/ddec.h"
+#include "src/validator/forking_search.h"
 #include "src/validator/null.h"
 #include "src/validator/invariants.h"
 
@@ -28,6 +29,7 @@
 #include <ctime>
 #include <iomanip>
 #include <algorithm>
+#include <memory>
 #include <set>
 
 // this is configurable via build system
@@ -75,17 +77,17 @@ void DdecValidator::warn(string s) {
 
 
 
-void DdecValidator::get_states_at_cutpoint(size_t i, size_t target_point, size_t rewrite_point, vector<DataCollector::TracePoint>& target_states, vector<DataCollector::TracePoint>& rewrite_states, bool boundit) const {
+void DdecValidator::get_states_at_cutpoint(size_t i, size_t target_point, size_t rewrite_point, vector<size_t>& target_states, vector<size_t>& rewrite_states, bool boundit) const {
   //cout << "      - Collecting state data" << endl;
   for (size_t k = 0; k < 2; ++k) {
 
-    auto& traces = k ? rewrite_traces_[i] : target_traces_[i];
+    auto& trace = k ? rewrite_traces_[i] : target_traces_[i];
     auto& states = k ? rewrite_states : target_states;
     auto cutpoint = k ? rewrite_point : target_point;
     size_t bound = k ? rewrite_bound_ : target_bound_;
     size_t j = 0;
-    for (auto point : traces) {
-      if (point.block_id == cutpoint) {
+    for (size_t point = 0; point < trace.size(); ++point) {
+      if (trace.get_block(point) == cutpoint) {
         states.push_back(point);
         j++;
         if (boundit && j > bound)
@@ -109,16 +111,20 @@ vector<uint64_t> DdecValidator::find_alignment_predicate_constants(size_t target
     DEBUG_ALIGN_PRED_CONSTANTS(cout << "  * Processing trace " << i << endl;)
     set<uint64_t> my_constants;
 
-    vector<DataCollector::TracePoint> target_states;
-    vector<DataCollector::TracePoint> rewrite_states;
+    vector<size_t> target_states;
+    vector<size_t> rewrite_states;
 
     get_states_at_cutpoint(i, target_point, rewrite_point, target_states, rewrite_states, true);
 
     DEBUG_ALIGN_PRED_CONSTANTS(cout << dec << "Got " << target_states.size() << " target states, " << rewrite_states.size() << " rewrite states." << endl;)
     if (target_states.size() > 2 && rewrite_states.size() > 2) {
+      // the left hand side splits into a target half and a rewrite half
+      vector<uint64_t> target_sum;
+      vector<uint64_t> rewrite_sum;
+      prefilter_.get_sums(inv, i, target_sum, rewrite_sum);
       for (auto ts : target_states) {
         for (auto rs : rewrite_states) {
-          auto value = inv.calculate_lhs(ts.cs, rs.cs);
+          auto value = target_sum[ts] + rewrite_sum[rs];
           my_constants.insert(value);
           DEBUG_ALIGN_PRED_CONSTANTS(cout << hex << "     Found constant " << value << endl;)
         }
@@ -171,29 +177,39 @@ vector<uint64_t> DdecValidator::find_alignment_predicate_constants(size_t target
 
 
 
-bool pair_below(pair<DataCollector::TracePoint, DataCollector::TracePoint>& pair1,
-                pair<DataCollector::TracePoint, DataCollector::TracePoint>& pair2) {
-  auto& first_target = pair1.first.index;
-  auto& first_rewrite = pair1.second.index;
-  auto& second_target = pair2.first.index;
-  auto& second_rewrite = pair2.second.index;
-
-  if (first_target == second_target && first_rewrite == second_rewrite)
-    return false;
-
-  if (second_target < first_target)
-    return false;
-
-  if (second_rewrite < first_rewrite)
-    return false;
+vector<pair<size_t, size_t>> DdecValidator::get_successor_pairs(
+  const vector<pair<size_t, size_t>>& pairs, size_t k,
+  size_t target_bound, size_t rewrite_bound) {
+
+  // The pairs after this one are looked at a target index at a time.  In
+  // each, only the one with the lowest rewrite index can be a successor, and
+  // only if no earlier one was as low.  Anything between two pairs is within
+  // the bounds of the first, so nothing further away needs looking at.
+  auto first = pairs[k];
+  vector<pair<size_t, size_t>> successors;
+  size_t lowest = (size_t)-1;
+
+  auto row = pairs.begin() + k;
+  while (row != pairs.end() && row->first - first.first <= target_bound && lowest > first.second) {
+    auto row_end = upper_bound(row, pairs.end(), make_pair(row->first, (size_t)-1));
+    auto it = lower_bound(row, row_end, make_pair(row->first, first.second));
+    if (it != row_end && *it == first)
+      ++it;
+    if (it != row_end) {
+      if (it->second < lowest && it->second - first.second <= rewrite_bound)
+        successors.push_back(*it);
+      lowest = min(lowest, it->second);
+    }
+    row = row_end;
+  }
 
-  return true;
+  return successors;
 }
 
-
 bool DdecValidator::build_paa_for_alignment_predicate(std::shared_ptr<Invariant> inv, ProgramAlignmentAutomata& paa) {
 
   bool found_loop = false;
+  auto linear = AlignmentPrefilter::get_linear_part(inv);
   for (size_t i = 0; i < target_traces_.size(); ++i) {
     DEBUG_PAA_CONSTRUCTION(cout << "TRACE " << i << endl;)
     if (i > training_set_size_)
@@ -205,44 +221,58 @@ bool DdecValidator::build_paa_for_alignment_predicate(std::shared_ptr<Invariant>
     if (target_trace.size() < 2 || rewrite_trace.size() < 2)
       continue;
 
-    auto target_trace_path = DataCollector::project_states(target_trace);
-    auto rewrite_trace_path = DataCollector::project_states(rewrite_trace);
-
-    set<pair<DataCollector::TracePoint, DataCollector::TracePoint>> matching_pairs;
-    matching_pairs.insert(pair<DataCollector::TracePoint,DataCollector::TracePoint>(target_trace[0], rewrite_trace[0]));
-    matching_pairs.insert(pair<DataCollector::TracePoint,DataCollector::TracePoint>(target_trace.back(), rewrite_trace.back()));
+    auto target_trace_path = target_trace.get_path();
+    auto rewrite_trace_path = rewrite_trace.get_path();
+
+    // indexes of the matching points, in sorted order; the ends always match
+    size_t target_last = target_trace.size() - 1;
+    size_t rewrite_last = rewrite_trace.size() - 1;
+    vector<pair<size_t, size_t>> matching_pairs;
+    matching_pairs.push_back(make_pair(0, 0));
+
+    // the linear part of the predicate is evaluated for all pairs at once;
+    // the rest only needs checking where it holds
+    vector<uint8_t> linear_matches;
+    bool have_matches = linear && prefilter_.get_matches(*linear, i, linear_matches);
+
+    // the states are only needed if some of the predicate is left to check
+    DataCollector::Trace target_states;
+    DataCollector::Trace rewrite_states;
+    if (!have_matches || linear != inv) {
+      target_states = DataCollector::expand(target_trace);
+      rewrite_states = DataCollector::expand(rewrite_trace);
+    }
 
     // edges from entry to first iteration
     bool found_false = false;
-    for (auto ts : target_trace) {
-      for (auto rs : rewrite_trace) {
-        if (inv->check(ts.cs,rs.cs)) {
+    for (size_t ti = 0; ti < target_trace.size(); ++ti) {
+      for (size_t ri = 0; ri < rewrite_trace.size(); ++ri) {
+        bool holds;
+        if (have_matches)
+          holds = linear_matches[ti*rewrite_trace.size() + ri] &&
+                  (linear == inv || inv->check(target_states[ti].cs, rewrite_states[ri].cs));
+        else
+          holds = inv->check(target_states[ti].cs, rewrite_states[ri].cs);
+        if (holds) {
           DEBUG_PAA_CONSTRUCTION(
-            cout << " - ADDING PAIR at blocks " << ts.block_id << " / " << rs.block_id
-            << "  trace indexes " << ts.index << " / " << rs.index << endl;
-            /*cout << "STATES" << endl;
-            cout << ts.cs << endl;
-            cout << rs.cs << endl;*/)
-          matching_pairs.insert(pair<DataCollector::TracePoint, DataCollector::TracePoint>(ts, rs));
+            cout << " - ADDING PAIR at blocks " << target_trace.get_block(ti) << " / " << rewrite_trace.get_block(ri)
+            << "  trace indexes " << ti << " / " << ri << endl;)
+          bool is_end = (ti == 0 && ri == 0) || (ti == target_last && ri == rewrite_last);
+          if (!is_end)
+            matching_pairs.push_back(make_pair(ti, ri));
         } else {
-          /*
-          cout << " - FAILS FOR blocks " << ts.block_id << " / " << rs.block_id
-               << " trace indexes " << ts.index << " / " << rs.index << endl;
-          cout << "STATES" << endl;
-          cout << ts.cs << endl;
-          cout << rs.cs << endl; */
-
           found_false = true;
         }
       }
     }
+    matching_pairs.push_back(make_pair(target_last, rewrite_last));
 
     bool dupes = false;
     for (size_t k = 0; k < 2; ++k) {
       auto& trace = k ? rewrite_trace : target_trace;
       for (size_t i = 0; i < trace.size(); ++i) {
         for (size_t j = i+1; j < trace.size(); ++j) {
-          if (trace[i].block_id == trace[j].block_id) {
+          if (trace.get_block(i) == trace.get_block(j)) {
             dupes = true;
             break;
           }
@@ -262,73 +292,25 @@ bool DdecValidator::build_paa_for_alignment_predicate(std::shared_ptr<Invariant>
       return false;
     }
 
-    // edges from first iteration to second
-    for (auto first_pair : matching_pairs) {
-      for (auto second_pair : matching_pairs) {
-        auto& first_target = first_pair.first;
-        auto& first_rewrite = first_pair.second;
-        auto& second_target = second_pair.first;
-        auto& second_rewrite = second_pair.second;
-
-        /*
-        cout << " - Considering pairs:" << endl;
-        cout << "     First.  Basic blocks " << first_target.block_id << " / " << first_rewrite.block_id
-             << "  Trace indexes " << first_target.index << " / " << first_rewrite.index << endl;
-        cout << "     Second.  Basic blocks " << second_target.block_id << " / " << second_rewrite.block_id
-             << "  Trace indexes " << second_target.index << " / " << second_rewrite.index << endl;
-             */
-
-        if (!pair_below(first_pair, second_pair)) {
-          //cout << "          === SKIPPING DUE TO ORDER" << endl;
-          continue;
-        }
-
-        if (second_target.index - first_target.index > target_bound_) {
-          //cout << "          === SKIPPING DUE TO TARGET BOUND" << endl;
-          continue;
-        }
-        if (second_rewrite.index - first_rewrite.index > rewrite_bound_) {
-          //cout << "          === SKIPPING DUE TO REWRITE BOUND" << endl;
-          continue;
-        }
-
-
-
-        bool found_bad_pair = false;
-        for (auto third_pair : matching_pairs) {
-          if (third_pair == first_pair)
-            continue;
-          if (third_pair == second_pair)
-            continue;
-          if (pair_below(first_pair, third_pair) &&
-              pair_below(third_pair, second_pair)) {
-            found_bad_pair = true;
-            //cout << "          === SKIPPING DUE TO BAD TRIPPLE " << endl;
-            //cout << "          " << third_pair.first.index << " , " << third_pair.second.index << endl;
-            break;
-          }
-        }
-        if (found_bad_pair) {
-          continue;
-        }
-
-
+    // edges from each matching pair to the nearest ones after it
+    for (size_t k = 0; k < matching_pairs.size(); ++k) {
+      auto first_pair = matching_pairs[k];
+      for (auto second_pair : get_successor_pairs(matching_pairs, k, target_bound_, rewrite_bound_)) {
         DEBUG_PAA_CONSTRUCTION(
           cout << " - Considering pairs:" << endl;
-          cout << "     First.  Basic blocks " << first_target.block_id << " / " << first_rewrite.block_id
-          << "  Trace indexes " << first_target.index << " / " << first_rewrite.index << endl;
-          cout << "     Second.  Basic blocks " << second_target.block_id << " / " << second_rewrite.block_id
-          << "  Trace indexes " << second_target.index << " / " << second_rewrite.index << endl; )
-        DEBUG_PAA_CONSTRUCTION(cout << "NOT SKIPPING THESE" << endl;)
+          cout << "     First.  Basic blocks " << target_trace_path[first_pair.first] << " / " << rewrite_trace_path[first_pair.second]
+          << "  Trace indexes " << first_pair.first << " / " << first_pair.second << endl;
+          cout << "     Second.  Basic blocks " << target_trace_path[second_pair.first] << " / " << rewrite_trace_path[second_pair.second]
+          << "  Trace indexes " << second_pair.first << " / " << second_pair.second << endl; )
 
         CfgPath target_path;
         CfgPath rewrite_path;
 
-        target_path.insert(target_path.begin(), target_trace_path.begin()+first_target.index, target_trace_path.begin() + second_target.index);
-        rewrite_path.insert(rewrite_path.begin(), rewrite_trace_path.begin()+first_rewrite.index, rewrite_trace_path.begin() + second_rewrite.index);
+        target_path.insert(target_path.begin(), target_trace_path.begin() + first_pair.first, target_trace_path.begin() + second_pair.first);
+        rewrite_path.insert(rewrite_path.begin(), rewrite_trace_path.begin() + first_pair.second, rewrite_trace_path.begin() + second_pair.second);
 
         DEBUG_PAA_CONSTRUCTION(cout << "    **** FOUND CORRESPONDING PATHS " << target_path << " / " << rewrite_path << endl;)
-        ProgramAlignmentAutomata::Edge e(ProgramAlignmentAutomata::State(second_target.block_id, second_rewrite.block_id), target_path, rewrite_path);
+        ProgramAlignmentAutomata::Edge e(ProgramAlignmentAutomata::State(target_trace_path[second_pair.first], rewrite_trace_path[second_pair.second]), target_path, rewrite_path);
         paa.add_edge(e);
       }
     }
@@ -347,26 +329,32 @@ bool DdecValidator::build_paa_for_alignment_predicate(std::shared_ptr<Invariant>
   return true;
 }
 
-bool DdecValidator::verify_paa(ProgramAlignmentAutomata& paa) {
+bool DdecValidator::test_paa(ProgramAlignmentAutomata& paa) {
 
   // check if there are any cycles with only edges in target / only edges in rewrite
   auto edge_reachable = paa.get_edge_reachable_states();
   cout << "Checking for cycle in paa" << endl;
   for (auto s : edge_reachable) {
     if (paa.one_program_cycle(s, true) || paa.one_program_cycle(s, false)) {
-      cout << "[verify_paa] Failure.  State " << s << " in cycle which doesn't make progress. " << endl;
+      cout << "[test_paa] Failure.  State " << s << " in cycle which doesn't make progress. " << endl;
       return false;
     }
   }
 
   // check if this paa makes sense
-  bool ap_failed_ever = false;
   bool paa_ok = paa.test_paa(data_collector_);
   if (!paa_ok) {
-    cout << "[verify_paa] PAA does not accept all test inputs.  Aborting." << endl;
+    cout << "[test_paa] PAA does not accept all test inputs.  Aborting." << endl;
     return false;
   }
 
+  return true;
+}
+
+bool DdecValidator::verify_paa(ProgramAlignmentAutomata& paa) {
+
+  auto edge_reachable = paa.get_edge_reachable_states();
+
   if (benchmark_proof_succeeded_) {
     cout << "[verify_paa] No need to check further... see ya." << endl;
     return false;
@@ -492,6 +480,7 @@ bool DdecValidator::verify_paa(ProgramAlignmentAutomata& paa) {
       // we want to *right away* identify any conjuncts that don't need to be processed
       if (r.has_ceg) {
         reachable_examples_for_state[data.edge.to].push_back(pair<CpuState,CpuState>(r.target_final_ceg, r.rewrite_final_ceg));
+        ceg_pool_.add(data.edge, r);
 
         cout << "[verify_paa]      counterexample details" << endl;
         cout << "[verify_paa]      TARGET START STATE" << endl << endl << r.target_ceg << endl;
@@ -565,6 +554,8 @@ bool DdecValidator::verify_paa(ProgramAlignmentAutomata& paa) {
       cout << endl;
       update_needed.clear();
 
+      // conjuncts that counterexamples from earlier rounds (or earlier PAAs) already refute
+      map<ProgramAlignmentAutomata::State, set<size_t>> refuted_by_pool;
 
 
       // check every hoare triple for entire graph, and throw out conjuncts that we're
@@ -587,10 +578,45 @@ bool DdecValidator::verify_paa(ProgramAlignmentAutomata& paa) {
             testcases.push_back(make_pair(target_testcases[i], rewrite_testcases[i]));
           }
 
+          // construct source invariant
+          shared_ptr<ConjunctionInvariant> new_source_invariant =
+            dynamic_pointer_cast<ConjunctionInvariant>(source_inv->clone());
+
+          // we don't want to just remove these conjuncts because they may imply others which do hold
+          // (we can however, remove them, if we add in the others also)
+          //const auto& conjuncts_to_ignore = conjuncts_to_delete[state];
+          //for(size_t i = 0; i < source_inv->size(); ++i) {
+          //if(!conjuncts_to_ignore.count(i))
+          //  new_source_invariant.add_invariant((*source_inv)[i]);
+          //}
+          for (auto inv : assume_always_) {
+            new_source_invariant->add_invariant(inv);
+          }
+
+          if (!refuted_by_pool.count(target))
+            refuted_by_pool[target] = ceg_pool_.refuted(paa, target, assume_always_);
+          const auto& refuted = refuted_by_pool[target];
+
+          // all the conjuncts for this edge are checked as one batch
+          auto batch = make_shared<ConjunctionInvariant>();
+          vector<void*> batch_params;
           for (size_t i = 0; i < target_inv->size(); ++i) {
             if (conjuncts_to_delete[target].count(i))
               continue;
 
+            // no need to ask the solver about these
+            if (refuted.count(i)) {
+              auto conjunct = (*target_inv)[i];
+              cout << "[verify_paa]      conjunct " << i << " refuted by stored counterexample: " << *conjunct << endl;
+              conjuncts_to_delete[target].insert(i);
+              fixpoint = false;
+              if (conjunct->is_critical() || target == fail_state || target == end_state) {
+                cout << "[verify_paa] Failure. Stored counterexample refutes " << *conjunct << " at " << target << endl;
+                failure = true;
+              }
+              continue;
+            }
+
             // create callback parameter
             CallbackParam* cbp = new CallbackParam();
             cbp->edge = e;
@@ -599,47 +625,36 @@ bool DdecValidator::verify_paa(ProgramAlignmentAutomata& paa) {
             pointers_to_delete.push_back(cbp);
             auto conjunct = (*target_inv)[i];
 
-            // construct source invariant
-            shared_ptr<ConjunctionInvariant> new_source_invariant =
-              dynamic_pointer_cast<ConjunctionInvariant>(source_inv->clone());
-
-            // we don't want to just remove these conjuncts because they may imply others which do hold
-            // (we can however, remove them, if we add in the others also)
-            //const auto& conjuncts_to_ignore = conjuncts_to_delete[state];
-            //for(size_t i = 0; i < source_inv->size(); ++i) {
-            //if(!conjuncts_to_ignore.count(i))
-            //  new_source_invariant.add_invariant((*source_inv)[i]);
-            //}
-            for (auto inv : assume_always_) {
-              new_source_invariant->add_invariant(inv);
-            }
-
-            // dispatch the check
             cout << "[verify_paa]      dispatching conjunct " << i << ": " << *conjunct << endl;
-            checker_.check(target_, rewrite_, e.to.ts, e.to.rs, e.te, e.re,
-                           new_source_invariant, conjunct, testcases, callback, true, (void*)cbp);
-
-            // see if we've received any callbacks that end it all
-            if (failure) {
-              checker_.delete_all();
-              for (auto it : pointers_to_delete)
-                delete it;
-              return false;
-            }
+            batch->add_invariant(conjunct);
+            batch_params.push_back((void*)cbp);
           }
 
-          // invoke callback for any jobs that are already finished
-          checker_.check_for_callbacks();
-          if (failure) {
-            checker_.delete_all();
-            for (auto it : pointers_to_delete)
-              delete it;
-            return false;
-          }
+          // queue the checks; the scheduler decides the order
+          scheduler_.add(target_, rewrite_, e, new_source_invariant, batch, testcases, batch_params);
         }
       }
 
-      checker_.block_until_complete();
+      // A conjunct that has been refuted needs no more checking, and neither does
+      // anything assuming the invariant of a state that is about to lose conjuncts;
+      // those edges are all checked again next iteration.
+      auto is_moot = [&](void* param) {
+        auto data = static_cast<CallbackParam*>(param);
+        auto refuted = conjuncts_to_delete.find(data->edge.to);
+        if (refuted != conjuncts_to_delete.end() && refuted->second.count(data->conjunct))
+          return true;
+        auto weakened = conjuncts_to_delete.find(data->edge.from);
+        return weakened != conjuncts_to_delete.end() && weakened->second.size() > 0;
+      };
+      auto should_stop = [&]() {
+        return failure;
+      };
+
+      scheduler_.run(callback, is_moot, should_stop);
+      if (scheduler_.get_skipped())
+        cout << "[verify_paa] skipped " << scheduler_.get_skipped() << " obligations made moot by refutations" << endl;
+      cout << "[verify_paa] " << memo_.get_hits() << " obligations answered from " << memo_.size()
+           << " remembered verdicts so far" << endl;
       if (failure) {
         checker_.delete_all();
         for (auto it : pointers_to_delete)
@@ -749,6 +764,37 @@ vector<Variable> DdecValidator::get_stack_locations(bool is_rewrite) {
 
 bool DdecValidator::test_alignment_predicate(shared_ptr<Invariant> invariant) {
   ProgramAlignmentAutomata paa(target_, rewrite_);
+  if (!screen_alignment_predicate(invariant, paa))
+    return false;
+  return verify_paa(paa);
+}
+
+bool DdecValidator::test_alignment_predicates(const vector<shared_ptr<Invariant>>& candidates) {
+
+  /** Each candidate's PAA is built and run against the traces here, so that
+    cheap rejections never wait behind a fixpoint.  The fixpoints run in
+    child processes, each with its own PAA, learner and copy of the checker. */
+  unique_ptr<ProgramAlignmentAutomata> paa;
+  auto screen = [&](size_t i) {
+    paa.reset(new ProgramAlignmentAutomata(target_, rewrite_));
+    return screen_alignment_predicate(candidates[i], *paa);
+  };
+  auto prove = [&](size_t i) {
+    return verify_paa(*paa);
+  };
+
+  ForkingSearch search(parallel_predicates_);
+  int found = search.run(candidates.size(), screen, prove);
+  cout << "[test_alignment_predicates] " << search.get_screened_out() << " of "
+       << candidates.size() << " alignment predicates rejected by the traces" << endl;
+  if (found == -1)
+    return false;
+
+  cout << "[test_alignment_predicates] Proved with alignment predicate " << *candidates[found] << endl;
+  return true;
+}
+
+bool DdecValidator::screen_alignment_predicate(shared_ptr<Invariant> invariant, ProgramAlignmentAutomata& paa) {
   cout << "[test_alignment_predicate] Trying alignment predicate " << *invariant << endl;
   bool success = build_paa_for_alignment_predicate(invariant, paa);
   if (!success)
@@ -767,8 +813,7 @@ bool DdecValidator::test_alignment_predicate(shared_ptr<Invariant> invariant) {
 
   cout << "TRYING THIS PAA!" << endl;
   paa.print_all();
-  bool works = verify_paa(paa);
-  return works;
+  return test_paa(paa);
 }
 
 bool DdecValidator::verify(const Cfg& init_target, const Cfg& init_rewrite) {
@@ -782,9 +827,13 @@ bool DdecValidator::verify(const Cfg& init_target, const Cfg& init_rewrite) {
 
   target_ = init_target;
   rewrite_ = init_rewrite;
+  ceg_pool_.clear();
+  memo_.clear();
 
-  target_traces_ = data_collector_.get_traces(target_);
-  rewrite_traces_ = data_collector_.get_traces(rewrite_);
+  target_traces_ = data_collector_.get_compact_traces(target_);
+  rewrite_traces_ = data_collector_.get_compact_traces(rewrite_);
+  prefilter_.reset(target_traces_, rewrite_traces_, training_set_size_);
+  prefilter_.set_bound(target_bound_, rewrite_bound_);
 
   /** Check if user has supplied an alignment predicate */
   if (alignment_predicate_) {
@@ -798,6 +847,7 @@ bool DdecValidator::verify(const Cfg& init_target, const Cfg& init_rewrite) {
   auto memequ = make_shared<MemoryEqualityInvariant>();
   set<EqualityInvariant> tried_invariants;
   vector<shared_ptr<EqualityInvariant>> try_again_predicates;
+  vector<shared_ptr<Invariant>> candidates;
 
   /** For every pair of program points in both programs, we try and
     guess an alignment predicate.  By choosing a pair of program points
@@ -869,12 +919,7 @@ bool DdecValidator::verify(const Cfg& init_target, const Cfg& init_rewrite) {
               auto conj = make_shared<ConjunctionInvariant>();
               conj->add_invariant(specific);
               conj->add_invariant(memequ);
-
-              /** test_alignment_predicate does all the work in checking the alignment
-                predicate; if it returns true, we have succeeded! */
-              bool success = test_alignment_predicate(conj);
-              if (success)
-                return true;
+              candidates.push_back(conj);
             }
           }
         }
@@ -882,13 +927,25 @@ bool DdecValidator::verify(const Cfg& init_target, const Cfg& init_rewrite) {
     }
   }
 
-  /** Now we try alignment predicates that don't assert equivalence. */
-  for (auto inv : try_again_predicates) {
-    bool success = test_alignment_predicate(inv);
-    if (success)
-      return true;
+  /** Then alignment predicates that don't assert equivalence. */
+  candidates.insert(candidates.end(), try_again_predicates.begin(), try_again_predicates.end());
+
+  /** Throw out the ones that can't line up the traces before building any PAA. */
+  if (alignment_prefilter_) {
+    vector<shared_ptr<Invariant>> kept;
+    for (auto it : candidates)
+      if (prefilter_.keep(it))
+        kept.push_back(it);
+    cout << "[verify] prefilter kept " << kept.size() << " of " << candidates.size()
+         << " alignment predicates" << endl;
+    candidates = kept;
   }
 
+  /** test_alignment_predicates does all the work in checking the alignment
+    predicates; if it returns true, we have succeeded! */
+  if (test_alignment_predicates(candidates))
+    return true;
+
   auto now = system_clock::now();
   auto diff = duration_cast<microseconds>(now - benchmark_searchstart_).count();
   benchmark_total_search_time_ += diff;
@@ -15,12 +15,16 @@
 #ifndef STOKE_SRC_VALIDATOR_DDEC_H
 #define STOKE_SRC_VALIDATOR_DDEC_H
 
+#include "src/validator/alignment_prefilter.h"
+#include "src/validator/counterexample_pool.h"
 #include "src/validator/paa.h"
+#include "src/validator/proof_memo.h"
 #include "src/validator/data_collector.h"
 #include "src/validator/invariant.h"
 #include "src/validator/invariants/conjunction.h"
 #include "src/validator/learner.h"
 #include "src/validator/obligation_checker.h"
+#include "src/validator/obligation_scheduler.h"
 #include "src/validator/validator.h"
 
 
@@ -37,9 +41,13 @@ public:
           sandbox_(sandbox),
           data_collector_(sandbox),
           invariant_learner_(inv),
+          scheduler_(checker),
           alignment_predicate_(),
-          training_set_size_(20)
+          training_set_size_(20),
+          parallel_predicates_(1),
+          alignment_prefilter_(true)
   {
+    scheduler_.set_memo(&memo_);
   }
 
   DdecValidator(const DdecValidator& rhs) :
@@ -49,10 +57,15 @@ public:
     sandbox_(rhs.sandbox_),
     data_collector_(sandbox_),
     invariant_learner_(rhs.invariant_learner_),
-    training_set_size_(rhs.training_set_size_) {
+    scheduler_(checker_),
+    training_set_size_(rhs.training_set_size_),
+    parallel_predicates_(rhs.parallel_predicates_),
+    alignment_prefilter_(rhs.alignment_prefilter_) {
 
     target_bound_ = rhs.target_bound_;
     rewrite_bound_ = rhs.rewrite_bound_;
+    scheduler_.set_memo(&memo_);
+    data_collector_.set_cache_dir(rhs.data_collector_.get_cache_dir());
   }
 
   /** Set the bound for bounded validator */
@@ -67,6 +80,36 @@ public:
     return *this;
   }
 
+  /** Set the maximum number of edges checked at once; 0 for no limit. */
+  DdecValidator& set_obligation_window(size_t n) {
+    scheduler_.set_window(n);
+    return *this;
+  }
+
+  /** Set the number of alignment predicates to try at once, each in a process
+    of its own; 1 tries them one at a time in this process.  The checker must
+    work in a forked child, so it can't rely on threads of this process.  With
+    more than one, the counterexample pool and proof memo a child builds up
+    are lost when it exits. */
+  DdecValidator& set_parallel_predicates(size_t n) {
+    parallel_predicates_ = n;
+    return *this;
+  }
+
+  /** Discard alignment predicates that can't line up the traces before
+    building a PAA for them. */
+  DdecValidator& set_alignment_prefilter(bool b) {
+    alignment_prefilter_ = b;
+    return *this;
+  }
+
+  /** Keep the traces of target and rewrite in files under this directory,
+    so later runs on the same testcases don't collect them again. */
+  DdecValidator& set_trace_cache_dir(const std::string& dir) {
+    data_collector_.set_cache_dir(dir);
+    return *this;
+  }
+
   /** Add an assumption that holds at every point (e.g. read-only memory) */
   DdecValidator& assume_always(std::shared_ptr<Invariant> assumption) {
     assume_always_.push_back(assumption);
@@ -83,6 +126,14 @@ public:
   /** Verify if target and rewrite are equivalent. */
   bool verify(const Cfg& target, const Cfg& rewrite);
 
+  /** Given the sorted (target index, rewrite index) pairs where an alignment
+    predicate holds on a trace, find the ones PAA edges go to from the k-th:
+    those after it in both programs, within the bounds, with no other pair in
+    between. */
+  static std::vector<std::pair<size_t, size_t>> get_successor_pairs(
+        const std::vector<std::pair<size_t, size_t>>& pairs, size_t k,
+        size_t target_bound, size_t rewrite_bound);
+
 
 private:
 
@@ -102,6 +153,8 @@ private:
   std::shared_ptr<ConjunctionInvariant> get_final_invariant(ProgramAlignmentAutomata&) const;
   std::shared_ptr<ConjunctionInvariant> get_fail_invariant() const;
 
+  /** Check that a paa is cycle-free and accepts every test input */
+  bool test_paa(ProgramAlignmentAutomata& paa);
   /** Verify that a paa is correct */
   bool verify_paa(ProgramAlignmentAutomata& paa);
 
@@ -110,19 +163,32 @@ private:
 
   bool build_paa_for_alignment_predicate(std::shared_ptr<Invariant> inv, ProgramAlignmentAutomata&);
   std::vector<uint64_t> find_alignment_predicate_constants(size_t target_point, size_t rewrite_point, EqualityInvariant inv);
-  void get_states_at_cutpoint(size_t trace, size_t target_point, size_t rewrite_point, std::vector<DataCollector::TracePoint>& target_states, std::vector<DataCollector::TracePoint>& rewrite_states, bool bound) const;
+  void get_states_at_cutpoint(size_t trace, size_t target_point, size_t rewrite_point, std::vector<size_t>& target_states, std::vector<size_t>& rewrite_states, bool bound) const;
   bool test_alignment_predicate(std::shared_ptr<Invariant> inv);
+  /** Build the paa for an alignment predicate and test it on the traces. */
+  bool screen_alignment_predicate(std::shared_ptr<Invariant> inv, ProgramAlignmentAutomata&);
+  /** Try alignment predicates until one gives a proof. */
+  bool test_alignment_predicates(const std::vector<std::shared_ptr<Invariant>>& candidates);
 
   /** Invariants assumed to hold at any point. */
   std::vector<std::shared_ptr<Invariant>> assume_always_;
 
+  /** Evaluates candidate alignment predicates over the traces in bulk. */
+  AlignmentPrefilter prefilter_;
+  /** Counterexamples from every PAA tried for the current target and rewrite. */
+  CounterexamplePool ceg_pool_;
+  /** Verdicts on hoare triples seen for the current target and rewrite. */
+  ProofMemo memo_;
+  /** Orders the obligations of each fixpoint iteration. */
+  ObligationScheduler scheduler_;
+
   /** Bound */
   size_t target_bound_;
   size_t rewrite_bound_;
 
   /** Traces */
-  std::vector<DataCollector::Trace> target_traces_;
-  std::vector<DataCollector::Trace> rewrite_traces_;
+  std::vector<CompactTrace> target_traces_;
+  std::vector<CompactTrace> rewrite_traces_;
 
   /** Try to sign extend values? */
   bool try_sign_extend_;
@@ -139,6 +205,8 @@ private:
   bool benchmark_proof_succeeded_;
 
   size_t training_set_size_;
+  size_t parallel_predicates_;
+  bool alignment_prefilter_;
 };
 
 } // namespace stoke
@@ -17,6 +17,7 @@
 #define STOKE_SRC_VALIDATOR_FILTER_H
 
 #include <string>
+#include <typeinfo>
 
 #include "src/ext/x64asm/include/x64asm.h"
 #include "src/symstate/state.h"
@@ -49,6 +50,12 @@ public:
     return handler_;
   }
 
+  /** Describe the filter and handler, so that stored results are only reused
+    with the same ones. */
+  virtual std::string get_config() const {
+    return std::string(typeid(*this).name()) + " " + typeid(handler_).name();
+  }
+
 protected:
 
   std::string error_;
@@ -59,6 +59,12 @@ public:
     return constraints;
   }
 
+  std::string get_config() const override {
+    std::stringstream ss;
+    ss << Filter::get_config() << " " << low_ << " " << high_;
+    return ss.str();
+  }
+
 private:
 
   uint64_t low_;
@@ -65,6 +65,14 @@ public:
     return constraints;
   }
 
+  std::string get_config() const override {
+    std::stringstream ss;
+    ss << Filter::get_config();
+    for (size_t i = 0; i < low_.size(); ++i)
+      ss << " " << low_[i] << "-" << high_[i];
+    return ss.str();
+  }
+
 private:
 
   std::vector<uint64_t> low_;
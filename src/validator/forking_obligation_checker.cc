@@ -18,11 +18,13 @@
 #include "sys/types.h"
 #include "sys/wait.h"
 #include "signal.h"
+#include <algorithm>
 #include <chrono>
+#include <set>
 
 #include "src/validator/forking_obligation_checker.h"
 
-#define DEBUG_FORKING_CHECKER(X) { X }
+#define DEBUG_FORKING_CHECKER(X) { if(0) { X } }
 
 using namespace std;
 using namespace stoke;
@@ -49,24 +51,10 @@ void ForkingObligationChecker::check(
   vector<pid_t> friends;
   set<pid_t> friend_set;
 
-  for (auto child_checker : child_checkers_) {
-    block_until_free();
-
-    /** Check that all the friends are still running. */
-    bool still_running = false;
-    if (friends.size()) {
-      for (auto pi : process_info_) {
-        if (friend_set.count(pi.pid)) {
-          still_running = true;
-          break;
-        }
-      }
+  /** All the racers start together, so none can finish before the rest start. */
+  block_until_free(child_checkers_.size());
 
-      /** If the friends are not running, we're done! */
-      if (!still_running) {
-        return;
-      }
-    }
+  for (auto child_checker : child_checkers_) {
 
     /** Pipe and fork */
     DEBUG_FORKING_CHECKER(cout << "[check] pipe!" << endl;)
@@ -74,7 +62,9 @@ void ForkingObligationChecker::check(
     int result = pipe2(pipefd, O_NONBLOCK);
     if (result != 0) {
       perror("[check] pipe");
-      return_error(callback, "Call to pipe() failed", optional);
+      // if some racers started, they will answer
+      if (friends.size() == 0)
+        return_error(callback, "Call to pipe() failed", optional);
       return;
     }
 
@@ -92,7 +82,8 @@ void ForkingObligationChecker::check(
         stringstream ss;
         result.write_text(ss);
         ss << endl;
-        const char* buffer = ss.str().c_str();
+        auto str = ss.str();
+        const char* buffer = str.c_str();
         DEBUG_FORKING_CHECKER(cout << "BUFFER: " << buffer << endl;)
         size_t len = strlen(buffer);
 
@@ -264,12 +255,25 @@ void ForkingObligationChecker::poll_and_read(bool fast) {
     if (remove_set.count(pid))
       continue;
 
-    finish_process(pi);
-
     // add current entry to remove set
     to_remove.push_back(pid);
     remove_set.insert(pid);
 
+    // a racer without a definitive answer defers to the ones still running
+    auto result = get_result(pi);
+    bool definitive = !result.has_error && (result.verified || result.has_ceg);
+    bool friends_running = false;
+    for (auto& other : process_info_) {
+      if (!remove_set.count(other.pid) && count(friends.begin(), friends.end(), other.pid))
+        friends_running = true;
+    }
+    if (!definitive && friends_running)
+      continue;
+
+    DEBUG_FORKING_CHECKER(cout << "[poll_and_read] won by solver " << (size_t)result.solver
+                          << " with strategy " << (size_t)result.strategy << endl;)
+    (*pi.callback)(result, pi.optional);
+
     // add any friends to the remove set
     for (auto f : friends) {
       to_remove.push_back(f);
@@ -283,7 +287,6 @@ void ForkingObligationChecker::poll_and_read(bool fast) {
 
 
   /** Remove all structures related to PIDs.  This is slow, but OK. */
-  cout << "TO REMOVE: " << endl;
   for (auto pid : to_remove) {
     int index = -1;
     int fd = -1;
@@ -294,11 +297,14 @@ void ForkingObligationChecker::poll_and_read(bool fast) {
         break;
       }
     }
+    // friends that finished earlier are already gone
+    if (index == -1)
+      continue;
     for (size_t j = index; j < process_info_.size() - 1; ++j) {
       pollfds_[j] = pollfds_[j+1];
     }
     process_info_.erase(process_info_.begin() + index);
-    cout << "KILLING " << pid << endl;
+    DEBUG_FORKING_CHECKER(cout << "[poll_and_read] killing " << pid << endl;)
     kill(pid, SIGKILL);
     waitpid(pid, NULL, 0);
     close(fd);
@@ -307,16 +313,20 @@ void ForkingObligationChecker::poll_and_read(bool fast) {
   DEBUG_FORKING_CHECKER(print_table();)
 }
 
-void ForkingObligationChecker::finish_process(ProcessInfo& pi) const {
+ObligationChecker::Result ForkingObligationChecker::get_result(const ProcessInfo& pi) const {
   ObligationChecker::Result result;
   stringstream ss(pi.data);
   ss >> result;
-  DEBUG_FORKING_CHECKER(cout << "[finish_process] got result: " << endl;
+  if (pi.data.size() == 0 || ss.fail()) {
+    result.verified = false;
+    result.has_ceg = false;
+    result.has_error = true;
+    result.error_message = "Checker process exited without a result";
+  }
+  DEBUG_FORKING_CHECKER(cout << "[get_result] got result: " << endl;
                         result.write_text(cout);
-                        cout << endl;
-                        cout << "calling callback at addr " << (uint64_t)pi.callback << endl;)
-  (*pi.callback)(result, pi.optional);
-  close(pi.fd);
+                        cout << endl;)
+  return result;
 }
 
 void ForkingObligationChecker::block_until_complete() {
@@ -326,9 +336,9 @@ void ForkingObligationChecker::block_until_complete() {
   }
 }
 
-void ForkingObligationChecker::block_until_free() {
+void ForkingObligationChecker::block_until_free(size_t n) {
   DEBUG_FORKING_CHECKER(cout << "[block_until_free] called" << endl;)
-  while (process_info_.size() == max_processes_) {
+  while (process_info_.size() + n > max_processes_) {
     poll_and_read(false);
   }
 }
@@ -21,6 +21,9 @@
 #include <string>
 
 #include "poll.h"
+#include "signal.h"
+#include "sys/wait.h"
+#include "unistd.h"
 
 #include "src/validator/obligation_checker.h"
 
@@ -32,6 +35,10 @@
 
 namespace stoke {
 
+/** Races all the child checkers on every obligation, each in its own
+  process.  The first definitive answer (verified or counterexample) wins and
+  the other racers are killed; if no racer is definitive, the last answer is
+  reported.  The result's solver and strategy say which child won. */
 class ForkingObligationChecker : public ObligationChecker {
 
 public:
@@ -41,6 +48,7 @@ public:
     max_processes_(max_procs)
   {
     assert(child_checkers_.size() > 0);
+    assert(max_processes_ >= child_checkers_.size());
     pollfds_ = new pollfd[max_processes_];
   }
 
@@ -67,6 +75,36 @@ public:
     return child_checkers_[0]->get_filter();
   }
 
+  /** Children keep their own alias strategies; the rest of the settings
+    apply to all of them. */
+  ObligationChecker& set_fixpoint_up(bool b) override {
+    ObligationChecker::set_fixpoint_up(b);
+    for (auto it : child_checkers_)
+      it->set_fixpoint_up(b);
+    return *this;
+  }
+
+  ObligationChecker& set_separate_stack(bool b) override {
+    ObligationChecker::set_separate_stack(b);
+    for (auto it : child_checkers_)
+      it->set_separate_stack(b);
+    return *this;
+  }
+
+  ObligationChecker& set_nacl(bool b) override {
+    ObligationChecker::set_nacl(b);
+    for (auto it : child_checkers_)
+      it->set_nacl(b);
+    return *this;
+  }
+
+  ObligationChecker& set_basic_block_ghosts(bool b) override {
+    ObligationChecker::set_basic_block_ghosts(b);
+    for (auto it : child_checkers_)
+      it->set_basic_block_ghosts(b);
+    return *this;
+  }
+
   /** Process a signal. Check all the running processes to see if they're completed. */
   void signal();
 
@@ -78,9 +116,12 @@ public:
     poll_and_read(false);
   }
 
-  /** Forget about everything that has been started. */ virtual void delete_all() {
+  /** Forget about everything that has been started. */
+  virtual void delete_all() {
     for (auto pi : process_info_) {
       kill(pi.pid, SIGKILL);
+      waitpid(pi.pid, NULL, 0);
+      close(pi.fd);
     }
     process_info_.clear();
     return;
@@ -122,10 +163,10 @@ private:
 
   /** Tries to read from one of the processes */
   void poll_and_read(bool fast);
-  /** Block until free thread. */
-  void block_until_free();
-  /** Call the callback and cleanup process. */
-  void finish_process(ProcessInfo& pi) const;
+  /** Block until there are n free processes. */
+  void block_until_free(size_t n = 1);
+  /** Parse the result a process sent back. */
+  Result get_result(const ProcessInfo& pi) const;
   /** Return an error to callback */
   void return_error(Callback& callback, std::string s, void* optional) const;
   /** For debugging */
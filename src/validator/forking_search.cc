@@ -0,0 +1,146 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cerrno>
+#include <cstdio>
+#include <iostream>
+
+#include "poll.h"
+#include "signal.h"
+#include "sys/wait.h"
+#include "unistd.h"
+
+#include "src/validator/forking_search.h"
+
+#define DEBUG_FORKING_SEARCH(X) { if(0) { X } }
+
+using namespace std;
+using namespace stoke;
+
+int ForkingSearch::run(size_t n, function<bool (size_t)> screen, function<bool (size_t)> prove) {
+  screened_out_ = 0;
+  int found = -1;
+  size_t next = 0;
+
+  while (found == -1 && (next < n || running_.size())) {
+
+    // screen candidates until every process is busy; rejections are cheap
+    // enough that they shouldn't wait behind a proof
+    while (found == -1 && next < n && (running_.size() < max_processes_ || max_processes_ <= 1)) {
+      size_t candidate = next++;
+      if (!screen(candidate)) {
+        screened_out_++;
+        continue;
+      }
+      if (max_processes_ <= 1 || !start(candidate, prove)) {
+        if (prove(candidate))
+          found = candidate;
+      }
+    }
+
+    if (found == -1 && running_.size())
+      found = wait_for_any();
+  }
+
+  for (auto& it : running_)
+    stop(it);
+  running_.clear();
+  return found;
+}
+
+bool ForkingSearch::start(size_t candidate, function<bool (size_t)>& prove) {
+  int pipefd[2];
+  if (pipe(pipefd) != 0) {
+    perror("[forking_search] pipe");
+    return false;
+  }
+
+  // anything still buffered would otherwise be printed twice
+  cout.flush();
+  cerr.flush();
+
+  pid_t pid = fork();
+  if (pid < 0) {
+    perror("[forking_search] fork");
+    close(pipefd[0]);
+    close(pipefd[1]);
+    return false;
+  }
+
+  if (pid == 0) {
+    // child; in a group of its own so that stop() gets its solvers too
+    setpgid(0, 0);
+    close(pipefd[0]);
+    char verdict = prove(candidate) ? 1 : 0;
+    cout.flush();
+    if (write(pipefd[1], &verdict, 1) != 1)
+      perror("[forking_search] write");
+    close(pipefd[1]);
+    _exit(0);
+  }
+
+  // parent; also set the group here, in case we kill the child before it gets to
+  setpgid(pid, pid);
+  close(pipefd[1]);
+  Child child;
+  child.pid = pid;
+  child.fd = pipefd[0];
+  child.candidate = candidate;
+  running_.push_back(child);
+  DEBUG_FORKING_SEARCH(cout << "[forking_search] candidate " << candidate << " in pid " << pid << endl;)
+  return true;
+}
+
+int ForkingSearch::wait_for_any() {
+  vector<pollfd> fds(running_.size());
+  for (size_t i = 0; i < running_.size(); ++i) {
+    fds[i].fd = running_[i].fd;
+    fds[i].events = POLLIN;
+    fds[i].revents = 0;
+  }
+
+  int ready = poll(fds.data(), fds.size(), -1);
+  if (ready < 0) {
+    if (errno != EINTR)
+      perror("[forking_search] poll");
+    return -1;
+  }
+
+  int found = -1;
+  for (size_t i = running_.size(); i > 0; --i) {
+    if (!fds[i-1].revents)
+      continue;
+
+    auto child = running_[i-1];
+    char verdict = 0;
+    // a child that died without writing anything didn't prove its candidate
+    if (read(child.fd, &verdict, 1) != 1)
+      verdict = 0;
+    close(child.fd);
+    waitpid(child.pid, NULL, 0);
+    running_.erase(running_.begin() + i - 1);
+
+    DEBUG_FORKING_SEARCH(cout << "[forking_search] candidate " << child.candidate << " done: " << (int)verdict << endl;)
+    if (verdict && found == -1)
+      found = child.candidate;
+  }
+  return found;
+}
+
+void ForkingSearch::stop(const Child& child) {
+  kill(-child.pid, SIGKILL);
+  kill(child.pid, SIGKILL);
+  waitpid(child.pid, NULL, 0);
+  close(child.fd);
+}
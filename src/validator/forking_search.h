@@ -0,0 +1,73 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef STOKE_SRC_VALIDATOR_FORKING_SEARCH_H
+#define STOKE_SRC_VALIDATOR_FORKING_SEARCH_H
+
+#include <functional>
+#include <vector>
+
+#include "sys/types.h"
+
+namespace stoke {
+
+/** Looks for the first of a list of candidates that can be proven, trying
+  several at once.  Each candidate first goes through a cheap screen in this
+  process; the ones that pass get an expensive proof attempt in a child
+  process of their own.  The first proof to succeed wins, and every other
+  attempt still running is killed, along with any processes it started.
+
+  The proof attempt for a candidate runs right after the screen passed it, so
+  it can use whatever state the screen set up.  With one process at most,
+  nothing is forked and candidates are tried one after another. */
+class ForkingSearch {
+
+public:
+
+  ForkingSearch(size_t max_procs) : max_processes_(max_procs), screened_out_(0) { }
+
+  /** Try candidates 0 through n-1.  Returns the one proven, or -1 if none was.
+    Proofs may succeed out of order, so with more than one process the
+    candidate returned need not be the first provable one. */
+  int run(size_t n, std::function<bool (size_t)> screen, std::function<bool (size_t)> prove);
+
+  /** Number of candidates the last run rejected without a proof attempt. */
+  size_t get_screened_out() const {
+    return screened_out_;
+  }
+
+private:
+
+  struct Child {
+    pid_t pid;
+    int fd;
+    size_t candidate;
+  };
+
+  /** Start a proof attempt; returns false if no process could be started. */
+  bool start(size_t candidate, std::function<bool (size_t)>& prove);
+  /** Wait for some attempt to finish; returns the candidate proven, or -1. */
+  int wait_for_any();
+  /** Kill an attempt and everything it started. */
+  void stop(const Child& child);
+
+  size_t max_processes_;
+  size_t screened_out_;
+  std::vector<Child> running_;
+
+};
+
+} // namespace stoke
+
+#endif
@@ -13,7 +13,6 @@
 // limitations under the License.
 
 #include "src/validator/int_matrix.h"
-#include "src/validator/sage.h"
 
 #include <cassert>
 #include <chrono>
@@ -34,9 +33,6 @@ using namespace std;
 using namespace std::chrono;
 using namespace stoke;
 
-// TODO: use temporary files for SAGE
-
-
 IntVector IntMatrix::operator*(IntVector& vect) const {
   auto& matrix = *this;
   assert(matrix.size() == 0 || matrix[0].size() == vect.size());
@@ -83,212 +79,326 @@ bool IntMatrix::in_nullspace(IntVector& vect) const {
   return true;
 }
 
-IntMatrix IntMatrix::solve_diophantine() const {
-  assert(check_rectangle());
-  assert(this->size() > 0);
-  assert((*this)[0].size() > 0);
+namespace {
 
-  auto& matrix = *this;
-  Sage sage;
-  auto& of = sage.get_stream();
-  of << "f = open(\"" << sage.get_tmp_filename() << "\", 'w')" << endl;
-  of << "rows=" << matrix.size() << endl;
-  of << "cols=" << matrix[0].size() << endl;
-  of << "ZZ=IntegerRing()" << endl;
-  of << "A = MatrixSpace(ZZ, rows, cols)([";
-  for (size_t i = 0; i < matrix.size(); ++i) {
-    for (size_t j = 0; j < matrix[i].size(); ++j) {
-      of << matrix[i][j];
-      if (i < matrix.size() - 1 || j < matrix[i].size() - 1)
-        of << ", ";
+typedef __int128 int128_t;
+
+/** Number of trailing zero bits; 64 for zero. */
+size_t valuation(uint64_t x) {
+  return x ? __builtin_ctzll(x) : 64;
+}
+
+/** Inverse of an odd number mod 2^64, by Newton's method.  x = u is right in
+  the low 3 bits, and each step doubles that. */
+uint64_t inverse(uint64_t u) {
+  assert(u & 1);
+  uint64_t x = u;
+  for (size_t i = 0; i < 5; ++i)
+    x *= 2 - u*x;
+  return x;
+}
+
+/** row -= q * pivot, mod 2^64 */
+void subtract_row(vector<uint64_t>& row, const vector<uint64_t>& pivot, uint64_t q) {
+  for (size_t i = 0; i < row.size(); ++i)
+    row[i] -= q*pivot[i];
+}
+
+/** The Howell form of rows over Z/2^64: echelon form where each pivot is a
+  power of two, entries above a pivot 2^v are below 2^v, and for every k the
+  rows that start with k zeros span everything in the row space that does.
+  Rows are added as it goes so the last part holds; see Storjohann and
+  Mulders, "Fast algorithms for linear algebra modulo N" (1998). */
+vector<vector<uint64_t>> howell(vector<vector<uint64_t>> rows, size_t cols) {
+  size_t r = 0;
+  for (size_t c = 0; c < cols && r < rows.size(); ++c) {
+
+    // the pivot has the fewest factors of two; every other entry in the
+    // column is then a multiple of it
+    size_t pivot = r;
+    for (size_t i = r + 1; i < rows.size(); ++i)
+      if (valuation(rows[i][c]) < valuation(rows[pivot][c]))
+        pivot = i;
+    size_t v = valuation(rows[pivot][c]);
+    if (v == 64)
+      continue;
+    swap(rows[r], rows[pivot]);
+
+    // scale to make the pivot 2^v
+    uint64_t unit = inverse(rows[r][c] >> v);
+    for (auto& it : rows[r])
+      it *= unit;
+
+    for (size_t i = 0; i < rows.size(); ++i) {
+      if (i == r)
+        continue;
+      uint64_t q = rows[i][c] >> v;
+      if (q)
+        subtract_row(rows[i], rows[r], q);
     }
-  }
-  of << "])" << endl;
-  of << "D,U,V=A.smith_form()" << endl;
-  of << "min_dim = min(rows,cols)" << endl;
-  of << "diagonals = [ D[i][i] for i in range(0,min_dim) if D[i][i] != 0]" << endl;
-  of << "nz_diag = len(diagonals)" << endl;
-  of << "bv_len = len(V.rows())" << endl;
-  of << "basis = [ [0]*nz_diag + [0]*i + [1] + [0]*(bv_len-nz_diag-i-1) for i in range(0,bv_len-nz_diag)]" << endl;
-  of << "dim = len(basis)" << endl;
-  of << "outputs = [ V*vector(b) for b in basis ]" << endl;
-  of << "print >>f, len(outputs), len(outputs[0])" << endl;
-  of << "for output in outputs:" << endl;
-  of << "\tprint >>f, \" \".join(map(lambda x:str(x), output))" << endl;
-  of << "f.close()" << endl;
-  of << endl;
-
-  /** Run sage */
-  sage.run();
-
-  ifstream in(sage.get_tmp_filename());
-
-  /** Read basis vectors from sage */
-  IntMatrix basis_vectors;
-  size_t output_rows, output_cols;
-  in >> output_rows >> output_cols;
-  if (!in.good()) {
-    assert(false);
-    return basis_vectors;
-  }
-  for (size_t i = 0; i < output_rows; ++i) {
-    IntVector row;
-    for (size_t j = 0; j < output_cols; ++j) {
-
-      uint64_t x;
-      in >> x;
-
-      /** Check to make sure that we don't have any parser errors */
-      if (!in.good()) {
-        assert(false);
-        cout << "Got bad SAGE output" << endl;
-        exit(1);
-        return basis_vectors;
-      }
 
-      row.push_back((int64_t)x);
+    // 2^(64-v) times the pivot row is zero up to here, but maybe not after
+    if (v > 0) {
+      auto annihilated = rows[r];
+      for (auto& it : annihilated)
+        it <<= (64 - v);
+      bool zero = true;
+      for (auto it : annihilated)
+        zero &= (it == 0);
+      if (!zero)
+        rows.push_back(annihilated);
     }
-    basis_vectors.push_back(row);
+
+    r++;
   }
 
-  return basis_vectors;
+  rows.resize(r);
+  return rows;
 }
 
-IntMatrix IntMatrix::nullspace64() const {
-  auto& matrix = *this;
+typedef unsigned __int128 uint128_t;
 
-  Sage sage;
-  auto& of = sage.get_stream();
-  of << "f = open(\"" << sage.get_tmp_filename() << "\", 'w')" << endl;
-  of << "rows=" << matrix.size() << endl;
-  of << "cols=" << matrix[0].size() << endl;
-  of << "src=ZZ**rows/(ZZ**rows * 2**64)" << endl;
-  of << "dst=ZZ**cols/(ZZ**cols * 2**64)" << endl;
-  of << "A = matrix([";
-  for (size_t i = 0; i < matrix.size(); ++i) {
-    of << "[ ";
-    for (size_t j = 0; j < matrix[i].size(); ++j) {
-      of << matrix[i][j];
-      if (j < matrix[i].size() - 1)
-        of << ", ";
+const int128_t min_int128 = (int128_t)((uint128_t)1 << 127);
+
+/** |x|, which always fits unsigned. */
+uint128_t magnitude(int128_t x) {
+  return x < 0 ? -(uint128_t)x : (uint128_t)x;
+}
+
+/** out = a - b*c; false if that overflows. */
+bool mul_sub(int128_t a, int128_t b, int128_t c, int128_t& out) {
+  int128_t product;
+  return !__builtin_mul_overflow(b, c, &product) && !__builtin_sub_overflow(a, product, &out);
+}
+
+/** out = a + b*c; false if that overflows. */
+bool mul_add(int128_t a, int128_t b, int128_t c, int128_t& out) {
+  int128_t product;
+  return !__builtin_mul_overflow(b, c, &product) && !__builtin_add_overflow(a, product, &out);
+}
+
+/** Narrow to 64 bits; false if x doesn't fit. */
+bool narrow(int128_t x, int64_t& out) {
+  out = (int64_t)x;
+  return (int128_t)out == x;
+}
+
+/** Column echelon form over the integers.  Finds a unimodular V with
+  A*V = [H | 0], where H is lower echelon with a column per pivot row.
+  Sets the pivot rows, in order.  Returns false if an entry overflowed 128
+  bits; then H and V are meaningless. */
+bool column_echelon(const IntMatrix& matrix,
+                    vector<vector<int128_t>>& h,
+                    vector<vector<int128_t>>& v,
+                    vector<size_t>& pivot_rows) {
+  size_t rows = matrix.rows();
+  size_t cols = matrix.cols();
+
+  h.assign(rows, vector<int128_t>(cols, 0));
+  for (size_t i = 0; i < rows; ++i)
+    for (size_t j = 0; j < cols; ++j)
+      h[i][j] = matrix[i][j];
+  v.assign(cols, vector<int128_t>(cols, 0));
+  for (size_t j = 0; j < cols; ++j)
+    v[j][j] = 1;
+
+  auto swap_columns = [&](vector<vector<int128_t>>& m, size_t r, size_t j) {
+    for (auto& row : m)
+      swap(row[r], row[j]);
+  };
+  // col_j -= q*col_r, in both H and V
+  auto subtract_column = [&](size_t r, size_t j, int128_t q) {
+    for (auto m : { &h, &v })
+      for (auto& row : *m)
+        if (!mul_sub(row[j], q, row[r], row[j]))
+          return false;
+    return true;
+  };
+
+  pivot_rows.clear();
+  size_t r = 0;
+  for (size_t i = 0; i < rows && r < cols; ++i) {
+    // Euclid's algorithm across the row: bring the smallest entry to column
+    // r and reduce the others by it, until they're all zero.  Going by the
+    // smallest keeps the entries of V from blowing up.
+    while (true) {
+      size_t smallest = cols;
+      for (size_t j = r; j < cols; ++j) {
+        if (h[i][j] == 0)
+          continue;
+        if (smallest == cols || magnitude(h[i][j]) < magnitude(h[i][smallest]))
+          smallest = j;
+      }
+      if (smallest == cols)
+        break;
+      swap_columns(h, r, smallest);
+      swap_columns(v, r, smallest);
+
+      bool done = true;
+      for (size_t j = r + 1; j < cols; ++j) {
+        if (h[i][j] == 0)
+          continue;
+        // the pivot is smallest, so only min / -1 can overflow
+        if (h[i][r] == -1 && h[i][j] == min_int128)
+          return false;
+        // round to nearest, so what's left is at most half the pivot
+        auto q = h[i][j] / h[i][r];
+        auto rest = h[i][j] % h[i][r];
+        if (2*magnitude(rest) > magnitude(h[i][r]))
+          q += ((rest < 0) == (h[i][r] < 0)) ? 1 : -1;
+        if (!subtract_column(r, j, q))
+          return false;
+        done &= (h[i][j] == 0);
+      }
+      if (done)
+        break;
     }
-    of << "]";
-    if (i < matrix.size() - 1)
-      of << ", ";
-  }
-  of << "])" << endl;
-  of << "A = A.transpose()" << endl;
-  of << "vectors = [src(x) for x in A]" << endl;
-  of << "phi = dst.hom(vectors, src)" << endl;
-  of << "ker = phi.kernel()" << endl;
-  of << "output = [dst(b) for b in phi.kernel().gens()]" << endl;
-  of << "print >>f, len(output)" << endl;
-  of << "for entry in output:" << endl;
-  of << "\tfor item in entry:" << endl;
-  of << "\t\tprint >>f, item" << endl;
-  of << "f.close()" << endl;
-  of << endl;
-
-  sage.run();
-  ifstream in(sage.get_tmp_filename());
-
-  /** Read basis vectors from sage */
-  size_t output_rows;
-  size_t output_cols = matrix[0].size();
-  in >> output_rows;
-  if (!in.good()) {
-    cout << "Couldn't read output rows :(" << endl;
-    assert(false);
-  }
-  //cout << "Looking for " << output_rows << " rows" << endl;
-  IntMatrix output(output_rows, output_cols);
-  for (size_t i = 0; i < output_rows; ++i) {
-    for (size_t j = 0; j < output_cols; ++j) {
-      uint64_t x;
-      in >> x;
-
-      /** Check to make sure that we don't have any parser errors */
-      if (!in.good()) {
-        //cout << "Couldn't read entry :(" << endl;
-        assert(false);
-        cout << "Got bad SAGE output" << endl;
-        exit(1);
-        return output;
+
+    if (h[i][r] != 0) {
+      // Hermite form: a positive pivot, with the entries before it reduced
+      if (h[i][r] < 0 && !subtract_column(r, r, 2))
+        return false;
+      for (size_t k = 0; k < r; ++k) {
+        auto q = h[i][k] / h[i][r];
+        if (h[i][k] % h[i][r] < 0)
+          q--;
+        if (!subtract_column(r, k, q))
+          return false;
       }
 
-      output[i][j] = x;
-      //cout << "Reading " << x << endl;
+      pivot_rows.push_back(i);
+      r++;
     }
   }
-
-  return output;
+  return true;
 }
 
-IntVector IntMatrix::solve_diophantine(IntVector b) const {
+} // namespace
+
+IntMatrix IntMatrix::howell_form() const {
   auto& matrix = *this;
+  vector<vector<uint64_t>> rows;
+  for (auto& it : matrix)
+    rows.push_back(vector<uint64_t>(it.begin(), it.end()));
 
-  Sage sage;
+  IntMatrix result;
+  for (auto& it : howell(rows, cols()))
+    result.push_back(vector<int64_t>(it.begin(), it.end()));
+  return result;
+}
 
-  auto& of = sage.get_stream();
-  of << "f = open(\"" << sage.get_tmp_filename() << "\", 'w')" << endl;
-  of << "rows=" << matrix.size() << endl;
-  of << "cols=" << matrix[0].size() << endl;
-  of << "ZZ=IntegerRing()" << endl;
-  of << "A = MatrixSpace(ZZ, rows, cols)([";
-  for (size_t i = 0; i < matrix.size(); ++i) {
-    for (size_t j = 0; j < matrix[i].size(); ++j) {
-      of << matrix[i][j];
-      if (i < matrix.size() - 1 || j < matrix[i].size() - 1)
-        of << ", ";
-    }
-  }
-  of << "])" << endl;
-  of << "C = MatrixSpace(ZZ, rows, 1)([";
-  for (size_t i = 0; i < b.size(); ++i) {
-    of << b[i] << ", ";
+bool IntMatrix::solve_diophantine(IntMatrix& basis) const {
+  assert(check_rectangle());
+  assert(this->size() > 0);
+  assert((*this)[0].size() > 0);
+
+  basis.clear();
+  vector<vector<int128_t>> h;
+  vector<vector<int128_t>> v;
+  vector<size_t> pivots;
+  if (!column_echelon(*this, h, v, pivots))
+    return false;
+
+  /** The columns of V past the pivots are a basis for the kernel */
+  for (size_t j = pivots.size(); j < cols(); ++j) {
+    IntVector row(cols());
+    for (size_t i = 0; i < cols(); ++i)
+      if (!narrow(v[i][j], row[i])) {
+        basis.clear();
+        return false;
+      }
+    basis.push_back(row);
   }
-  of << "])" << endl;
-  of << "B,U,V=A.smith_form()" << endl;
-  of << "min_dim = min(rows,cols)" << endl;
-  of << "diagonals = [ B[i][i] for i in range(0,min_dim) if B[i][i] != 0]" << endl;
-  of << "nz_diag = len(diagonals)" << endl;
-  of << "D = U*C" << endl;
-  of << "solution = [ D[i][0] // B[i][i] for i in range(0, nz_diag) ] + [0]*(cols-nz_diag)" << endl;
-  of << "output = V*vector(solution)" << endl;
-  of << "print >>f, len(output)" << endl;
-  of << "for entry in output:" << endl;
-  of << "\tprint >>f, entry" << endl;
-  of << "f.close()" << endl;
-  of << endl;
-
-  sage.run();
-  ifstream in(sage.get_tmp_filename());
-  /** Read basis vectors from sage */
-  IntVector output;
-  size_t output_rows;
-  in >> output_rows;
-  if (!in.good()) {
-    assert(false);
-    return output;
+
+  return true;
+}
+
+IntMatrix IntMatrix::nullspace64() const {
+  auto& matrix = *this;
+  size_t rows = matrix.size();
+  size_t cols = matrix[0].size();
+
+  /** Row reduce [A^T | I].  Each row stays of the form [A^T x | x]; the
+    rows that start with rows zeros are the kernel, in Howell form. */
+  vector<vector<uint64_t>> augmented(cols, vector<uint64_t>(rows + cols, 0));
+  for (size_t j = 0; j < cols; ++j) {
+    for (size_t i = 0; i < rows; ++i)
+      augmented[j][i] = matrix[i][j];
+    augmented[j][rows + j] = 1;
   }
-  for (size_t i = 0; i < output_rows; ++i) {
-    uint64_t x;
-    in >> x;
-
-    /** Check to make sure that we don't have any parser errors */
-    if (!in.good()) {
-      assert(false);
-      cout << "Got bad SAGE output" << endl;
-      exit(1);
-      return output;
-    }
 
-    output.push_back((int64_t)x);
+  IntMatrix output;
+  for (auto& it : howell(augmented, rows + cols)) {
+    bool in_kernel = true;
+    for (size_t i = 0; i < rows; ++i)
+      in_kernel &= (it[i] == 0);
+    if (in_kernel)
+      output.push_back(vector<int64_t>(it.begin() + rows, it.end()));
   }
 
   return output;
 }
 
+bool IntMatrix::solve_diophantine(const IntVector& b, IntVector& x) const {
+  assert(b.size() == rows());
+
+  x.clear();
+  vector<vector<int128_t>> h;
+  vector<vector<int128_t>> v;
+  vector<size_t> pivots;
+  if (!column_echelon(*this, h, v, pivots))
+    return false;
+
+  /** Solve H y = b by substitution down the pivot rows; like the Smith form
+    solution, the division rounds down if there's no exact solution.  The
+    pivots are positive. */
+  vector<int128_t> y(cols(), 0);
+  for (size_t k = 0; k < pivots.size(); ++k) {
+    auto row = pivots[k];
+    int128_t rest = b[row];
+    for (size_t l = 0; l < k; ++l)
+      if (!mul_sub(rest, h[row][l], y[l], rest))
+        return false;
+    int128_t d = h[row][k];
+    int128_t q = rest / d;
+    if (rest % d < 0)
+      q--;
+    y[k] = q;
+  }
+
+  vector<int128_t> sum(cols(), 0);
+  for (size_t i = 0; i < cols(); ++i)
+    for (size_t k = 0; k < pivots.size(); ++k)
+      if (!mul_add(sum[i], v[i][k], y[k], sum[i]))
+        return false;
+
+  // Any multiple of a kernel column, past the pivots of V, can be added.
+  // Take off what shrinks each one's largest entry, so the solution is more
+  // likely to fit 64 bits.
+  for (size_t pass = 0; pass < 2; ++pass) {
+    for (size_t j = pivots.size(); j < cols(); ++j) {
+      size_t largest = 0;
+      for (size_t i = 1; i < cols(); ++i)
+        if (magnitude(v[i][j]) > magnitude(v[largest][j]))
+          largest = i;
+      if (v[largest][j] == 0 || (v[largest][j] == -1 && sum[largest] == min_int128))
+        continue;
+      auto t = sum[largest] / v[largest][j];
+      for (size_t i = 0; t && i < cols(); ++i)
+        if (!mul_sub(sum[i], t, v[i][j], sum[i]))
+          return false;
+    }
+  }
+
+  IntVector output(cols());
+  for (size_t i = 0; i < cols(); ++i)
+    if (!narrow(sum[i], output[i]))
+      return false;
+
+  x = output;
+  return true;
+}
+
 void IntMatrix::print() const {
   auto& m = *this;
   for (size_t i =0; i < m.size(); ++i) {
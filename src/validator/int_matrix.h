@@ -57,13 +57,18 @@ public:
   /** Check if vector is in nullspace */
   bool in_nullspace(IntVector& vect) const;
 
-  /** Compute a generating set for the nullspace over Z/2^64Z */
+  /** Compute a generating set for the nullspace over Z/2^64Z, in Howell form */
   IntMatrix nullspace64() const;
-
-  /** Return generating set to solutions of Ax = 0 */
-  IntMatrix solve_diophantine() const;
-  /** Returns a solution to Ax = b */
-  IntVector solve_diophantine(IntVector b) const;
+  /** The Howell form of the rows over Z/2^64Z; two matrices span the same
+    rows exactly when these are equal. */
+  IntMatrix howell_form() const;
+
+  /** Find a generating set for the integer solutions of Ax = 0.  Returns
+    false, with no basis, if a value overflowed 128 bits along the way or
+    an entry of the basis doesn't fit 64. */
+  bool solve_diophantine(IntMatrix& basis) const;
+  /** Find a solution to Ax = b; the same overflows make it return false. */
+  bool solve_diophantine(const IntVector& b, IntVector& x) const;
 
   size_t rows() const {
     return size();
@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include "src/validator/compiled_invariant.h"
 #include "src/validator/invariant.h"
 #include "src/validator/invariants.h"
 
@@ -63,6 +64,10 @@ void Invariant::get_dereference_map(DereferenceMap& deref_map,
 };
 
 
+void Invariant::compile(CompiledInvariant& program) const {
+  program.fallback(*this);
+}
+
 std::shared_ptr<Invariant> Invariant::deserialize(istream& in) {
   string class_name;
   in >> ws >> class_name;
@@ -23,6 +23,7 @@
 
 namespace stoke {
 
+class CompiledInvariant;
 class ConjunctionInvariant;
 
 class Invariant {
@@ -84,6 +85,10 @@ public:
     return true;
   }
 
+  /** Emit the operations that evaluate this invariant over a batch of
+    states.  By default, the batch is checked pair by pair. */
+  virtual void compile(CompiledInvariant& program) const;
+
   virtual std::vector<Variable> get_variables() const {
     std::vector<Variable> empty;
     return empty;
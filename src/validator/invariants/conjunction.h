@@ -15,6 +15,7 @@
 #ifndef STOKE_SRC_VALIDATOR_INVARIANT_CONJUNCTION_H
 #define STOKE_SRC_VALIDATOR_INVARIANT_CONJUNCTION_H
 
+#include "src/validator/compiled_invariant.h"
 #include "src/validator/invariant.h"
 
 namespace stoke {
@@ -86,6 +87,12 @@ public:
     return true;
   }
 
+  void compile(CompiledInvariant& program) const override {
+    for (auto it : invariants_)
+      it->compile(program);
+    program.conjoin(invariants_.size());
+  }
+
   std::ostream& write_pretty(std::ostream& os) const override {
 
     if (invariants_.size() == 0) {
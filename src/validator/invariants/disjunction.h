@@ -15,6 +15,7 @@
 #ifndef STOKE_SRC_VALIDATOR_INVARIANT_DISJUNCTION_H
 #define STOKE_SRC_VALIDATOR_INVARIANT_DISJUNCTION_H
 
+#include "src/validator/compiled_invariant.h"
 #include "src/validator/invariant.h"
 
 namespace stoke {
@@ -71,6 +72,12 @@ public:
     return false;
   }
 
+  void compile(CompiledInvariant& program) const override {
+    for (auto it : invariants_)
+      it->compile(program);
+    program.disjoin(invariants_.size());
+  }
+
   std::ostream& write(std::ostream& os) const override {
 
     if (invariants_.size() == 0) {
@@ -29,6 +29,7 @@
 #ifndef STOKE_SRC_VALIDATOR_INVARIANT_EQUALITY_H
 #define STOKE_SRC_VALIDATOR_INVARIANT_EQUALITY_H
 
+#include "src/validator/compiled_invariant.h"
 #include "src/validator/invariant.h"
 #include "src/validator/variable.h"
 
@@ -132,6 +133,10 @@ public:
       return ((uint64_t)constant_ - sum) % modulus_ == 0;
   }
 
+  void compile(CompiledInvariant& program) const override {
+    program.linear(terms_, (uint64_t)constant_, modulus_);
+  }
+
   /** Calculate the sum of terms on the left hand side. */
   uint64_t calculate_lhs(const CpuState& target, const CpuState& rewrite) const {
     uint64_t sum = 0;
@@ -211,6 +216,14 @@ public:
     return terms_;
   }
 
+  long get_constant() const {
+    return constant_;
+  }
+
+  uint64_t get_modulus() const {
+    return modulus_;
+  }
+
   /** return true if we're sure that *this does not imply inv. */
   virtual bool does_not_imply(std::shared_ptr<Invariant> inv) const override {
     auto casted = std::dynamic_pointer_cast<EqualityInvariant>(inv);
@@ -15,6 +15,7 @@
 #ifndef STOKE_SRC_VALIDATOR_INVARIANT_FALSE_H
 #define STOKE_SRC_VALIDATOR_INVARIANT_FALSE_H
 
+#include "src/validator/compiled_invariant.h"
 #include "src/validator/invariant.h"
 
 
@@ -40,6 +41,10 @@ public:
     return false;
   }
 
+  void compile(CompiledInvariant& program) const override {
+    program.constant(false);
+  }
+
   virtual std::ostream& serialize(std::ostream& out) const override {
     out << "FalseInvariant" << std::endl;
     return out;
@@ -15,6 +15,7 @@
 #ifndef STOKE_SRC_VALIDATOR_INVARIANT_IMPLICATION_H
 #define STOKE_SRC_VALIDATOR_INVARIANT_IMPLICATION_H
 
+#include "src/validator/compiled_invariant.h"
 #include "src/validator/invariant.h"
 
 namespace stoke {
@@ -50,6 +51,13 @@ public:
     return !a | b;
   }
 
+  void compile(CompiledInvariant& program) const override {
+    a_->compile(program);
+    program.negate();
+    b_->compile(program);
+    program.disjoin(2);
+  }
+
   std::ostream& write(std::ostream& os) const {
 
     os << "( ";
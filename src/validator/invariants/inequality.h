@@ -15,6 +15,7 @@
 #ifndef STOKE_SRC_VALIDATOR_INVARIANT_INEQUALITY_H
 #define STOKE_SRC_VALIDATOR_INVARIANT_INEQUALITY_H
 
+#include "src/validator/compiled_invariant.h"
 #include "src/validator/invariant.h"
 #include "src/validator/variable.h"
 
@@ -120,6 +121,30 @@ public:
     return false;
   }
 
+  void compile(CompiledInvariant& program) const override {
+    size_t bits = 0;
+    if (is_signed_) {
+      switch (variable1_.size) {
+      case 1:
+        bits = 8;
+        break;
+      case 2:
+        bits = 16;
+        break;
+      case 3:
+        bits = 32;
+        break;
+      case 4:
+        bits = 64;
+        break;
+      default:
+        program.fallback(*this);
+        return;
+      }
+    }
+    program.compare(variable1_, lhs_constant_, variable2_, bits, is_strict_);
+  }
+
   std::ostream& write(std::ostream& os) const {
     os << variable1_;
     if (lhs_constant_ != 0) {
@@ -15,6 +15,7 @@
 #ifndef STOKE_SRC_VALIDATOR_INVARIANT_MOD2N_H
 #define STOKE_SRC_VALIDATOR_INVARIANT_MOD2N_H
 
+#include "src/validator/compiled_invariant.h"
 #include "src/validator/invariant.h"
 
 namespace stoke {
@@ -49,6 +50,11 @@ public:
     return anded == 0;
   }
 
+  void compile(CompiledInvariant& program) const override {
+    uint64_t mask = (1 << zero_bits_) - 1;
+    program.mask_zero(variable_, mask);
+  }
+
   virtual std::vector<Variable> get_variables() const {
     std::vector<Variable> result;
     result.push_back(variable_);
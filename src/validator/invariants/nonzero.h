@@ -15,6 +15,7 @@
 #ifndef STOKE_SRC_VALIDATOR_INVARIANT_NONZERO_H
 #define STOKE_SRC_VALIDATOR_INVARIANT_NONZERO_H
 
+#include "src/validator/compiled_invariant.h"
 #include "src/validator/invariant.h"
 
 namespace stoke {
@@ -51,6 +52,12 @@ public:
       return (variable_.from_state(target,rewrite) == 0);
   }
 
+  void compile(CompiledInvariant& program) const override {
+    program.mask_zero(variable_, (uint64_t)(-1));
+    if (!negate_)
+      program.negate();
+  }
+
   virtual std::vector<Variable> get_variables() const {
     std::vector<Variable> result;
     result.push_back(variable_);
@@ -15,6 +15,7 @@
 #ifndef STOKE_SRC_VALIDATOR_INVARIANT_NOT_H
 #define STOKE_SRC_VALIDATOR_INVARIANT_NOT_H
 
+#include "src/validator/compiled_invariant.h"
 #include "src/validator/invariant.h"
 
 namespace stoke {
@@ -40,6 +41,11 @@ public:
     return !a;
   }
 
+  void compile(CompiledInvariant& program) const override {
+    a_->compile(program);
+    program.negate();
+  }
+
   std::ostream& write(std::ostream& os) const {
 
     os << "!( ";
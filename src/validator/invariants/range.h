@@ -15,6 +15,7 @@
 #ifndef STOKE_SRC_VALIDATOR_INVARIANT_RANGE_H
 #define STOKE_SRC_VALIDATOR_INVARIANT_RANGE_H
 
+#include "src/validator/compiled_invariant.h"
 #include "src/validator/invariant.h"
 #include "src/validator/variable.h"
 
@@ -44,6 +45,12 @@ public:
     return (min_ <= v) && (v <= max_);
   }
 
+  void compile(CompiledInvariant& program) const override {
+    program.bound(variable_, min_, false, false);
+    program.bound(variable_, max_, true, false);
+    program.conjoin(2);
+  }
+
   std::ostream& write(std::ostream& os) const {
     if (min_ > 0 && max_ < (uint64_t)(-1)) {
       os << min_ << " ≤ " << variable_ << " ≤ " << max_;
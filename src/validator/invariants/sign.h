@@ -15,6 +15,7 @@
 #ifndef STOKE_SRC_VALIDATOR_INVARIANT_SIGN_H
 #define STOKE_SRC_VALIDATOR_INVARIANT_SIGN_H
 
+#include "src/validator/compiled_invariant.h"
 #include "src/validator/invariant.h"
 
 namespace stoke {
@@ -51,6 +52,10 @@ public:
       return value <= 0;
   }
 
+  void compile(CompiledInvariant& program) const override {
+    program.bound(variable_, 0, !positive_, true);
+  }
+
   virtual std::vector<Variable> get_variables() const {
     std::vector<Variable> result;
     result.push_back(variable_);
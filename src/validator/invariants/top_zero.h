@@ -15,6 +15,7 @@
 #ifndef STOKE_SRC_VALIDATOR_INVARIANT_TOPZERO_H
 #define STOKE_SRC_VALIDATOR_INVARIANT_TOPZERO_H
 
+#include "src/validator/compiled_invariant.h"
 #include "src/validator/invariant.h"
 
 namespace stoke {
@@ -45,6 +46,10 @@ public:
     }
   }
 
+  void compile(CompiledInvariant& program) const override {
+    program.mask_zero(Variable(reg_, is_rewrite_), 0xffffffff00000000);
+  }
+
   std::ostream& write(std::ostream& os) const {
     os << reg_;
     if (is_rewrite_)
@@ -15,6 +15,7 @@
 #ifndef STOKE_SRC_VALIDATOR_INVARIANT_TRUE_H
 #define STOKE_SRC_VALIDATOR_INVARIANT_TRUE_H
 
+#include "src/validator/compiled_invariant.h"
 #include "src/validator/invariant.h"
 
 
@@ -40,6 +41,10 @@ public:
     return true;
   }
 
+  void compile(CompiledInvariant& program) const override {
+    program.constant(true);
+  }
+
   virtual std::ostream& serialize(std::ostream& out) const {
     out << "TrueInvariant" << std::endl;
     return out;
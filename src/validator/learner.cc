@@ -15,6 +15,7 @@
 #include <chrono>
 
 #include "src/state/cpu_state.h"
+#include "src/validator/compiled_invariant.h"
 #include "src/validator/invariants/conjunction.h"
 #include "src/validator/invariants/disjunction.h"
 #include "src/validator/invariants/equality.h"
@@ -463,54 +464,31 @@ vector<std::shared_ptr<InequalityInvariant>> InvariantLearner::build_inequality_
   return inequalities;
 }
 
-// https://stackoverflow.com/questions/19738919/gcd-function-for-c
-uint64_t InvariantLearner::euclid(uint64_t a, uint64_t b)
-{
-  while (b != 0)
-  {
-    a %= b;
-    a ^= b;
-    b ^= a;
-    a ^= b;
-  }
-
-  return a;
-}
-
-
 vector<std::shared_ptr<EqualityInvariant>> InvariantLearner::build_modulo_invariants(
     RegSet target_regs,
     RegSet rewrite_regs,
     const vector<CpuState>& target_states,
-const vector<CpuState>& rewrite_states) const {
+    const vector<CpuState>& rewrite_states,
+StateColumns& data) const {
 
   vector<std::shared_ptr<EqualityInvariant>> modulos;
 
   // For now, let's look at unsigned target-target and rewrite-rewrite modulo equalities
   for (size_t k = 0; k < 2; ++k) {
     auto regs = k ? rewrite_regs : target_regs;
-    const auto& states = k ? rewrite_states : target_states;
 
     for (auto i = regs.gp_begin(); i != regs.gp_end(); ++i) {
 
       // first, let's get gcd for all values for just this register
-      uint64_t onereg_gcd = 0;
-      uint64_t onereg_val = states[0][*i];
-      for (auto& it : states) {
-        auto value = it[*i] - onereg_val;
-        if (value != 0) {
-          if (onereg_gcd == 0)
-            onereg_gcd = value;
-          else
-            onereg_gcd = euclid(onereg_gcd, value);
-        }
-      }
+      auto& values = data.get(Variable(*i, k));
+      uint64_t onereg_val = values[0];
+      uint64_t onereg_gcd = StateColumns::difference_gcd(values);
       if (onereg_gcd > 1) {
         Variable v(*i, k);
         v.coefficient = 1;
         auto terms = {v};
         auto inv = std::make_shared<EqualityInvariant>(terms, onereg_val % onereg_gcd, onereg_gcd);
-        if (inv->check(target_states, rewrite_states))
+        if (CompiledInvariant(inv).check(data))
           modulos.push_back(inv);
       }
 
@@ -521,26 +499,15 @@ const vector<CpuState>& rewrite_states) const {
           continue;
 
         /** collect all the differences. */
-        vector<uint64_t> differences;
-        for (auto& it : states) {
-          differences.push_back(it[*i] - it[*j]);
-        }
+        auto& i_values = data.get(Variable(*i, k));
+        auto& j_values = data.get(Variable(*j, k));
+        vector<uint64_t> differences(i_values.size());
+        for (size_t s = 0; s < differences.size(); ++s)
+          differences[s] = i_values[s] - j_values[s];
 
         /** get gcd of all differences of differences */
-        uint64_t gcd = 0;
         uint64_t some_diff = differences[0];
-        for (size_t s = 1; s < differences.size(); ++s) {
-          auto difference = differences[s] - some_diff;
-          if (difference != 0) {
-            if (gcd == 0)
-              gcd = difference;
-            else
-              gcd = euclid(gcd, difference);
-          }
-
-          if (gcd == 1)
-            break;
-        }
+        uint64_t gcd = StateColumns::difference_gcd(differences);
 
         /** if we have a gcd greater than 1, create an invariant. */
         if (gcd > 1) {
@@ -551,7 +518,7 @@ const vector<CpuState>& rewrite_states) const {
           auto terms = {v, w};
           some_diff = some_diff % gcd;
           auto inv = std::make_shared<EqualityInvariant>(terms, some_diff, gcd);
-          if (inv->check(target_states, rewrite_states)) {
+          if (CompiledInvariant(inv).check(data)) {
             modulos.push_back(inv);
           }
         }
@@ -566,10 +533,7 @@ const vector<CpuState>& rewrite_states) const {
 vector<std::shared_ptr<InequalityInvariant>> InvariantLearner::build_inequality_with_constant_invariants(
       RegSet target_regs,
       RegSet rewrite_regs,
-      const vector<CpuState>& target_states,
-const vector<CpuState>& rewrite_states) {
-
-  assert(target_states.size() == rewrite_states.size());
+StateColumns& data) {
 
   vector<std::shared_ptr<InequalityInvariant>> outputs;
   vector<Variable> variables;
@@ -599,11 +563,13 @@ const vector<CpuState>& rewrite_states) {
   uniform_int_distribution<size_t> dis(0, 100);
 
   for (auto& v1 : variables) {
+    auto& v1_values = data.get(v1);
     for (auto& v2 : variables) {
       if (v1 == v2)
         continue;
       if (v1.size != v2.size)
         continue;
+      auto& v2_values = data.get(v2);
 
       // look for invariants of the form
       // i + constant <= j   (i.e. constant <= j - i)
@@ -617,16 +583,14 @@ const vector<CpuState>& rewrite_states) {
       uint64_t max_difference = 0;
       uint64_t max_count = 0;
       uint64_t min_count = 0;
-      for (size_t i = 0 ; i < target_states.size(); ++i) {
+      for (size_t i = 0 ; i < data.rows(); ++i) {
 
 
         size_t choice = dis(gen_);
-        if (choice <= 10 && target_states.size() > 20)
+        if (choice <= 10 && data.rows() > 20)
           continue;
 
-        auto a = v1.from_state(target_states[i], rewrite_states[i]);
-        auto b = v2.from_state(target_states[i], rewrite_states[i]);
-        uint64_t difference = b - a;
+        uint64_t difference = v2_values[i] - v1_values[i];
         //cout << "  difference " << difference << endl;
         if (difference > max_difference) {
           max_difference = difference;
@@ -664,7 +628,8 @@ vector<std::shared_ptr<RangeInvariant>> InvariantLearner::build_range_invariants
                                        RegSet target_regs,
                                        RegSet rewrite_regs,
                                        const vector<CpuState>& target_states,
-const vector<CpuState>& rewrite_states) const {
+                                       const vector<CpuState>& rewrite_states,
+StateColumns& data) const {
 
   vector<std::shared_ptr<RangeInvariant>> ranges;
   vector<Variable> variables;
@@ -685,30 +650,11 @@ const vector<CpuState>& rewrite_states) const {
 
   for (auto var : variables) {
 
-    uint64_t min = (uint64_t)(-1);
-    uint64_t max = 0;
-    uint64_t min_count = 0;
-    uint64_t max_count = 0;
-
-    for (size_t i = 0; i < target_states.size(); ++i) {
-      auto ts = target_states[i];
-      auto rs = rewrite_states[i];
-
-      auto value = var.from_state(ts, rs);
-      if (value == max) {
-        max_count++;
-      } else if (value > max) {
-        max = value;
-        max_count = 1;
-      }
-      if (value == min) {
-        min_count++;
-      }
-      if (value < min) {
-        min = value;
-        min_count = 1;
-      }
-    }
+    uint64_t min;
+    uint64_t max;
+    size_t min_count;
+    size_t max_count;
+    StateColumns::range(data.get(var), min, min_count, max, max_count);
 
     if (min_count > 2) {
       auto inv = std::make_shared<RangeInvariant>(var, min, (uint64_t)(-1));
@@ -822,40 +768,31 @@ const vector<CpuState>& rewrite_states) {
   return inv;
 }
 
-std::pair<std::vector<CpuState>, std::vector<CpuState>> InvariantLearner::choose_tcs(
-      const std::vector<CpuState>& target_states,
-const std::vector<CpuState>& rewrite_states) {
-  assert(target_states.size() == rewrite_states.size());
+vector<size_t> InvariantLearner::choose_tcs(size_t count) {
+
+  vector<size_t> remaining;
+  for (size_t i = 0; i < count; ++i)
+    remaining.push_back(i);
 
   //cout << "sample_tcs_ = " << sample_tcs_ << endl;
-  if (sample_tcs_ == 0 || sample_tcs_ >= target_states.size()) {
+  if (sample_tcs_ == 0 || sample_tcs_ >= count) {
     //cout << "Preserving all tcs" << endl;
-    return pair<vector<CpuState>,vector<CpuState>>(target_states, rewrite_states);
+    return remaining;
   }
 
-  std::vector<CpuState> target_chosen;
-  std::vector<CpuState> rewrite_chosen;
-  auto target_remaining = target_states;
-  auto rewrite_remaining = rewrite_states;
-
+  vector<size_t> chosen;
   for (size_t i = 0; i < sample_tcs_; ++i) {
-    size_t pick_from = target_remaining.size();
+    size_t pick_from = remaining.size();
     uniform_int_distribution<size_t> dis(0, pick_from-1);
 
     size_t choice = dis(gen_);
-    target_chosen.push_back(target_remaining[choice]);
-    rewrite_chosen.push_back(rewrite_remaining[choice]);
-
-    target_remaining.erase(target_remaining.begin() + choice);
-    rewrite_remaining.erase(rewrite_remaining.begin() + choice);
-
-    assert(target_remaining.size() == rewrite_remaining.size());
-    assert(target_chosen.size() == rewrite_chosen.size());
+    chosen.push_back(remaining[choice]);
+    remaining.erase(remaining.begin() + choice);
   }
 
-  //cout << "Selected " << target_chosen.size() << " testcases" << endl;
+  //cout << "Selected " << chosen.size() << " testcases" << endl;
 
-  return pair<vector<CpuState>, vector<CpuState>>(target_chosen, rewrite_chosen);
+  return chosen;
 }
 
 void InvariantLearner::debug_memory_nonequivalent(
@@ -941,27 +878,14 @@ std::shared_ptr<ConjunctionInvariant> InvariantLearner::learn(
   === AND === remove variables that are constants. */
 vector<std::shared_ptr<Invariant>> InvariantLearner::learn_constants(
                                   vector<Variable>& columns,
-                                  const vector<CpuState>& target_states,
-const vector<CpuState>& rewrite_states) {
-
-  assert(target_states.size() == rewrite_states.size());
-  size_t tc_count = target_states.size();
+StateColumns& data) {
 
   vector<std::shared_ptr<Invariant>> invariants;
 
   for (size_t i = 0; i < columns.size(); ++i) {
 
-    auto value = columns[i].from_state(target_states[0], rewrite_states[0]);
-    bool match = true;
-    for (size_t k = 1; k < tc_count; ++k) {
-      auto curr = columns[i].from_state(target_states[k], rewrite_states[k]);
-      if (curr != value) {
-        match = false;
-        break;
-      }
-    }
-
-    if (match) {
+    uint64_t value;
+    if (StateColumns::is_constant(data.get(columns[i]), value)) {
       vector<Variable> terms;
       terms.push_back(columns[i]);
       auto ei = std::make_shared<EqualityInvariant>(terms, value);
@@ -976,100 +900,28 @@ const vector<CpuState>& rewrite_states) {
   return invariants;
 }
 
-void multiplication_update(uint64_t& col_i_value, uint64_t& col_j_value,
-                           bool& i_bigger, bool& found_prod, uint64_t& prod, bool& prod_match) {
-  if (prod_match == false)
-    return;
-
-  if (!found_prod) {
-    if (col_i_value != 0 && col_j_value != 0) {
-      auto tmp_diff = col_i_value / col_j_value;
-      if (tmp_diff * col_j_value == col_i_value) {
-        found_prod = true;
-        prod = tmp_diff;
-        i_bigger = true;
-        return;
-      } else {
-        tmp_diff = col_j_value / col_i_value;
-        if (tmp_diff*col_i_value == col_j_value) {
-          found_prod = true;
-          prod = tmp_diff;
-          i_bigger = false;
-          return;
-        } else {
-          prod_match = false;
-          return;
-        }
-      }
-    } else if (col_i_value == 0 && col_j_value != 0) {
-      prod_match = false;
-      return;
-    } else if (col_j_value == 0 && col_i_value != 0) {
-      prod_match = false;
-      return;
-    }
-  } else {
-    if (i_bigger) {
-      if (prod*col_j_value != col_i_value) {
-        prod_match = false;
-        return;
-      }
-    } else {
-      if (prod*col_i_value != col_j_value) {
-        prod_match = false;
-        return;
-      }
-    }
-  }
-
-}
-
-
 /** Learn constants over a set of columns,
   === AND === remove variables that are constants. */
 vector<std::shared_ptr<Invariant>> InvariantLearner::learn_easy_equalities(
                                   vector<Variable>& columns,
-                                  const vector<CpuState>& target_states,
-const vector<CpuState>& rewrite_states) {
-
-  assert(target_states.size() == rewrite_states.size());
-  size_t tc_count = target_states.size();
+StateColumns& data) {
 
   vector<std::shared_ptr<Invariant>> invariants;
 
   vector<size_t> columns_to_erase;
   for (size_t i = 0; i < columns.size(); ++i) {
+    auto& col_i = data.get(columns[i]);
     for (size_t j = i+1; j < columns.size(); ++j) {
+      auto& col_j = data.get(columns[j]);
 
       // check if column i matches column j
       //DEBUG_LEARNER(cout << " - Checking if column " << columns[i] << " matches " << columns[j] << endl;)
-      bool diff_match = true;
-      bool prod_match = true;
-      bool found_prod = false;
       bool i_bigger = false;
       uint64_t prod;
+      uint64_t diff;
+      bool diff_match = StateColumns::constant_difference(col_i, col_j, diff);
+      bool prod_match = !diff_match && StateColumns::constant_ratio(col_i, col_j, prod, i_bigger);
 
-      uint64_t diff = 0;
-      if (tc_count > 0) {
-        uint64_t col_i_start_value = columns[i].from_state(target_states[0], rewrite_states[0]);
-        uint64_t col_j_start_value = columns[j].from_state(target_states[0], rewrite_states[0]);
-        diff = col_i_start_value - col_j_start_value;
-        multiplication_update(col_i_start_value, col_j_start_value, i_bigger, found_prod, prod, prod_match);
-      }
-
-      for (size_t k = 1; k < tc_count; ++k) {
-        auto col_i_value = columns[i].from_state(target_states[k], rewrite_states[k]);
-        auto col_j_value = columns[j].from_state(target_states[k], rewrite_states[k]);
-
-        if (col_i_value - col_j_value != diff) {
-          diff_match = false;
-        }
-
-        multiplication_update(col_i_value, col_j_value, i_bigger, found_prod, prod, prod_match);
-
-        if (!diff_match && !prod_match)
-          break;
-      }
       // add equality asserting column[i] matches column[j].
       if (diff_match) {
         vector<Variable> terms;
@@ -1083,7 +935,7 @@ const vector<CpuState>& rewrite_states) {
         DEBUG_LEARNER(cout << "generating " << *ei << endl;)
 
         columns_to_erase.push_back(j);
-      } else if (prod_match && found_prod) {
+      } else if (prod_match) {
         vector<Variable> terms;
         columns[i].coefficient = i_bigger ? 1 : prod;
         columns[j].coefficient = i_bigger ? -prod : -1;
@@ -1114,25 +966,22 @@ const vector<CpuState>& rewrite_states) {
 
 IntMatrix InvariantLearner::states_to_matrix(
   const vector<Variable>& variables,
-  const vector<CpuState>& target_states,
-  const vector<CpuState>& rewrite_states) {
-
-  assert(target_states.size() == rewrite_states.size());
+  StateColumns& data,
+  const vector<size_t>& rows) {
 
-  size_t num_rows = target_states.size();
+  size_t num_rows = rows.size();
   size_t num_cols = variables.size()+1;
-  uint64_t* matrix = new uint64_t[num_rows*num_cols];
+  IntMatrix matrix(num_rows, num_cols);
 
-  for (size_t i = 0; i < num_rows; ++i) {
-    for (size_t j = 0; j < num_cols-1; ++j) {
-      matrix[i*num_cols + j] = variables[j].from_state(target_states[i], rewrite_states[i]);
-    }
-    matrix[i*num_cols + num_cols - 1] = 1;
+  for (size_t j = 0; j < num_cols-1; ++j) {
+    auto& column = data.get(variables[j]);
+    for (size_t i = 0; i < num_rows; ++i)
+      matrix[i][j] = column[rows[i]];
   }
-  IntMatrix matrix2(num_rows, num_cols, matrix);
+  for (size_t i = 0; i < num_rows; ++i)
+    matrix[i][num_cols - 1] = 1;
 
-  delete[] matrix;
-  return matrix2;
+  return matrix;
 }
 
 std::shared_ptr<ConjunctionInvariant> InvariantLearner::matrix_to_invariant(
@@ -1169,15 +1018,23 @@ vector<std::shared_ptr<Invariant>> InvariantLearner::learn_equalities(
                                   vector<Variable> columns,
                                   const vector<CpuState>& target_states,
 const vector<CpuState>& rewrite_states) {
+  StateColumns data(target_states, rewrite_states);
+  return learn_equalities(columns, target_states, rewrite_states, data);
+}
+
+vector<std::shared_ptr<Invariant>> InvariantLearner::learn_equalities(
+                                  vector<Variable> columns,
+                                  const vector<CpuState>& target_states,
+                                  const vector<CpuState>& rewrite_states,
+StateColumns& data) {
 
   size_t num_columns = columns.size() + 1;
-  size_t tc_count = target_states.size();
 
   vector<std::shared_ptr<Invariant>> invariants;
 
   /** First do some checks to make things faster. */
   /** (A) check for constant columns. */
-  auto constant_invs = learn_constants(columns, target_states, rewrite_states);
+  auto constant_invs = learn_constants(columns, data);
   invariants.insert(invariants.begin(), constant_invs.begin(), constant_invs.end());
 
   /*
@@ -1186,7 +1043,7 @@ const vector<CpuState>& rewrite_states) {
   cout << endl;*/
 
   /** (B) check for some equalities */
-  auto equal_invs = learn_easy_equalities(columns, target_states, rewrite_states);
+  auto equal_invs = learn_easy_equalities(columns, data);
   invariants.insert(invariants.begin(), equal_invs.begin(), equal_invs.end());
 
   /*
@@ -1201,14 +1058,12 @@ const vector<CpuState>& rewrite_states) {
   }
 
   /** (C) sample rows; perform check; try again. */
-  auto tc_pairs = choose_tcs(target_states, rewrite_states);
-  auto target_learn = tc_pairs.first;
-  auto rewrite_learn = tc_pairs.second;
+  auto learn_rows = choose_tcs(data.rows());
 
   bool done = false;
   std::shared_ptr<ConjunctionInvariant> equalities;
   while (!done) {
-    auto matrix = states_to_matrix(columns, target_learn, rewrite_learn);
+    auto matrix = states_to_matrix(columns, data, learn_rows);
     cout << "COMPUTING KERNEL OF THIS MATRIX " << matrix.rows() << " x " << matrix.cols() << endl;
     matrix.print();
 
@@ -1221,8 +1076,6 @@ const vector<CpuState>& rewrite_states) {
 
     size_t new_states = 0;
     bool all_work = true;
-    vector<CpuState> target_bad;
-    vector<CpuState> rewrite_bad;
 
     vector<bool> invariant_ceg_found(equalities->size(), false);
 
@@ -1231,8 +1084,8 @@ const vector<CpuState>& rewrite_states) {
       if (new_states >= sample_tcs_)
         break;
 
-      auto target_state = target_states[i];
-      auto rewrite_state = rewrite_states[i];
+      auto& target_state = target_states[i];
+      auto& rewrite_state = rewrite_states[i];
 
       bool added = false;
       for (size_t j = 0; j < equalities->size(); ++j) {
@@ -1244,8 +1097,7 @@ const vector<CpuState>& rewrite_states) {
           cout << *(*equalities)[j] << endl;
           invariant_ceg_found[j] = true;
           if (!added) {
-            target_learn.push_back(target_state);
-            rewrite_learn.push_back(rewrite_state);
+            learn_rows.push_back(i);
             added = true;
           }
           new_states++;
@@ -1289,25 +1141,19 @@ std::shared_ptr<ConjunctionInvariant> InvariantLearner::learn_simple(x64asm::Reg
     return conj;
   }
 
+  // every pass below reads its variables out of here
+  StateColumns data(target_states, rewrite_states);
+
 // NonZero invariants
   auto class_nonzero = graph.new_class();
   for (size_t k = 0; k < 2; ++k) {
-    auto& states = k ? rewrite_states : target_states;
     auto& regs = k ? rewrite_regs : target_regs;
 
     for (auto it = regs.gp_begin(); it != regs.gp_end(); ++it) {
-      bool all_nonzero = true;
-
-      for (auto state : states) {
-        if (state.gp[*it].get_fixed_quad(0) == 0) {
-          all_nonzero = false;
-        }
-      }
-
-      if (all_nonzero) {
-        Variable v(r64s[*it], k);
+      Variable v(r64s[*it], k);
+      if (StateColumns::all_nonzero(data.get(v))) {
         auto nz = std::make_shared<NonzeroInvariant>(v);
-        if (nz->check(target_states, rewrite_states)) {
+        if (CompiledInvariant(nz).check(data)) {
           conj->add_invariant(nz);
           graph.add_invariant(nz);
         } else {
@@ -1333,7 +1179,7 @@ std::shared_ptr<ConjunctionInvariant> InvariantLearner::learn_simple(x64asm::Reg
     for (size_t k = 0; k < 2; ++k) {
       for (auto r : r64s) {
         auto candidate = std::make_shared<TopZeroInvariant>(r, k);
-        if (candidate->check(target_states, rewrite_states)) {
+        if (CompiledInvariant(candidate).check(data)) {
           conj->add_invariant(candidate);
         }
       }
@@ -1344,7 +1190,7 @@ std::shared_ptr<ConjunctionInvariant> InvariantLearner::learn_simple(x64asm::Reg
   auto class_sign = graph.new_class();
   auto potential_sign = build_sign_invariants(target_regs, rewrite_regs);
   for (auto sign : potential_sign) {
-    if (sign->check(target_states, rewrite_states)) {
+    if (CompiledInvariant(sign).check(data)) {
       conj->add_invariant(sign);
       graph.add_invariant(sign);
     }
@@ -1355,7 +1201,7 @@ std::shared_ptr<ConjunctionInvariant> InvariantLearner::learn_simple(x64asm::Reg
   auto class_memreg_equ = graph.new_class();
   auto potential_equalities = build_memory_register_equalities(target_regs, rewrite_regs);
   for (auto ineq : potential_equalities) {
-    if (ineq->check(target_states, rewrite_states)) {
+    if (CompiledInvariant(ineq).check(data)) {
       //cout << "Using " << *ineq << endl;
       conj->add_invariant(ineq);
       graph.add_invariant(ineq);
@@ -1379,10 +1225,10 @@ std::shared_ptr<ConjunctionInvariant> InvariantLearner::learn_simple(x64asm::Reg
   */
 
   // Inequality invariants with constant
-  auto inequalities_with_constants = build_inequality_with_constant_invariants(target_regs, rewrite_regs, target_states, rewrite_states);
+  auto inequalities_with_constants = build_inequality_with_constant_invariants(target_regs, rewrite_regs, data);
   auto class_ineq_const = graph.new_class();
   for (auto ineq : inequalities_with_constants) {
-    if (ineq->check(target_states, rewrite_states)) {
+    if (CompiledInvariant(ineq).check(data)) {
       conj->add_invariant(ineq);
       graph.add_invariant(ineq);
     }
@@ -1390,7 +1236,7 @@ std::shared_ptr<ConjunctionInvariant> InvariantLearner::learn_simple(x64asm::Reg
 
   // Modulo invariants
   auto class_modulo = graph.new_class();
-  auto modulos = build_modulo_invariants(target_regs, rewrite_regs, target_states, rewrite_states);
+  auto modulos = build_modulo_invariants(target_regs, rewrite_regs, target_states, rewrite_states, data);
   for (auto it : modulos) {
     conj->add_invariant(it);
     graph.add_invariant(it);
@@ -1398,7 +1244,7 @@ std::shared_ptr<ConjunctionInvariant> InvariantLearner::learn_simple(x64asm::Reg
 
   // Range invariants
   auto class_bound = graph.new_class();
-  auto ranges = build_range_invariants(target_regs, rewrite_regs, target_states, rewrite_states);
+  auto ranges = build_range_invariants(target_regs, rewrite_regs, target_states, rewrite_states, data);
   for (auto it : ranges) {
     conj->add_invariant(it);
     graph.add_invariant(it);
@@ -1456,8 +1302,8 @@ std::shared_ptr<ConjunctionInvariant> InvariantLearner::learn_simple(x64asm::Reg
     auto vector_vars_rewrite = sub_registers_for_regset(rewrite_regs, true);
     vector_columns.insert(vector_columns.begin(), vector_vars_target.begin(), vector_vars_target.end());
     vector_columns.insert(vector_columns.begin(), vector_vars_rewrite.begin(), vector_vars_rewrite.end());
-    auto easy_constants = learn_constants(vector_columns, target_states, rewrite_states);
-    auto easy_equalities = learn_easy_equalities(vector_columns, target_states, rewrite_states);
+    auto easy_constants = learn_constants(vector_columns, data);
+    auto easy_equalities = learn_easy_equalities(vector_columns, data);
 
     conj->add_invariants(easy_equalities);
     conj->add_invariants(easy_constants);
@@ -1559,7 +1405,7 @@ std::shared_ptr<ConjunctionInvariant> InvariantLearner::learn_simple(x64asm::Reg
 }
 );
   auto equality_class = graph.new_class();
-  auto equality_invs = learn_equalities(columns, target_states, rewrite_states);
+  auto equality_invs = learn_equalities(columns, target_states, rewrite_states, data);
   for (auto inv : equality_invs) {
     conj->add_invariant(inv);
     graph.add_invariant(inv);
@@ -27,6 +27,7 @@
 #include "src/validator/int_matrix.h"
 #include "src/validator/implication_graph.h"
 #include "src/validator/obligation_checker.h"
+#include "src/validator/state_columns.h"
 #include "src/validator/validator.h"
 
 namespace stoke {
@@ -112,15 +113,21 @@ public:
 
 private:
 
-  /** Select sample_tcs_ (if nonzero) from the TCs provided. */
-  std::pair<std::vector<CpuState>, std::vector<CpuState>> choose_tcs(
-        const std::vector<CpuState>&, const std::vector<CpuState>&);
+  /** Select sample_tcs_ (if nonzero) from count TCs; returns their indexes. */
+  std::vector<size_t> choose_tcs(size_t count);
 
-  /** Extract variables from states and put them into a matrix. */
+  /** Put the values of variables at some rows into a matrix. */
   IntMatrix states_to_matrix(
     const std::vector<Variable>& variables,
-    const std::vector<CpuState>& target_states,
-    const std::vector<CpuState>& rewrite_states);
+    StateColumns& data,
+    const std::vector<size_t>& rows);
+
+  /** Learn linear equalities, reading values from data. */
+  std::vector<std::shared_ptr<Invariant>> learn_equalities(
+                                         std::vector<Variable>,
+                                         const std::vector<CpuState>&,
+                                         const std::vector<CpuState>&,
+                                         StateColumns& data);
 
   /** Take a matrix (from nullspace computation), and extract invariants from
    * it. */
@@ -132,15 +139,13 @@ private:
     remove the variable from the referenced set of columns. */
   std::vector<std::shared_ptr<Invariant>> learn_constants(
                                          std::vector<Variable>& columns,
-                                         const std::vector<CpuState>& target_states,
-                                         const std::vector<CpuState>& rewrite_states);
+                                         StateColumns& data);
 
   /** Learn that two variables are equal over many states, AND,
     remove the variable from the referenced set of columns. */
   std::vector<std::shared_ptr<Invariant>> learn_easy_equalities(
                                          std::vector<Variable>& columns,
-                                         const std::vector<CpuState>& target_states,
-                                         const std::vector<CpuState>& rewrite_states);
+                                         StateColumns& data);
 
   /** Learn a single invariant, without regard for flags. */
   std::shared_ptr<ConjunctionInvariant> learn_simple(
@@ -163,8 +168,7 @@ private:
   std::vector<std::shared_ptr<InequalityInvariant>> build_inequality_with_constant_invariants(
         x64asm::RegSet target_regs,
         x64asm::RegSet rewrite_regs,
-        const std::vector<CpuState>& target_states,
-        const std::vector<CpuState>& rewrite_states);
+        StateColumns& data);
 
   /** Create set of invariants of form x - y == c (mod N) that
    hold over given data. */
@@ -172,7 +176,8 @@ private:
         x64asm::RegSet target_regs,
         x64asm::RegSet rewrite_regs,
         const std::vector<CpuState>& target_states,
-        const std::vector<CpuState>& rewrite_states) const;
+        const std::vector<CpuState>& rewrite_states,
+        StateColumns& data) const;
 
   /** Create set of invariants of form x - y == c (mod N) that
    hold over given data. */
@@ -180,7 +185,8 @@ private:
         x64asm::RegSet target_regs,
         x64asm::RegSet rewrite_regs,
         const std::vector<CpuState>& target_states,
-        const std::vector<CpuState>& rewrite_states) const;
+        const std::vector<CpuState>& rewrite_states,
+        StateColumns& data) const;
 
   /** Get all variables corresponding to relevant sub-variables of a register. */
   std::vector<Variable> sub_registers_for_regset(x64asm::RegSet rs, bool is_rewrite) const;
@@ -213,9 +219,6 @@ private:
   /** Random generator. */
   std::default_random_engine gen_;
 
-  /** utility: compute gcd of two ints. */
-  static uint64_t euclid(uint64_t, uint64_t);
-
   /** for picking memory derefernces. */
   const Cfg& target_;
   const Cfg& rewrite_;
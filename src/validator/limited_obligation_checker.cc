@@ -0,0 +1,275 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cerrno>
+#include <chrono>
+#include <sstream>
+
+#include "poll.h"
+#include "signal.h"
+#include "sys/resource.h"
+#include "sys/types.h"
+#include "sys/wait.h"
+#include "unistd.h"
+
+#include "src/validator/limited_obligation_checker.h"
+
+#define DEBUG_LIMITED_CHECKER(X) { if(0) { X } }
+
+using namespace std;
+using namespace std::chrono;
+using namespace stoke;
+
+namespace {
+
+/** Write a whole string to a file descriptor. */
+void write_all(int fd, const string& str) {
+  const char* buffer = str.c_str();
+  size_t len = str.size();
+  while (len > 0) {
+    auto n = write(fd, buffer, len);
+    if (n == -1) {
+      if (errno == EINTR)
+        continue;
+      return;
+    }
+    len -= n;
+    buffer += n;
+  }
+}
+
+bool is_definitive(const ObligationChecker::Result& result) {
+  return !result.has_error && (result.verified || result.has_ceg);
+}
+
+} // namespace
+
+ObligationChecker::Result LimitedObligationChecker::make_error(const Rung& rung, const string& message) {
+  Result result;
+  result.verified = false;
+  result.has_ceg = false;
+  result.has_error = true;
+  result.error_message = message;
+  result.gen_time_microseconds = 0;
+  result.smt_time_microseconds = 0;
+  result.solver = Solver::NONE;
+  result.strategy = rung.checker->get_alias_strategy();
+  return result;
+}
+
+vector<ObligationChecker::Result> LimitedObligationChecker::run(const Rung& rung,
+    const Cfg& target, const Cfg& rewrite,
+    Cfg::id_type target_block, Cfg::id_type rewrite_block,
+    const CfgPath& p, const CfgPath& q,
+    std::shared_ptr<Invariant> assume, std::shared_ptr<ConjunctionInvariant> prove,
+    const std::vector<std::pair<CpuState, CpuState>>& testcases,
+    bool override_separate_stack) {
+
+  size_t count = prove->size();
+  vector<Result> results(count);
+
+  int pipefd[2];
+  if (pipe(pipefd) != 0) {
+    for (auto& it : results)
+      it = make_error(rung, "Call to pipe() failed");
+    return results;
+  }
+
+  pid_t pid = fork();
+  if (pid == -1) {
+    close(pipefd[0]);
+    close(pipefd[1]);
+    for (auto& it : results)
+      it = make_error(rung, "Call to fork() failed");
+    return results;
+  }
+
+  if (pid == 0) {
+    // child: check under the memory limit and send back each result as it
+    // comes; in a group of its own so that a timeout gets its solvers too
+    setpgid(0, 0);
+    close(pipefd[0]);
+    if (rung.memory_mb) {
+      struct rlimit rl;
+      rl.rlim_cur = rung.memory_mb << 20;
+      rl.rlim_max = rung.memory_mb << 20;
+      setrlimit(RLIMIT_AS, &rl);
+    }
+
+    Callback callback = [&pipefd] (Result& result, void* optional) {
+      stringstream ss;
+      ss << (size_t)optional << endl;
+      result.write_text(ss);
+      ss << endl;
+      write_all(pipefd[1], ss.str());
+    };
+
+    vector<void*> optionals;
+    for (size_t i = 0; i < count; ++i)
+      optionals.push_back((void*)i);
+
+    if (count == 1)
+      rung.checker->check(target, rewrite, target_block, rewrite_block, p, q, assume, (*prove)[0],
+                          testcases, callback, override_separate_stack, optionals[0]);
+    else
+      rung.checker->check_batch(target, rewrite, target_block, rewrite_block, p, q, assume, prove,
+                                testcases, callback, override_separate_stack, optionals);
+    rung.checker->block_until_complete();
+
+    close(pipefd[1]);
+    cout.flush();
+    _exit(0);
+  }
+
+  // parent: read until the child is done or the time is up; also set the
+  // group here, in case we kill the child before it gets to
+  setpgid(pid, pid);
+  close(pipefd[1]);
+  auto start = steady_clock::now();
+  bool timed_out = false;
+  string data;
+  char buffer[4096];
+
+  while (true) {
+    int wait = -1;
+    if (rung.timeout_ms) {
+      uint64_t elapsed = duration_cast<milliseconds>(steady_clock::now() - start).count();
+      if (elapsed >= rung.timeout_ms) {
+        timed_out = true;
+        break;
+      }
+      wait = rung.timeout_ms - elapsed;
+    }
+
+    pollfd pfd;
+    pfd.fd = pipefd[0];
+    pfd.events = POLLIN;
+    int ready = poll(&pfd, 1, wait);
+    if (ready == -1 && errno != EINTR)
+      break;
+    if (ready <= 0)
+      continue;
+
+    auto n = read(pipefd[0], buffer, sizeof(buffer));
+    if (n > 0)
+      data.append(buffer, n);
+    else if (n == 0 || errno != EINTR)
+      break;
+  }
+
+  if (timed_out) {
+    kill(-pid, SIGKILL);
+    kill(pid, SIGKILL);
+  }
+  int status = 0;
+  waitpid(pid, &status, 0);
+  close(pipefd[0]);
+
+  // whatever the child reported before it stopped is still good
+  vector<bool> reported(count, false);
+  stringstream ss(data);
+  size_t index;
+  while (ss >> index) {
+    Result result;
+    result.read_text(ss);
+    if (ss.fail() || index >= count)
+      break;
+    results[index] = result;
+    reported[index] = true;
+  }
+
+  string message;
+  if (timed_out) {
+    stringstream msg;
+    msg << "Timed out after " << rung.timeout_ms << " ms";
+    message = msg.str();
+  } else if (WIFSIGNALED(status)) {
+    stringstream msg;
+    msg << "Checker process killed by signal " << WTERMSIG(status);
+    if (rung.memory_mb)
+      msg << " (memory limit " << rung.memory_mb << " MB)";
+    message = msg.str();
+  } else {
+    message = "Checker process exited without a result";
+  }
+
+  for (size_t i = 0; i < count; ++i) {
+    if (!reported[i])
+      results[i] = make_error(rung, message);
+  }
+
+  DEBUG_LIMITED_CHECKER(cout << "[limited] rung finished in "
+                        << duration_cast<milliseconds>(steady_clock::now() - start).count()
+                        << " ms; " << message << endl;)
+  return results;
+}
+
+void LimitedObligationChecker::check(const Cfg& target, const Cfg& rewrite,
+                                     Cfg::id_type target_block, Cfg::id_type rewrite_block,
+                                     const CfgPath& p, const CfgPath& q,
+                                     std::shared_ptr<Invariant> assume, std::shared_ptr<Invariant> prove,
+                                     const std::vector<std::pair<CpuState, CpuState>>& testcases,
+                                     Callback& callback,
+                                     bool override_separate_stack,
+                                     void* optional) {
+
+  auto batch = make_shared<ConjunctionInvariant>();
+  batch->add_invariant(prove);
+  check_batch(target, rewrite, target_block, rewrite_block, p, q, assume, batch, testcases,
+              callback, override_separate_stack, { optional });
+}
+
+void LimitedObligationChecker::check_batch(const Cfg& target, const Cfg& rewrite,
+    Cfg::id_type target_block, Cfg::id_type rewrite_block,
+    const CfgPath& p, const CfgPath& q,
+    std::shared_ptr<Invariant> assume, std::shared_ptr<ConjunctionInvariant> prove,
+    const std::vector<std::pair<CpuState, CpuState>>& testcases,
+    Callback& callback,
+    bool override_separate_stack,
+    const std::vector<void*>& optionals) {
+
+  assert(prove->size() == optionals.size());
+
+  vector<size_t> remaining;
+  for (size_t i = 0; i < prove->size(); ++i)
+    remaining.push_back(i);
+  vector<Result> last(prove->size());
+
+  for (auto& rung : ladder_) {
+    auto batch = make_shared<ConjunctionInvariant>();
+    for (auto i : remaining)
+      batch->add_invariant((*prove)[i]);
+
+    auto results = run(rung, target, rewrite, target_block, rewrite_block, p, q,
+                       assume, batch, testcases, override_separate_stack);
+
+    vector<size_t> undecided;
+    for (size_t k = 0; k < remaining.size(); ++k) {
+      auto i = remaining[k];
+      if (is_definitive(results[k])) {
+        callback(results[k], optionals[i]);
+      } else {
+        last[i] = results[k];
+        undecided.push_back(i);
+      }
+    }
+
+    remaining = undecided;
+    if (remaining.size() == 0)
+      return;
+  }
+
+  for (auto i : remaining)
+    callback(last[i], optionals[i]);
+}
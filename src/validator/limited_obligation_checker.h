@@ -0,0 +1,125 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef STOKE_SRC_VALIDATOR_LIMITED_OBLIGATION_CHECKER_H
+#define STOKE_SRC_VALIDATOR_LIMITED_OBLIGATION_CHECKER_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "src/validator/obligation_checker.h"
+
+namespace stoke {
+
+/** Runs every obligation in a child process with a wall-clock and memory
+  limit, escalating through a ladder of checkers.  An obligation moves to the
+  next rung when a rung has no definitive answer (an error, a timeout, or
+  running out of memory).  If no rung answers, the last error is reported.
+  Checks block until they are done.  Don't use this from a process with
+  other threads: the child may deadlock on a lock one of them held at the
+  fork. */
+class LimitedObligationChecker : public ObligationChecker {
+
+public:
+
+  /** One step of the escalation ladder. */
+  struct Rung {
+    ObligationChecker* checker;
+    /** Wall-clock limit in milliseconds; 0 for none. */
+    uint64_t timeout_ms;
+    /** Address space limit in megabytes; 0 for none. */
+    uint64_t memory_mb;
+  };
+
+  LimitedObligationChecker(const std::vector<Rung>& ladder) : ObligationChecker(), ladder_(ladder) {
+    assert(ladder_.size() > 0);
+  }
+
+  /** Rungs keep their own alias strategies; the rest of the settings apply
+    to all of them. */
+  ObligationChecker& set_fixpoint_up(bool b) override {
+    ObligationChecker::set_fixpoint_up(b);
+    for (auto& it : ladder_)
+      it.checker->set_fixpoint_up(b);
+    return *this;
+  }
+
+  ObligationChecker& set_separate_stack(bool b) override {
+    ObligationChecker::set_separate_stack(b);
+    for (auto& it : ladder_)
+      it.checker->set_separate_stack(b);
+    return *this;
+  }
+
+  ObligationChecker& set_nacl(bool b) override {
+    ObligationChecker::set_nacl(b);
+    for (auto& it : ladder_)
+      it.checker->set_nacl(b);
+    return *this;
+  }
+
+  ObligationChecker& set_basic_block_ghosts(bool b) override {
+    ObligationChecker::set_basic_block_ghosts(b);
+    for (auto& it : ladder_)
+      it.checker->set_basic_block_ghosts(b);
+    return *this;
+  }
+
+  void check(const Cfg& target, const Cfg& rewrite,
+             Cfg::id_type target_block, Cfg::id_type rewrite_block,
+             const CfgPath& p, const CfgPath& q,
+             std::shared_ptr<Invariant> assume, std::shared_ptr<Invariant> prove,
+             const std::vector<std::pair<CpuState, CpuState>>& testcases,
+             Callback& callback,
+             bool override_separate_stack,
+             void* optional) override;
+
+  /** Each rung checks the conjuncts the previous rungs couldn't decide as one batch. */
+  void check_batch(const Cfg& target, const Cfg& rewrite,
+                   Cfg::id_type target_block, Cfg::id_type rewrite_block,
+                   const CfgPath& p, const CfgPath& q,
+                   std::shared_ptr<Invariant> assume, std::shared_ptr<ConjunctionInvariant> prove,
+                   const std::vector<std::pair<CpuState, CpuState>>& testcases,
+                   Callback& callback,
+                   bool override_separate_stack,
+                   const std::vector<void*>& optionals) override;
+
+  /** Get the filter */
+  Filter& get_filter() override {
+    return ladder_[0].checker->get_filter();
+  }
+
+private:
+
+  /** Check a batch on one rung in a child process.  Every conjunct gets a
+    result, which is an error if the child didn't report one. */
+  std::vector<Result> run(const Rung& rung,
+                          const Cfg& target, const Cfg& rewrite,
+                          Cfg::id_type target_block, Cfg::id_type rewrite_block,
+                          const CfgPath& p, const CfgPath& q,
+                          std::shared_ptr<Invariant> assume, std::shared_ptr<ConjunctionInvariant> prove,
+                          const std::vector<std::pair<CpuState, CpuState>>& testcases,
+                          bool override_separate_stack);
+
+  /** Make an error result. */
+  static Result make_error(const Rung& rung, const std::string& message);
+
+  std::vector<Rung> ladder_;
+
+};
+
+} // namespace stoke
+
+#endif
@@ -0,0 +1,296 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "src/validator/local_queue.h"
+
+using namespace std;
+using namespace stoke;
+
+namespace {
+
+/** List the names in a directory. */
+vector<string> list_dir(const string& path) {
+  vector<string> names;
+  DIR* dir = opendir(path.c_str());
+  if (!dir)
+    return names;
+  struct dirent* entry;
+  while ((entry = readdir(dir)) != NULL) {
+    string name = entry->d_name;
+    if (name != "." && name != "..")
+      names.push_back(name);
+  }
+  closedir(dir);
+  return names;
+}
+
+/** Read a whole file.  Returns false if it can't be opened. */
+bool read_file(const string& path, string& contents) {
+  ifstream ifs(path);
+  if (!ifs.is_open())
+    return false;
+  stringstream ss;
+  ss << ifs.rdbuf();
+  contents = ss.str();
+  return true;
+}
+
+bool file_exists(const string& path) {
+  struct stat st;
+  return stat(path.c_str(), &st) == 0;
+}
+
+/** When a process started, in clock ticks after boot; 0 if it doesn't exist.
+  A pid can be reused, but not at the same start time. */
+uint64_t start_time(pid_t pid) {
+  string contents;
+  if (!read_file("/proc/" + to_string(pid) + "/stat", contents))
+    return 0;
+
+  // the command may contain anything, so count fields from its ')'; the
+  // state is the third field and the start time the twenty-second
+  auto paren = contents.rfind(')');
+  if (paren == string::npos)
+    return 0;
+  stringstream ss(contents.substr(paren + 1));
+  string field;
+  for (size_t i = 3; i <= 22; ++i)
+    ss >> field;
+  if (ss.fail())
+    return 0;
+  return strtoull(field.c_str(), NULL, 10);
+}
+
+} // namespace
+
+LocalQueue::LocalQueue(const string& dir) : dir_(dir), queue_fd_(-1), results_fd_(-1), tmp_counter_(0) {
+
+  for (auto sub : { "", "/problems", "/queue", "/claimed", "/results", "/tmp" }) {
+    auto path = dir_ + sub;
+    if (mkdir(path.c_str(), 0755) == -1 && errno != EEXIST) {
+      error_ = "Could not create " + path + ": " + strerror(errno);
+      return;
+    }
+  }
+
+  queue_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  results_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (queue_fd_ == -1 || results_fd_ == -1 ||
+      inotify_add_watch(queue_fd_, (dir_ + "/queue").c_str(), IN_CREATE | IN_MOVED_TO) == -1 ||
+      inotify_add_watch(results_fd_, (dir_ + "/results").c_str(), IN_CREATE | IN_MOVED_TO) == -1) {
+    error_ = string("Could not watch queue directory: ") + strerror(errno);
+  }
+}
+
+LocalQueue::~LocalQueue() {
+  if (queue_fd_ != -1)
+    close(queue_fd_);
+  if (results_fd_ != -1)
+    close(results_fd_);
+}
+
+bool LocalQueue::parse_spec(const string& spec, string& dir) {
+  string prefix = "local:";
+  if (spec.compare(0, prefix.size(), prefix) != 0 || spec.size() == prefix.size())
+    return false;
+  dir = spec.substr(prefix.size());
+  return true;
+}
+
+string LocalQueue::job_name(const string& hash, const string& solver, const string& strategy) {
+  return hash + "." + solver + "." + strategy;
+}
+
+string LocalQueue::write_tmp(const string& contents) {
+  stringstream path;
+  path << dir_ << "/tmp/" << getpid() << "." << tmp_counter_++;
+
+  ofstream ofs(path.str());
+  ofs << contents;
+  ofs.close();
+  if (ofs.fail()) {
+    error_ = "Could not write " + path.str();
+    unlink(path.str().c_str());
+    return "";
+  }
+  return path.str();
+}
+
+bool LocalQueue::is_claimed(const string& name) {
+  for (auto entry : list_dir(dir_ + "/claimed")) {
+    if (entry.compare(0, name.size() + 1, name + ".") == 0)
+      return true;
+  }
+  return false;
+}
+
+bool LocalQueue::submit(const string& hash, const string& problem,
+                        const vector<pair<string, string>>& runs) {
+
+  error_ = "";
+
+  // link() refuses to replace an existing file, so the first submitter wins
+  auto problem_path = dir_ + "/problems/" + hash;
+  if (!file_exists(problem_path)) {
+    auto tmp = write_tmp(problem);
+    if (tmp == "")
+      return false;
+    if (link(tmp.c_str(), problem_path.c_str()) == -1 && errno != EEXIST) {
+      error_ = "Could not add problem " + hash + ": " + strerror(errno);
+      unlink(tmp.c_str());
+      return false;
+    }
+    unlink(tmp.c_str());
+  }
+
+  for (auto run : runs) {
+    auto name = job_name(hash, run.first, run.second);
+    if (file_exists(dir_ + "/results/" + name) || is_claimed(name))
+      continue;
+
+    auto tmp = write_tmp("");
+    if (tmp == "")
+      return false;
+    auto queue_path = dir_ + "/queue/" + name;
+    if (link(tmp.c_str(), queue_path.c_str()) == -1 && errno != EEXIST) {
+      error_ = "Could not queue " + name + ": " + strerror(errno);
+      unlink(tmp.c_str());
+      return false;
+    }
+    unlink(tmp.c_str());
+  }
+
+  return true;
+}
+
+bool LocalQueue::claim(Job& job) {
+
+  stringstream suffix;
+  suffix << "." << getpid() << "-" << start_time(getpid());
+
+  for (auto name : list_dir(dir_ + "/queue")) {
+    // rename() is atomic, so only one process gets each job
+    auto from = dir_ + "/queue/" + name;
+    auto to = dir_ + "/claimed/" + name + suffix.str();
+    if (rename(from.c_str(), to.c_str()) == -1)
+      continue;
+
+    stringstream ss(name);
+    getline(ss, job.hash, '.');
+    getline(ss, job.solver, '.');
+    getline(ss, job.strategy, '.');
+    if (!read_file(dir_ + "/problems/" + job.hash, job.problem)) {
+      error_ = "Job " + name + " has no problem";
+      unlink(to.c_str());
+      continue;
+    }
+    return true;
+  }
+
+  return false;
+}
+
+bool LocalQueue::finish(const Job& job, const ObligationChecker::Result& result) {
+
+  error_ = "";
+  stringstream ss;
+  result.write_text(ss);
+  auto tmp = write_tmp(ss.str());
+  if (tmp == "")
+    return false;
+
+  auto name = job_name(job.hash, job.solver, job.strategy);
+  auto path = dir_ + "/results/" + name;
+  if (rename(tmp.c_str(), path.c_str()) == -1) {
+    error_ = "Could not record result for " + name + ": " + strerror(errno);
+    unlink(tmp.c_str());
+    return false;
+  }
+
+  for (auto entry : list_dir(dir_ + "/claimed")) {
+    if (entry.compare(0, name.size() + 1, name + ".") == 0)
+      unlink((dir_ + "/claimed/" + entry).c_str());
+  }
+  return true;
+}
+
+bool LocalQueue::get_result(const string& hash, const string& solver, const string& strategy,
+                            ObligationChecker::Result& result) {
+  string contents;
+  if (!read_file(dir_ + "/results/" + job_name(hash, solver, strategy), contents))
+    return false;
+
+  stringstream ss(contents);
+  result.read_text(ss);
+  if (ss.fail()) {
+    error_ = "Could not parse result for " + job_name(hash, solver, strategy);
+    return false;
+  }
+  return true;
+}
+
+size_t LocalQueue::requeue_abandoned() {
+  size_t count = 0;
+  for (auto entry : list_dir(dir_ + "/claimed")) {
+    auto dot = entry.rfind('.');
+    if (dot == string::npos)
+      continue;
+    // the owner is <pid>-<start>; older claims only have the pid
+    auto owner = entry.substr(dot + 1);
+    auto dash = owner.find('-');
+    pid_t pid = atoi(owner.substr(0, dash).c_str());
+    if (pid <= 0)
+      continue;
+    auto started = start_time(pid);
+    if (dash == string::npos ? started != 0 :
+        started == strtoull(owner.substr(dash + 1).c_str(), NULL, 10))
+      continue;
+
+    auto from = dir_ + "/claimed/" + entry;
+    auto to = dir_ + "/queue/" + entry.substr(0, dot);
+    if (rename(from.c_str(), to.c_str()) == 0)
+      count++;
+  }
+  return count;
+}
+
+void LocalQueue::wait(int fd, int timeout_ms) {
+  if (fd == -1)
+    return;
+
+  pollfd pfd;
+  pfd.fd = fd;
+  pfd.events = POLLIN;
+  if (poll(&pfd, 1, timeout_ms) <= 0)
+    return;
+
+  // drain the events; callers look at the directory themselves
+  char buffer[4096];
+  while (read(fd, buffer, sizeof(buffer)) > 0);
+}
@@ -0,0 +1,122 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef STOKE_SRC_VALIDATOR_LOCAL_QUEUE_H
+#define STOKE_SRC_VALIDATOR_LOCAL_QUEUE_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "src/validator/obligation_checker.h"
+
+namespace stoke {
+
+/** A queue of proof obligations kept in a directory, for checkers and
+  stoke_worker processes on the same machine.  It has the tables of the
+  postgres backend as subdirectories:
+
+    problems/<hash>                      -- the text of an obligation
+    queue/<hash>.<solver>.<strategy>     -- a job waiting for a worker
+    claimed/<hash>.<solver>.<strategy>.<pid>-<start> -- a job taken by
+                                         process pid, started at start
+    results/<hash>.<solver>.<strategy>   -- the result of a job
+
+  Files are written under tmp/ and then linked or renamed into place, so
+  readers never see partial files and a job is claimed by exactly one
+  process.  Waiting uses inotify. */
+class LocalQueue {
+
+public:
+
+  /** A job taken from the queue. */
+  struct Job {
+    std::string hash;
+    std::string solver;
+    std::string strategy;
+    std::string problem;
+  };
+
+  /** Open (or create) the queue in a directory. */
+  LocalQueue(const std::string& dir);
+  ~LocalQueue();
+
+  /** Get the directory from a queue specification "local:<dir>".  Returns
+    false if the specification is not of this form. */
+  static bool parse_spec(const std::string& spec, std::string& dir);
+
+  /** The name of the files for a job. */
+  static std::string job_name(const std::string& hash, const std::string& solver,
+                              const std::string& strategy);
+
+  /** Add an obligation and queue a job for each (solver, strategy) pair
+    that isn't already queued, running or done. */
+  bool submit(const std::string& hash, const std::string& problem,
+              const std::vector<std::pair<std::string, std::string>>& runs);
+
+  /** Take a job from the queue.  Returns false if there are none. */
+  bool claim(Job& job);
+  /** Record the result of a claimed job. */
+  bool finish(const Job& job, const ObligationChecker::Result& result);
+
+  /** Look up the result of a job.  Returns false if there is none yet. */
+  bool get_result(const std::string& hash, const std::string& solver,
+                  const std::string& strategy, ObligationChecker::Result& result);
+
+  /** Put jobs claimed by processes that no longer exist back on the queue.
+    A process that has the claimer's pid but started at another time is a
+    different one.  Returns how many there were. */
+  size_t requeue_abandoned();
+
+  /** Wait until a job may have been queued, or the timeout passes. */
+  void wait_for_jobs(int timeout_ms) {
+    wait(queue_fd_, timeout_ms);
+  }
+  /** Wait until a result may have been recorded, or the timeout passes. */
+  void wait_for_results(int timeout_ms) {
+    wait(results_fd_, timeout_ms);
+  }
+
+  /** Did opening the queue, or the last operation, fail? */
+  bool has_error() const {
+    return error_.size() > 0;
+  }
+  /** Get the last error message. */
+  std::string get_error() const {
+    return error_;
+  }
+
+private:
+
+  /** Write a file under tmp/ and return its path, or "" on failure. */
+  std::string write_tmp(const std::string& contents);
+  /** Is the job claimed by some process? */
+  bool is_claimed(const std::string& name);
+  /** Wait for events on an inotify descriptor. */
+  void wait(int fd, int timeout_ms);
+
+  std::string dir_;
+  /** inotify descriptors watching queue/ and results/. */
+  int queue_fd_;
+  int results_fd_;
+  /** Makes names of temporary files unique within this process. */
+  size_t tmp_counter_;
+
+  std::string error_;
+
+};
+
+} // namespace stoke
+
+#endif
@@ -0,0 +1,157 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <sstream>
+
+#include "src/validator/local_queue_obligation_checker.h"
+
+using namespace std;
+using namespace stoke;
+
+void LocalQueueObligationChecker::check(const Cfg& target, const Cfg& rewrite,
+                                        Cfg::id_type target_block, Cfg::id_type rewrite_block,
+                                        const CfgPath& p, const CfgPath& q,
+                                        shared_ptr<Invariant> assume, shared_ptr<Invariant> prove,
+                                        const std::vector<std::pair<CpuState, CpuState>>& testcases,
+                                        Callback& callback,
+                                        bool override_separate_stack,
+                                        void* optional) {
+
+  auto hash = hash_obligation(target, rewrite, target_block, rewrite_block, p, q,
+                              assume, prove, separate_stack_ || override_separate_stack);
+
+  Result result;
+  if (find_result(hash, result)) {
+    callback(result, optional);
+    return;
+  }
+
+  /** Another check of this obligation already queued it. */
+  if (outstanding_jobs_.count(hash)) {
+    auto& job = outstanding_jobs_[hash];
+    job.callbacks.push_back(&callback);
+    job.optionals.push_back(optional);
+    return;
+  }
+
+  /** Sample test cases */
+  vector<pair<CpuState,CpuState>> sampled_testcases;
+  if (testcases.size() > 5) {
+    for (size_t i = 0; i < testcases.size(); i += testcases.size()/5) {
+      sampled_testcases.push_back(testcases[i]);
+    }
+  } else {
+    sampled_testcases = testcases;
+  }
+
+  Obligation obligation;
+  obligation.target = target;
+  obligation.rewrite = rewrite;
+  obligation.target_block = target_block;
+  obligation.rewrite_block = rewrite_block;
+  obligation.P = p;
+  obligation.Q = q;
+  obligation.assume = assume;
+  obligation.prove = prove;
+  obligation.testcases = sampled_testcases;
+  obligation.separate_stack = separate_stack_ || override_separate_stack;
+
+  stringstream ss;
+  obligation.write_text(ss);
+
+  if (!queue_.submit(hash, ss.str(), runs_)) {
+    Result r;
+    r.verified = false;
+    r.has_ceg = false;
+    r.has_error = true;
+    r.error_message = queue_.get_error();
+    r.gen_time_microseconds = 0;
+    r.smt_time_microseconds = 0;
+    r.solver = Solver::NONE;
+    r.strategy = alias_strategy_;
+    r.info = hash;
+    callback(r, optional);
+    return;
+  }
+
+  auto& job = outstanding_jobs_[hash];
+  job.callbacks.push_back(&callback);
+  job.optionals.push_back(optional);
+}
+
+bool LocalQueueObligationChecker::find_result(const string& hash, Result& result) {
+
+  size_t errors = 0;
+  bool found = false;
+  Result first_error;
+
+  for (auto run : runs_) {
+    Result r;
+    if (!queue_.get_result(hash, run.first, run.second, r))
+      continue;
+
+    if (r.has_error) {
+      if (errors == 0)
+        first_error = r;
+      errors++;
+      continue;
+    }
+
+    // several workers may have answered; report the fastest
+    auto time = r.gen_time_microseconds + r.smt_time_microseconds;
+    if (!found || time < result.gen_time_microseconds + result.smt_time_microseconds)
+      result = r;
+    found = true;
+  }
+
+  if (found) {
+    result.info = hash;
+    return true;
+  }
+
+  // we don't want to make the callback unless we get errors from all solvers
+  if (errors == runs_.size()) {
+    result = first_error;
+    result.error_message = "All solvers encountered error; e.g. " + first_error.error_message;
+    result.info = hash;
+    return true;
+  }
+
+  return false;
+}
+
+void LocalQueueObligationChecker::poll_queue() {
+
+  vector<string> done;
+  for (auto& it : outstanding_jobs_) {
+    Result result;
+    if (!find_result(it.first, result))
+      continue;
+    for (size_t i = 0; i < it.second.callbacks.size(); ++i)
+      (*it.second.callbacks[i])(result, it.second.optionals[i]);
+    done.push_back(it.first);
+  }
+
+  for (auto hash : done)
+    outstanding_jobs_.erase(hash);
+}
+
+void LocalQueueObligationChecker::block_until_complete() {
+  poll_queue();
+  while (outstanding_jobs_.size() > 0) {
+    queue_.wait_for_results(1000);
+    queue_.requeue_abandoned();
+    poll_queue();
+  }
+}
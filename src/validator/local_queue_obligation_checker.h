@@ -0,0 +1,109 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef STOKE_SRC_VALIDATOR_LOCAL_QUEUE_OBLIGATION_CHECKER_H
+#define STOKE_SRC_VALIDATOR_LOCAL_QUEUE_OBLIGATION_CHECKER_H
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "src/validator/filters/default.h"
+#include "src/validator/handlers/combo_handler.h"
+#include "src/validator/local_queue.h"
+#include "src/validator/obligation_checker.h"
+
+namespace stoke {
+
+/** Sends obligations to stoke_worker processes through a LocalQueue, the
+  way PostgresObligationChecker does through the database.  Each obligation
+  is queued for every solver and alias strategy; the fastest answer wins. */
+class LocalQueueObligationChecker : public ObligationChecker {
+
+public:
+
+  LocalQueueObligationChecker(const std::string& dir) :
+    handler_(), filter_(handler_), queue_(dir)
+  {
+    runs_ = {
+      { "z3", "flat" }, { "cvc4", "flat" }, { "z3", "arm" }, { "cvc4", "arm" }
+    };
+  }
+
+  /** Did opening the queue fail? */
+  bool has_error() const {
+    return queue_.has_error();
+  }
+  std::string get_error() const {
+    return queue_.get_error();
+  }
+
+  void check(const Cfg& target, const Cfg& rewrite,
+             Cfg::id_type target_block, Cfg::id_type rewrite_block,
+             const CfgPath& p, const CfgPath& q,
+             std::shared_ptr<Invariant> assume, std::shared_ptr<Invariant> prove,
+             const std::vector<std::pair<CpuState, CpuState>>& testcases,
+             Callback& callback,
+             bool override_separate_stack,
+             void* optional) override;
+
+  /** Blocks until all the checking has done and the callbacks have been called. */
+  void block_until_complete() override;
+
+  /** Checks to see if we can make any callbacks now. */
+  void check_for_callbacks() override {
+    poll_queue();
+  }
+
+  /** Forget about everything that has been started. */
+  void delete_all() override {
+    outstanding_jobs_.clear();
+  }
+
+  /** Get the filter */
+  Filter& get_filter() override {
+    return filter_;
+  }
+
+private:
+
+  /** Sometimes two jobs with the same hash will be submitted, in which case we need to
+    be prepared to perform the callback multiple times. */
+  struct Job {
+    std::vector<Callback*> callbacks;
+    std::vector<void*> optionals;
+  };
+
+  /** Look for the answer to an obligation.  Returns false if there is none yet. */
+  bool find_result(const std::string& hash, Result& result);
+  /** Make the callbacks for every obligation with an answer. */
+  void poll_queue();
+
+  /** Book keeping */
+  ComboHandler handler_;
+  DefaultFilter filter_;
+
+  LocalQueue queue_;
+  /** The (solver, strategy) pairs each obligation is queued for. */
+  std::vector<std::pair<std::string, std::string>> runs_;
+
+  /** The jobs we don't have results for, by hash. */
+  std::map<std::string, Job> outstanding_jobs_;
+
+};
+
+} //namespace stoke
+
+#endif
@@ -13,9 +13,12 @@
 // limitations under the License.
 
 #include <chrono>
+#include <set>
+#include <sstream>
 
 #include "src/cfg/paths.h"
 #include "src/serialize/serialize.h"
+#include "src/validator/md5.h"
 #include "src/validator/obligation_checker.h"
 
 using namespace stoke;
@@ -160,3 +163,82 @@ ObligationChecker::JumpType ObligationChecker::is_jump(const Cfg& cfg, Cfg::id_t
     return JumpType::JUMP;
   }
 }
+
+namespace {
+
+/** Write the code executed along a path.  Block ids and label names are left
+  out; the jump taken out of each block, and the rip offsets of instructions
+  that can observe rip, are kept. */
+void write_path(ostream& os, const Cfg& cfg, Cfg::id_type end_block, const CfgPath& P) {
+  auto& function = cfg.get_function();
+  auto& code = cfg.get_code();
+
+  for (size_t i = 0; i < P.size(); ++i) {
+    auto block = P[i];
+    os << (int)ObligationChecker::is_jump(cfg, end_block, P, i) << endl;
+    if (cfg.num_instrs(block) == 0)
+      continue;
+
+    size_t start_index = cfg.get_index(Cfg::loc_type(block, 0));
+    size_t end_index = start_index + cfg.num_instrs(block);
+    for (size_t j = start_index; j < end_index; ++j) {
+      auto& instr = code[j];
+      if (instr.is_label_defn())
+        continue;
+
+      // The path already determines where a jump goes
+      if (instr.is_any_jump()) {
+        os << "J" << (int)instr.get_opcode() << endl;
+        continue;
+      }
+
+      os << instr;
+      auto mi = instr.mem_index();
+      if ((mi != -1 && instr.get_operand<M8>(mi).rip_offset()) || instr.is_any_call())
+        os << " @" << function.hex_offset(j) + function.get_rip_offset() + function.hex_size(j);
+      os << endl;
+    }
+    os << "." << endl;
+  }
+  os << endl;
+}
+
+/** Serialize an invariant, with the conjuncts of any conjunction sorted and
+  deduplicated. */
+string canonical_invariant(shared_ptr<Invariant> inv) {
+  auto conj = dynamic_pointer_cast<ConjunctionInvariant>(inv);
+  if (!conj) {
+    stringstream ss;
+    inv->serialize(ss);
+    return ss.str();
+  }
+
+  set<string> conjuncts;
+  for (size_t i = 0; i < conj->size(); ++i)
+    conjuncts.insert(canonical_invariant((*conj)[i]));
+  if (conjuncts.size() == 1)
+    return *conjuncts.begin();
+
+  stringstream ss;
+  ss << "AND " << conjuncts.size() << endl;
+  for (auto& it : conjuncts)
+    ss << it.size() << " " << it << endl;
+  return ss.str();
+}
+
+} // namespace
+
+string ObligationChecker::hash_obligation(const Cfg& target, const Cfg& rewrite,
+    Cfg::id_type target_block, Cfg::id_type rewrite_block,
+    const CfgPath& P, const CfgPath& Q,
+    std::shared_ptr<Invariant> assume, std::shared_ptr<Invariant> prove,
+    bool separate_stack) {
+
+  stringstream ss;
+  write_path(ss, target, target_block, P);
+  write_path(ss, rewrite, rewrite_block, Q);
+  ss << canonical_invariant(assume) << endl;
+  ss << canonical_invariant(prove) << endl;
+  ss << separate_stack << endl;
+  return md5(ss.str());
+}
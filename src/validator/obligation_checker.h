@@ -36,6 +36,7 @@
 #include "src/symstate/memory/arm.h"
 #include "src/validator/data_collector.h"
 #include "src/validator/invariant.h"
+#include "src/validator/invariants/conjunction.h"
 #include "src/validator/filters/default.h"
 #include "src/validator/filters/bound_away.h"
 
@@ -117,6 +118,12 @@ public:
     std::istream& read_text(std::istream& is);
     std::ostream& write_text(std::ostream& os) const;
 
+    /** Canonical hash of this obligation; see ObligationChecker::hash_obligation. */
+    std::string hash() const {
+      return hash_obligation(target, rewrite, target_block, rewrite_block, P, Q,
+                             assume, prove, separate_stack);
+    }
+
     Obligation() :
       target(TUnit(), x64asm::RegSet::empty(), x64asm::RegSet::empty()),
       rewrite(TUnit(), x64asm::RegSet::empty(), x64asm::RegSet::empty())
@@ -229,6 +236,26 @@ public:
                      bool override_separate_stack,
                      void* optional) = 0;
 
+  /** Check a batch of obligations that differ only in the conjunct being
+    proved.  The callback is invoked once per conjunct of prove, with
+    optionals[i] for the i-th conjunct.  By default, each conjunct is checked
+    on its own. */
+  virtual void check_batch(const Cfg& target, const Cfg& rewrite,
+                           Cfg::id_type target_block, Cfg::id_type rewrite_block,
+                           const CfgPath& p, const CfgPath& q,
+                           std::shared_ptr<Invariant> assume, std::shared_ptr<ConjunctionInvariant> prove,
+                           const std::vector<std::pair<CpuState, CpuState>>& testcases,
+                           Callback& callback,
+                           bool override_separate_stack,
+                           const std::vector<void*>& optionals) {
+    assert(prove->size() == optionals.size());
+    for (size_t i = 0; i < prove->size(); ++i) {
+      // check() may modify the assumption, so each conjunct gets its own copy
+      check(target, rewrite, target_block, rewrite_block, p, q, assume->clone(), (*prove)[i],
+            testcases, callback, override_separate_stack, optionals[i]);
+    }
+  }
+
   void check(const Obligation& problem, Callback& callback, void* optional = NULL) {
     check(problem.target, problem.rewrite, problem.target_block, problem.rewrite_block,
           problem.P, problem.Q, problem.assume, problem.prove, problem.testcases,
@@ -263,6 +290,16 @@ public:
   /** Is there a jump in the path following this basic block? */
   static JumpType is_jump(const Cfg&, const Cfg::id_type start, const CfgPath& P, size_t i);
 
+  /** Compute a canonical hash of an obligation.  Only the code along P and Q
+    is hashed (not block ids or the rest of the cfgs), conjuncts of the
+    invariants are put in a normal order, and testcases are left out; so
+    obligations that differ only in these respects get the same hash. */
+  static std::string hash_obligation(const Cfg& target, const Cfg& rewrite,
+                                     Cfg::id_type target_block, Cfg::id_type rewrite_block,
+                                     const CfgPath& P, const CfgPath& Q,
+                                     std::shared_ptr<Invariant> assume, std::shared_ptr<Invariant> prove,
+                                     bool separate_stack);
+
 
 protected:
 
@@ -0,0 +1,210 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <typeinfo>
+
+#include "src/validator/obligation_scheduler.h"
+
+#define DEBUG_SCHEDULER(X) { if(0) { X } }
+
+using namespace std;
+using namespace stoke;
+
+ObligationScheduler::ObligationScheduler(ObligationChecker& checker) :
+  checker_(checker), window_(0), memo_(NULL), in_flight_(0), skipped_(0), callback_(NULL) {
+
+  wrapper_ = [this] (ObligationChecker::Result& result, void* param) {
+    handle(result, param);
+  };
+}
+
+string ObligationScheduler::get_kind(const Invariant& conjunct) {
+  return typeid(conjunct).name();
+}
+
+double ObligationScheduler::estimate_refutation(const Invariant& conjunct,
+    const ProgramAlignmentAutomata::State& state) const {
+
+  // Laplace-smoothed rates; with no history both are 1/2
+  auto kind = kind_stats_.find(get_kind(conjunct));
+  double kind_rate = 0.5;
+  if (kind != kind_stats_.end())
+    kind_rate = (kind->second.refuted + 1.0)/(kind->second.total + 2.0);
+
+  auto at_state = state_stats_.find(state);
+  double state_rate = 0.5;
+  if (at_state != state_stats_.end())
+    state_rate = (at_state->second.refuted + 1.0)/(at_state->second.total + 2.0);
+
+  return (kind_rate + state_rate)/2;
+}
+
+void ObligationScheduler::add(const Cfg& target, const Cfg& rewrite,
+                              const ProgramAlignmentAutomata::Edge& edge,
+                              shared_ptr<Invariant> assume, shared_ptr<ConjunctionInvariant> prove,
+                              const vector<pair<CpuState, CpuState>>& testcases,
+                              const vector<void*>& params) {
+
+  assert(prove->size() == params.size());
+  if (params.size() == 0)
+    return;
+
+  auto job = unique_ptr<Job>(new Job());
+  job->target = &target;
+  job->rewrite = &rewrite;
+  job->edge = edge;
+  job->assume = assume;
+  job->testcases = testcases;
+  job->outstanding = 0;
+  if (memo_) {
+    job->path_key = ProofMemo::path_key(edge);
+    job->assume_keys = ProofMemo::conjunct_keys(assume);
+  }
+
+  // longer paths mean bigger formulas
+  double cost = 1 + edge.te.size() + edge.re.size();
+  job->score = 0;
+  for (size_t i = 0; i < prove->size(); ++i) {
+    Item item;
+    item.conjunct = (*prove)[i];
+    item.param = params[i];
+    item.kind = get_kind(*item.conjunct);
+    item.score = estimate_refutation(*item.conjunct, edge.to)/cost;
+    if (memo_)
+      item.prove_key = ProofMemo::prove_key(item.conjunct);
+    job->score = max(job->score, item.score);
+    job->items.push_back(item);
+  }
+
+  stable_sort(job->items.begin(), job->items.end(), [] (const Item& a, const Item& b) {
+    return a.score > b.score;
+  });
+  job->tags.reserve(job->items.size());
+  for (size_t i = 0; i < job->items.size(); ++i)
+    job->tags.push_back({ job.get(), i });
+
+  queue_.push_back(move(job));
+}
+
+void ObligationScheduler::dispatch(Job& job, function<bool (void*)>& is_moot) {
+
+  auto batch = make_shared<ConjunctionInvariant>();
+  vector<void*> tags;
+  for (size_t i = 0; i < job.items.size(); ++i) {
+    auto& item = job.items[i];
+    if (is_moot(item.param)) {
+      skipped_++;
+      continue;
+    }
+
+    // this triple, or one that implies its verdict, has been checked before
+    ObligationChecker::Result result;
+    if (memo_ && memo_->lookup(job.path_key, job.assume_keys, item.prove_key, result)) {
+      (*callback_)(result, item.param);
+      continue;
+    }
+
+    batch->add_invariant(item.conjunct);
+    tags.push_back(&job.tags[i]);
+  }
+
+  if (batch->size() == 0)
+    return;
+
+  DEBUG_SCHEDULER(cout << "[scheduler] dispatching " << batch->size() << " conjuncts for "
+                  << job.edge << " with score " << job.score << endl;)
+
+  // callbacks may come before check_batch returns
+  job.outstanding = batch->size();
+  in_flight_++;
+  checker_.check_batch(*job.target, *job.rewrite, job.edge.to.ts, job.edge.to.rs,
+                       job.edge.te, job.edge.re, job.assume, batch, job.testcases,
+                       wrapper_, true, tags);
+}
+
+void ObligationScheduler::handle(ObligationChecker::Result& result, void* param) {
+  auto tag = static_cast<Tag*>(param);
+  auto job = tag->job;
+  auto& item = job->items[tag->index];
+
+  if (!result.has_error) {
+    bool refuted = result.has_ceg || !result.verified;
+    auto& kind = kind_stats_[item.kind];
+    auto& state = state_stats_[job->edge.to];
+    kind.total++;
+    state.total++;
+    if (refuted) {
+      kind.refuted++;
+      state.refuted++;
+    }
+  }
+
+  if (memo_)
+    memo_->record(job->path_key, job->assume_keys, item.prove_key, result);
+
+  (*callback_)(result, item.param);
+
+  if (--job->outstanding == 0)
+    in_flight_--;
+}
+
+void ObligationScheduler::run(ObligationChecker::Callback& callback,
+                              function<bool (void*)> is_moot,
+                              function<bool ()> should_stop) {
+
+  callback_ = &callback;
+  skipped_ = 0;
+  in_flight_ = 0;
+
+  stable_sort(queue_.begin(), queue_.end(), [] (const unique_ptr<Job>& a, const unique_ptr<Job>& b) {
+    return a->score > b->score;
+  });
+
+  size_t next = 0;
+  bool stopped = false;
+  while (next < queue_.size() || in_flight_ > 0) {
+    if (should_stop()) {
+      stopped = true;
+      break;
+    }
+
+    if (next < queue_.size() && (window_ == 0 || in_flight_ < window_)) {
+      dispatch(*queue_[next++], is_moot);
+      checker_.check_for_callbacks();
+      continue;
+    }
+
+    if (next == queue_.size()) {
+      checker_.block_until_complete();
+      in_flight_ = 0;
+      continue;
+    }
+
+    // the window is full; wait for something to finish
+    checker_.check_for_callbacks();
+    if (in_flight_ >= window_)
+      this_thread::sleep_for(chrono::milliseconds(1));
+  }
+
+  // anything still running refers to jobs we're about to free
+  if (stopped)
+    checker_.delete_all();
+
+  queue_.clear();
+  callback_ = NULL;
+}
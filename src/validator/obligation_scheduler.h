@@ -0,0 +1,148 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef STOKE_SRC_VALIDATOR_OBLIGATION_SCHEDULER_H
+#define STOKE_SRC_VALIDATOR_OBLIGATION_SCHEDULER_H
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "src/validator/invariants/conjunction.h"
+#include "src/validator/obligation_checker.h"
+#include "src/validator/paa.h"
+#include "src/validator/proof_memo.h"
+
+namespace stoke {
+
+/** Sits between DdecValidator and an ObligationChecker during a fixpoint
+  iteration.  Obligations are queued per PAA edge, then sent to the checker
+  with the ones most likely to be refuted, per unit of cost, first.  Before
+  each is sent, the caller gets to say whether it is still worth checking,
+  so work made moot by a refutation is never started. */
+class ObligationScheduler {
+
+public:
+
+  ObligationScheduler(ObligationChecker& checker);
+
+  /** Set the maximum number of edges being checked at once; 0 for no limit.
+    A small window keeps obligations in the queue, where a refutation can
+    still cancel them. */
+  ObligationScheduler& set_window(size_t n) {
+    window_ = n;
+    return *this;
+  }
+
+  /** Answer obligations from (and record verdicts in) a memo; NULL for none. */
+  ObligationScheduler& set_memo(ProofMemo* memo) {
+    memo_ = memo;
+    return *this;
+  }
+
+  /** Queue the conjuncts of prove for an edge, with one parameter each for
+    the callback. */
+  void add(const Cfg& target, const Cfg& rewrite,
+           const ProgramAlignmentAutomata::Edge& edge,
+           std::shared_ptr<Invariant> assume, std::shared_ptr<ConjunctionInvariant> prove,
+           const std::vector<std::pair<CpuState, CpuState>>& testcases,
+           const std::vector<void*>& params);
+
+  /** Check everything queued, calling the callback with the given parameters.
+    Conjuncts for which is_moot returns true when their turn comes are skipped.
+    Returns early, abandoning the rest, once should_stop returns true. */
+  void run(ObligationChecker::Callback& callback,
+           std::function<bool (void*)> is_moot,
+           std::function<bool ()> should_stop);
+
+  /** Estimated probability that a conjunct of this kind at this state is refuted. */
+  double estimate_refutation(const Invariant& conjunct, const ProgramAlignmentAutomata::State& state) const;
+
+  /** Number of conjuncts skipped by the last run. */
+  size_t get_skipped() const {
+    return skipped_;
+  }
+
+private:
+
+  struct Item {
+    std::shared_ptr<Invariant> conjunct;
+    void* param;
+    std::string kind;
+    double score;
+    /** Memo key of the conjunct. */
+    std::string prove_key;
+  };
+
+  struct Job;
+
+  /** Passed to the checker in place of the caller's parameter. */
+  struct Tag {
+    Job* job;
+    size_t index;
+  };
+
+  struct Job {
+    const Cfg* target;
+    const Cfg* rewrite;
+    ProgramAlignmentAutomata::Edge edge;
+    std::shared_ptr<Invariant> assume;
+    std::vector<std::pair<CpuState, CpuState>> testcases;
+    std::vector<Item> items;
+    std::vector<Tag> tags;
+    size_t outstanding;
+    double score;
+    /** Memo keys of the paths and the assumptions. */
+    std::string path_key;
+    std::set<std::string> assume_keys;
+  };
+
+  /** Refutations and outcomes seen. */
+  struct Stats {
+    size_t refuted;
+    size_t total;
+    Stats() : refuted(0), total(0) { }
+  };
+
+  /** Send the conjuncts of a job that aren't moot to the checker. */
+  void dispatch(Job& job, std::function<bool (void*)>& is_moot);
+  /** Record the outcome of a conjunct and pass it on. */
+  void handle(ObligationChecker::Result& result, void* param);
+
+  static std::string get_kind(const Invariant& conjunct);
+
+  ObligationChecker& checker_;
+  size_t window_;
+  ProofMemo* memo_;
+
+  std::vector<std::unique_ptr<Job>> queue_;
+  size_t in_flight_;
+  size_t skipped_;
+
+  ObligationChecker::Callback* callback_;
+  ObligationChecker::Callback wrapper_;
+
+  /** Outcomes by kind of conjunct, and by state; kept across runs. */
+  std::map<std::string, Stats> kind_stats_;
+  std::map<ProgramAlignmentAutomata::State, Stats> state_stats_;
+
+};
+
+} // namespace stoke
+
+#endif
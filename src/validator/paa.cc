@@ -90,15 +90,15 @@ ProgramAlignmentAutomata::Edge::Edge(ProgramAlignmentAutomata::State tail, const
   }
 }
 
-bool ProgramAlignmentAutomata::is_prefix(const CfgPath& tr1, const DataCollector::Trace& tr2) {
-  if (tr1.size() > tr2.size()) {
-    DEBUG_IS_PREFIX(cout << "[is_prefix]     tr1:" << tr1.size() << " > tr2:" << tr2.size() << endl;)
+bool ProgramAlignmentAutomata::is_prefix(const CfgPath& tr1, const DataCollector::Trace& tr2, size_t offset) {
+  if (tr1.size() > tr2.size() - offset) {
+    DEBUG_IS_PREFIX(cout << "[is_prefix]     tr1:" << tr1.size() << " > tr2:" << tr2.size() - offset << endl;)
     return false;
   }
 
   for (size_t i = 0; i < tr1.size(); ++i) {
-    DEBUG_IS_PREFIX(cout << "[is_prefix]      tr1[" << i << "]=" << tr1[i] << "; tr2[" << i << "]=" << tr2[i].block_id << endl;)
-    if (tr1[i] != tr2[i].block_id) {
+    DEBUG_IS_PREFIX(cout << "[is_prefix]      tr1[" << i << "]=" << tr1[i] << "; tr2[" << i << "]=" << tr2[offset + i].block_id << endl;)
+    if (tr1[i] != tr2[offset + i].block_id) {
       return false;
     }
   }
@@ -122,39 +122,20 @@ bool ProgramAlignmentAutomata::is_edge_prefix(const CfgPath& tr1, const CfgPath&
   return true;
 }
 
-void ProgramAlignmentAutomata::remove_prefix(const CfgPath& tr1, DataCollector::Trace& tr2) {
-  assert(is_prefix(tr1, tr2));
-
-  for (size_t i = 0; i < tr1.size(); ++i) {
-    tr2.erase(tr2.begin());
-  }
-}
-
 /** Here we trace one test case through the Automata along every possible path.
   Returns false on error. */
-bool ProgramAlignmentAutomata::learn_state_data(const DataCollector::Trace& orig_target_trace,
-    const DataCollector::Trace& orig_rewrite_trace) {
-
-  /** Copy traces */
-  auto target_trace = orig_target_trace;
-  auto rewrite_trace = orig_rewrite_trace;
+bool ProgramAlignmentAutomata::learn_state_data(const DataCollector::Trace& target_trace,
+    const DataCollector::Trace& rewrite_trace) {
 
   /** Setup initial state */
   TraceState initial;
   initial.state = start_state();
-  initial.target_current = target_trace[0].cs;
-  initial.rewrite_current = rewrite_trace[0].cs;
-
-  /** Configure initial traces */
-  auto tt_copy = target_trace;
-  auto rt_copy = rewrite_trace;
-
-  initial.target_trace = tt_copy;
-  initial.rewrite_trace = rt_copy;
+  initial.target_offset = 0;
+  initial.rewrite_offset = 0;
 
   /** Record initial data */
-  target_state_data_[initial.state].push_back(initial.target_current);
-  rewrite_state_data_[initial.state].push_back(initial.rewrite_current);
+  target_state_data_[initial.state].push_back(target_trace[0].cs);
+  rewrite_state_data_[initial.state].push_back(rewrite_trace[0].cs);
 
   /** Setup worklist */
   vector<TraceState> current;
@@ -174,12 +155,12 @@ bool ProgramAlignmentAutomata::learn_state_data(const DataCollector::Trace& orig
 
       if (exit == tr_state.state) {
 
-        if (tr_state.target_trace.size() != 1) {
+        if (target_trace.size() - tr_state.target_offset != 1) {
           DEBUG_LEARN_STATE_DATA(cout << "[lsd] problem: at exit state, but there's still unconsumed target trace" << endl;)
           return false;
         }
 
-        if (tr_state.rewrite_trace.size() != 1) {
+        if (rewrite_trace.size() - tr_state.rewrite_offset != 1) {
           DEBUG_LEARN_STATE_DATA(cout << "[lsd] problem: at exit state, but there's still unconsumed rewrite trace" << endl;)
           return false;
         }
@@ -189,8 +170,8 @@ bool ProgramAlignmentAutomata::learn_state_data(const DataCollector::Trace& orig
 
       DEBUG_LEARN_STATE_DATA(
         cout << "[lsd] processing trace state @ " << tr_state.state << endl;
-        cout << "[lsd]            target rem  = " << DataCollector::project_states(tr_state.target_trace) << endl;
-        cout << "[lsd]            rewrite rem = " << DataCollector::project_states(tr_state.rewrite_trace) << endl;)
+        cout << "[lsd]            target at   = " << tr_state.target_offset << " of " << target_trace.size() << endl;
+        cout << "[lsd]            rewrite at  = " << tr_state.rewrite_offset << " of " << rewrite_trace.size() << endl;)
       bool found_matching_edge = false;
 
       for (auto edge : next_edges_[tr_state.state]) {
@@ -207,7 +188,7 @@ bool ProgramAlignmentAutomata::learn_state_data(const DataCollector::Trace& orig
             // check if edge's target path is prefix of tr_state's target path
             auto te_copy = edge.te;
         te_copy.push_back(edge.to.ts);
-        if (!is_prefix(te_copy, tr_state.target_trace)) {
+        if (!is_prefix(te_copy, target_trace, tr_state.target_offset)) {
           DEBUG_LEARN_STATE_DATA(cout << "     target prefix fail" << endl;)
           continue;
         }
@@ -215,7 +196,7 @@ bool ProgramAlignmentAutomata::learn_state_data(const DataCollector::Trace& orig
         // check if edge's rewrite path is prefix of tr_state's rewrite path
         auto re_copy = edge.re;
         re_copy.push_back(edge.to.rs);
-        if (!is_prefix(re_copy, tr_state.rewrite_trace)) {
+        if (!is_prefix(re_copy, rewrite_trace, tr_state.rewrite_offset)) {
           DEBUG_LEARN_STATE_DATA(cout << "     rewrite prefix fail" << endl;)
           continue;
         }
@@ -229,23 +210,18 @@ bool ProgramAlignmentAutomata::learn_state_data(const DataCollector::Trace& orig
         TraceState follow = tr_state;
         follow.state = edge.to;
 
-        // (2) update the CpuStates
-        if (edge.te.size() < follow.target_trace.size())
-          follow.target_current = follow.target_trace[edge.te.size()].cs;
-        if (edge.re.size() < follow.rewrite_trace.size())
-          follow.rewrite_current = follow.rewrite_trace[edge.re.size()].cs;
-
-        // (3) remove the prefixes from both traces
-        remove_prefix(edge.te, follow.target_trace);
-        remove_prefix(edge.re, follow.rewrite_trace);
+        // (2) move past the edge in both traces; the CpuStates we're at now
+        // are the ones at the new offsets
+        follow.target_offset += edge.te.size();
+        follow.rewrite_offset += edge.re.size();
 
-        // (4) record the CpuState in the right place
-        target_state_data_[edge.to].push_back(follow.target_current);
-        rewrite_state_data_[edge.to].push_back(follow.rewrite_current);
-        target_edge_data_[edge].push_back(tr_state.target_current);
-        rewrite_edge_data_[edge].push_back(tr_state.rewrite_current);
+        // (3) record the CpuState in the right place
+        target_state_data_[edge.to].push_back(target_trace[follow.target_offset].cs);
+        rewrite_state_data_[edge.to].push_back(rewrite_trace[follow.rewrite_offset].cs);
+        target_edge_data_[edge].push_back(target_trace[tr_state.target_offset].cs);
+        rewrite_edge_data_[edge].push_back(rewrite_trace[tr_state.rewrite_offset].cs);
 
-        // (5) setup new worklist item
+        // (4) setup new worklist item
         next.push_back(follow);
         data_reachable_states_.insert(follow.state);
 
@@ -275,14 +251,15 @@ bool ProgramAlignmentAutomata::test_paa(DataCollector& dc) {
   target_state_data_.clear();
   rewrite_state_data_.clear();
 
-  auto target_traces = dc.get_traces(target_);
-  auto rewrite_traces = dc.get_traces(rewrite_);
+  auto& target_traces = dc.get_compact_traces(target_);
+  auto& rewrite_traces = dc.get_compact_traces(rewrite_);
 
-  // Step 1: get data at each state.
+  // Step 1: get data at each state.  Only one testcase's states are filled
+  // in at a time.
   for (size_t i = 0; i < target_traces.size(); ++i) {
     //cout << "TESTCASE " << i << endl;
-    auto target_trace = target_traces[i];
-    auto rewrite_trace = rewrite_traces[i];
+    auto target_trace = DataCollector::expand(target_traces[i]);
+    auto rewrite_trace = DataCollector::expand(rewrite_traces[i]);
 
     /*
     auto target_last = target_trace.back();
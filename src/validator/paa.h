@@ -348,10 +348,9 @@ private:
     a single test case. */
   struct TraceState {
     State state;
-    CpuState target_current;
-    CpuState rewrite_current;
-    DataCollector::Trace target_trace;
-    DataCollector::Trace rewrite_trace;
+    /** How far into the traces we are. */
+    size_t target_offset;
+    size_t rewrite_offset;
   };
 
   /** Runs a test case/trace through all possible paths in automata to
@@ -359,8 +358,9 @@ private:
   bool learn_state_data(const DataCollector::Trace& target,
                         const DataCollector::Trace& rewrite);
 
-  /** Is an edge (a series of states) a prefix of a trace (a series of state/cpu state pairs)? */
-  bool is_prefix(const CfgPath& tr1, const DataCollector::Trace& tr2);
+  /** Is an edge (a series of states) a prefix of a trace (a series of state/cpu state pairs)
+    starting at offset? */
+  bool is_prefix(const CfgPath& tr1, const DataCollector::Trace& tr2, size_t offset);
   /** Is an edge (a series of states) a prefix of a trace (a series of state/cpu state pairs)? */
   bool is_edge_prefix(const CfgPath& tr1, const CfgPath& tr2);
   /** Is a node contained in a cycle? */
@@ -369,9 +369,6 @@ private:
   /** Get fringe states of single CFG. */
   std::set<CfgPath> get_cfg_fringe(const Cfg& cfg, State state, bool is_rewrite) const;
 
-  /** Remove an edge prefix from a trace. */
-  void remove_prefix(const CfgPath& tr1, DataCollector::Trace& tr2);
-
   Cfg& target_; //serialize
   Cfg& rewrite_; //serialize
 
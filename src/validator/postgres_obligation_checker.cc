@@ -14,7 +14,6 @@
 
 #include "src/serialize/serialize.h"
 #include "src/validator/postgres_obligation_checker.h"
-#include "src/validator/md5.h"
 
 using namespace std;
 using namespace stoke;
@@ -105,6 +104,27 @@ void PostgresObligationChecker::check(const Cfg& target, const Cfg& rewrite,
                                       bool override_separate_stack,
                                       void* optional) {
 
+  auto hash = hash_obligation(target, rewrite, target_block, rewrite_block, p, q,
+                              assume, prove, separate_stack_ || override_separate_stack);
+
+  if (local_cache_.count(hash)) {
+    // this lightens the load on the database, and maybe even the local solver
+    cout << "[check] found answer in cache!" << endl;
+    callback(local_cache_[hash], optional);
+    return;
+  }
+
+  if (shortcircuit_ > 0) {
+    // if we can quickly perform the SMT check ourselves, don't go to the database
+    auto r = smt_checker_.check_wait(target, rewrite, target_block, rewrite_block,
+                                     p, q, assume, prove, testcases, override_separate_stack);
+    if (r.verified || r.has_ceg) {
+      local_cache_[hash] = r;
+      callback(r, optional);
+      return;
+    }
+  }
+
   /** Sample test cases */
   vector<pair<CpuState,CpuState>> sampled_testcases;
   if (testcases.size() > 5) {
@@ -131,25 +151,6 @@ void PostgresObligationChecker::check(const Cfg& target, const Cfg& rewrite,
 
   stringstream ss;
   obligation.write_text(ss);
-  auto hash = md5(ss.str());
-
-  if (local_cache_.count(hash)) {
-    // this lightens the load on the database, and maybe even the local solver
-    cout << "[check] found answer in cache!" << endl;
-    callback(local_cache_[hash], optional);
-    return;
-  }
-
-  if (shortcircuit_ > 0) {
-    // if we can quickly perform the SMT check ourselves, don't go to the database
-    auto r = smt_checker_.check_wait(target, rewrite, target_block, rewrite_block,
-                                     p, q, assume, prove, testcases, override_separate_stack);
-    if (r.verified || r.has_ceg) {
-      local_cache_[hash] = r;
-      callback(r, optional);
-      return;
-    }
-  }
 
   if (pipeline_ == NULL) {
     pipeline_tx_ = new nontransaction(connection_);
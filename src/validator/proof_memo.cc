@@ -0,0 +1,109 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <sstream>
+
+#include "src/validator/invariants/conjunction.h"
+#include "src/validator/md5.h"
+#include "src/validator/proof_memo.h"
+
+using namespace std;
+using namespace stoke;
+
+namespace {
+
+void add_conjunct_keys(shared_ptr<Invariant> inv, set<string>& keys) {
+  auto conj = dynamic_pointer_cast<ConjunctionInvariant>(inv);
+  if (conj) {
+    for (size_t i = 0; i < conj->size(); ++i)
+      add_conjunct_keys((*conj)[i], keys);
+    return;
+  }
+
+  stringstream ss;
+  inv->serialize(ss);
+  keys.insert(md5(ss.str()));
+}
+
+} // namespace
+
+string ProofMemo::path_key(const ProgramAlignmentAutomata::Edge& edge) {
+  // the block we end at decides which way the last jump goes
+  stringstream ss;
+  ss << edge.to.ts << " " << edge.to.rs << " ;";
+  for (auto it : edge.te)
+    ss << " " << it;
+  ss << " ;";
+  for (auto it : edge.re)
+    ss << " " << it;
+  return ss.str();
+}
+
+set<string> ProofMemo::conjunct_keys(shared_ptr<Invariant> inv) {
+  set<string> keys;
+  add_conjunct_keys(inv, keys);
+  return keys;
+}
+
+string ProofMemo::prove_key(shared_ptr<Invariant> inv) {
+  string key;
+  for (auto& it : conjunct_keys(inv))
+    key += it;
+  return key;
+}
+
+bool ProofMemo::lookup(const string& path, const set<string>& assume,
+                       const string& prove, ObligationChecker::Result& result) {
+
+  auto by_path = memo_.find(path);
+  if (by_path == memo_.end())
+    return false;
+  auto verdicts = by_path->second.find(prove);
+  if (verdicts == by_path->second.end())
+    return false;
+
+  for (auto& it : verdicts->second) {
+    bool proved = it.result.verified;
+    // proofs carry over to stronger assumptions, counterexamples to weaker ones
+    bool applies = proved ?
+                   includes(assume.begin(), assume.end(), it.assume.begin(), it.assume.end()) :
+                   includes(it.assume.begin(), it.assume.end(), assume.begin(), assume.end());
+    if (applies) {
+      result = it.result;
+      hits_++;
+      return true;
+    }
+  }
+  return false;
+}
+
+void ProofMemo::record(const string& path, const set<string>& assume,
+                       const string& prove, const ObligationChecker::Result& result) {
+  if (result.has_error)
+    return;
+
+  Verdict verdict;
+  verdict.assume = assume;
+  verdict.result = result;
+  memo_[path][prove].push_back(verdict);
+}
+
+size_t ProofMemo::size() const {
+  size_t count = 0;
+  for (auto& by_path : memo_)
+    for (auto& verdicts : by_path.second)
+      count += verdicts.second.size();
+  return count;
+}
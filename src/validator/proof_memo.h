@@ -0,0 +1,84 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef STOKE_SRC_VALIDATOR_PROOF_MEMO_H
+#define STOKE_SRC_VALIDATOR_PROOF_MEMO_H
+
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "src/validator/invariant.h"
+#include "src/validator/obligation_checker.h"
+#include "src/validator/paa.h"
+
+namespace stoke {
+
+/** Remembers the verdicts on hoare triples {assume} edge {prove} for one
+  target and rewrite, where assume is a set of conjuncts and prove a single
+  conjunct.  Verdicts are reused monotonically: a proof under a set of
+  assumptions holds under any superset of it, and a counterexample under a
+  set of assumptions is one under any subset of it. */
+class ProofMemo {
+
+public:
+
+  ProofMemo() : hits_(0) { }
+
+  /** Key for the paths of an edge. */
+  static std::string path_key(const ProgramAlignmentAutomata::Edge& edge);
+  /** Keys for the conjuncts of an invariant, with nested conjunctions flattened. */
+  static std::set<std::string> conjunct_keys(std::shared_ptr<Invariant> inv);
+  /** Key for the invariant to prove. */
+  static std::string prove_key(std::shared_ptr<Invariant> inv);
+
+  /** Look for a verdict that applies.  Returns false if there is none. */
+  bool lookup(const std::string& path, const std::set<std::string>& assume,
+              const std::string& prove, ObligationChecker::Result& result);
+
+  /** Remember a verdict.  Errors and timeouts aren't remembered. */
+  void record(const std::string& path, const std::set<std::string>& assume,
+              const std::string& prove, const ObligationChecker::Result& result);
+
+  /** Number of verdicts remembered. */
+  size_t size() const;
+  /** Number of successful lookups. */
+  size_t get_hits() const {
+    return hits_;
+  }
+
+  /** Forget everything; for a new target and rewrite. */
+  void clear() {
+    memo_.clear();
+    hits_ = 0;
+  }
+
+private:
+
+  struct Verdict {
+    std::set<std::string> assume;
+    ObligationChecker::Result result;
+  };
+
+  /** Verdicts by path, then by conjunct proved. */
+  std::map<std::string, std::map<std::string, std::vector<Verdict>>> memo_;
+  size_t hits_;
+
+};
+
+} // namespace stoke
+
+#endif
@@ -0,0 +1,327 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "src/validator/md5.h"
+#include "src/validator/result_store.h"
+
+using namespace std;
+using namespace stoke;
+
+#define INDEX_MAGIC 0x58444953454b4f54ull  // "TOKESIDX"
+#define LOG_MAGIC "STOKERS1"
+#define RECORD_MAGIC 0x52435244u
+#define INITIAL_CAPACITY 1024
+
+namespace {
+
+/** Holds flock() on a file for the lifetime of the object. */
+class FileLock {
+public:
+  FileLock(int fd, int operation) : fd_(fd) {
+    while (flock(fd_, operation) == -1 && errno == EINTR);
+  }
+  ~FileLock() {
+    flock(fd_, LOCK_UN);
+  }
+private:
+  int fd_;
+};
+
+} // namespace
+
+ResultStore::ResultStore(const string& path) :
+  index_fd_(-1), log_fd_(-1), map_(NULL), map_size_(0) {
+
+  log_fd_ = open((path + ".log").c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+  index_fd_ = open((path + ".idx").c_str(), O_RDWR | O_CREAT, 0644);
+  if (log_fd_ == -1 || index_fd_ == -1) {
+    error_ = "Could not open result store " + path + ": " + strerror(errno);
+    return;
+  }
+
+  FileLock lock(index_fd_, LOCK_EX);
+
+  struct stat st;
+  if (fstat(log_fd_, &st) == -1) {
+    error_ = string("Could not stat result log: ") + strerror(errno);
+    return;
+  }
+  // The log begins with a magic string, so no record lives at offset 0.
+  if (st.st_size == 0 && write(log_fd_, LOG_MAGIC, strlen(LOG_MAGIC)) != (ssize_t)strlen(LOG_MAGIC)) {
+    error_ = string("Could not initialize result log: ") + strerror(errno);
+    return;
+  }
+
+  if (fstat(index_fd_, &st) == -1) {
+    error_ = string("Could not stat result index: ") + strerror(errno);
+    return;
+  }
+  if (st.st_size == 0)
+    init_index(INITIAL_CAPACITY);
+  else
+    remap();
+}
+
+ResultStore::~ResultStore() {
+  if (map_)
+    munmap(map_, map_size_);
+  if (index_fd_ != -1)
+    close(index_fd_);
+  if (log_fd_ != -1)
+    close(log_fd_);
+}
+
+string ResultStore::make_key(const string& hash, Solver solver,
+                             ObligationChecker::AliasStrategy strategy,
+                             const string& settings) {
+  stringstream ss;
+  ss << hash << " " << (size_t)solver << " " << (size_t)strategy << " " << settings;
+  return ss.str();
+}
+
+void ResultStore::digest(const string& key, uint64_t* out) {
+  auto hex = md5(key);
+  out[0] = strtoull(hex.substr(0, 16).c_str(), NULL, 16);
+  out[1] = strtoull(hex.substr(16, 16).c_str(), NULL, 16);
+}
+
+bool ResultStore::remap() {
+  struct stat st;
+  if (fstat(index_fd_, &st) == -1) {
+    error_ = string("Could not stat result index: ") + strerror(errno);
+    return false;
+  }
+  if ((size_t)st.st_size == map_size_ && map_)
+    return true;
+
+  if (map_)
+    munmap(map_, map_size_);
+  map_ = NULL;
+  map_size_ = 0;
+
+  if ((size_t)st.st_size < sizeof(IndexHeader)) {
+    error_ = "Result index is truncated.";
+    return false;
+  }
+
+  void* map = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, index_fd_, 0);
+  if (map == MAP_FAILED) {
+    error_ = string("Could not map result index: ") + strerror(errno);
+    return false;
+  }
+  map_ = (char*)map;
+  map_size_ = st.st_size;
+
+  if (header()->magic != INDEX_MAGIC ||
+      sizeof(IndexHeader) + header()->capacity*sizeof(IndexSlot) > map_size_) {
+    error_ = "Result index is corrupt.";
+    return false;
+  }
+  return true;
+}
+
+bool ResultStore::init_index(uint64_t capacity) {
+  if (map_)
+    munmap(map_, map_size_);
+  map_ = NULL;
+  map_size_ = 0;
+
+  size_t size = sizeof(IndexHeader) + capacity*sizeof(IndexSlot);
+  if (ftruncate(index_fd_, 0) == -1 || ftruncate(index_fd_, size) == -1) {
+    error_ = string("Could not resize result index: ") + strerror(errno);
+    return false;
+  }
+
+  void* map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, index_fd_, 0);
+  if (map == MAP_FAILED) {
+    error_ = string("Could not map result index: ") + strerror(errno);
+    return false;
+  }
+  map_ = (char*)map;
+  map_size_ = size;
+
+  header()->capacity = capacity;
+  header()->count = 0;
+  header()->magic = INDEX_MAGIC;
+  return true;
+}
+
+bool ResultStore::grow() {
+  vector<IndexSlot> occupied;
+  for (size_t i = 0; i < header()->capacity; ++i) {
+    if (slots()[i].offset)
+      occupied.push_back(slots()[i]);
+  }
+
+  if (!init_index(2*header()->capacity))
+    return false;
+
+  // Keys are unique, so entries only need an empty slot.
+  auto capacity = header()->capacity;
+  for (auto& entry : occupied) {
+    size_t i = entry.digest[0] % capacity;
+    while (slots()[i].offset)
+      i = (i + 1) % capacity;
+    slots()[i] = entry;
+  }
+  header()->count = occupied.size();
+  return true;
+}
+
+ResultStore::IndexSlot* ResultStore::find_slot(const string& key, const uint64_t* digest, bool& found) {
+  found = false;
+  auto capacity = header()->capacity;
+
+  size_t i = digest[0] % capacity;
+  for (size_t probes = 0; probes < capacity; ++probes) {
+    auto slot = slots() + i;
+    if (slot->offset == 0)
+      return slot;
+
+    string stored;
+    if (slot->digest[0] == digest[0] && slot->digest[1] == digest[1] &&
+        read_key(slot->offset, stored) && stored == key) {
+      found = true;
+      return slot;
+    }
+    i = (i + 1) % capacity;
+  }
+  return NULL;
+}
+
+bool ResultStore::read_key(uint64_t offset, string& key) {
+  RecordHeader rh;
+  if (pread(log_fd_, &rh, sizeof(rh), offset) != sizeof(rh) || rh.magic != RECORD_MAGIC)
+    return false;
+
+  key.resize(rh.key_size);
+  return pread(log_fd_, &key[0], rh.key_size, offset + sizeof(rh)) == (ssize_t)rh.key_size;
+}
+
+bool ResultStore::read_value(uint64_t offset, string& value) {
+  RecordHeader rh;
+  if (pread(log_fd_, &rh, sizeof(rh), offset) != sizeof(rh) || rh.magic != RECORD_MAGIC)
+    return false;
+
+  value.resize(rh.value_size);
+  return pread(log_fd_, &value[0], rh.value_size, offset + sizeof(rh) + rh.key_size) == (ssize_t)rh.value_size;
+}
+
+bool ResultStore::get(const string& key, ObligationChecker::Result& result) {
+  lock_guard<mutex> guard(mutex_);
+  if (index_fd_ == -1)
+    return false;
+
+  FileLock lock(index_fd_, LOCK_SH);
+  if (!remap())
+    return false;
+
+  uint64_t d[2];
+  digest(key, d);
+
+  bool found;
+  auto slot = find_slot(key, d, found);
+  if (!found)
+    return false;
+
+  string value;
+  if (!read_value(slot->offset, value)) {
+    error_ = "Could not read result log record.";
+    return false;
+  }
+
+  stringstream ss(value);
+  result.read_text(ss);
+  return !ss.fail();
+}
+
+bool ResultStore::put(const string& key, const ObligationChecker::Result& result) {
+  lock_guard<mutex> guard(mutex_);
+  if (index_fd_ == -1)
+    return false;
+
+  FileLock lock(index_fd_, LOCK_EX);
+  if (!remap())
+    return false;
+
+  stringstream ss;
+  result.write_text(ss);
+  auto value = ss.str();
+
+  RecordHeader rh;
+  rh.magic = RECORD_MAGIC;
+  rh.key_size = key.size();
+  rh.value_size = value.size();
+
+  string record((char*)&rh, sizeof(rh));
+  record += key;
+  record += value;
+
+  // All writers hold the exclusive lock, so the record lands at the current end.
+  struct stat st;
+  if (fstat(log_fd_, &st) == -1) {
+    error_ = string("Could not stat result log: ") + strerror(errno);
+    return false;
+  }
+  uint64_t offset = st.st_size;
+  if (write(log_fd_, record.c_str(), record.size()) != (ssize_t)record.size()) {
+    error_ = string("Could not append to result log: ") + strerror(errno);
+    return false;
+  }
+
+  uint64_t d[2];
+  digest(key, d);
+
+  bool found;
+  auto slot = find_slot(key, d, found);
+  if (!found && 2*(header()->count + 1) > header()->capacity) {
+    if (!grow())
+      return false;
+    slot = find_slot(key, d, found);
+  }
+  if (!slot) {
+    error_ = "Result index is full.";
+    return false;
+  }
+
+  slot->digest[0] = d[0];
+  slot->digest[1] = d[1];
+  slot->offset = offset;
+  if (!found)
+    header()->count++;
+  return true;
+}
+
+size_t ResultStore::size() {
+  lock_guard<mutex> guard(mutex_);
+  if (index_fd_ == -1)
+    return 0;
+
+  FileLock lock(index_fd_, LOCK_SH);
+  if (!remap())
+    return 0;
+  return header()->count;
+}
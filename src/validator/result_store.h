@@ -0,0 +1,123 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef STOKE_SRC_VALIDATOR_RESULT_STORE_H
+#define STOKE_SRC_VALIDATOR_RESULT_STORE_H
+
+#include <mutex>
+#include <string>
+
+#include "src/solver/solver.h"
+#include "src/validator/obligation_checker.h"
+
+namespace stoke {
+
+/** A persistent store of obligation results that can be shared between
+  processes on one machine.  Results are appended to a log file (path.log),
+  and a memory-mapped open-addressing hash table (path.idx) maps keys to
+  offsets in the log.  All access is serialized with flock() on the index. */
+class ResultStore {
+
+public:
+
+  /** Open (or create) the store with the given path prefix. */
+  ResultStore(const std::string& path);
+  ~ResultStore();
+
+  /** Build the key for a result from an obligation hash, solver, strategy and
+    a description of any other settings the result depends on. */
+  static std::string make_key(const std::string& hash, Solver solver,
+                              ObligationChecker::AliasStrategy strategy,
+                              const std::string& settings);
+
+  /** Look up a result.  Returns false if there is none. */
+  bool get(const std::string& key, ObligationChecker::Result& result);
+  /** Record a result; it replaces any earlier result for the same key. */
+  bool put(const std::string& key, const ObligationChecker::Result& result);
+
+  /** Number of keys in the store. */
+  size_t size();
+
+  /** Did opening the store, or the last operation, fail? */
+  bool has_error() const {
+    return error_.size() > 0;
+  }
+  /** Get the last error message. */
+  std::string get_error() const {
+    return error_;
+  }
+
+private:
+
+  struct IndexHeader {
+    uint64_t magic;
+    uint64_t capacity;
+    uint64_t count;
+  };
+
+  struct IndexSlot {
+    uint64_t digest[2];
+    /** Offset of the record in the log; 0 for an empty slot. */
+    uint64_t offset;
+  };
+
+  struct RecordHeader {
+    uint32_t magic;
+    uint32_t key_size;
+    uint32_t value_size;
+  };
+
+  /** Index file descriptor; also used for locking. */
+  int index_fd_;
+  /** Log file descriptor. */
+  int log_fd_;
+  /** The mapped index. */
+  char* map_;
+  size_t map_size_;
+
+  /** Serializes threads of this process; flock() only excludes other processes. */
+  std::mutex mutex_;
+
+  std::string error_;
+
+  IndexHeader* header() {
+    return (IndexHeader*)map_;
+  }
+  IndexSlot* slots() {
+    return (IndexSlot*)(map_ + sizeof(IndexHeader));
+  }
+
+  /** Make sure the mapping covers the whole index file.  Call with the lock held. */
+  bool remap();
+  /** Initialize an empty index of the given capacity.  Call with the exclusive lock held. */
+  bool init_index(uint64_t capacity);
+  /** Double the capacity of the index.  Call with the exclusive lock held. */
+  bool grow();
+
+  /** Find the slot for a key: either the one holding it, or the empty slot
+    where it belongs. */
+  IndexSlot* find_slot(const std::string& key, const uint64_t* digest, bool& found);
+  /** Read the key stored in a log record. */
+  bool read_key(uint64_t offset, std::string& key);
+  /** Read the value stored in a log record. */
+  bool read_value(uint64_t offset, std::string& value);
+
+  /** Compute the digest of a key. */
+  static void digest(const std::string& key, uint64_t* out);
+
+};
+
+} // namespace stoke
+
+#endif
@@ -0,0 +1,80 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/validator/selecting_obligation_checker.h"
+
+#define DEBUG_SELECTING_CHECKER(X) { if(0) { X } }
+
+using namespace std;
+using namespace stoke;
+
+void SelectingObligationChecker::check(const Cfg& target, const Cfg& rewrite,
+                                       Cfg::id_type target_block, Cfg::id_type rewrite_block,
+                                       const CfgPath& p, const CfgPath& q,
+                                       std::shared_ptr<Invariant> assume, std::shared_ptr<Invariant> prove,
+                                       const std::vector<std::pair<CpuState, CpuState>>& testcases,
+                                       Callback& callback,
+                                       bool override_separate_stack,
+                                       void* optional) {
+
+  auto pending = new Pending(target, rewrite);
+  pending->target_block = target_block;
+  pending->rewrite_block = rewrite_block;
+  pending->p = p;
+  pending->q = q;
+  pending->assume = assume;
+  pending->prove = prove;
+  pending->testcases = testcases;
+  pending->override_separate_stack = override_separate_stack;
+  pending->features = StrategySelector::get_features(target, rewrite, p, q, assume, prove);
+  pending->order = selector_.rank(pending->features);
+  pending->next = 0;
+  pending->callback = &callback;
+  pending->optional = optional;
+
+  pending_.insert(pending);
+  dispatch(pending);
+}
+
+void SelectingObligationChecker::dispatch(Pending* pending) {
+  auto arm = pending->order[pending->next];
+  DEBUG_SELECTING_CHECKER(cout << "[selecting] " << pending->features.get_shape()
+                          << " to arm " << arm << endl;)
+  arms_[arm]->check(pending->target, pending->rewrite,
+                    pending->target_block, pending->rewrite_block,
+                    pending->p, pending->q, pending->assume, pending->prove,
+                    pending->testcases, record_callback_,
+                    pending->override_separate_stack, pending);
+}
+
+void SelectingObligationChecker::record(Result& result, void* optional) {
+  auto pending = static_cast<Pending*>(optional);
+  if (!pending_.count(pending))
+    return;
+
+  selector_.record(pending->features, pending->order[pending->next], result);
+
+  bool definitive = !result.has_error && (result.verified || result.has_ceg);
+  if (!definitive && pending->next + 1 < pending->order.size()) {
+    pending->next++;
+    dispatch(pending);
+    return;
+  }
+
+  pending_.erase(pending);
+  auto& callback = *pending->callback;
+  auto user_optional = pending->optional;
+  delete pending;
+  callback(result, user_optional);
+}
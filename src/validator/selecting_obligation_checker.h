@@ -0,0 +1,151 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef STOKE_SRC_VALIDATOR_SELECTING_OBLIGATION_CHECKER_H
+#define STOKE_SRC_VALIDATOR_SELECTING_OBLIGATION_CHECKER_H
+
+#include <set>
+#include <vector>
+
+#include "src/validator/obligation_checker.h"
+#include "src/validator/strategy_selector.h"
+
+namespace stoke {
+
+/** Sends each obligation to the child checker the StrategySelector predicts
+  to be fastest, and records how it did.  If that child has no definitive
+  answer, the next one in the ranking gets a turn. */
+class SelectingObligationChecker : public ObligationChecker {
+
+public:
+
+  /** Child i is the selector's arm i. */
+  SelectingObligationChecker(const std::vector<ObligationChecker*>& arms, StrategySelector& selector) :
+    ObligationChecker(), arms_(arms), selector_(selector)
+  {
+    record_callback_ = [this] (Result& result, void* optional) {
+      record(result, optional);
+    };
+  }
+
+  ~SelectingObligationChecker() {
+    delete_all();
+  }
+
+  /** Children keep their own alias strategies; the rest of the settings
+    apply to all of them. */
+  ObligationChecker& set_fixpoint_up(bool b) override {
+    ObligationChecker::set_fixpoint_up(b);
+    for (auto it : arms_)
+      it->set_fixpoint_up(b);
+    return *this;
+  }
+
+  ObligationChecker& set_separate_stack(bool b) override {
+    ObligationChecker::set_separate_stack(b);
+    for (auto it : arms_)
+      it->set_separate_stack(b);
+    return *this;
+  }
+
+  ObligationChecker& set_nacl(bool b) override {
+    ObligationChecker::set_nacl(b);
+    for (auto it : arms_)
+      it->set_nacl(b);
+    return *this;
+  }
+
+  ObligationChecker& set_basic_block_ghosts(bool b) override {
+    ObligationChecker::set_basic_block_ghosts(b);
+    for (auto it : arms_)
+      it->set_basic_block_ghosts(b);
+    return *this;
+  }
+
+  void check(const Cfg& target, const Cfg& rewrite,
+             Cfg::id_type target_block, Cfg::id_type rewrite_block,
+             const CfgPath& p, const CfgPath& q,
+             std::shared_ptr<Invariant> assume, std::shared_ptr<Invariant> prove,
+             const std::vector<std::pair<CpuState, CpuState>>& testcases,
+             Callback& callback,
+             bool override_separate_stack,
+             void* optional) override;
+
+  void check_for_callbacks() override {
+    for (auto it : arms_)
+      it->check_for_callbacks();
+  }
+
+  /** Blocks until all the checking has done and the callbacks have been called. */
+  void block_until_complete() override {
+    // a result can send its obligation on to another arm
+    while (pending_.size()) {
+      for (auto it : arms_)
+        it->block_until_complete();
+    }
+  }
+
+  void delete_all() override {
+    for (auto it : arms_)
+      it->delete_all();
+    for (auto it : pending_)
+      delete it;
+    pending_.clear();
+  }
+
+  Filter& get_filter() override {
+    return arms_[0]->get_filter();
+  }
+
+private:
+
+  /** An obligation being tried on the arms in order. */
+  struct Pending {
+    Cfg target;
+    Cfg rewrite;
+    Cfg::id_type target_block;
+    Cfg::id_type rewrite_block;
+    CfgPath p;
+    CfgPath q;
+    std::shared_ptr<Invariant> assume;
+    std::shared_ptr<Invariant> prove;
+    std::vector<std::pair<CpuState, CpuState>> testcases;
+    bool override_separate_stack;
+
+    StrategySelector::Features features;
+    std::vector<size_t> order;
+    size_t next;
+
+    Callback* callback;
+    void* optional;
+
+    Pending(const Cfg& t, const Cfg& r) : target(t), rewrite(r) { }
+  };
+
+  /** Send an obligation to its next arm. */
+  void dispatch(Pending* pending);
+  /** Handle the result from an arm. */
+  void record(Result& result, void* optional);
+
+  std::vector<ObligationChecker*> arms_;
+  StrategySelector& selector_;
+
+  Callback record_callback_;
+  std::set<Pending*> pending_;
+
+};
+
+} // namespace stoke
+
+#endif
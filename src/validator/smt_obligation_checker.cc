@@ -13,6 +13,8 @@
 // limitations under the License.
 
 #include <chrono>
+#include <set>
+#include <unordered_map>
 
 #include "src/cfg/cfg.h"
 #include "src/cfg/paths.h"
@@ -29,6 +31,7 @@
 #include "src/validator/smt_obligation_checker.h"
 #include "src/solver/z3solver.h"
 #include "src/symstate/memory_manager.h"
+#include "src/symstate/var_visitor.h"
 
 #include "tools/io/state_diff.h"
 #include "tools/common/version_info.h"
@@ -92,6 +95,75 @@ map<K,V> append_maps(vector<map<K,V>> maps) {
   return output;
 }
 
+namespace {
+
+/** Appends the top-level conjuncts of a constraint. */
+void split_conjuncts(const SymBool& b, vector<SymBool>& conjuncts) {
+  if (b.ptr->type() == SymBool::AND) {
+    auto conj = static_cast<const SymBoolAnd * const>(b.ptr);
+    split_conjuncts(SymBool(conj->a_), conjuncts);
+    split_conjuncts(SymBool(conj->b_), conjuncts);
+  } else if (b.ptr->type() != SymBool::TRUE) {
+    conjuncts.push_back(b);
+  }
+}
+
+} // namespace
+
+bool SmtObligationChecker::slice(const vector<SymBool>& constraints,
+                                 const vector<SymBool>& roots,
+                                 vector<SymBool>& cone) {
+
+  vector<SymBool> conjuncts;
+  for (auto& it : constraints)
+    split_conjuncts(it, conjuncts);
+
+  // Which conjuncts mention each variable
+  vector<vector<string>> vars(conjuncts.size());
+  unordered_map<string, vector<size_t>> users;
+  for (size_t i = 0; i < conjuncts.size(); ++i) {
+    SymVarVisitor visitor;
+    visitor(conjuncts[i]);
+    vars[i].assign(visitor.get_vars().begin(), visitor.get_vars().end());
+    for (auto& v : vars[i])
+      users[v].push_back(i);
+  }
+
+  // Walk back from the variables of the roots.  Closed conjuncts, like a
+  // constant false, stay in regardless.
+  vector<bool> keep(conjuncts.size(), false);
+  set<string> reached;
+  vector<string> worklist;
+  for (auto& it : roots) {
+    SymVarVisitor visitor;
+    visitor(it);
+    for (auto& v : visitor.get_vars())
+      if (reached.insert(v).second)
+        worklist.push_back(v);
+  }
+  for (size_t i = 0; i < conjuncts.size(); ++i)
+    keep[i] = vars[i].empty();
+
+  while (worklist.size()) {
+    auto v = worklist.back();
+    worklist.pop_back();
+    for (auto i : users[v]) {
+      if (keep[i])
+        continue;
+      keep[i] = true;
+      for (auto& w : vars[i])
+        if (reached.insert(w).second)
+          worklist.push_back(w);
+    }
+  }
+
+  cone.clear();
+  for (size_t i = 0; i < conjuncts.size(); ++i)
+    if (keep[i])
+      cone.push_back(conjuncts[i]);
+  return cone.size() < conjuncts.size();
+}
+
 /** Returns an invariant representing the fact that the last state transition in the path is taken. */
 std::shared_ptr<Invariant> SmtObligationChecker::get_jump_inv(const Cfg& cfg, Cfg::id_type end_block, const CfgPath& p, bool is_rewrite) {
   auto jump_type = ObligationChecker::is_jump(cfg, end_block, p, p.size() - 1);
@@ -328,6 +400,43 @@ void SmtObligationChecker::build_circuit(const Cfg& cfg, Cfg::id_type bb, JumpTy
     SymState& state, size_t& line_no, const LineMap& line_info,
     bool ignore_last_line) {
 
+  if (!block_summaries_ || !BlockSummaryCache::is_summarizable(cfg, bb)) {
+    execute_block(cfg, bb, jump, state, line_no, line_info, ignore_last_line);
+    return;
+  }
+
+  auto key = BlockSummaryCache::get_key(cfg, bb, jump, line_info, line_no, ignore_last_line);
+  if (!summary_cache_.find(key)) {
+    // Execute the block once on a fresh symbolic state.
+    auto previous_error = error_;
+    error_ = "";
+    size_t summary_line_no = line_no;
+    auto& summary = summary_cache_.begin(key);
+    try {
+      execute_block(cfg, bb, jump, summary, summary_line_no, line_info, ignore_last_line);
+    } catch (validator_error e) {
+      summary_cache_.end(key, false);
+      error_ = previous_error;
+      throw;
+    }
+    bool ok = error_.size() == 0;
+    summary_cache_.end(key, ok);
+    error_ = previous_error;
+
+    if (!ok) {
+      execute_block(cfg, bb, jump, state, line_no, line_info, ignore_last_line);
+      return;
+    }
+  }
+
+  summary_cache_.apply(key, state);
+  line_no += cfg.num_instrs(bb);
+}
+
+void SmtObligationChecker::execute_block(const Cfg& cfg, Cfg::id_type bb, JumpType jump,
+    SymState& state, size_t& line_no, const LineMap& line_info,
+    bool ignore_last_line) {
+
   if (cfg.num_instrs(bb) == 0)
     return;
 
@@ -529,8 +638,153 @@ void SmtObligationChecker::check(
   bool override_separate_stack,
   void* optional) {
 
+  init_mm();
+  check_core(target, rewrite, target_block, rewrite_block, P, Q, assume, { prove },
+             given_testcases, callback, override_separate_stack, { optional });
+  stop_mm();
+}
+
+void SmtObligationChecker::check_batch(
+  const Cfg& target,
+  const Cfg& rewrite,
+  Cfg::id_type target_block,
+  Cfg::id_type rewrite_block,
+  const CfgPath& P,
+  const CfgPath& Q,
+  std::shared_ptr<Invariant> assume,
+  std::shared_ptr<ConjunctionInvariant> prove,
+  const vector<pair<CpuState, CpuState>>& given_testcases,
+  Callback& callback,
+  bool override_separate_stack,
+  const vector<void*>& optionals) {
+
+  assert(prove->size() == optionals.size());
+
+  // The ARM model builds its aliasing cases from the dereferences of the
+  // invariant being proved, so each conjunct needs its own query.
+  bool batchable = alias_strategy_ != AliasStrategy::ARM;
+  for (size_t i = 0; i < prove->size(); ++i) {
+    if (dynamic_pointer_cast<MemoryEqualityInvariant>((*prove)[i]))
+      batchable = false;
+  }
+
+  if (!batchable || prove->size() < 2) {
+    ObligationChecker::check_batch(target, rewrite, target_block, rewrite_block, P, Q, assume, prove,
+                                   given_testcases, callback, override_separate_stack, optionals);
+    return;
+  }
+
+  vector<shared_ptr<Invariant>> proves;
+  for (size_t i = 0; i < prove->size(); ++i)
+    proves.push_back((*prove)[i]);
+
+  init_mm();
+  check_core(target, rewrite, target_block, rewrite_block, P, Q, assume, proves,
+             given_testcases, callback, override_separate_stack, optionals);
+  stop_mm();
+}
+
+void SmtObligationChecker::init_mm() {
+  if (mm_depth_++)
+    return;
+
+  if (!memory_manager_)
+    memory_manager_.reset(new SymMemoryManager());
+  previous_bv_manager_ = SymBitVector::get_memory_manager();
+  previous_bool_manager_ = SymBool::get_memory_manager();
+  previous_array_manager_ = SymArray::get_memory_manager();
+  SymBitVector::set_memory_manager(memory_manager_.get());
+  SymBool::set_memory_manager(memory_manager_.get());
+  SymArray::set_memory_manager(memory_manager_.get());
+}
+
+void SmtObligationChecker::stop_mm() {
+  assert(mm_depth_);
+  if (--mm_depth_)
+    return;
+
+  SymBitVector::set_memory_manager(previous_bv_manager_);
+  SymBool::set_memory_manager(previous_bool_manager_);
+  SymArray::set_memory_manager(previous_array_manager_);
+  // Nothing built from the summaries is in use between obligations.  Kept
+  // nodes may point into them, so they go too.
+  bool trimmed = summary_cache_.trim();
+  if (trimmed || !solver_.get_incremental() || memory_manager_->size() > max_kept_nodes_)
+    memory_manager_->collect();
+}
+
+void SmtObligationChecker::check_core(
+  const Cfg& target,
+  const Cfg& rewrite,
+  Cfg::id_type target_block,
+  Cfg::id_type rewrite_block,
+  const CfgPath& P,
+  const CfgPath& Q,
+  std::shared_ptr<Invariant> assume,
+  const vector<shared_ptr<Invariant>>& all_proves,
+  const vector<pair<CpuState, CpuState>>& given_testcases,
+  Callback& callback,
+  bool override_separate_stack,
+  const vector<void*>& all_optionals) {
+
+  assert(all_proves.size() > 0);
+  assert(all_proves.size() == all_optionals.size());
+
   auto start_time = system_clock::now();
 
+  // Concrete runs refute many obligations for much less than a query; the
+  // solver only sees the ones that survive.
+  vector<shared_ptr<Invariant>> proves;
+  vector<void*> optionals;
+  auto found = falsifier_.falsify(target, rewrite, target_block, rewrite_block, P, Q,
+                                  assume, all_proves, given_testcases);
+  for (size_t i = 0; i < all_proves.size(); ++i) {
+    if (!found.count(i)) {
+      proves.push_back(all_proves[i]);
+      optionals.push_back(all_optionals[i]);
+      continue;
+    }
+
+    auto& ceg = found[i];
+    ObligationChecker::Result result;
+    result.solver = solver_.get_enum();
+    result.strategy = alias_strategy_;
+    result.smt_time_microseconds = 0;
+    result.gen_time_microseconds = duration_cast<microseconds>(system_clock::now() - start_time).count();
+    result.source_version = string(version_info);
+    result.comments = "Concrete counterexample";
+    result.verified = false;
+    result.has_ceg = true;
+    result.has_error = false;
+    result.error_message = "";
+    result.target_ceg = ceg.target_start;
+    result.rewrite_ceg = ceg.rewrite_start;
+    result.target_final_ceg = ceg.target_end;
+    result.rewrite_final_ceg = ceg.rewrite_end;
+    callback(result, all_optionals[i]);
+  }
+  if (proves.empty())
+    return;
+
+  auto prove = proves[0];
+
+  // Errors and early exits apply to every obligation in the batch.
+  auto report_error = [&](string& message, uint64_t smt_duration, uint64_t gen_duration) {
+    for (auto optional : optionals)
+      return_error(callback, message, optional, smt_duration, gen_duration);
+  };
+  auto report = [&](ObligationChecker::Result& result) {
+    for (auto optional : optionals)
+      callback(result, optional);
+  };
+
+  // Racing memory models takes several checkers; see ForkingObligationChecker.
+  if (alias_strategy_ == AliasStrategy::ARMS_RACE) {
+    string message = "The arms race strategy needs a portfolio of checkers.";
+    report_error(message, 0, 0);
+    return;
+  }
+
   auto testcases = given_testcases;
 
 #ifdef DEBUG_CHECKER_PERFORMANCE
@@ -564,7 +818,7 @@ void SmtObligationChecker::check(
   OBLIG_DEBUG(assume->write_pretty(cout);)
   OBLIG_DEBUG(cout << endl;)
   OBLIG_DEBUG(cout << "Proving: ";)
-  OBLIG_DEBUG(prove->write_pretty(cout);)
+  OBLIG_DEBUG(for (auto it : proves) it->write_pretty(cout);)
   OBLIG_DEBUG(cout << endl;)
   OBLIG_DEBUG(cout << "----" << endl;)
   OBLIG_DEBUG(print_m.unlock();)
@@ -574,6 +828,7 @@ void SmtObligationChecker::check(
   bool arm_model = alias_strategy_ == AliasStrategy::ARM;
   bool dummy_model = alias_strategy_ == AliasStrategy::DUMMY;
   bool arm_testcases = arm_model && (testcases.size() > 0);
+  assert(!arm_model || proves.size() == 1);
 
   //OBLIG_DEBUG(cout << "[check_core] arm_testcases = " << arm_testcases << endl;)
 
@@ -671,7 +926,7 @@ void SmtObligationChecker::check(
     message << e.get_file() << ":" << e.get_line() << ": " << e.get_message();
     auto str = message.str();
     uint64_t gen_time = duration_cast<microseconds>(system_clock::now() - start_time).count();
-    return_error(callback, str, optional, 0, gen_time);
+    report_error(str, 0, gen_time);
     delete state_t.memory;
     delete state_r.memory;
     return;
@@ -696,7 +951,7 @@ void SmtObligationChecker::check(
 
   if (error_ != "") {
     uint64_t gen_time = duration_cast<microseconds>(system_clock::now() - start_time).count();
-    return_error(callback, error_, optional, 0, gen_time);
+    report_error(error_, 0, gen_time);
     return;
   }
 
@@ -727,7 +982,7 @@ void SmtObligationChecker::check(
       result.has_ceg = false;
       result.has_error = false;
       result.error_message = "";
-      callback(result, optional);
+      report(result);
       return;
     } else {
       cout << "Couldn't take short-circuit option without memory." << endl;
@@ -736,25 +991,32 @@ void SmtObligationChecker::check(
   }
 
 
-  auto prove_conj = dynamic_pointer_cast<ConjunctionInvariant>(prove);
-  shared_ptr<MemoryEqualityInvariant> prove_memequ;
-  if (!prove_conj) {
-    prove_conj = make_shared<ConjunctionInvariant>();
-    prove_conj->add_invariant(prove);
-  }
-  for (size_t i = 0; i < prove_conj->size(); ++i) {
-    auto inv = (*prove_conj)[i];
-    auto memequ = dynamic_pointer_cast<MemoryEqualityInvariant>(inv);
-    if (memequ) {
-      prove_memequ = memequ;
-      prove_conj->remove(i);
-      break;
+  // Build inequality constraints, one for each obligation
+  vector<shared_ptr<MemoryEqualityInvariant>> prove_memequs;
+  vector<SymBool> prove_part2s;
+  for (auto it : proves) {
+    auto prove_conj = dynamic_pointer_cast<ConjunctionInvariant>(it);
+    shared_ptr<MemoryEqualityInvariant> prove_memequ;
+    if (!prove_conj) {
+      prove_conj = make_shared<ConjunctionInvariant>();
+      prove_conj->add_invariant(it);
+    }
+    for (size_t i = 0; i < prove_conj->size(); ++i) {
+      auto inv = (*prove_conj)[i];
+      auto memequ = dynamic_pointer_cast<MemoryEqualityInvariant>(inv);
+      if (memequ) {
+        prove_memequ = memequ;
+        prove_conj->remove(i);
+        break;
+      }
     }
-  }
 
-  // Build inequality constraint
-  auto prove_part2 = !(*prove_conj)(state_t, state_r, invariant_lineno);
-  //cout << "prove constraints part 2 = " << prove_part2 << endl;
+    size_t prove_lineno = invariant_lineno;
+    auto prove_part2 = !(*prove_conj)(state_t, state_r, prove_lineno);
+    //cout << "prove constraints part 2 = " << prove_part2 << endl;
+    prove_memequs.push_back(prove_memequ);
+    prove_part2s.push_back(prove_part2);
+  }
 
   // Try to generate ARM testcase if needed
   if (arm_model && (testcases.size() == 0)) {
@@ -906,7 +1168,7 @@ void SmtObligationChecker::check(
       result.has_ceg = false;
       result.has_error = false;
       result.error_message = "";
-      callback(result, optional);
+      report(result);
       return;
     }
 
@@ -920,39 +1182,52 @@ void SmtObligationChecker::check(
                        rewrite_con.end());
   }
 
-  // Add prove memequ constraint
-  if (prove_memequ) {
-    vector<SymBitVector> excluded_badaddrs = prove_memequ->get_excluded_addresses(state_t, state_r);
-
-    auto target_heap = arm_model ? static_cast<ArmMemory*>(state_t.memory)->get_variable()
-                       : static_cast<FlatMemory*>(state_t.memory)->get_variable();
-    auto rewrite_heap = arm_model ? static_cast<ArmMemory*>(state_r.memory)->get_variable()
-                        : static_cast<FlatMemory*>(state_r.memory)->get_variable();
-
-    if (excluded_badaddrs.size()) {
-      SymBitVector badaddr = SymBitVector::tmp_var(64);
-      SymBool prove_part1 = SymBool::_false();
-      SymBool is_badaddr = SymBool::_true();
-      for (auto it : excluded_badaddrs)
-        is_badaddr = is_badaddr & (it != badaddr);
-
-      auto target_read = target_heap[badaddr];
-      auto rewrite_read = rewrite_heap[badaddr];
-
-      is_badaddr = is_badaddr & (target_read != rewrite_read);
-      prove_part1 = prove_part1 | is_badaddr;
-      //cout << "Generating prove_part1 = " << prove_part1 << endl;
-
-      auto prove_constraint = prove_part1 | prove_part2;
-      constraints.push_back(prove_constraint);
+  // Add prove memequ constraints
+  vector<SymBool> prove_constraints;
+  for (size_t k = 0; k < proves.size(); ++k) {
+    auto prove_memequ = prove_memequs[k];
+    auto prove_part2 = prove_part2s[k];
+
+    if (prove_memequ) {
+      vector<SymBitVector> excluded_badaddrs = prove_memequ->get_excluded_addresses(state_t, state_r);
+
+      auto target_heap = arm_model ? static_cast<ArmMemory*>(state_t.memory)->get_variable()
+                         : static_cast<FlatMemory*>(state_t.memory)->get_variable();
+      auto rewrite_heap = arm_model ? static_cast<ArmMemory*>(state_r.memory)->get_variable()
+                          : static_cast<FlatMemory*>(state_r.memory)->get_variable();
+
+      if (excluded_badaddrs.size()) {
+        SymBitVector badaddr = SymBitVector::tmp_var(64);
+        SymBool prove_part1 = SymBool::_false();
+        SymBool is_badaddr = SymBool::_true();
+        for (auto it : excluded_badaddrs)
+          is_badaddr = is_badaddr & (it != badaddr);
+
+        auto target_read = target_heap[badaddr];
+        auto rewrite_read = rewrite_heap[badaddr];
+
+        is_badaddr = is_badaddr & (target_read != rewrite_read);
+        prove_part1 = prove_part1 | is_badaddr;
+        //cout << "Generating prove_part1 = " << prove_part1 << endl;
+
+        auto prove_constraint = prove_part1 | prove_part2;
+        prove_constraints.push_back(prove_constraint);
+      } else {
+        auto prove_constraint = !(target_heap == rewrite_heap) | prove_part2;
+        prove_constraints.push_back(prove_constraint);
+      }
     } else {
-      auto prove_constraint = !(target_heap == rewrite_heap) | prove_part2;
-      constraints.push_back(prove_constraint);
+      prove_constraints.push_back(prove_part2);
     }
-  } else {
-    constraints.push_back(prove_part2);
   }
 
+  // A single obligation is checked with one query; a batch shares its
+  // constraints in one solver session and checks each obligation under an
+  // assumption.
+  bool batch = proves.size() > 1;
+  if (!batch)
+    constraints.push_back(prove_constraints[0]);
+
 
   CONSTRAINT_DEBUG(print_m.lock();)
   CONSTRAINT_DEBUG(cout << "[ConstraintDebug] for P: " << P << " Q: " << Q << endl;)
@@ -970,150 +1245,199 @@ void SmtObligationChecker::check(
 #endif
 
   auto sat_start = system_clock::now();
+  uint64_t gen_duration = duration_cast<microseconds>(sat_start - start_time).count();
+
+  // Most obligations are about a few registers; leave out the constraints
+  // that can't reach them.
+  vector<SymBool> cone;
+  bool sliced = slicing_ && slice(constraints, prove_constraints, cone);
 
   //simplifier_.simplify(constraints);
-  bool is_sat = solver_.is_sat(constraints);
-  uint64_t smt_duration = duration_cast<microseconds>(system_clock::now() - sat_start).count();
-  uint64_t gen_duration = duration_cast<microseconds>(sat_start - start_time).count();
+  if (batch)
+    solver_.start_session(sliced ? cone : constraints);
 
-  if (solver_.has_error()) {
-    stringstream err;
-    err << "solver: " << solver_.get_error();
-    auto str = err.str();
-    return_error(callback, str, optional, smt_duration, gen_duration);
-    return;
-  }
+  auto query = [&](size_t k) {
+    if (batch)
+      return solver_.is_sat_assuming(prove_constraints[k]);
+    return solver_.is_sat(sliced ? cone : constraints);
+  };
+
+  // Obligations that already have a result
+  vector<bool> done(proves.size(), false);
+
+  for (size_t k = 0; k < proves.size(); ++k) {
+    if (done[k])
+      continue;
+    done[k] = true;
+
+    auto query_start = system_clock::now();
+    bool is_sat = query(k);
+    if (is_sat && sliced && !solver_.has_error()) {
+      // What was left out may be unsatisfiable by itself, as on an infeasible
+      // path, and the counterexample needs a model of the whole state.  From
+      // here on, query everything.
+      sliced = false;
+      if (batch) {
+        solver_.end_session();
+        solver_.start_session(constraints);
+      }
+      is_sat = query(k);
+    }
+    uint64_t smt_duration = duration_cast<microseconds>(system_clock::now() - query_start).count();
+
+    if (solver_.has_error()) {
+      stringstream err;
+      err << "solver: " << solver_.get_error();
+      auto str = err.str();
+      return_error(callback, str, optionals[k], smt_duration, gen_duration);
+      continue;
+    }
 
 #ifdef DEBUG_CHECKER_PERFORMANCE
-  microseconds perf_solve = duration_cast<microseconds>(system_clock::now().time_since_epoch());
-  solver_time_ += (perf_solve - perf_constr_end).count();
+    microseconds perf_solve = duration_cast<microseconds>(system_clock::now().time_since_epoch());
+    solver_time_ += (perf_solve - perf_constr_end).count();
 #endif
 
 
 
-  ObligationChecker::Result result;
-  result.solver = solver_.get_enum();
-  result.strategy = alias_strategy_;
-  result.smt_time_microseconds = smt_duration;
-  result.gen_time_microseconds = gen_duration;
-  result.source_version = string(version_info);
+    ObligationChecker::Result result;
+    result.solver = solver_.get_enum();
+    result.strategy = alias_strategy_;
+    result.smt_time_microseconds = smt_duration;
+    result.gen_time_microseconds = gen_duration;
+    result.source_version = string(version_info);
+
+    if (is_sat) {
+      CpuState ceg_t = state_from_model("_1_INIT");
+      CpuState ceg_r = state_from_model("_2_INIT");
+      CpuState ceg_tf = state_from_model("_1_FINAL");
+      CpuState ceg_rf = state_from_model("_2_FINAL");
+
+      auto target_rsp = ceg_t[rsp];
+      auto rewrite_rsp = ceg_r[rsp];
+
+      bool ok = true;
+      if (flat_model) {
+        auto target_flat = static_cast<FlatMemory*>(state_t.memory);
+        auto rewrite_flat = static_cast<FlatMemory*>(state_r.memory);
+
+        vector<map<const SymBitVectorAbstract*, uint64_t>> other_maps;
+        other_maps.push_back(target_flat->get_access_list());
+        other_maps.push_back(rewrite_flat->get_access_list());
+        auto other_map = append_maps(other_maps);
+
+        ok &= build_testcase_from_array(ceg_t, target_flat->get_start_variable(),
+                                        target_flat->get_stack_start_variables(), other_map, target_rsp);
+        ok &= build_testcase_from_array(ceg_r, rewrite_flat->get_start_variable(),
+                                        rewrite_flat->get_stack_start_variables(), other_map, rewrite_rsp);
+        build_testcase_from_array(ceg_tf, target_flat->get_variable(),
+                                  target_flat->get_stack_end_variables(), other_map, target_rsp);
+        build_testcase_from_array(ceg_rf, rewrite_flat->get_variable(),
+                                  rewrite_flat->get_stack_end_variables(), other_map, rewrite_rsp);
+
+      } else if (arm_model) {
+        auto target_arm = static_cast<ArmMemory*>(state_t.memory);
+        auto rewrite_arm = static_cast<ArmMemory*>(state_r.memory);
+
+        vector<map<const SymBitVectorAbstract*, uint64_t>> other_maps;
+        other_maps.push_back(target_arm->get_access_list());
+        other_maps.push_back(rewrite_arm->get_access_list());
+        auto other_map = append_maps(other_maps);
+
+        ok &= build_testcase_from_array(ceg_t, target_arm->get_start_variable(),
+                                        target_arm->get_stack_start_variables(), other_map, target_rsp);
+        ok &= build_testcase_from_array(ceg_r, rewrite_arm->get_start_variable(),
+                                        rewrite_arm->get_stack_start_variables(), other_map, rewrite_rsp);
+        build_testcase_from_array(ceg_tf, target_arm->get_variable(),
+                                  target_arm->get_stack_end_variables(), other_map, target_rsp);
+        build_testcase_from_array(ceg_rf, rewrite_arm->get_variable(),
+                                  rewrite_arm->get_stack_end_variables(), other_map, rewrite_rsp);
+      }
 
-  if (is_sat) {
-    bool have_ceg;
-    CpuState ceg_t = state_from_model("_1_INIT");
-    CpuState ceg_r = state_from_model("_2_INIT");
-    CpuState ceg_tf = state_from_model("_1_FINAL");
-    CpuState ceg_rf = state_from_model("_2_FINAL");
-
-    auto target_rsp = ceg_t[rsp];
-    auto rewrite_rsp = ceg_r[rsp];
-
-    bool ok = true;
-    if (flat_model) {
-      auto target_flat = static_cast<FlatMemory*>(state_t.memory);
-      auto rewrite_flat = static_cast<FlatMemory*>(state_r.memory);
-
-      vector<map<const SymBitVectorAbstract*, uint64_t>> other_maps;
-      other_maps.push_back(target_flat->get_access_list());
-      other_maps.push_back(rewrite_flat->get_access_list());
-      auto other_map = append_maps(other_maps);
-
-      ok &= build_testcase_from_array(ceg_t, target_flat->get_start_variable(),
-                                      target_flat->get_stack_start_variables(), other_map, target_rsp);
-      ok &= build_testcase_from_array(ceg_r, rewrite_flat->get_start_variable(),
-                                      rewrite_flat->get_stack_start_variables(), other_map, rewrite_rsp);
-      build_testcase_from_array(ceg_tf, target_flat->get_variable(),
-                                target_flat->get_stack_end_variables(), other_map, target_rsp);
-      build_testcase_from_array(ceg_rf, rewrite_flat->get_variable(),
-                                rewrite_flat->get_stack_end_variables(), other_map, rewrite_rsp);
-
-    } else if (arm_model) {
-      auto target_arm = static_cast<ArmMemory*>(state_t.memory);
-      auto rewrite_arm = static_cast<ArmMemory*>(state_r.memory);
-
-      vector<map<const SymBitVectorAbstract*, uint64_t>> other_maps;
-      other_maps.push_back(target_arm->get_access_list());
-      other_maps.push_back(rewrite_arm->get_access_list());
-      auto other_map = append_maps(other_maps);
-
-      ok &= build_testcase_from_array(ceg_t, target_arm->get_start_variable(),
-                                      target_arm->get_stack_start_variables(), other_map, target_rsp);
-      ok &= build_testcase_from_array(ceg_r, rewrite_arm->get_start_variable(),
-                                      rewrite_arm->get_stack_start_variables(), other_map, rewrite_rsp);
-      build_testcase_from_array(ceg_tf, target_arm->get_variable(),
-                                target_arm->get_stack_end_variables(), other_map, target_rsp);
-      build_testcase_from_array(ceg_rf, rewrite_arm->get_variable(),
-                                rewrite_arm->get_stack_end_variables(), other_map, rewrite_rsp);
-    }
+      if (!ok) {
+        // We don't have memory accurate in our counterexample.  Just leave.
+        CEG_DEBUG(cout << "[counterexample-debug] for P: " << P << " Q: " << Q << endl;)
+        CEG_DEBUG(cout << "(  Counterexample does not have accurate memory)" << endl;)
+      }
 
-    if (!ok) {
-      // We don't have memory accurate in our counterexample.  Just leave.
+      CEG_DEBUG(print_m.lock();)
       CEG_DEBUG(cout << "[counterexample-debug] for P: " << P << " Q: " << Q << endl;)
-      CEG_DEBUG(cout << "(  Counterexample does not have accurate memory)" << endl;)
-    }
-
-    CEG_DEBUG(print_m.lock();)
-    CEG_DEBUG(cout << "[counterexample-debug] for P: " << P << " Q: " << Q << endl;)
-    CEG_DEBUG(cout << "  (Got counterexample)" << endl;)
-    CEG_DEBUG(cout << "TARGET START STATE" << endl;)
-    CEG_DEBUG(cout << ceg_t << endl;)
-    CEG_DEBUG(cout << "REWRITE START STATE" << endl;)
-    CEG_DEBUG(cout << ceg_r << endl;)
-    CEG_DEBUG(cout << "TARGET (expected) END STATE" << endl;)
-    CEG_DEBUG(cout << ceg_tf << endl;)
-    CEG_DEBUG(cout << "REWRITE (expected) END STATE" << endl;)
-    CEG_DEBUG(cout << ceg_rf << endl;)
-    CEG_DEBUG(print_m.unlock();)
-
-
-    /** Checks ceg with sandbox. */
-    if (!check_counterexamples_ || check_counterexample(target, rewrite, target_unroll, rewrite_unroll, P, Q, target_linemap, rewrite_linemap, assume, prove, ceg_t, ceg_r, ceg_tf, ceg_rf, separate_stack)) {
-    } else {
-      ok = false;
-      CEG_DEBUG(cout << "  (Spurious counterexample detected) P=" << P << " Q=" << Q << endl;)
-    }
-
-    delete state_t.memory;
-    delete state_r.memory;
+      CEG_DEBUG(cout << "  (Got counterexample)" << endl;)
+      CEG_DEBUG(cout << "TARGET START STATE" << endl;)
+      CEG_DEBUG(cout << ceg_t << endl;)
+      CEG_DEBUG(cout << "REWRITE START STATE" << endl;)
+      CEG_DEBUG(cout << ceg_r << endl;)
+      CEG_DEBUG(cout << "TARGET (expected) END STATE" << endl;)
+      CEG_DEBUG(cout << ceg_tf << endl;)
+      CEG_DEBUG(cout << "REWRITE (expected) END STATE" << endl;)
+      CEG_DEBUG(cout << ceg_rf << endl;)
+      CEG_DEBUG(print_m.unlock();)
+
+
+      /** Checks ceg with sandbox. */
+      if (!check_counterexamples_ || check_counterexample(target, rewrite, target_unroll, rewrite_unroll, P, Q, target_linemap, rewrite_linemap, assume, proves[k], ceg_t, ceg_r, ceg_tf, ceg_rf, separate_stack)) {
+        if (ok)
+          falsifier_.add(ceg_t, ceg_r);
+      } else {
+        ok = false;
+        CEG_DEBUG(cout << "  (Spurious counterexample detected) P=" << P << " Q=" << Q << endl;)
+      }
 
 #ifdef DEBUG_CHECKER_PERFORMANCE
-    microseconds perf_ceg = duration_cast<microseconds>(system_clock::now().time_since_epoch());
-    ceg_time_ += (perf_ceg - perf_solve).count();
-    print_performance();
+      microseconds perf_ceg = duration_cast<microseconds>(system_clock::now().time_since_epoch());
+      ceg_time_ += (perf_ceg - perf_solve).count();
+      print_performance();
 #endif
 
-    result.verified = false;
-    result.has_ceg = ok;
-    result.has_error = false;
-    result.error_message = "";
-    result.target_ceg = ceg_t;
-    result.rewrite_ceg = ceg_r;
-    result.target_final_ceg = ceg_tf;
-    result.rewrite_final_ceg = ceg_rf;
+      result.verified = false;
+      result.has_ceg = ok;
+      result.has_error = false;
+      result.error_message = "";
+      result.target_ceg = ceg_t;
+      result.rewrite_ceg = ceg_r;
+      result.target_final_ceg = ceg_tf;
+      result.rewrite_final_ceg = ceg_rf;
 
-    callback(result, optional);
+      callback(result, optionals[k]);
 
-  } else {
+      // A real counterexample also refutes every other obligation of the
+      // batch that fails on its final states; those need no query.
+      if (!ok)
+        continue;
+      for (size_t j = k + 1; j < proves.size(); ++j) {
+        if (done[j] || proves[j]->check(ceg_tf, ceg_rf))
+          continue;
+        done[j] = true;
+
+        ObligationChecker::Result shared = result;
+        shared.smt_time_microseconds = 0;
+        shared.comments = "Counterexample shared within batch";
+        callback(shared, optionals[j]);
+      }
 
-    delete state_t.memory;
-    delete state_r.memory;
+    } else {
 
-    CEG_DEBUG(cout << "  (This case verified)" << endl;)
+      CEG_DEBUG(cout << "  (This case verified)" << endl;)
 
 #ifdef DEBUG_CHECKER_PERFORMANCE
-    microseconds perf_ceg = duration_cast<microseconds>(system_clock::now().time_since_epoch());
-    ceg_time_ += (perf_ceg - perf_solve).count();
+      microseconds perf_ceg = duration_cast<microseconds>(system_clock::now().time_since_epoch());
+      ceg_time_ += (perf_ceg - perf_solve).count();
 #endif
 
-    result.verified = true;
-    result.has_ceg = false;
-    result.has_error = false;
-    result.error_message = "";
-    callback(result, optional);
+      result.verified = true;
+      result.has_ceg = false;
+      result.has_error = false;
+      result.error_message = "";
+      callback(result, optionals[k]);
 
+    }
   }
 
+  if (batch)
+    solver_.end_session();
 
+  delete state_t.memory;
+  delete state_r.memory;
 }
 
 
@@ -32,6 +32,8 @@
 #include "src/symstate/memory/flat.h"
 #include "src/symstate/memory/arm.h"
 #include "src/symstate/simplify.h"
+#include "src/validator/block_summary_cache.h"
+#include "src/validator/concrete_falsifier.h"
 #include "src/validator/data_collector.h"
 #include "src/validator/invariant.h"
 #include "src/validator/line_info.h"
@@ -48,23 +50,32 @@
 namespace stoke {
 
 class SmtObligationChecker : public ObligationChecker {
+  friend class BlockSummaryCacheTest;
 
 public:
 
   SmtObligationChecker(SMTSolver& solver, Filter& filter) :
     ObligationChecker(),
     check_counterexamples_(true),
+    block_summaries_(true),
+    slicing_(true),
     solver_(solver),
-    filter_(filter)
+    filter_(filter),
+    memory_manager_(),
+    mm_depth_(0)
   {
   }
 
   SmtObligationChecker(const SmtObligationChecker& oc) :
     ObligationChecker(),
     check_counterexamples_(oc.check_counterexamples_),
+    block_summaries_(oc.block_summaries_),
+    slicing_(oc.slicing_),
+    falsifier_(oc.falsifier_),
     solver_(oc.solver_),
     filter_(oc.filter_),
-    memory_manager_()
+    memory_manager_(),
+    mm_depth_(0)
   {
   }
 
@@ -80,6 +91,32 @@ public:
     return *this;
   }
 
+  /** Reuse symbolic summaries of basic blocks across paths and obligations. */
+  SmtObligationChecker& set_block_summaries(bool b) {
+    block_summaries_ = b;
+    if (!b) {
+      // the solver only watches our manager, whose nodes may use the summaries
+      summary_cache_.clear();
+      if (memory_manager_)
+        memory_manager_->collect();
+    }
+    return *this;
+  }
+
+  /** Send the solver only the constraints in the cone of influence of the
+    invariant to prove. */
+  SmtObligationChecker& set_slicing(bool b) {
+    slicing_ = b;
+    return *this;
+  }
+
+  /** Before asking the solver, run the paths on up to this many concrete
+    start states; 0 turns it off. */
+  SmtObligationChecker& set_falsifier_trials(size_t n) {
+    falsifier_.set_trials(n);
+    return *this;
+  }
+
   /** Check.  This is a wrapper around check_* functions that handles parallelism and fixpoint. */
   void check(const Cfg& target, const Cfg& rewrite,
              Cfg::id_type target_block, Cfg::id_type rewrite_block,
@@ -90,16 +127,55 @@ public:
              bool override_separate_stack,
              void* optional) override;
 
+  /** Check a batch of conjuncts.  The path constraints are built once, and
+    each negated conjunct is checked under an assumption in one solver
+    session. */
+  void check_batch(const Cfg& target, const Cfg& rewrite,
+                   Cfg::id_type target_block, Cfg::id_type rewrite_block,
+                   const CfgPath& p, const CfgPath& q,
+                   std::shared_ptr<Invariant> assume, std::shared_ptr<ConjunctionInvariant> prove,
+                   const std::vector<std::pair<CpuState, CpuState>>& testcases,
+                   Callback& callback,
+                   bool override_separate_stack,
+                   const std::vector<void*>& optionals) override;
+
   Filter& get_filter() {
     return filter_;
   }
 
+  /** Collect the top-level conjuncts of the constraints that share a
+    variable with the roots, or with a conjunct collected before.  Returns
+    whether any conjunct was left out.  The cone is satisfiable whenever the
+    constraints are; the converse holds only if the rest is satisfiable. */
+  static bool slice(const std::vector<SymBool>& constraints,
+                    const std::vector<SymBool>& roots,
+                    std::vector<SymBool>& cone);
+
 private:
 
   bool check_counterexamples_;
+  bool block_summaries_;
+  bool slicing_;
+
+  /** Symbolic transfer functions of memory-free basic blocks. */
+  BlockSummaryCache summary_cache_;
+
+  /** Refutes obligations by concrete execution, ahead of the solver. */
+  ConcreteFalsifier falsifier_;
 
   SymSimplify simplifier_;
 
+  /** Check one or more obligations that share everything but the invariant to prove. */
+  void check_core(const Cfg& target, const Cfg& rewrite,
+                  Cfg::id_type target_block, Cfg::id_type rewrite_block,
+                  const CfgPath& p, const CfgPath& q,
+                  std::shared_ptr<Invariant> assume,
+                  const std::vector<std::shared_ptr<Invariant>>& proves,
+                  const std::vector<std::pair<CpuState, CpuState>>& testcases,
+                  Callback& callback,
+                  bool override_separate_stack,
+                  const std::vector<void*>& optionals);
+
   /** Trigger callback with error message. */
   void return_error(Callback& callback, std::string& s, void* optional, uint64_t smt_time, uint64_t gen_time) const;
 
@@ -148,8 +224,10 @@ private:
   /** Add ghost variables into symbolic state for a CFG. */
   void add_basic_block_ghosts(SymState& ss, const Cfg& cfg, std::string suffix);
 
-  /** Build the circuit for a single basic block */
+  /** Build the circuit for a single basic block, reusing a cached summary when possible. */
   void build_circuit(const Cfg&, Cfg::id_type, JumpType, SymState&, size_t& line_no, const LineMap& line_map, bool ignore_last_line);
+  /** Build the circuit for a single basic block by running the handler on each instruction. */
+  void execute_block(const Cfg&, Cfg::id_type, JumpType, SymState&, size_t& line_no, const LineMap& line_map, bool ignore_last_line);
 
   // This is to print out Cfg paths easily (for debugging purposes).
   static std::string print(const CfgPath& p) {
@@ -210,39 +288,26 @@ private:
   }
 #endif
 
-  /** Push a new memory manager onto the stack. */
-  void init_mm() {
-    auto manager = new SymMemoryManager();
-    SymBitVector::set_memory_manager(manager);
-    SymBool::set_memory_manager(manager);
-    memory_manager_.push(manager);
-  }
-  /** Pop a memory manager off the stack */
-  void stop_mm() {
-    assert(memory_manager_.size());
-    auto manager = memory_manager_.top();
-    manager->collect();
-    delete manager;
-
-    memory_manager_.pop();
-
-    if (memory_manager_.size()) {
-      auto manager = memory_manager_.top();
-      SymBitVector::set_memory_manager(manager);
-      SymBool::set_memory_manager(manager);
-    } else {
-      SymBitVector::set_memory_manager(NULL);
-      SymBool::set_memory_manager(NULL);
-    }
-
-  }
-  /** Discard and reset all memory managers. */
-  void reset_mm() {
-    while (memory_manager_.size())
-      stop_mm();
-  }
-  /** The memory manager */
-  std::stack<SymMemoryManager*> memory_manager_;
+  /** Install the manager for the nodes built for an obligation.  Calls
+    nest; only the outermost one switches managers. */
+  void init_mm();
+  /** Put back the managers from before init_mm, and free the obligation's
+    nodes.  An incremental solver keeps its translations of them between
+    queries, so then they stay until there are more than max_kept_nodes_;
+    the solver sees the collection and starts over.  The block summaries are
+    trimmed here too. */
+  void stop_mm();
+
+  /** Owns the nodes of the obligations being checked. */
+  std::unique_ptr<SymMemoryManager> memory_manager_;
+  /** The managers installed before init_mm. */
+  SymMemoryManager* previous_bv_manager_;
+  SymMemoryManager* previous_bool_manager_;
+  SymMemoryManager* previous_array_manager_;
+  /** Number of init_mm calls without a stop_mm. */
+  size_t mm_depth_;
+
+  static const size_t max_kept_nodes_ = 1 << 22;
 
   std::string error_;
 
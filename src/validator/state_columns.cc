@@ -0,0 +1,155 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cassert>
+
+#include "src/validator/state_columns.h"
+
+using namespace std;
+using namespace stoke;
+
+namespace {
+
+// https://stackoverflow.com/questions/19738919/gcd-function-for-c
+uint64_t euclid(uint64_t a, uint64_t b)
+{
+  while (b != 0)
+  {
+    a %= b;
+    a ^= b;
+    b ^= a;
+    a ^= b;
+  }
+
+  return a;
+}
+
+} // namespace
+
+StateColumns::StateColumns(const vector<CpuState>& target_states,
+                           const vector<CpuState>& rewrite_states) :
+  target_states_(target_states), rewrite_states_(rewrite_states) {
+  assert(target_states.size() == rewrite_states.size());
+}
+
+const vector<uint64_t>& StateColumns::get(const Variable& v) {
+  auto key = v;
+  key.coefficient = 1;
+  auto it = columns_.find(key);
+  if (it != columns_.end())
+    return it->second;
+
+  vector<uint64_t> column(rows());
+  for (size_t i = 0; i < rows(); ++i)
+    column[i] = key.from_state(target_states_[i], rewrite_states_[i]);
+  return columns_.emplace(key, column).first->second;
+}
+
+bool StateColumns::is_constant(const vector<uint64_t>& a, uint64_t& value) {
+  if (a.empty())
+    return false;
+
+  value = a[0];
+  for (size_t i = 1; i < a.size(); ++i)
+    if (a[i] != value)
+      return false;
+  return true;
+}
+
+bool StateColumns::constant_difference(const vector<uint64_t>& a,
+                                       const vector<uint64_t>& b, uint64_t& diff) {
+  assert(a.size() == b.size());
+  diff = a.empty() ? 0 : a[0] - b[0];
+  for (size_t i = 1; i < a.size(); ++i)
+    if (a[i] - b[i] != diff)
+      return false;
+  return true;
+}
+
+bool StateColumns::constant_ratio(const vector<uint64_t>& a,
+                                  const vector<uint64_t>& b,
+                                  uint64_t& ratio, bool& a_bigger) {
+  assert(a.size() == b.size());
+
+  // the ratio comes from the first row where both are nonzero
+  size_t i = 0;
+  for (; i < a.size(); ++i) {
+    if (a[i] == 0 && b[i] == 0)
+      continue;
+    if (a[i] == 0 || b[i] == 0)
+      return false;
+
+    if ((a[i] / b[i]) * b[i] == a[i]) {
+      ratio = a[i] / b[i];
+      a_bigger = true;
+    } else if ((b[i] / a[i]) * a[i] == b[i]) {
+      ratio = b[i] / a[i];
+      a_bigger = false;
+    } else {
+      return false;
+    }
+    break;
+  }
+  if (i == a.size())
+    return false;
+
+  const auto& big = a_bigger ? a : b;
+  const auto& small = a_bigger ? b : a;
+  for (++i; i < a.size(); ++i)
+    if (ratio*small[i] != big[i])
+      return false;
+  return true;
+}
+
+bool StateColumns::all_nonzero(const vector<uint64_t>& a) {
+  for (auto it : a)
+    if (it == 0)
+      return false;
+  return true;
+}
+
+uint64_t StateColumns::difference_gcd(const vector<uint64_t>& a) {
+  uint64_t gcd = 0;
+  for (size_t i = 1; i < a.size(); ++i) {
+    auto difference = a[i] - a[0];
+    if (difference != 0)
+      gcd = gcd ? euclid(gcd, difference) : difference;
+    if (gcd == 1)
+      break;
+  }
+  return gcd;
+}
+
+void StateColumns::range(const vector<uint64_t>& a,
+                         uint64_t& min, size_t& min_count,
+                         uint64_t& max, size_t& max_count) {
+  min = (uint64_t)(-1);
+  max = 0;
+  min_count = 0;
+  max_count = 0;
+  for (auto value : a) {
+    if (value == max) {
+      max_count++;
+    } else if (value > max) {
+      max = value;
+      max_count = 1;
+    }
+    if (value == min) {
+      min_count++;
+    } else if (value < min) {
+      min = value;
+      min_count = 1;
+    }
+  }
+}
@@ -0,0 +1,87 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef STOKE_SRC_VALIDATOR_STATE_COLUMNS_H
+#define STOKE_SRC_VALIDATOR_STATE_COLUMNS_H
+
+#include <map>
+#include <vector>
+
+#include "src/state/cpu_state.h"
+#include "src/validator/variable.h"
+
+namespace stoke {
+
+/** The values of variables over a set of target/rewrite state pairs, one
+  contiguous array per variable with a row per pair.  A column is read out of
+  the states the first time it's asked for; after that the learner's passes
+  scan it instead of calling Variable::from_state for every cell.  The states
+  must outlive this object. */
+class StateColumns {
+
+public:
+
+  StateColumns(const std::vector<CpuState>& target_states,
+               const std::vector<CpuState>& rewrite_states);
+
+  /** Number of state pairs. */
+  size_t rows() const {
+    return target_states_.size();
+  }
+
+  /** The state pairs themselves. */
+  const CpuState& target(size_t i) const {
+    return target_states_[i];
+  }
+  const CpuState& rewrite(size_t i) const {
+    return rewrite_states_[i];
+  }
+
+  /** The values of a variable; its coefficient is ignored. */
+  const std::vector<uint64_t>& get(const Variable& v);
+
+  /** Is every value the same?  If so, sets value to it. */
+  static bool is_constant(const std::vector<uint64_t>& a, uint64_t& value);
+  /** Is a[k] - b[k] the same for every k?  If so, sets diff to it. */
+  static bool constant_difference(const std::vector<uint64_t>& a,
+                                  const std::vector<uint64_t>& b, uint64_t& diff);
+  /** Is one column a fixed multiple of the other?  Zeros must line up, and
+    some row must have both nonzero.  If a is the multiple of b, sets a_bigger;
+    ratio is the multiplier. */
+  static bool constant_ratio(const std::vector<uint64_t>& a,
+                             const std::vector<uint64_t>& b,
+                             uint64_t& ratio, bool& a_bigger);
+  /** Is every value nonzero? */
+  static bool all_nonzero(const std::vector<uint64_t>& a);
+  /** The gcd of the differences of each value from the first; 0 if they're
+    all the same. */
+  static uint64_t difference_gcd(const std::vector<uint64_t>& a);
+  /** The least and greatest values and how often each comes up. */
+  static void range(const std::vector<uint64_t>& a,
+                    uint64_t& min, size_t& min_count,
+                    uint64_t& max, size_t& max_count);
+
+private:
+
+  const std::vector<CpuState>& target_states_;
+  const std::vector<CpuState>& rewrite_states_;
+
+  /** Columns by variable, with the coefficient set to 1. */
+  std::map<Variable, std::vector<uint64_t>> columns_;
+
+};
+
+} // namespace stoke
+
+#endif
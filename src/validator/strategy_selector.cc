@@ -0,0 +1,165 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <sstream>
+
+#include "src/validator/invariants/conjunction.h"
+#include "src/validator/invariants/memory_equality.h"
+#include "src/validator/strategy_selector.h"
+
+using namespace std;
+using namespace stoke;
+using namespace x64asm;
+
+namespace {
+
+/** Number of bits needed to write n; groups sizes by order of magnitude. */
+size_t log_bucket(size_t n) {
+  size_t bits = 0;
+  while (n) {
+    bits++;
+    n >>= 1;
+  }
+  return bits;
+}
+
+/** Does an invariant (or one of its conjuncts) relate the two memories? */
+bool has_memory_equality(shared_ptr<Invariant> inv) {
+  if (dynamic_pointer_cast<MemoryEqualityInvariant>(inv))
+    return true;
+  auto conj = dynamic_pointer_cast<ConjunctionInvariant>(inv);
+  if (conj) {
+    for (size_t i = 0; i < conj->size(); ++i)
+      if (has_memory_equality((*conj)[i]))
+        return true;
+  }
+  return false;
+}
+
+/** Add the features of the code along a path. */
+void add_path_features(const Cfg& cfg, const CfgPath& p, size_t& length, StrategySelector::Features& features) {
+  auto& code = cfg.get_code();
+  length = 0;
+  for (auto block : p) {
+    if (cfg.num_instrs(block) == 0)
+      continue;
+    size_t start = cfg.get_index(Cfg::loc_type(block, 0));
+    for (size_t i = start; i < start + cfg.num_instrs(block); ++i) {
+      auto& instr = code[i];
+      if (instr.is_label_defn() || instr.is_nop())
+        continue;
+      length++;
+      if (instr.is_memory_dereference())
+        features.dereferences++;
+
+      stringstream ss;
+      ss << instr;
+      string opcode;
+      ss >> opcode;
+      if (opcode.find("mul") != string::npos || opcode.find("div") != string::npos)
+        features.multiply_divide = true;
+    }
+  }
+}
+
+} // namespace
+
+string StrategySelector::Features::get_shape() const {
+  stringstream ss;
+  ss << "t" << log_bucket(target_length) << "r" << log_bucket(rewrite_length)
+     << "d" << log_bucket(dereferences) << "m" << memory_equality << "x" << multiply_divide;
+  return ss.str();
+}
+
+StrategySelector::StrategySelector(const vector<Arm>& arms, const string& path) :
+  arms_(arms), exploration_(0.05), failure_penalty_(60000000) {
+
+  assert(arms_.size() > 0);
+  if (path == "")
+    return;
+
+  ifstream ifs(path);
+  string shape;
+  size_t solver, strategy;
+  double cost;
+  while (ifs >> shape >> solver >> strategy >> cost)
+    observe(shape, Arm((Solver)solver, (ObligationChecker::AliasStrategy)strategy), cost);
+
+  log_.open(path, ofstream::app);
+}
+
+StrategySelector::Features StrategySelector::get_features(const Cfg& target, const Cfg& rewrite,
+    const CfgPath& p, const CfgPath& q,
+    shared_ptr<Invariant> assume, shared_ptr<Invariant> prove) {
+
+  Features features;
+  features.dereferences = 0;
+  features.multiply_divide = false;
+  add_path_features(target, p, features.target_length, features);
+  add_path_features(rewrite, q, features.rewrite_length, features);
+  features.memory_equality = has_memory_equality(assume) || has_memory_equality(prove);
+  return features;
+}
+
+void StrategySelector::observe(const string& shape, const Arm& arm, double cost) {
+  auto& stats = stats_[shape][arm];
+  stats.count++;
+  stats.total += cost;
+}
+
+double StrategySelector::predict(const Features& features, size_t arm) {
+  lock_guard<mutex> lock(mutex_);
+  auto shape = stats_.find(features.get_shape());
+  if (shape == stats_.end())
+    return -1;
+  auto stats = shape->second.find(arms_[arm]);
+  if (stats == shape->second.end())
+    return -1;
+  return stats->second.total / stats->second.count;
+}
+
+vector<size_t> StrategySelector::rank(const Features& features) {
+  vector<pair<double, size_t>> predictions;
+  for (size_t i = 0; i < arms_.size(); ++i)
+    predictions.push_back(pair<double, size_t>(predict(features, i), i));
+  // untried arms predict -1, so they sort first
+  stable_sort(predictions.begin(), predictions.end());
+
+  vector<size_t> order;
+  for (auto it : predictions)
+    order.push_back(it.second);
+
+  lock_guard<mutex> lock(mutex_);
+  uniform_real_distribution<double> coin(0, 1);
+  if (order.size() > 1 && coin(gen_) < exploration_) {
+    uniform_int_distribution<size_t> pick(1, order.size() - 1);
+    swap(order[0], order[pick(gen_)]);
+  }
+  return order;
+}
+
+void StrategySelector::record(const Features& features, size_t arm, const ObligationChecker::Result& result) {
+  double cost = result.gen_time_microseconds + result.smt_time_microseconds;
+  if (result.has_error || !(result.verified || result.has_ceg))
+    cost += failure_penalty_;
+
+  auto shape = features.get_shape();
+  lock_guard<mutex> lock(mutex_);
+  observe(shape, arms_[arm], cost);
+  if (log_.is_open()) {
+    log_ << shape << " " << (size_t)arms_[arm].first << " " << (size_t)arms_[arm].second
+         << " " << cost << endl;
+  }
+}
@@ -0,0 +1,112 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef STOKE_SRC_VALIDATOR_STRATEGY_SELECTOR_H
+#define STOKE_SRC_VALIDATOR_STRATEGY_SELECTOR_H
+
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "src/solver/solver.h"
+#include "src/validator/obligation_checker.h"
+
+namespace stoke {
+
+/** Predicts which (solver, alias strategy) pair discharges an obligation
+  fastest, from a log of how earlier obligations of the same shape went. */
+class StrategySelector {
+
+public:
+
+  typedef std::pair<Solver, ObligationChecker::AliasStrategy> Arm;
+
+  /** Cheap features of an obligation. */
+  struct Features {
+    size_t target_length;
+    size_t rewrite_length;
+    size_t dereferences;
+    bool memory_equality;
+    bool multiply_divide;
+
+    /** Bucketed form of the features; obligations of one shape share statistics. */
+    std::string get_shape() const;
+  };
+
+  /** The log at path (if not empty) is read, and new observations are
+    appended to it. */
+  StrategySelector(const std::vector<Arm>& arms, const std::string& path = "");
+
+  /** Compute the features of an obligation. */
+  static Features get_features(const Cfg& target, const Cfg& rewrite,
+                               const CfgPath& p, const CfgPath& q,
+                               std::shared_ptr<Invariant> assume, std::shared_ptr<Invariant> prove);
+
+  /** Set the probability of trying a random arm first. */
+  StrategySelector& set_exploration(double rate) {
+    exploration_ = rate;
+    return *this;
+  }
+  /** Set the cost in microseconds charged for an arm that didn't answer. */
+  StrategySelector& set_failure_penalty(uint64_t us) {
+    failure_penalty_ = us;
+    return *this;
+  }
+  /** Set the seed used for exploration. */
+  StrategySelector& set_seed(std::default_random_engine::result_type seed) {
+    gen_.seed(seed);
+    return *this;
+  }
+
+  /** Order the arms (by index) from lowest to highest predicted time.  Arms
+    never tried on this shape come first. */
+  std::vector<size_t> rank(const Features& features);
+
+  /** Record how an arm did on an obligation. */
+  void record(const Features& features, size_t arm, const ObligationChecker::Result& result);
+
+  /** Predicted time in microseconds of an arm on a shape, or -1 if never tried. */
+  double predict(const Features& features, size_t arm);
+
+private:
+
+  struct Stats {
+    size_t count;
+    double total;
+    Stats() : count(0), total(0) { }
+  };
+
+  /** Add an observation to the statistics. */
+  void observe(const std::string& shape, const Arm& arm, double cost);
+
+  std::vector<Arm> arms_;
+  std::map<std::string, std::map<Arm, Stats>> stats_;
+
+  std::ofstream log_;
+  double exploration_;
+  uint64_t failure_penalty_;
+  std::default_random_engine gen_;
+
+  /** Results may be recorded from several threads. */
+  std::mutex mutex_;
+
+};
+
+} // namespace stoke
+
+#endif
@@ -0,0 +1,208 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/symstate/array.h"
+#include "src/symstate/bitvector.h"
+#include "src/symstate/bool.h"
+#include "src/symstate/memory_manager.h"
+#include "src/validator/threaded_obligation_checker.h"
+
+using namespace std;
+using namespace stoke;
+
+ThreadedObligationChecker::ThreadedObligationChecker(vector<ObligationChecker*>& child_checkers) :
+  ObligationChecker(), child_checkers_(child_checkers), outstanding_(0), generation_(0), stop_(false) {
+
+  assert(child_checkers_.size() > 0);
+  for (auto it : child_checkers_)
+    threads_.push_back(thread(&ThreadedObligationChecker::work, this, it));
+}
+
+ThreadedObligationChecker::~ThreadedObligationChecker() {
+  {
+    lock_guard<mutex> lock(mutex_);
+    stop_ = true;
+    for (auto it : jobs_)
+      delete it;
+    jobs_.clear();
+  }
+  work_cv_.notify_all();
+  for (auto& it : threads_)
+    it.join();
+}
+
+void ThreadedObligationChecker::work(ObligationChecker* checker) {
+
+  // The nodes of each obligation belong to the manager the SmtObligationChecker
+  // installs around it, which frees them.  This one only gets the few built
+  // outside check(), and frees them when the pool stops.
+  SymMemoryManager manager;
+  SymBitVector::set_memory_manager(&manager);
+  SymBool::set_memory_manager(&manager);
+  SymArray::set_memory_manager(&manager);
+
+  while (true) {
+    Job* job;
+    {
+      unique_lock<mutex> lock(mutex_);
+      work_cv_.wait(lock, [this] { return stop_ || jobs_.size() > 0; });
+      if (stop_)
+        break;
+      job = jobs_.front();
+      jobs_.pop_front();
+    }
+
+    vector<Done> results;
+    Callback collect = [&results, job] (Result& result, void* optional) {
+      Done done;
+      done.result = result;
+      done.callback = job->callback;
+      done.optional = optional;
+      results.push_back(done);
+    };
+
+    if (job->batch) {
+      checker->check_batch(job->target, job->rewrite, job->target_block, job->rewrite_block,
+                           job->p, job->q, job->assume, job->prove, job->testcases,
+                           collect, job->override_separate_stack, job->optionals);
+    } else {
+      checker->check(job->target, job->rewrite, job->target_block, job->rewrite_block,
+                     job->p, job->q, job->assume, (*job->prove)[0], job->testcases,
+                     collect, job->override_separate_stack, job->optionals[0]);
+    }
+    checker->block_until_complete();
+
+    {
+      lock_guard<mutex> lock(mutex_);
+      if (job->generation == generation_) {
+        for (auto& it : results)
+          done_.push_back(it);
+        outstanding_--;
+      }
+    }
+    done_cv_.notify_all();
+    delete job;
+  }
+
+  SymBitVector::set_memory_manager(NULL);
+  SymBool::set_memory_manager(NULL);
+  SymArray::set_memory_manager(NULL);
+  manager.collect();
+}
+
+void ThreadedObligationChecker::enqueue(Job* job) {
+  {
+    lock_guard<mutex> lock(mutex_);
+    job->generation = generation_;
+    jobs_.push_back(job);
+    outstanding_++;
+  }
+  work_cv_.notify_one();
+}
+
+void ThreadedObligationChecker::check(const Cfg& target, const Cfg& rewrite,
+                                      Cfg::id_type target_block, Cfg::id_type rewrite_block,
+                                      const CfgPath& p, const CfgPath& q,
+                                      std::shared_ptr<Invariant> assume, std::shared_ptr<Invariant> prove,
+                                      const std::vector<std::pair<CpuState, CpuState>>& testcases,
+                                      Callback& callback,
+                                      bool override_separate_stack,
+                                      void* optional) {
+
+  auto job = new Job(target, rewrite);
+  job->target_block = target_block;
+  job->rewrite_block = rewrite_block;
+  job->p = p;
+  job->q = q;
+  job->assume = assume->clone();
+  job->prove = make_shared<ConjunctionInvariant>();
+  job->prove->add_invariant(prove->clone());
+  job->testcases = testcases;
+  job->override_separate_stack = override_separate_stack;
+  job->batch = false;
+  job->callback = &callback;
+  job->optionals.push_back(optional);
+  enqueue(job);
+}
+
+void ThreadedObligationChecker::check_batch(const Cfg& target, const Cfg& rewrite,
+    Cfg::id_type target_block, Cfg::id_type rewrite_block,
+    const CfgPath& p, const CfgPath& q,
+    std::shared_ptr<Invariant> assume, std::shared_ptr<ConjunctionInvariant> prove,
+    const std::vector<std::pair<CpuState, CpuState>>& testcases,
+    Callback& callback,
+    bool override_separate_stack,
+    const std::vector<void*>& optionals) {
+
+  assert(prove->size() == optionals.size());
+
+  auto job = new Job(target, rewrite);
+  job->target_block = target_block;
+  job->rewrite_block = rewrite_block;
+  job->p = p;
+  job->q = q;
+  job->assume = assume->clone();
+  job->prove = make_shared<ConjunctionInvariant>();
+  for (size_t i = 0; i < prove->size(); ++i)
+    job->prove->add_invariant((*prove)[i]->clone());
+  job->testcases = testcases;
+  job->override_separate_stack = override_separate_stack;
+  job->batch = true;
+  job->callback = &callback;
+  job->optionals = optionals;
+  enqueue(job);
+}
+
+void ThreadedObligationChecker::deliver(deque<Done>& done) {
+  // A callback may call delete_all(), after which nothing else is delivered.
+  auto generation = generation_;
+  for (auto& it : done) {
+    if (generation != generation_)
+      break;
+    (*it.callback)(it.result, it.optional);
+  }
+}
+
+void ThreadedObligationChecker::check_for_callbacks() {
+  deque<Done> done;
+  {
+    lock_guard<mutex> lock(mutex_);
+    done.swap(done_);
+  }
+  deliver(done);
+}
+
+void ThreadedObligationChecker::block_until_complete() {
+  while (true) {
+    deque<Done> done;
+    {
+      unique_lock<mutex> lock(mutex_);
+      done_cv_.wait(lock, [this] { return outstanding_ == 0 || done_.size() > 0; });
+      if (outstanding_ == 0 && done_.size() == 0)
+        return;
+      done.swap(done_);
+    }
+    deliver(done);
+  }
+}
+
+void ThreadedObligationChecker::delete_all() {
+  lock_guard<mutex> lock(mutex_);
+  for (auto it : jobs_)
+    delete it;
+  jobs_.clear();
+  done_.clear();
+  outstanding_ = 0;
+  generation_++;
+}
@@ -0,0 +1,170 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef STOKE_SRC_VALIDATOR_THREADED_OBLIGATION_CHECKER_H
+#define STOKE_SRC_VALIDATOR_THREADED_OBLIGATION_CHECKER_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "src/validator/obligation_checker.h"
+
+namespace stoke {
+
+/** Discharges obligations on a pool of threads in this process.  Each
+  worker thread owns one of the child checkers, which must not share solvers
+  with each other.  Callbacks are only ever invoked on the caller's thread,
+  from check_for_callbacks() and block_until_complete(). */
+class ThreadedObligationChecker : public ObligationChecker {
+
+public:
+
+  ThreadedObligationChecker(std::vector<ObligationChecker*>& child_checkers);
+  ~ThreadedObligationChecker();
+
+  /** The setters apply to every child; use them before checking anything. */
+  ObligationChecker& set_alias_strategy(AliasStrategy as) override {
+    for (auto it : child_checkers_)
+      it->set_alias_strategy(as);
+    return *this;
+  }
+
+  AliasStrategy get_alias_strategy() override {
+    return child_checkers_[0]->get_alias_strategy();
+  }
+
+  ObligationChecker& set_fixpoint_up(bool b) override {
+    for (auto it : child_checkers_)
+      it->set_fixpoint_up(b);
+    return *this;
+  }
+
+  ObligationChecker& set_separate_stack(bool b) override {
+    for (auto it : child_checkers_)
+      it->set_separate_stack(b);
+    return *this;
+  }
+
+  ObligationChecker& set_nacl(bool b) override {
+    for (auto it : child_checkers_)
+      it->set_nacl(b);
+    return *this;
+  }
+
+  ObligationChecker& set_basic_block_ghosts(bool b) override {
+    for (auto it : child_checkers_)
+      it->set_basic_block_ghosts(b);
+    return *this;
+  }
+
+  /** Queue an obligation for the workers; the callback comes later. */
+  void check(const Cfg& target, const Cfg& rewrite,
+             Cfg::id_type target_block, Cfg::id_type rewrite_block,
+             const CfgPath& p, const CfgPath& q,
+             std::shared_ptr<Invariant> assume, std::shared_ptr<Invariant> prove,
+             const std::vector<std::pair<CpuState, CpuState>>& testcases,
+             Callback& callback,
+             bool override_separate_stack,
+             void* optional) override;
+
+  /** Queue a batch; one worker checks all its conjuncts. */
+  void check_batch(const Cfg& target, const Cfg& rewrite,
+                   Cfg::id_type target_block, Cfg::id_type rewrite_block,
+                   const CfgPath& p, const CfgPath& q,
+                   std::shared_ptr<Invariant> assume, std::shared_ptr<ConjunctionInvariant> prove,
+                   const std::vector<std::pair<CpuState, CpuState>>& testcases,
+                   Callback& callback,
+                   bool override_separate_stack,
+                   const std::vector<void*>& optionals) override;
+
+  /** Invoke the callbacks of finished obligations. */
+  void check_for_callbacks() override;
+
+  /** Blocks until all the checking has done and the callbacks have been called. */
+  void block_until_complete() override;
+
+  /** Forget about everything that has been started.  Obligations already
+    running finish, but their results are dropped. */
+  void delete_all() override;
+
+  /** Get the filter */
+  Filter& get_filter() override {
+    return child_checkers_[0]->get_filter();
+  }
+
+private:
+
+  /** An obligation (or batch of them) waiting for a worker.  Everything is
+    copied, so the caller is free to change its arguments afterwards. */
+  struct Job {
+    Cfg target;
+    Cfg rewrite;
+    Cfg::id_type target_block;
+    Cfg::id_type rewrite_block;
+    CfgPath p;
+    CfgPath q;
+    std::shared_ptr<Invariant> assume;
+    std::shared_ptr<ConjunctionInvariant> prove;
+    std::vector<std::pair<CpuState, CpuState>> testcases;
+    bool override_separate_stack;
+    bool batch;
+
+    Callback* callback;
+    std::vector<void*> optionals;
+    /** Value of generation_ when the job was queued. */
+    uint64_t generation;
+
+    Job(const Cfg& t, const Cfg& r) : target(t), rewrite(r) { }
+  };
+
+  /** A result waiting to be delivered to the caller. */
+  struct Done {
+    Result result;
+    Callback* callback;
+    void* optional;
+  };
+
+  /** Main loop of a worker thread. */
+  void work(ObligationChecker* checker);
+  /** Add a job to the queue. */
+  void enqueue(Job* job);
+  /** Hand finished results to their callbacks. */
+  void deliver(std::deque<Done>& done);
+
+  std::vector<ObligationChecker*> child_checkers_;
+  std::vector<std::thread> threads_;
+
+  /** Protects everything below. */
+  std::mutex mutex_;
+  /** Signalled when there's a job, or when the workers should stop. */
+  std::condition_variable work_cv_;
+  /** Signalled when a job finishes. */
+  std::condition_variable done_cv_;
+
+  std::deque<Job*> jobs_;
+  std::deque<Done> done_;
+  /** Jobs queued or running. */
+  size_t outstanding_;
+  /** Incremented by delete_all(); results of older jobs are dropped. */
+  uint64_t generation_;
+  bool stop_;
+
+};
+
+} // namespace stoke
+
+#endif
@@ -350,4 +350,79 @@ TEST(Z3SolverTest, QuantifiersSat) {
   EXPECT_FALSE(z3.has_error()) << "Z3 encountered: " << z3.get_error();
 }
 
+
+TEST(Z3SolverTest, SessionChecksEachAssumption) {
+  auto x = SymBitVector::var(64, "x");
+  auto y = SymBitVector::var(64, "y");
+
+  vector<SymBool> constraints = {x == y + SymBitVector::constant(64, 1)};
+
+  Z3Solver z3;
+  z3.start_session(constraints);
+
+  EXPECT_FALSE(z3.is_sat_assuming(x == y));
+  EXPECT_FALSE(z3.has_error()) << "Z3 encountered: " << z3.get_error();
+
+  EXPECT_TRUE(z3.is_sat_assuming(x == SymBitVector::constant(64, 5)));
+  EXPECT_FALSE(z3.has_error()) << "Z3 encountered: " << z3.get_error();
+  EXPECT_EQ(4ul, z3.get_model_bv("y", 64).get_fixed_quad(0));
+
+  // earlier assumptions don't carry over
+  EXPECT_TRUE(z3.is_sat_assuming(x == SymBitVector::constant(64, 7)));
+  EXPECT_FALSE(z3.has_error()) << "Z3 encountered: " << z3.get_error();
+
+  z3.end_session();
+}
+
+
+TEST(Z3SolverTest, IncrementalQueriesAreIndependent) {
+  auto x = SymBitVector::var(64, "x");
+  auto y = SymBitVector::var(64, "y");
+
+  auto shared = x == y + SymBitVector::constant(64, 1);
+
+  Z3Solver z3;
+  z3.set_incremental(true);
+
+  vector<SymBool> unsat = {shared, x == y};
+  EXPECT_FALSE(z3.is_sat(unsat));
+  EXPECT_FALSE(z3.has_error()) << "Z3 encountered: " << z3.get_error();
+
+  vector<SymBool> sat = {shared, x == SymBitVector::constant(64, 3)};
+  EXPECT_TRUE(z3.is_sat(sat));
+  EXPECT_FALSE(z3.has_error()) << "Z3 encountered: " << z3.get_error();
+  EXPECT_EQ(2ul, z3.get_model_bv("y", 64).get_fixed_quad(0));
+
+  // the constraint x == y from the first query must not persist
+  vector<SymBool> alone = {x == y};
+  EXPECT_TRUE(z3.is_sat(alone));
+  EXPECT_FALSE(z3.has_error()) << "Z3 encountered: " << z3.get_error();
+}
+
+TEST(Z3SolverTest, IncrementalForgetsCollectedNodes) {
+  SymMemoryManager manager;
+  SymBitVector::set_memory_manager(&manager);
+  SymBool::set_memory_manager(&manager);
+
+  Z3Solver z3;
+  z3.set_incremental(true);
+
+  {
+    vector<SymBool> sat = {SymBitVector::var(64, "x") == SymBitVector::constant(64, 1)};
+    EXPECT_TRUE(z3.is_sat(sat));
+  }
+  manager.collect();
+
+  // built the same way, so x == 2 likely lands where x == 1 was
+  {
+    auto c = SymBitVector::var(64, "x") == SymBitVector::constant(64, 2);
+    vector<SymBool> unsat = {c, !c};
+    EXPECT_FALSE(z3.is_sat(unsat));
+    EXPECT_FALSE(z3.has_error()) << "Z3 encountered: " << z3.get_error();
+  }
+
+  SymBitVector::set_memory_manager(NULL);
+  SymBool::set_memory_manager(NULL);
+}
+
 }
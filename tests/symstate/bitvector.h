@@ -152,4 +152,101 @@ TEST(SymBitVectorTest, UninterpretedFunctionTypesDisagree) {
   EXPECT_EQ(0, tc(f(x,y) == g(x,x,y)));
 }
 
+TEST(SymBitVectorTest, FoldsConstants) {
+
+  auto a = SymBitVector::constant(8, 0xf0);
+  auto b = SymBitVector::constant(8, 0x1f);
+
+  auto check = [](const SymBitVector& bv, uint64_t value) {
+    ASSERT_EQ(SymBitVector::CONSTANT, bv.type());
+    EXPECT_EQ(value, static_cast<const SymBitVectorConstant*>(bv.ptr)->constant_);
+  };
+
+  check(a & b, 0x10);
+  check(a | b, 0xff);
+  check(a ^ b, 0xef);
+  check(a + b, 0x0f);
+  check(b - a, 0x2f);
+  check(!a, 0x0f);
+  check(-b, 0xe1);
+  check(a << SymBitVector::constant(8, 2), 0xc0);
+  check(a >> SymBitVector::constant(8, 9), 0);
+  check(a || b, 0xf01f);
+  check(a[5][2], 0xc);
+  check(b.sign_extend(16), 0x1f);
+  check(a.sign_extend(16), 0xfff0);
+
+  EXPECT_EQ(SymBool::TRUE, (a > b).type());
+  EXPECT_EQ(SymBool::TRUE, a.s_lt(b).type());
+  EXPECT_EQ(SymBool::FALSE, (a == b).type());
+}
+
+TEST(SymBitVectorTest, AppliesIdentities) {
+
+  auto x = SymBitVector::var(32, "x");
+  auto zero = SymBitVector::constant(32, 0);
+  auto ones = SymBitVector::constant(32, -1);
+
+  EXPECT_TRUE((x & ones).equals(x));
+  EXPECT_TRUE((x & zero).equals(zero));
+  EXPECT_TRUE((zero & x).equals(zero));
+  EXPECT_TRUE((x | zero).equals(x));
+  EXPECT_TRUE((x | ones).equals(ones));
+  EXPECT_TRUE((x + zero).equals(x));
+  EXPECT_TRUE((zero + x).equals(x));
+  EXPECT_TRUE((x - zero).equals(x));
+  EXPECT_TRUE((x ^ zero).equals(x));
+  EXPECT_TRUE((x << 0).equals(x));
+  EXPECT_TRUE((!!x).equals(x));
+  EXPECT_TRUE((-(-x)).equals(x));
+  EXPECT_TRUE(x[31][0].equals(x));
+
+  // constants go on the right of commutative operators
+  auto c = SymBitVector::constant(32, 3);
+  EXPECT_TRUE((c + x).equals(x + c));
+  EXPECT_TRUE((c & x).equals(x & c));
+}
+
+TEST(SymBitVectorTest, SimplifiesExtractsAndConcats) {
+
+  auto x = SymBitVector::var(32, "x");
+  auto y = SymBitVector::var(32, "y");
+
+  EXPECT_TRUE((x[31][16] || x[15][0]).equals(x));
+  EXPECT_TRUE((x[23][16] || x[15][8]).equals(x[23][8]));
+  EXPECT_TRUE((x || y)[47][32].equals(x[15][0]));
+  EXPECT_TRUE((x || y)[7][0].equals(y[7][0]));
+  EXPECT_TRUE(x[23][8][7][0].equals(x[15][8]));
+  EXPECT_TRUE(x.zero_extend(64)[31][0].equals(x));
+  // straddles the two halves
+  EXPECT_EQ(SymBitVector::EXTRACT, (x || y)[39][24].type());
+}
+
+TEST(SymBitVectorTest, SimplifiesBools) {
+
+  auto a = SymBool::var("a");
+  auto b = SymBool::var("b");
+  auto t = SymBool::_true();
+  auto f = SymBool::_false();
+
+  EXPECT_TRUE((a & t).equals(a));
+  EXPECT_TRUE((t & a).equals(a));
+  EXPECT_TRUE((a & f).equals(f));
+  EXPECT_TRUE((a | f).equals(a));
+  EXPECT_TRUE((a | t).equals(t));
+  EXPECT_TRUE((a ^ f).equals(a));
+  EXPECT_TRUE((a ^ t).equals(!a));
+  EXPECT_TRUE((!!a).equals(a));
+  EXPECT_TRUE(t.implies(a).equals(a));
+  EXPECT_TRUE(a.implies(t).equals(t));
+  EXPECT_TRUE(t.ite(a, b).equals(a));
+  EXPECT_TRUE((t & f).equals(f));
+  EXPECT_TRUE((f == f).equals(t));
+
+  auto x = SymBitVector::var(8, "x");
+  auto y = SymBitVector::var(8, "y");
+  EXPECT_TRUE(f.ite(x, y).equals(y));
+  EXPECT_TRUE(SymBitVector::from_bool(t).equals(SymBitVector::constant(1, 1)));
+}
+
 } //namespace stoke
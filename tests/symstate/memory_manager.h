@@ -0,0 +1,88 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "src/symstate/bitvector.h"
+#include "src/symstate/memory_manager.h"
+#include "src/symstate/transform_visitor.h"
+
+namespace stoke {
+
+class SymMemoryManagerTest : public ::testing::Test {
+
+protected:
+
+  void SetUp() {
+    SymBitVector::set_memory_manager(&manager_);
+    SymBool::set_memory_manager(&manager_);
+    SymArray::set_memory_manager(&manager_);
+  }
+
+  void TearDown() {
+    SymBitVector::set_memory_manager(NULL);
+    SymBool::set_memory_manager(NULL);
+    SymArray::set_memory_manager(NULL);
+  }
+
+  SymMemoryManager manager_;
+
+};
+
+TEST_F(SymMemoryManagerTest, SharesIdenticalNodes) {
+
+  auto x = SymBitVector::var(64, "x");
+  auto y = SymBitVector::var(64, "y");
+
+  auto a = ((x + y) & SymBitVector::constant(64, 3))[7][0] == SymBitVector::constant(8, 1);
+  auto size = manager_.size();
+  auto b = ((SymBitVector::var(64, "x") + y) & SymBitVector::constant(64, 3))[7][0] ==
+           SymBitVector::constant(8, 1);
+
+  EXPECT_EQ(a.ptr, b.ptr);
+  EXPECT_EQ(size, manager_.size());
+
+  // same shape, different leaves
+  auto c = ((x + y) & SymBitVector::constant(64, 3))[7][0] == SymBitVector::constant(8, 2);
+  EXPECT_NE(a.ptr, c.ptr);
+  EXPECT_FALSE(a.equals(c));
+}
+
+TEST_F(SymMemoryManagerTest, SharesArraysAndTransformedNodes) {
+
+  auto x = SymBitVector::var(64, "x");
+  auto a = SymArray::var(64, 8, "m").update(x, SymBitVector::constant(8, 1))[x];
+  auto b = SymArray::var(64, 8, "m").update(x, SymBitVector::constant(8, 1))[x];
+  EXPECT_EQ(a.ptr, b.ptr);
+
+  SymTransformVisitor tv;
+  EXPECT_EQ(x.ptr, tv.make_bitvector_var(64, "x"));
+}
+
+TEST_F(SymMemoryManagerTest, CollectReleasesEverything) {
+
+  auto x = SymBitVector::var(64, "x");
+  for (size_t i = 0; i < 10000; ++i)
+    x = x + SymBitVector::tmp_var(64);
+  EXPECT_LT(20000ul, manager_.size());
+
+  manager_.collect();
+  EXPECT_EQ(0ul, manager_.size());
+
+  // the manager can be used again afterwards
+  auto y = SymBitVector::var(64, "y");
+  EXPECT_TRUE(y.equals(SymBitVector::var(64, "y")));
+  EXPECT_EQ(1ul, manager_.size());
+}
+
+} //namespace stoke
@@ -56,10 +56,32 @@ using namespace x64asm;
 #include "tests/state/state.h"
 #include "tests/stategen/stategen.h"
 #include "tests/symstate/bitvector.h"
+#include "tests/symstate/memory_manager.h"
 #include "tests/tunit/tunit.h"
 #include "tests/unionfind/unionfind.h"
+#include "tests/validator/alignment_prefilter.h"
+#include "tests/validator/block_summary_cache.h"
+#include "tests/validator/caching_obligation_checker.h"
+#include "tests/validator/compact_trace.h"
+#include "tests/validator/compiled_invariant.h"
+#include "tests/validator/concrete_falsifier.h"
+#include "tests/validator/counterexample_pool.h"
+#include "tests/validator/forking_search.h"
+#include "tests/validator/int_matrix.h"
 #include "tests/validator/invariants.h"
 #include "tests/validator/invariant_serialize.h"
+#include "tests/validator/limited_obligation_checker.h"
+#include "tests/validator/local_queue.h"
+#include "tests/validator/obligation_hash.h"
+#include "tests/validator/obligation_scheduler.h"
+#include "tests/validator/proof_memo.h"
+#include "tests/validator/result_store.h"
+#include "tests/validator/slicing.h"
+#include "tests/validator/smt_obligation_checker.h"
+#include "tests/validator/state_columns.h"
+#include "tests/validator/strategy_selector.h"
+#include "tests/validator/successor_pairs.h"
+#include "tests/validator/threaded_obligation_checker.h"
 #include "tests/validator/variables.h"
 #include "tests/verifier/verifier.h"
 #include "tests/fixture.h"
@@ -0,0 +1,104 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/validator/alignment_prefilter.h"
+#include "src/validator/data_collector.h"
+#include "src/validator/invariants/conjunction.h"
+#include "src/validator/invariants/equality.h"
+#include "src/validator/invariants/memory_equality.h"
+
+namespace stoke {
+
+class AlignmentPrefilterTest : public ::testing::Test {
+
+protected:
+
+  /** A trace through the given blocks, with rax counting up by step. */
+  CompactTrace make_trace(std::vector<Cfg::id_type> blocks, uint64_t step) {
+    CompactTrace trace;
+    CpuState cs;
+    for (size_t i = 0; i < blocks.size(); ++i) {
+      cs.gp[x64asm::rax].get_fixed_quad(0) = i*step;
+      trace.push_back(blocks[i], 0, cs);
+    }
+    trace.finish();
+    return trace;
+  }
+
+  /** target rax * a - rewrite rax * b = c */
+  std::shared_ptr<EqualityInvariant> make_predicate(long a, long b, long c) {
+    Variable t(x64asm::rax, false);
+    Variable r(x64asm::rax, true);
+    t.coefficient = a;
+    r.coefficient = -b;
+    return std::make_shared<EqualityInvariant>(std::vector<Variable>({ t, r }), c);
+  }
+
+};
+
+TEST_F(AlignmentPrefilterTest, MatchesAgreeWithCheck) {
+  std::vector<CompactTrace> target = { make_trace({ 0, 1, 2, 1, 2, 1, 3 }, 3) };
+  std::vector<CompactTrace> rewrite = { make_trace({ 0, 1, 1, 1, 1, 2 }, 7) };
+  AlignmentPrefilter prefilter;
+  prefilter.reset(target, rewrite, 20);
+  auto target_states = DataCollector::expand(target[0]);
+  auto rewrite_states = DataCollector::expand(rewrite[0]);
+
+  for (long a = 1; a <= 8; a *= 2) {
+    for (long c = -3; c <= 3; ++c) {
+      auto inv = make_predicate(a, 1, c);
+      std::vector<uint8_t> matches;
+      ASSERT_TRUE(prefilter.get_matches(*inv, 0, matches));
+      for (size_t i = 0; i < target_states.size(); ++i)
+        for (size_t j = 0; j < rewrite_states.size(); ++j)
+          EXPECT_EQ(inv->check(target_states[i].cs, rewrite_states[j].cs), matches[i*rewrite_states.size() + j] != 0);
+    }
+  }
+}
+
+TEST_F(AlignmentPrefilterTest, KeepsPredicateThatLinesUpLoop) {
+  std::vector<CompactTrace> target = { make_trace({ 0, 1, 1, 1, 1, 1, 1, 1, 1, 2 }, 1) };
+  std::vector<CompactTrace> rewrite = { make_trace({ 0, 1, 1, 1, 1, 1, 1, 1, 1, 2 }, 1) };
+  AlignmentPrefilter prefilter;
+  prefilter.reset(target, rewrite, 20);
+  prefilter.set_bound(2, 2);
+
+  EXPECT_TRUE(prefilter.keep(make_predicate(1, 1, 0)));
+  // only holds at the start, so the loop can't be covered in steps of 2
+  EXPECT_FALSE(prefilter.keep(make_predicate(1, 2, 0)));
+
+  // the heap equality can only make it hold in fewer places
+  auto conj = std::make_shared<ConjunctionInvariant>();
+  conj->add_invariant(make_predicate(1, 2, 0));
+  conj->add_invariant(std::make_shared<MemoryEqualityInvariant>());
+  EXPECT_FALSE(prefilter.keep(conj));
+}
+
+TEST_F(AlignmentPrefilterTest, RejectsPredicateThatHoldsEverywhereOnLoop) {
+  std::vector<CompactTrace> target = { make_trace({ 0, 1, 1, 2 }, 0) };
+  std::vector<CompactTrace> rewrite = { make_trace({ 0, 1, 1, 2 }, 0) };
+  AlignmentPrefilter prefilter;
+  prefilter.reset(target, rewrite, 20);
+  prefilter.set_bound(5, 5);
+
+  EXPECT_FALSE(prefilter.keep(make_predicate(1, 1, 0)));
+
+  // the heap might differ somewhere, so this is for the PAA to find out
+  auto conj = std::make_shared<ConjunctionInvariant>();
+  conj->add_invariant(make_predicate(1, 1, 0));
+  conj->add_invariant(std::make_shared<MemoryEqualityInvariant>());
+  EXPECT_TRUE(prefilter.keep(conj));
+}
+
+} //namespace stoke
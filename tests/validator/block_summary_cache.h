@@ -0,0 +1,221 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/solver/z3solver.h"
+#include "src/symstate/transform_visitor.h"
+#include "src/validator/block_summary_cache.h"
+#include "src/validator/filters/default.h"
+#include "src/validator/handlers/combo_handler.h"
+#include "src/validator/path_unroller.h"
+#include "src/validator/smt_obligation_checker.h"
+
+namespace stoke {
+
+class BlockSummaryCacheTest : public ::testing::Test {
+
+protected:
+
+  /** Renames temporaries in the order they're first seen, so that states
+    built with different temporaries can be compared. */
+  class TmpRenamer : public SymTransformVisitor {
+  public:
+    TmpRenamer() : count_(0) {}
+
+    SymBitVectorAbstract* visit(const SymBitVectorVar * const bv) {
+      if (bv->get_name().find("TMP_BV_") != 0)
+        return (SymBitVectorAbstract*)bv;
+      std::stringstream name;
+      name << "SAME_BV_" << count_++;
+      return (SymBitVectorAbstract*)SymBitVector::var(bv->get_size(), name.str()).ptr;
+    }
+
+    SymBoolAbstract* visit(const SymBoolVar * const b) {
+      if (b->get_name().find("TMP_BOOL_") != 0)
+        return (SymBoolAbstract*)b;
+      std::stringstream name;
+      name << "SAME_BOOL_" << count_++;
+      return (SymBoolAbstract*)SymBool::var(name.str()).ptr;
+    }
+
+  private:
+    size_t count_;
+  };
+
+  /** Run the blocks of a path ending at end_block through build_circuit,
+    from a fresh state. */
+  SymState run(SmtObligationChecker& oc, const Cfg& cfg, const CfgPath& p, Cfg::id_type end_block) {
+    LineMap linemap;
+    x64asm::Code unrolled;
+    PathUnroller::generate_linemap(cfg, p, linemap, false, unrolled);
+
+    SymState state("IN");
+    size_t line_no = 0;
+    for (size_t i = 0; i < p.size(); ++i)
+      oc.build_circuit(cfg, p[i], ObligationChecker::is_jump(cfg, end_block, p, i), state,
+                       line_no, linemap, i == p.size() - 1);
+    return state;
+  }
+
+  static const BlockSummaryCache& get_summaries(const SmtObligationChecker& oc) {
+    return oc.summary_cache_;
+  }
+
+  /** Check that two states agree on every register, flag and signal, and
+    that their constraints are equivalent, up to renaming temporaries. */
+  void expect_same(const SymState& a, const SymState& b) {
+    ASSERT_EQ(a.constraints.size(), b.constraints.size());
+
+    TmpRenamer rename_a;
+    TmpRenamer rename_b;
+    auto bv = [] (TmpRenamer& r, const SymBitVector& x) {
+      return SymBitVector(r(x));
+    };
+    auto bl = [] (TmpRenamer& r, const SymBool& x) {
+      return SymBool(r(x));
+    };
+
+    auto differ = SymBool::_false();
+    for (size_t i = 0; i < a.gp.size(); ++i)
+      differ = differ | (bv(rename_a, a.gp[i]) != bv(rename_b, b.gp[i]));
+    for (size_t i = 0; i < a.sse.size(); ++i)
+      differ = differ | (bv(rename_a, a.sse[i]) != bv(rename_b, b.sse[i]));
+    for (size_t i = 0; i < a.rf.size(); ++i)
+      differ = differ | (bl(rename_a, a.rf[i]) != bl(rename_b, b.rf[i]));
+    differ = differ | (bl(rename_a, a.sigbus) != bl(rename_b, b.sigbus));
+    differ = differ | (bl(rename_a, a.sigfpe) != bl(rename_b, b.sigfpe));
+    differ = differ | (bl(rename_a, a.sigsegv) != bl(rename_b, b.sigsegv));
+    differ = differ | (bv(rename_a, a.rip) != bv(rename_b, b.rip));
+
+    auto constraints_a = SymBool::_true();
+    auto constraints_b = SymBool::_true();
+    for (size_t i = 0; i < a.constraints.size(); ++i) {
+      constraints_a = constraints_a & bl(rename_a, a.constraints[i]);
+      constraints_b = constraints_b & bl(rename_b, b.constraints[i]);
+    }
+    differ = differ | (constraints_a != constraints_b);
+
+    Z3Solver solver;
+    EXPECT_FALSE(solver.is_sat({ differ }));
+    EXPECT_FALSE(solver.has_error()) << solver.get_error();
+  }
+
+};
+
+TEST_F(BlockSummaryCacheTest, RegisterBlockIsSummarizable) {
+  std::stringstream ss;
+  ss << ".foo:" << std::endl;
+  ss << "addq %rax, %rbx" << std::endl;
+  ss << "jmpq .bar" << std::endl;
+  ss << ".bar:" << std::endl;
+  ss << "retq" << std::endl;
+
+  x64asm::Code code;
+  ss >> code;
+  Cfg cfg(code, x64asm::RegSet::universe(), x64asm::RegSet::universe());
+
+  EXPECT_TRUE(BlockSummaryCache::is_summarizable(cfg, cfg.get_entry() + 1));
+  EXPECT_FALSE(BlockSummaryCache::is_summarizable(cfg, cfg.get_entry() + 2));
+}
+
+TEST_F(BlockSummaryCacheTest, MemoryBlockIsNotSummarizable) {
+  std::stringstream ss;
+  ss << ".foo:" << std::endl;
+  ss << "movq (%rcx), %rbx" << std::endl;
+  ss << "jmpq .bar" << std::endl;
+  ss << ".bar:" << std::endl;
+  ss << "retq" << std::endl;
+
+  x64asm::Code code;
+  ss >> code;
+  Cfg cfg(code, x64asm::RegSet::universe(), x64asm::RegSet::universe());
+
+  EXPECT_FALSE(BlockSummaryCache::is_summarizable(cfg, cfg.get_entry() + 1));
+}
+
+TEST_F(BlockSummaryCacheTest, ApplySubstitutesInputs) {
+  BlockSummaryCache cache;
+
+  auto& summary = cache.begin("key");
+  summary.gp[3] = summary.gp[0] + summary.gp[3];
+  cache.end("key", true);
+  ASSERT_NE(nullptr, cache.find("key"));
+
+  SymState state("TEST");
+  auto rax = state.gp[0];
+  auto rbx = state.gp[3];
+  cache.apply("key", state);
+
+  EXPECT_TRUE(state.gp[3].equals(rax + rbx));
+  EXPECT_TRUE(state.gp[0].equals(rax));
+  EXPECT_EQ(0ul, state.constraints.size());
+}
+
+TEST_F(BlockSummaryCacheTest, SummariesMatchExecution) {
+  std::stringstream ss;
+  ss << ".foo:" << std::endl;
+  ss << "movl %ecx, %eax" << std::endl;
+  ss << "movb %dl, %ah" << std::endl;
+  ss << "addw %bx, %ax" << std::endl;
+  ss << "andq %rcx, %rbx" << std::endl;
+  ss << "shlq $0x3, %rdx" << std::endl;
+  ss << "cmpq $0x10, %rax" << std::endl;
+  ss << "jne .bar" << std::endl;
+  ss << "incq %rcx" << std::endl;
+  ss << "setb %sil" << std::endl;
+  ss << ".bar:" << std::endl;
+  ss << "retq" << std::endl;
+
+  x64asm::Code code;
+  ss >> code;
+  Cfg cfg(code, x64asm::RegSet::universe(), x64asm::RegSet::universe());
+  auto first = cfg.get_entry() + 1;
+  auto fall = first + 1;
+  auto bar = first + 2;
+
+  ComboHandler handler;
+  DefaultFilter filter(handler);
+  Z3Solver solver;
+  SmtObligationChecker with(solver, filter);
+  SmtObligationChecker without(solver, filter);
+  without.set_block_summaries(false);
+
+  // the fall-through and the jump, each twice so that a summary is reused
+  std::vector<CfgPath> paths = { { first, fall, bar }, { first, bar }, { first, fall, bar }, { first, bar } };
+  for (auto& p : paths) {
+    auto expected = run(without, cfg, p, bar);
+    auto actual = run(with, cfg, p, bar);
+    expect_same(expected, actual);
+  }
+
+  EXPECT_EQ(3ul, get_summaries(with).get_misses());
+  EXPECT_LT(0ul, get_summaries(with).get_hits());
+}
+
+TEST_F(BlockSummaryCacheTest, TrimDiscardsPastTheMaximum) {
+  BlockSummaryCache cache;
+
+  auto& summary = cache.begin("key");
+  summary.gp[3] = summary.gp[0] + summary.gp[3];
+  cache.end("key", true);
+
+  cache.set_max_nodes(1000000);
+  EXPECT_FALSE(cache.trim());
+  EXPECT_NE(nullptr, cache.find("key"));
+
+  cache.set_max_nodes(1);
+  EXPECT_TRUE(cache.trim());
+  EXPECT_EQ(nullptr, cache.find("key"));
+}
+
+} //namespace stoke
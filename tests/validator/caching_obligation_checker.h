@@ -0,0 +1,121 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <unistd.h>
+
+#include "src/validator/caching_obligation_checker.h"
+#include "src/validator/demo_obligation_checker.h"
+#include "src/validator/invariants/true.h"
+
+namespace stoke {
+
+/** Verifies everything, and counts the obligations it's asked. */
+class VerifyingObligationChecker : public DemoObligationChecker {
+
+public:
+
+  VerifyingObligationChecker() : checks(0) { }
+
+  void check(const Cfg& target, const Cfg& rewrite,
+             Cfg::id_type target_block, Cfg::id_type rewrite_block,
+             const CfgPath& p, const CfgPath& q,
+             std::shared_ptr<Invariant> assume, std::shared_ptr<Invariant> prove,
+             const std::vector<std::pair<CpuState, CpuState>>& testcases,
+             Callback& callback,
+             bool separate_stack,
+             void* optional = NULL) override {
+    checks++;
+    Result r;
+    r.verified = true;
+    r.has_ceg = false;
+    r.has_error = false;
+    r.error_message = "";
+    r.gen_time_microseconds = 1;
+    r.smt_time_microseconds = 2;
+    r.solver = Solver::Z3;
+    r.strategy = AliasStrategy::FLAT;
+    r.source_version = "test";
+    r.info = "";
+    callback(r, optional);
+  }
+
+  size_t checks;
+
+};
+
+class CachingObligationCheckerTest : public ::testing::Test {
+
+protected:
+
+  void SetUp() {
+    path_ = "/tmp/stoke_caching_checker_test_" + std::to_string(getpid());
+    TearDown();
+  }
+
+  void TearDown() {
+    unlink((path_ + ".log").c_str());
+    unlink((path_ + ".idx").c_str());
+  }
+
+  std::string path_;
+};
+
+TEST_F(CachingObligationCheckerTest, SettingsChangeTheKey) {
+  std::stringstream ss;
+  ss << ".foo:" << std::endl;
+  ss << "retq" << std::endl;
+  x64asm::Code code;
+  ss >> code;
+  Cfg cfg(code, x64asm::RegSet::universe(), x64asm::RegSet::universe());
+
+  ResultStore store(path_);
+  ASSERT_FALSE(store.has_error()) << store.get_error();
+  VerifyingObligationChecker child;
+  CachingObligationChecker checker(child, store, Solver::Z3);
+
+  size_t verified = 0;
+  ObligationChecker::Callback callback = [&] (ObligationChecker::Result& result, void* optional) {
+    verified += result.verified;
+  };
+  auto inv = std::make_shared<TrueInvariant>();
+  std::vector<std::pair<CpuState, CpuState>> testcases;
+  auto check = [&] () {
+    checker.check(cfg, cfg, cfg.get_exit(), cfg.get_exit(), { }, { }, inv, inv, testcases,
+                  callback, false, NULL);
+  };
+
+  check();
+  check();
+  EXPECT_EQ(1ul, child.checks);
+  EXPECT_EQ(1ul, checker.get_hits());
+
+  // a result verified without nacl says nothing about one with it
+  checker.set_nacl(true);
+  check();
+  EXPECT_EQ(2ul, child.checks);
+  check();
+  EXPECT_EQ(2ul, child.checks);
+
+  checker.set_basic_block_ghosts(false);
+  check();
+  EXPECT_EQ(3ul, child.checks);
+
+  checker.set_nacl(false);
+  checker.set_basic_block_ghosts(true);
+  check();
+  EXPECT_EQ(3ul, child.checks);
+  EXPECT_EQ(6ul, verified);
+}
+
+} //namespace stoke
@@ -0,0 +1,116 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <sstream>
+
+#include "src/validator/compact_trace.h"
+
+namespace stoke {
+
+class CompactTraceTest : public ::testing::Test {
+
+protected:
+
+  /** A state with a 4k stack, where step i has stored to one byte. */
+  std::vector<CpuState> make_states(size_t count) {
+    std::vector<CpuState> states;
+    CpuState cs;
+    cs.stack.resize(0x700000000, 0x1000);
+    for (size_t i = 0; i < count; ++i) {
+      uint64_t addr = 0x700000000 + (i*200) % 0x1000;
+      cs.stack.set_valid(addr, true);
+      cs.stack[addr] = i;
+      cs.gp[x64asm::rax].get_fixed_quad(0) = i;
+      cs.rf.set(0, i % 2);
+      states.push_back(cs);
+    }
+    return states;
+  }
+
+};
+
+TEST_F(CompactTraceTest, RebuildsEveryState) {
+  auto states = make_states(50);
+  CompactTrace trace;
+  for (size_t i = 0; i < states.size(); ++i)
+    trace.push_back(i % 3, i, states[i]);
+  trace.finish();
+
+  ASSERT_EQ(states.size(), trace.size());
+  CpuState sequential;
+  for (size_t i = 0; i < states.size(); ++i) {
+    EXPECT_EQ(i % 3, trace.get_block(i));
+    EXPECT_EQ(i, trace.get_line_number(i));
+
+    CpuState cs;
+    trace.get_state(i, cs);
+    EXPECT_EQ(states[i], cs);
+
+    trace.next_state(i, sequential);
+    EXPECT_EQ(states[i], sequential);
+  }
+}
+
+TEST_F(CompactTraceTest, SnapshotsWhenLayoutChanges) {
+  auto states = make_states(10);
+  states[5].heap.resize(0x100000000, 0x40);
+  states[5].heap.set_valid(0x100000000, true);
+  states[5].heap[0x100000000] = 0x2a;
+
+  CompactTrace trace;
+  for (size_t i = 0; i < states.size(); ++i)
+    trace.push_back(0, 0, states[i]);
+  trace.finish();
+
+  for (size_t i = 0; i < states.size(); ++i) {
+    CpuState cs;
+    trace.get_state(i, cs);
+    EXPECT_EQ(states[i], cs);
+  }
+}
+
+TEST_F(CompactTraceTest, KeepsOnlyChangedPages) {
+  auto states = make_states(100);
+  CompactTrace trace;
+  for (auto& it : states)
+    trace.push_back(0, 0, it);
+  trace.finish();
+
+  // one snapshot plus a page or so per point, against a full stack per point
+  EXPECT_LT(trace.get_memory_bytes(), 2*0x1000 + 100*2*CompactTrace::page_size);
+}
+
+TEST_F(CompactTraceTest, SerializeRoundTrip) {
+  auto states = make_states(20);
+  states[3].shadow["foo"] = 7;
+  CompactTrace trace;
+  for (size_t i = 0; i < states.size(); ++i)
+    trace.push_back(i, 2*i, states[i]);
+  trace.finish();
+
+  std::stringstream ss;
+  trace.serialize(ss);
+  auto copy = CompactTrace::deserialize(ss);
+
+  ASSERT_EQ(trace.size(), copy.size());
+  for (size_t i = 0; i < states.size(); ++i) {
+    EXPECT_EQ(i, copy.get_block(i));
+    EXPECT_EQ(2*i, copy.get_line_number(i));
+    CpuState cs;
+    copy.get_state(i, cs);
+    EXPECT_EQ(states[i], cs);
+  }
+}
+
+} //namespace stoke
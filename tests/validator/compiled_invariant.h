@@ -0,0 +1,170 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/validator/compiled_invariant.h"
+#include "src/validator/invariants/conjunction.h"
+#include "src/validator/invariants/disjunction.h"
+#include "src/validator/invariants/equality.h"
+#include "src/validator/invariants/false.h"
+#include "src/validator/invariants/flag.h"
+#include "src/validator/invariants/implication.h"
+#include "src/validator/invariants/inequality.h"
+#include "src/validator/invariants/mod_2n.h"
+#include "src/validator/invariants/nonzero.h"
+#include "src/validator/invariants/not.h"
+#include "src/validator/invariants/range.h"
+#include "src/validator/invariants/sign.h"
+#include "src/validator/invariants/top_zero.h"
+#include "src/validator/invariants/true.h"
+
+namespace stoke {
+
+class CompiledInvariantTest : public ::testing::Test {
+
+protected:
+
+  /** Pairs with values around 0, around the sign bits, and above 32 bits. */
+  void SetUp() {
+    std::vector<uint64_t> values = { 0, 1, 2, 8, 0x7f, 0x80, 0xffff, 0x7fffffff,
+                                     0x80000000, 0x100000000, (uint64_t)-1,
+                                     (uint64_t)-8, 0x8000000000000000
+                                   };
+    for (size_t i = 0; i < values.size(); ++i) {
+      CpuState target;
+      CpuState rewrite;
+      target.gp[x64asm::rax].get_fixed_quad(0) = values[i];
+      target.gp[x64asm::rcx].get_fixed_quad(0) = values[(i + 3) % values.size()];
+      rewrite.gp[x64asm::rax].get_fixed_quad(0) = values[(i*5) % values.size()];
+      rewrite.gp[x64asm::rdx].get_fixed_quad(0) = 2*values[i] + 8;
+      target.rf.set(x64asm::eflags_zf.index(), i % 2);
+      target_.push_back(target);
+      rewrite_.push_back(rewrite);
+    }
+  }
+
+  /** Check that the compiled form agrees with Invariant::check on every
+    pair. */
+  void expect_agrees(std::shared_ptr<Invariant> inv) {
+    StateColumns data(target_, rewrite_);
+    CompiledInvariant compiled(inv);
+    std::vector<uint8_t> holds;
+    compiled.evaluate(data, holds);
+
+    ASSERT_EQ(target_.size(), holds.size());
+    bool all = true;
+    for (size_t i = 0; i < holds.size(); ++i) {
+      bool expected = inv->check(target_[i], rewrite_[i]);
+      EXPECT_EQ(expected, (bool)holds[i]) << *inv << " on pair " << i;
+      all &= expected;
+    }
+    EXPECT_EQ(all, compiled.check(data)) << *inv;
+  }
+
+  std::vector<CpuState> target_;
+  std::vector<CpuState> rewrite_;
+
+};
+
+TEST_F(CompiledInvariantTest, AtomsAgreeWithCheck) {
+  Variable rax(x64asm::rax, false);
+  Variable eax(x64asm::eax, false);
+  Variable al(x64asm::al, false);
+  Variable ax(x64asm::ax, false);
+  Variable rcx(x64asm::rcx, false);
+  Variable ecx(x64asm::ecx, false);
+  Variable cl(x64asm::cl, false);
+  Variable cx(x64asm::cx, false);
+  Variable rax_r(x64asm::rax, true);
+  Variable rdx_r(x64asm::rdx, true);
+
+  Variable two_rax = rax;
+  two_rax.coefficient = 2;
+  Variable minus_rdx = rdx_r;
+  minus_rdx.coefficient = -1;
+
+  std::vector<std::shared_ptr<Invariant>> invariants = {
+    std::make_shared<EqualityInvariant>(std::vector<Variable>({ two_rax, minus_rdx }), -8),
+    std::make_shared<EqualityInvariant>(std::vector<Variable>({ rax, rax_r }), 1, 4),
+    std::make_shared<NonzeroInvariant>(rax),
+    std::make_shared<NonzeroInvariant>(eax, true),
+    std::make_shared<Mod2NInvariant>(rax, 3),
+    std::make_shared<RangeInvariant>(rax, 2, 0x80000000),
+    std::make_shared<SignInvariant>(rax, true),
+    std::make_shared<SignInvariant>(rcx, false),
+    std::make_shared<TopZeroInvariant>(x64asm::rax, false),
+    std::make_shared<TopZeroInvariant>(x64asm::rdx, true),
+    std::make_shared<TrueInvariant>(),
+    std::make_shared<FalseInvariant>()
+  };
+
+  // strict or not, signed or not, with and without a constant; check()
+  // doesn't handle signed comparisons of 8 bytes
+  std::vector<std::pair<Variable, Variable>> operands = {
+    { rax, rcx }, { eax, ecx }, { al, cl }, { ax, cx }
+  };
+  for (auto& it : operands) {
+    for (size_t k = 0; k < 8; ++k) {
+      if ((k & 2) && it.first.size == 8)
+        continue;
+      invariants.push_back(std::make_shared<InequalityInvariant>(
+                             it.first, it.second, k & 1, k & 2, k & 4 ? 0x7f : 0));
+    }
+  }
+
+  for (auto inv : invariants)
+    expect_agrees(inv);
+}
+
+TEST_F(CompiledInvariantTest, ConnectivesAgreeWithCheck) {
+  Variable rax(x64asm::rax, false);
+  Variable rcx(x64asm::rcx, false);
+  auto nonzero = std::make_shared<NonzeroInvariant>(rax);
+  auto sign = std::make_shared<SignInvariant>(rcx, true);
+  auto mod = std::make_shared<Mod2NInvariant>(rcx, 1);
+
+  auto conj = std::make_shared<ConjunctionInvariant>();
+  conj->add_invariant(nonzero);
+  conj->add_invariant(sign);
+  conj->add_invariant(mod);
+
+  auto disj = std::make_shared<DisjunctionInvariant>();
+  disj->add_invariant(nonzero);
+  disj->add_invariant(sign);
+
+  expect_agrees(conj);
+  expect_agrees(disj);
+  expect_agrees(std::make_shared<ImplicationInvariant>(nonzero, sign));
+  expect_agrees(std::make_shared<NotInvariant>(conj));
+  expect_agrees(std::make_shared<ConjunctionInvariant>());
+  expect_agrees(std::make_shared<DisjunctionInvariant>());
+
+  auto nested = std::make_shared<DisjunctionInvariant>();
+  nested->add_invariant(conj);
+  nested->add_invariant(std::make_shared<NotInvariant>(disj));
+  expect_agrees(nested);
+}
+
+TEST_F(CompiledInvariantTest, FallsBackPerPair) {
+  auto zf = std::make_shared<FlagInvariant>("e", false, false);
+  auto conj = std::make_shared<ConjunctionInvariant>();
+  conj->add_invariant(zf);
+  conj->add_invariant(std::make_shared<NonzeroInvariant>(Variable(x64asm::rax, false)));
+
+  expect_agrees(zf);
+  expect_agrees(conj);
+  EXPECT_EQ(1ul, CompiledInvariant(conj).fallbacks());
+  EXPECT_EQ(0ul, CompiledInvariant(std::make_shared<TrueInvariant>()).fallbacks());
+}
+
+} // namespace stoke
@@ -0,0 +1,121 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <thread>
+
+#include "src/sandbox/sandbox.h"
+#include "src/stategen/stategen.h"
+#include "src/validator/concrete_falsifier.h"
+#include "src/validator/invariants/state_equality.h"
+
+namespace stoke {
+
+class ConcreteFalsifierTest : public ::testing::Test {
+
+protected:
+
+  void SetUp() {
+    Sandbox sb;
+    StateGen sg(&sb);
+    CpuState cs;
+    sg.get(cs);
+    cs.gp[x64asm::rax].get_fixed_quad(0) = 0;
+    testcases_.push_back(std::make_pair(cs, cs));
+
+    rax_equal_ = std::make_shared<StateEqualityInvariant>(x64asm::RegSet::empty() + x64asm::rax);
+  }
+
+  Cfg make_cfg(const std::string& body) {
+    std::stringstream ss;
+    ss << ".foo:" << std::endl;
+    ss << body;
+    ss << "retq" << std::endl;
+    x64asm::Code code;
+    ss >> code;
+    return Cfg(code, x64asm::RegSet::universe(), x64asm::RegSet::universe());
+  }
+
+  std::vector<std::pair<CpuState, CpuState>> testcases_;
+  std::shared_ptr<Invariant> rax_equal_;
+};
+
+TEST_F(ConcreteFalsifierTest, RefutesWithTestcase) {
+  auto target = make_cfg("incq %rax\n");
+  auto rewrite = make_cfg("addq $0x2, %rax\n");
+  CfgPath path = { target.get_entry() + 1 };
+
+  ConcreteFalsifier falsifier;
+  auto found = falsifier.falsify(target, rewrite, target.get_exit(), rewrite.get_exit(),
+                                 path, path, rax_equal_, { rax_equal_ }, testcases_);
+  ASSERT_EQ(1ul, found.size());
+  EXPECT_EQ(1ul, found[0].target_end.gp[x64asm::rax].get_fixed_quad(0));
+  EXPECT_EQ(2ul, found[0].rewrite_end.gp[x64asm::rax].get_fixed_quad(0));
+}
+
+TEST_F(ConcreteFalsifierTest, KeepsInvariantThatHolds) {
+  auto target = make_cfg("incq %rax\n");
+  CfgPath path = { target.get_entry() + 1 };
+
+  ConcreteFalsifier falsifier;
+  falsifier.set_trials(200);
+  auto found = falsifier.falsify(target, target, target.get_exit(), target.get_exit(),
+                                 path, path, rax_equal_, { rax_equal_ }, testcases_);
+  EXPECT_EQ(0ul, found.size());
+}
+
+TEST_F(ConcreteFalsifierTest, StaysOnThePath) {
+  std::string head = "cmpq $0x0, %rax\nje .L1\n";
+  auto target = make_cfg(head + "incq %rax\n.L1:\n");
+  auto rewrite = make_cfg(head + "addq $0x2, %rax\n.L1:\n");
+  // the fallthrough, which rax = 0 doesn't take
+  CfgPath path = { target.get_loc(1).first, target.get_loc(3).first };
+  auto end = target.get_loc(5).first;
+
+  ConcreteFalsifier falsifier;
+  falsifier.set_trials(1);
+  auto found = falsifier.falsify(target, rewrite, end, end,
+                                 path, path, rax_equal_, { rax_equal_ }, testcases_);
+  EXPECT_EQ(0ul, found.size());
+
+  // mutants of the testcase get there
+  falsifier.set_trials(1000);
+  found = falsifier.falsify(target, rewrite, end, end,
+                            path, path, rax_equal_, { rax_equal_ }, testcases_);
+  ASSERT_EQ(1ul, found.size());
+  EXPECT_NE(0ul, found[0].target_start.gp[x64asm::rax].get_fixed_quad(0));
+}
+
+TEST_F(ConcreteFalsifierTest, FaultsOnSeveralThreads) {
+  // rax is 0, so the testcase divides by zero; so do many of its mutants
+  auto target = make_cfg("divl %eax\n");
+  CfgPath path = { target.get_entry() + 1 };
+
+  std::vector<size_t> found(4, 1);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < found.size(); ++i) {
+    threads.push_back(std::thread([&, i] {
+      ConcreteFalsifier falsifier;
+      for (size_t j = 0; j < 5; ++j)
+        found[i] = falsifier.falsify(target, target, target.get_exit(), target.get_exit(),
+                                     path, path, rax_equal_, { rax_equal_ }, testcases_).size();
+    }));
+  }
+  for (auto& it : threads)
+    it.join();
+
+  for (auto it : found)
+    EXPECT_EQ(0ul, it);
+}
+
+} //namespace stoke
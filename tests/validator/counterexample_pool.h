@@ -0,0 +1,111 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/validator/counterexample_pool.h"
+#include "src/validator/invariants/state_equality.h"
+#include "src/validator/invariants/true.h"
+
+namespace stoke {
+
+class CounterexamplePoolTest : public ::testing::Test {
+
+protected:
+
+  void SetUp() {
+    std::stringstream ss;
+    ss << ".foo:" << std::endl;
+    ss << "incq %rax" << std::endl;
+    ss << "retq" << std::endl;
+    x64asm::Code code;
+    ss >> code;
+    cfg_ = new Cfg(code, x64asm::RegSet::universe(), x64asm::RegSet::universe());
+    paa_ = new ProgramAlignmentAutomata(*cfg_, *cfg_);
+
+    auto block = cfg_->get_entry() + 1;
+    exit_.ts = cfg_->get_exit();
+    exit_.rs = cfg_->get_exit();
+    edge_ = ProgramAlignmentAutomata::Edge(exit_, { block }, { block });
+    paa_->add_edge(edge_);
+
+    auto rax_equal = std::make_shared<StateEqualityInvariant>(x64asm::RegSet::empty() + x64asm::rax);
+    auto pre = std::make_shared<ConjunctionInvariant>();
+    pre->add_invariant(rax_equal);
+    paa_->set_invariant(edge_.from, pre);
+
+    auto post = std::make_shared<ConjunctionInvariant>();
+    post->add_invariant(rax_equal);
+    post->add_invariant(std::make_shared<TrueInvariant>());
+    paa_->set_invariant(exit_, post);
+  }
+
+  void TearDown() {
+    delete paa_;
+    delete cfg_;
+  }
+
+  /** A counterexample starting with the given values of rax. */
+  ObligationChecker::Result make_ceg(uint64_t target_rax, uint64_t rewrite_rax) {
+    ObligationChecker::Result result;
+    result.verified = false;
+    result.has_ceg = true;
+    result.has_error = false;
+    result.target_ceg.gp[x64asm::rax].get_fixed_quad(0) = target_rax;
+    result.rewrite_ceg.gp[x64asm::rax].get_fixed_quad(0) = rewrite_rax;
+    result.target_final_ceg.gp[x64asm::rax].get_fixed_quad(0) = target_rax + 1;
+    result.rewrite_final_ceg.gp[x64asm::rax].get_fixed_quad(0) = rewrite_rax + 2;
+    return result;
+  }
+
+  Cfg* cfg_;
+  ProgramAlignmentAutomata* paa_;
+  ProgramAlignmentAutomata::State exit_;
+  ProgramAlignmentAutomata::Edge edge_;
+};
+
+TEST_F(CounterexamplePoolTest, RefutesConjunct) {
+  CounterexamplePool pool;
+  pool.add(edge_, make_ceg(5, 5));
+
+  auto refuted = pool.refuted(*paa_, exit_, { });
+  EXPECT_EQ(std::set<size_t>({ 0 }), refuted);
+}
+
+TEST_F(CounterexamplePoolTest, IgnoresCounterexampleOutsidePrecondition) {
+  CounterexamplePool pool;
+  pool.add(edge_, make_ceg(5, 6));
+
+  EXPECT_EQ(0ul, pool.refuted(*paa_, exit_, { }).size());
+}
+
+TEST_F(CounterexamplePoolTest, IgnoresEdgesNotInPaa) {
+  CounterexamplePool pool;
+  auto other = edge_;
+  other.te.push_back(cfg_->get_exit());
+  pool.add(other, make_ceg(5, 5));
+
+  EXPECT_EQ(1ul, pool.size(exit_));
+  EXPECT_EQ(0ul, pool.refuted(*paa_, exit_, { }).size());
+}
+
+TEST_F(CounterexamplePoolTest, KeepsNewest) {
+  CounterexamplePool pool;
+  pool.set_capacity(1);
+  pool.add(edge_, make_ceg(5, 5));
+  pool.add(edge_, make_ceg(5, 6));
+
+  EXPECT_EQ(1ul, pool.size(exit_));
+  EXPECT_EQ(0ul, pool.refuted(*paa_, exit_, { }).size());
+}
+
+} //namespace stoke
@@ -0,0 +1,69 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+
+#include "unistd.h"
+
+#include "src/validator/forking_search.h"
+
+namespace stoke {
+
+TEST(ForkingSearchTest, SerialFindsFirst) {
+  ForkingSearch search(1);
+  std::vector<size_t> proved;
+  auto screen = [] (size_t i) {
+    return i % 2 == 1;
+  };
+  auto prove = [&proved] (size_t i) {
+    proved.push_back(i);
+    return i >= 5;
+  };
+
+  EXPECT_EQ(5, search.run(10, screen, prove));
+  EXPECT_EQ(std::vector<size_t>({ 1, 3, 5 }), proved);
+  EXPECT_EQ(3ul, search.get_screened_out());
+}
+
+TEST(ForkingSearchTest, NothingProvable) {
+  ForkingSearch search(4);
+  auto screen = [] (size_t i) {
+    return i != 2;
+  };
+  auto prove = [] (size_t i) {
+    return false;
+  };
+
+  EXPECT_EQ(-1, search.run(6, screen, prove));
+  EXPECT_EQ(1ul, search.get_screened_out());
+}
+
+TEST(ForkingSearchTest, FirstProofCancelsTheRest) {
+  ForkingSearch search(3);
+  auto screen = [] (size_t i) {
+    return true;
+  };
+  auto prove = [] (size_t i) {
+    if (i != 2)
+      sleep(60);
+    return true;
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_EQ(2, search.run(5, screen, prove));
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  EXPECT_LT(std::chrono::duration_cast<std::chrono::seconds>(elapsed).count(), 30);
+}
+
+} //namespace stoke
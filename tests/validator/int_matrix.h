@@ -0,0 +1,148 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <random>
+
+#include "src/validator/int_matrix.h"
+
+namespace stoke {
+
+class IntMatrixTest : public ::testing::Test {
+
+protected:
+
+  /** Is A x = 0, mod 2^64? */
+  bool in_kernel(const IntMatrix& a, const std::vector<int64_t>& x) {
+    for (auto& row : a) {
+      uint64_t sum = 0;
+      for (size_t j = 0; j < x.size(); ++j)
+        sum += (uint64_t)row[j]*(uint64_t)x[j];
+      if (sum)
+        return false;
+    }
+    return true;
+  }
+
+};
+
+TEST_F(IntMatrixTest, NullspaceHasKnownRelations) {
+  std::mt19937_64 gen(0);
+  for (size_t round = 0; round < 50; ++round) {
+    // columns x, y, z, 3x - 2y + 5, 4z, 1; with z a multiple of 2^62 on odd
+    // rounds so that 4z = 0 mod 2^64 too
+    IntMatrix a(10, 6);
+    for (auto& row : a) {
+      row[0] = gen();
+      row[1] = gen();
+      row[2] = round % 2 ? (int64_t)(gen() << 62) : (int64_t)gen();
+      row[3] = 3*(uint64_t)row[0] - 2*(uint64_t)row[1] + 5;
+      row[4] = 4*(uint64_t)row[2];
+      row[5] = 1;
+    }
+
+    auto nullspace = a.nullspace64();
+    for (auto& it : nullspace)
+      EXPECT_TRUE(in_kernel(a, it));
+    EXPECT_EQ(nullspace, nullspace.howell_form());
+
+    // the relations are spanned: adding them leaves the Howell form be
+    std::vector<std::vector<int64_t>> relations = {
+      { 3, -2, 0, -1, 0, 5 },
+      { 0, 0, 4, 0, -1, 0 }
+    };
+    if (round % 2)
+      relations.push_back({ 0, 0, 0, 0, 1, 0 });
+    for (auto& it : relations) {
+      auto more = nullspace;
+      more.push_back(it);
+      EXPECT_EQ(nullspace, more.howell_form());
+    }
+  }
+}
+
+TEST_F(IntMatrixTest, NullspaceModPowerOfTwo) {
+  // 2x = 0 has x = 2^63 as its only nonzero solution
+  IntMatrix a(1, 1);
+  a[0][0] = 2;
+  auto nullspace = a.nullspace64();
+  ASSERT_EQ(1ul, nullspace.size());
+  EXPECT_EQ((int64_t)0x8000000000000000, nullspace[0][0]);
+}
+
+TEST_F(IntMatrixTest, DiophantineSolutions) {
+  std::mt19937_64 gen(0);
+  for (size_t round = 0; round < 50; ++round) {
+    size_t rows = 2 + gen() % 8;
+    size_t cols = 2 + gen() % 8;
+    IntMatrix a(rows, cols);
+    for (auto& row : a)
+      for (auto& it : row)
+        it = (int64_t)(gen() % 11) - 5;
+
+    IntMatrix basis;
+    ASSERT_TRUE(a.solve_diophantine(basis));
+    for (auto& it : basis)
+      EXPECT_TRUE(in_kernel(a, it));
+
+    IntVector x;
+    for (size_t j = 0; j < cols; ++j)
+      x.push_back((int64_t)(gen() % 9) - 4);
+    auto b = a*x;
+    IntVector y;
+    ASSERT_TRUE(a.solve_diophantine(b, y));
+    EXPECT_EQ(b, a*y);
+  }
+}
+
+TEST_F(IntMatrixTest, DiophantineReportsOverflow) {
+  // the kernel of these is spanned by (1, -M, M^2), which doesn't fit
+  // 64 bits once M is 2^40
+  int64_t m = (int64_t)1 << 40;
+  IntMatrix a(2, 3);
+  a[0][0] = m;
+  a[0][1] = 1;
+  a[1][1] = m;
+  a[1][2] = 1;
+  IntMatrix basis;
+  EXPECT_FALSE(a.solve_diophantine(basis));
+  EXPECT_EQ(0ul, basis.size());
+
+  // with a third row of 2^62 the work goes past 128 bits
+  int64_t n = (int64_t)1 << 62;
+  IntMatrix c(3, 4);
+  c[0][0] = n;
+  c[0][1] = 1;
+  c[1][1] = n;
+  c[1][2] = 1;
+  c[2][2] = n;
+  c[2][3] = 1;
+  EXPECT_FALSE(c.solve_diophantine(basis));
+
+  IntVector b(3);
+  b[0] = 1;
+  IntVector x;
+  EXPECT_FALSE(c.solve_diophantine(b, x));
+  EXPECT_EQ(0ul, x.size());
+
+  // small systems still solve
+  IntMatrix s(1, 2);
+  s[0][0] = 3;
+  s[0][1] = 5;
+  IntVector t(1);
+  t[0] = 7;
+  ASSERT_TRUE(s.solve_diophantine(t, x));
+  EXPECT_EQ(t, s*x);
+}
+
+} //namespace stoke
@@ -0,0 +1,118 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include <thread>
+
+#include "src/validator/demo_obligation_checker.h"
+#include "src/validator/invariants/true.h"
+#include "src/validator/limited_obligation_checker.h"
+
+namespace stoke {
+
+/** Answers every obligation, optionally after a delay. */
+class FixedAnswerChecker : public DemoObligationChecker {
+public:
+  FixedAnswerChecker(bool verified, size_t delay_ms) : verified_(verified), delay_ms_(delay_ms) { }
+
+  void check(const Cfg& target, const Cfg& rewrite,
+             Cfg::id_type target_block, Cfg::id_type rewrite_block,
+             const CfgPath& p, const CfgPath& q,
+             std::shared_ptr<Invariant> assume, std::shared_ptr<Invariant> prove,
+             const std::vector<std::pair<CpuState, CpuState>>& testcases,
+             Callback& callback,
+             bool separate_stack,
+             void* optional = NULL) override {
+    std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms_));
+    Result r;
+    r.verified = verified_;
+    r.has_ceg = false;
+    r.has_error = false;
+    r.gen_time_microseconds = 0;
+    r.smt_time_microseconds = 0;
+    r.solver = Solver::NONE;
+    r.strategy = get_alias_strategy();
+    callback(r, optional);
+  }
+
+private:
+  bool verified_;
+  size_t delay_ms_;
+};
+
+class LimitedObligationCheckerTest : public ::testing::Test {
+
+protected:
+
+  void SetUp() {
+    std::stringstream ss;
+    ss << ".foo:" << std::endl;
+    ss << "retq" << std::endl;
+    x64asm::Code code;
+    ss >> code;
+    cfg_ = new Cfg(code, x64asm::RegSet::universe(), x64asm::RegSet::universe());
+  }
+
+  void TearDown() {
+    delete cfg_;
+  }
+
+  ObligationChecker::Result check(LimitedObligationChecker& checker) {
+    ObligationChecker::Result result;
+    size_t calls = 0;
+    ObligationChecker::Callback callback = [&] (ObligationChecker::Result& r, void*) {
+      result = r;
+      calls++;
+    };
+
+    auto inv = std::make_shared<TrueInvariant>();
+    std::vector<std::pair<CpuState, CpuState>> testcases;
+    checker.check(*cfg_, *cfg_, cfg_->get_exit(), cfg_->get_exit(), { }, { }, inv, inv,
+                  testcases, callback, false, NULL);
+    checker.block_until_complete();
+    EXPECT_EQ(1ul, calls);
+    return result;
+  }
+
+  Cfg* cfg_;
+};
+
+TEST_F(LimitedObligationCheckerTest, TimeoutIsAnError) {
+  FixedAnswerChecker slow(true, 5000);
+  LimitedObligationChecker checker({ { &slow, 100, 0 } });
+
+  auto result = check(checker);
+  EXPECT_TRUE(result.has_error);
+  EXPECT_FALSE(result.verified);
+}
+
+TEST_F(LimitedObligationCheckerTest, EscalatesPastTimeout) {
+  FixedAnswerChecker slow(true, 5000);
+  FixedAnswerChecker fast(true, 0);
+  LimitedObligationChecker checker({ { &slow, 100, 0 }, { &fast, 0, 0 } });
+
+  auto result = check(checker);
+  EXPECT_FALSE(result.has_error);
+  EXPECT_TRUE(result.verified);
+}
+
+TEST_F(LimitedObligationCheckerTest, EscalatesPastUndecided) {
+  FixedAnswerChecker undecided(false, 0);
+  FixedAnswerChecker fast(true, 0);
+  LimitedObligationChecker checker({ { &undecided, 0, 0 }, { &fast, 0, 0 } });
+
+  EXPECT_TRUE(check(checker).verified);
+}
+
+} //namespace stoke
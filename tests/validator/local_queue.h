@@ -0,0 +1,154 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdlib>
+#include <dirent.h>
+#include <unistd.h>
+
+#include "src/validator/invariants/true.h"
+#include "src/validator/local_queue.h"
+#include "src/validator/local_queue_obligation_checker.h"
+
+namespace stoke {
+
+class LocalQueueTest : public ::testing::Test {
+
+protected:
+
+  void SetUp() {
+    dir_ = "/tmp/stoke_local_queue_test_" + std::to_string(getpid());
+    TearDown();
+  }
+
+  void TearDown() {
+    std::string command = "rm -rf " + dir_;
+    EXPECT_EQ(0, system(command.c_str()));
+  }
+
+  ObligationChecker::Result make_result(bool verified) {
+    ObligationChecker::Result result;
+    result.verified = verified;
+    result.has_ceg = false;
+    result.has_error = false;
+    result.gen_time_microseconds = 1;
+    result.smt_time_microseconds = 2;
+    result.solver = Solver::Z3;
+    result.strategy = ObligationChecker::AliasStrategy::FLAT;
+    result.source_version = "test";
+    return result;
+  }
+
+  std::string dir_;
+};
+
+TEST_F(LocalQueueTest, ParseSpec) {
+  std::string dir;
+  EXPECT_TRUE(LocalQueue::parse_spec("local:/tmp/q", dir));
+  EXPECT_EQ("/tmp/q", dir);
+  EXPECT_FALSE(LocalQueue::parse_spec("local:", dir));
+  EXPECT_FALSE(LocalQueue::parse_spec("/tmp/q", dir));
+}
+
+TEST_F(LocalQueueTest, EachJobIsClaimedOnce) {
+  LocalQueue queue(dir_);
+  ASSERT_FALSE(queue.has_error()) << queue.get_error();
+
+  ASSERT_TRUE(queue.submit("abc", "problem text", { { "z3", "flat" }, { "cvc4", "arm" } }));
+
+  LocalQueue::Job first, second, third;
+  ASSERT_TRUE(queue.claim(first));
+  ASSERT_TRUE(queue.claim(second));
+  EXPECT_FALSE(queue.claim(third));
+
+  EXPECT_EQ("abc", first.hash);
+  EXPECT_EQ("problem text", first.problem);
+  EXPECT_NE(first.solver, second.solver);
+
+  ASSERT_TRUE(queue.finish(first, make_result(true)));
+  ObligationChecker::Result result;
+  ASSERT_TRUE(queue.get_result("abc", first.solver, first.strategy, result));
+  EXPECT_TRUE(result.verified);
+  EXPECT_FALSE(queue.get_result("abc", second.solver, second.strategy, result));
+
+  // finished and running jobs aren't queued again
+  ASSERT_TRUE(queue.submit("abc", "problem text", { { "z3", "flat" }, { "cvc4", "arm" } }));
+  EXPECT_FALSE(queue.claim(third));
+}
+
+TEST_F(LocalQueueTest, RequeuesClaimsOfReusedPids) {
+  LocalQueue queue(dir_);
+  ASSERT_FALSE(queue.has_error()) << queue.get_error();
+  ASSERT_TRUE(queue.submit("abc", "problem text", { { "z3", "flat" } }));
+
+  LocalQueue::Job job;
+  ASSERT_TRUE(queue.claim(job));
+  EXPECT_EQ(0ul, queue.requeue_abandoned());
+  EXPECT_FALSE(queue.claim(job));
+
+  // the same pid, but a process that started at another time
+  auto name = LocalQueue::job_name(job.hash, job.solver, job.strategy);
+  auto claimed = dir_ + "/claimed/" + name + "." + std::to_string(getpid());
+  std::string from;
+  DIR* dir = opendir((dir_ + "/claimed").c_str());
+  ASSERT_NE(nullptr, dir);
+  struct dirent* entry;
+  while ((entry = readdir(dir)) != NULL) {
+    if (std::string(entry->d_name).find(name + ".") == 0)
+      from = dir_ + "/claimed/" + entry->d_name;
+  }
+  closedir(dir);
+  ASSERT_NE("", from);
+  ASSERT_EQ(0, rename(from.c_str(), (claimed + "-1").c_str()));
+
+  EXPECT_EQ(1ul, queue.requeue_abandoned());
+  EXPECT_TRUE(queue.claim(job));
+}
+
+TEST_F(LocalQueueTest, CheckerGetsWorkerResult) {
+  std::stringstream ss;
+  ss << ".foo:" << std::endl;
+  ss << "retq" << std::endl;
+  x64asm::Code code;
+  ss >> code;
+  Cfg cfg(code, x64asm::RegSet::universe(), x64asm::RegSet::universe());
+
+  LocalQueueObligationChecker checker(dir_);
+  ASSERT_FALSE(checker.has_error()) << checker.get_error();
+
+  size_t calls = 0;
+  bool verified = false;
+  ObligationChecker::Callback callback = [&] (ObligationChecker::Result& r, void*) {
+    calls++;
+    verified = r.verified;
+  };
+
+  auto inv = std::make_shared<TrueInvariant>();
+  std::vector<std::pair<CpuState, CpuState>> testcases;
+  checker.check(cfg, cfg, cfg.get_exit(), cfg.get_exit(), { }, { }, inv, inv,
+                testcases, callback, false, NULL);
+  checker.check_for_callbacks();
+  EXPECT_EQ(0ul, calls);
+
+  // play the part of a worker: one answer is enough
+  LocalQueue worker(dir_);
+  LocalQueue::Job job;
+  ASSERT_TRUE(worker.claim(job));
+  ASSERT_TRUE(worker.finish(job, make_result(true)));
+
+  checker.block_until_complete();
+  EXPECT_EQ(1ul, calls);
+  EXPECT_TRUE(verified);
+}
+
+} //namespace stoke
@@ -0,0 +1,90 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/validator/invariants.h"
+#include "src/validator/obligation_checker.h"
+
+namespace stoke {
+
+class ObligationHashTest : public ::testing::Test {
+
+protected:
+
+  Cfg make_cfg(const std::string& str) {
+    std::stringstream ss(str);
+    x64asm::Code code;
+    ss >> code;
+    return Cfg(code, x64asm::RegSet::universe(), x64asm::RegSet::universe());
+  }
+
+  std::shared_ptr<Invariant> nonzero(const x64asm::R64& r) {
+    return std::make_shared<NonzeroInvariant>(Variable(r, false));
+  }
+
+  std::string hash(const Cfg& target, const CfgPath& p, std::shared_ptr<Invariant> prove) {
+    auto assume = std::make_shared<TrueInvariant>();
+    return ObligationChecker::hash_obligation(target, target, target.get_exit(), target.get_exit(),
+           p, p, assume, prove, false);
+  }
+};
+
+TEST_F(ObligationHashTest, ConjunctOrderDoesNotMatter) {
+  auto cfg = make_cfg(".foo:\naddq %rax, %rbx\nretq\n");
+  CfgPath p = { cfg.get_entry() + 1 };
+
+  auto a = std::make_shared<ConjunctionInvariant>();
+  a->add_invariant(nonzero(x64asm::rax));
+  a->add_invariant(nonzero(x64asm::rbx));
+
+  auto b = std::make_shared<ConjunctionInvariant>();
+  b->add_invariant(nonzero(x64asm::rbx));
+  b->add_invariant(nonzero(x64asm::rax));
+  b->add_invariant(nonzero(x64asm::rbx));
+
+  EXPECT_EQ(hash(cfg, p, a), hash(cfg, p, b));
+}
+
+TEST_F(ObligationHashTest, OnlyCodeOnPathMatters) {
+  auto cfg1 = make_cfg(".foo:\naddq %rax, %rbx\nretq\n");
+  auto cfg2 = make_cfg(".foo:\nje .bar\nsubq %rcx, %rdx\n.bar:\naddq %rax, %rbx\nretq\n");
+
+  // the addq block has a different id and label in each
+  CfgPath p1 = { cfg1.get_entry() + 1 };
+  CfgPath p2 = { cfg2.get_entry() + 3 };
+  EXPECT_EQ(hash(cfg1, p1, nonzero(x64asm::rax)), hash(cfg2, p2, nonzero(x64asm::rax)));
+
+  auto cfg3 = make_cfg(".foo:\nsubq %rax, %rbx\nretq\n");
+  EXPECT_NE(hash(cfg1, p1, nonzero(x64asm::rax)), hash(cfg3, p1, nonzero(x64asm::rax)));
+  EXPECT_NE(hash(cfg1, p1, nonzero(x64asm::rax)), hash(cfg1, p1, nonzero(x64asm::rbx)));
+}
+
+TEST_F(ObligationHashTest, TestcasesDoNotMatter) {
+  ObligationChecker::Obligation a;
+  a.target = make_cfg(".foo:\naddq %rax, %rbx\nretq\n");
+  a.rewrite = a.target;
+  a.target_block = a.target.get_exit();
+  a.rewrite_block = a.rewrite.get_exit();
+  a.P = { a.target.get_entry() + 1 };
+  a.Q = a.P;
+  a.assume = std::make_shared<TrueInvariant>();
+  a.prove = nonzero(x64asm::rax);
+  a.separate_stack = false;
+
+  auto b = a;
+  b.testcases.push_back(std::pair<CpuState, CpuState>(CpuState(), CpuState()));
+
+  EXPECT_EQ(a.hash(), b.hash());
+}
+
+} //namespace stoke
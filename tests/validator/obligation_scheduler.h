@@ -0,0 +1,151 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/validator/demo_obligation_checker.h"
+#include "src/validator/invariants/false.h"
+#include "src/validator/invariants/true.h"
+#include "src/validator/obligation_scheduler.h"
+
+namespace stoke {
+
+/** Proves everything but FalseInvariant, and remembers what it was asked. */
+class RecordingChecker : public DemoObligationChecker {
+public:
+  void check(const Cfg& target, const Cfg& rewrite,
+             Cfg::id_type target_block, Cfg::id_type rewrite_block,
+             const CfgPath& p, const CfgPath& q,
+             std::shared_ptr<Invariant> assume, std::shared_ptr<Invariant> prove,
+             const std::vector<std::pair<CpuState, CpuState>>& testcases,
+             Callback& callback,
+             bool separate_stack,
+             void* optional = NULL) override {
+    paths.push_back(p);
+    Result r;
+    r.verified = !std::dynamic_pointer_cast<FalseInvariant>(prove);
+    r.has_ceg = false;
+    r.has_error = false;
+    callback(r, optional);
+  }
+
+  std::vector<CfgPath> paths;
+};
+
+class ObligationSchedulerTest : public ::testing::Test {
+
+protected:
+
+  void SetUp() {
+    std::stringstream ss;
+    ss << ".foo:" << std::endl;
+    ss << "retq" << std::endl;
+    x64asm::Code code;
+    ss >> code;
+    cfg_ = new Cfg(code, x64asm::RegSet::universe(), x64asm::RegSet::universe());
+
+    state_.ts = cfg_->get_exit();
+    state_.rs = cfg_->get_exit();
+    callback_ = [this] (ObligationChecker::Result& r, void* param) {
+      answered_.push_back((size_t)param);
+    };
+  }
+
+  void TearDown() {
+    delete cfg_;
+  }
+
+  /** Queue one conjunct for an edge whose target path has the given length. */
+  void add(ObligationScheduler& scheduler, size_t length, std::shared_ptr<Invariant> conjunct, size_t param) {
+    CfgPath p(length, cfg_->get_entry() + 1);
+    ProgramAlignmentAutomata::Edge edge(state_, p, { cfg_->get_entry() + 1 });
+    auto prove = std::make_shared<ConjunctionInvariant>();
+    prove->add_invariant(conjunct);
+    std::vector<std::pair<CpuState, CpuState>> testcases;
+    scheduler.add(*cfg_, *cfg_, edge, std::make_shared<TrueInvariant>(), prove, testcases, { (void*)param });
+  }
+
+  Cfg* cfg_;
+  ProgramAlignmentAutomata::State state_;
+  ObligationChecker::Callback callback_;
+  std::vector<size_t> answered_;
+};
+
+TEST_F(ObligationSchedulerTest, ShortPathsFirst) {
+  RecordingChecker checker;
+  ObligationScheduler scheduler(checker);
+  add(scheduler, 5, std::make_shared<TrueInvariant>(), 1);
+  add(scheduler, 1, std::make_shared<TrueInvariant>(), 2);
+
+  scheduler.run(callback_, [] (void*) {
+    return false;
+  }, [] () {
+    return false;
+  });
+  EXPECT_EQ(std::vector<size_t>({ 2, 1 }), answered_);
+}
+
+TEST_F(ObligationSchedulerTest, SkipsMoot) {
+  RecordingChecker checker;
+  ObligationScheduler scheduler(checker);
+  add(scheduler, 1, std::make_shared<FalseInvariant>(), 1);
+  add(scheduler, 2, std::make_shared<TrueInvariant>(), 2);
+
+  // once the first is refuted, the second doesn't matter
+  scheduler.run(callback_, [this] (void* param) {
+    return answered_.size() > 0;
+  }, [] () {
+    return false;
+  });
+  EXPECT_EQ(std::vector<size_t>({ 1 }), answered_);
+  EXPECT_EQ(1ul, scheduler.get_skipped());
+  EXPECT_EQ(1ul, checker.paths.size());
+}
+
+TEST_F(ObligationSchedulerTest, LearnsWhatFails) {
+  RecordingChecker checker;
+  ObligationScheduler scheduler(checker);
+  for (size_t i = 0; i < 4; ++i) {
+    add(scheduler, 1, std::make_shared<FalseInvariant>(), i);
+    add(scheduler, 1, std::make_shared<TrueInvariant>(), i);
+  }
+  scheduler.run(callback_, [] (void*) {
+    return false;
+  }, [] () {
+    return false;
+  });
+
+  EXPECT_GT(scheduler.estimate_refutation(FalseInvariant(), state_),
+            scheduler.estimate_refutation(TrueInvariant(), state_));
+}
+
+TEST_F(ObligationSchedulerTest, MemoAnswersRepeats) {
+  RecordingChecker checker;
+  ProofMemo memo;
+  ObligationScheduler scheduler(checker);
+  scheduler.set_memo(&memo);
+
+  for (size_t round = 0; round < 2; ++round) {
+    add(scheduler, 1, std::make_shared<TrueInvariant>(), round);
+    scheduler.run(callback_, [] (void*) {
+      return false;
+    }, [] () {
+      return false;
+    });
+  }
+
+  EXPECT_EQ(std::vector<size_t>({ 0, 1 }), answered_);
+  EXPECT_EQ(1ul, checker.paths.size());
+  EXPECT_EQ(1ul, memo.get_hits());
+}
+
+} //namespace stoke
@@ -0,0 +1,86 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/validator/invariants/conjunction.h"
+#include "src/validator/invariants/no_signals.h"
+#include "src/validator/invariants/true.h"
+#include "src/validator/proof_memo.h"
+
+namespace stoke {
+
+class ProofMemoTest : public ::testing::Test {
+
+protected:
+
+  ObligationChecker::Result make_result(bool verified) {
+    ObligationChecker::Result result;
+    result.verified = verified;
+    result.has_ceg = !verified;
+    result.has_error = false;
+    return result;
+  }
+
+};
+
+TEST_F(ProofMemoTest, ProofHoldsUnderMoreAssumptions) {
+  ProofMemo memo;
+  memo.record("path", { "a" }, "p", make_result(true));
+
+  ObligationChecker::Result result;
+  EXPECT_TRUE(memo.lookup("path", { "a", "b" }, "p", result));
+  EXPECT_TRUE(result.verified);
+  EXPECT_FALSE(memo.lookup("path", { }, "p", result));
+  EXPECT_FALSE(memo.lookup("path", { "a" }, "q", result));
+  EXPECT_FALSE(memo.lookup("other", { "a" }, "p", result));
+}
+
+TEST_F(ProofMemoTest, CounterexampleHoldsUnderFewerAssumptions) {
+  ProofMemo memo;
+  memo.record("path", { "a", "b" }, "p", make_result(false));
+
+  ObligationChecker::Result result;
+  EXPECT_TRUE(memo.lookup("path", { "b" }, "p", result));
+  EXPECT_TRUE(result.has_ceg);
+  EXPECT_FALSE(memo.lookup("path", { "a", "b", "c" }, "p", result));
+  EXPECT_EQ(1ul, memo.get_hits());
+}
+
+TEST_F(ProofMemoTest, ErrorsAreNotRemembered) {
+  ProofMemo memo;
+  auto result = make_result(false);
+  result.has_error = true;
+  memo.record("path", { "a" }, "p", result);
+  EXPECT_EQ(0ul, memo.size());
+}
+
+TEST_F(ProofMemoTest, ConjunctionsAreFlattened) {
+  auto t = std::make_shared<TrueInvariant>();
+  auto ns = std::make_shared<NoSignalsInvariant>();
+
+  auto inner = std::make_shared<ConjunctionInvariant>();
+  inner->add_invariant(ns);
+  inner->add_invariant(t);
+  auto outer = std::make_shared<ConjunctionInvariant>();
+  outer->add_invariant(t);
+  outer->add_invariant(inner);
+
+  auto flat = std::make_shared<ConjunctionInvariant>();
+  flat->add_invariant(ns);
+  flat->add_invariant(t);
+
+  EXPECT_EQ(2ul, ProofMemo::conjunct_keys(outer).size());
+  EXPECT_EQ(ProofMemo::conjunct_keys(flat), ProofMemo::conjunct_keys(outer));
+}
+
+} //namespace stoke
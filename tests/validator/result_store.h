@@ -0,0 +1,99 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <unistd.h>
+
+#include "src/validator/result_store.h"
+
+namespace stoke {
+
+class ResultStoreTest : public ::testing::Test {
+
+protected:
+
+  void SetUp() {
+    path_ = "/tmp/stoke_result_store_test_" + std::to_string(getpid());
+    TearDown();
+  }
+
+  void TearDown() {
+    unlink((path_ + ".log").c_str());
+    unlink((path_ + ".idx").c_str());
+  }
+
+  ObligationChecker::Result make_result(bool verified) {
+    ObligationChecker::Result result;
+    result.verified = verified;
+    result.has_ceg = false;
+    result.has_error = false;
+    result.error_message = "";
+    result.gen_time_microseconds = 1;
+    result.smt_time_microseconds = 2;
+    result.solver = Solver::Z3;
+    result.strategy = ObligationChecker::AliasStrategy::FLAT;
+    result.source_version = "test";
+    result.info = "";
+    return result;
+  }
+
+  std::string path_;
+};
+
+TEST_F(ResultStoreTest, PutThenGet) {
+  ResultStore store(path_);
+  ASSERT_FALSE(store.has_error()) << store.get_error();
+
+  auto key = ResultStore::make_key("abc", Solver::Z3, ObligationChecker::AliasStrategy::FLAT, "");
+  ObligationChecker::Result result;
+  EXPECT_FALSE(store.get(key, result));
+
+  EXPECT_TRUE(store.put(key, make_result(true)));
+  ASSERT_TRUE(store.get(key, result));
+  EXPECT_TRUE(result.verified);
+  EXPECT_EQ(1ul, store.size());
+
+  auto other = ResultStore::make_key("abc", Solver::CVC4, ObligationChecker::AliasStrategy::FLAT, "");
+  EXPECT_FALSE(store.get(other, result));
+}
+
+TEST_F(ResultStoreTest, ResultsPersistAcrossInstances) {
+  {
+    ResultStore store(path_);
+    for (size_t i = 0; i < 3000; ++i)
+      store.put(std::to_string(i), make_result(i % 2));
+  }
+
+  ResultStore store(path_);
+  ASSERT_FALSE(store.has_error()) << store.get_error();
+  EXPECT_EQ(3000ul, store.size());
+
+  ObligationChecker::Result result;
+  for (size_t i = 0; i < 3000; i += 97) {
+    ASSERT_TRUE(store.get(std::to_string(i), result));
+    EXPECT_EQ((bool)(i % 2), result.verified);
+  }
+}
+
+TEST_F(ResultStoreTest, PutReplacesEarlierResult) {
+  ResultStore store(path_);
+  store.put("key", make_result(false));
+  store.put("key", make_result(true));
+
+  ObligationChecker::Result result;
+  ASSERT_TRUE(store.get("key", result));
+  EXPECT_TRUE(result.verified);
+  EXPECT_EQ(1ul, store.size());
+}
+
+} //namespace stoke
@@ -0,0 +1,59 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/validator/smt_obligation_checker.h"
+
+namespace stoke {
+
+TEST(SlicingTest, KeepsTheConeOfInfluence) {
+  auto w = SymBitVector::var(64, "w");
+  auto x = SymBitVector::var(64, "x");
+  auto y = SymBitVector::var(64, "y");
+  auto z = SymBitVector::var(64, "z");
+  auto q = SymBitVector::var(64, "q");
+
+  auto a = (x + SymBitVector::constant(64, 1)) == y;
+  auto b = z == SymBitVector::constant(64, 3);
+  auto c1 = y == w;
+  auto c2 = q == SymBitVector::constant(64, 0);
+  auto root = !(w == SymBitVector::constant(64, 5));
+
+  std::vector<SymBool> cone;
+  EXPECT_TRUE(SmtObligationChecker::slice({ a, b, c1 & c2, root }, { root }, cone));
+  ASSERT_EQ(3ul, cone.size());
+  EXPECT_TRUE(cone[0].equals(a));
+  EXPECT_TRUE(cone[1].equals(c1));
+  EXPECT_TRUE(cone[2].equals(root));
+
+  // a conjunct that links q to x pulls it in too
+  auto d = q == x;
+  EXPECT_TRUE(SmtObligationChecker::slice({ a, b, c1 & c2, d, root }, { root }, cone));
+  ASSERT_EQ(5ul, cone.size());
+}
+
+TEST(SlicingTest, KeepsClosedConjuncts) {
+  auto x = SymBitVector::var(64, "x");
+  auto z = SymBitVector::var(64, "z");
+  auto root = x == SymBitVector::constant(64, 1);
+
+  std::vector<SymBool> cone;
+  EXPECT_TRUE(SmtObligationChecker::slice({ SymBool::_false(), z == (z ^ SymBitVector::constant(64, 7)), root }, { root }, cone));
+  ASSERT_EQ(2ul, cone.size());
+  EXPECT_TRUE(cone[0].equals(SymBool::_false()));
+
+  EXPECT_FALSE(SmtObligationChecker::slice({ SymBool::_true(), root }, { root }, cone));
+  ASSERT_EQ(1ul, cone.size());
+}
+
+} //namespace stoke
@@ -0,0 +1,47 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/symstate/memory_manager.h"
+
+namespace stoke {
+
+class SmtObligationCheckerTest : public StraightLineValidatorTest { };
+
+TEST_F(SmtObligationCheckerTest, CheckerRestoresMemoryManager) {
+
+  target_ << ".foo:" << std::endl;
+  target_ << "incq %rax" << std::endl;
+  target_ << "retq" << std::endl;
+
+  rewrite_ << ".foo:" << std::endl;
+  rewrite_ << "addq $0x1, %rax" << std::endl;
+  rewrite_ << "retq" << std::endl;
+
+  SymMemoryManager outer;
+  SymBitVector::set_memory_manager(&outer);
+  SymBool::set_memory_manager(&outer);
+  SymArray::set_memory_manager(&outer);
+
+  assert_equiv();
+
+  EXPECT_EQ(&outer, SymBitVector::get_memory_manager());
+  EXPECT_EQ(&outer, SymBool::get_memory_manager());
+  EXPECT_EQ(&outer, SymArray::get_memory_manager());
+
+  SymBitVector::set_memory_manager(NULL);
+  SymBool::set_memory_manager(NULL);
+  SymArray::set_memory_manager(NULL);
+}
+
+} //namespace stoke
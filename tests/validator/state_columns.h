@@ -0,0 +1,78 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/validator/state_columns.h"
+
+namespace stoke {
+
+TEST(StateColumnsTest, ColumnsMatchFromState) {
+  std::vector<CpuState> target(10);
+  std::vector<CpuState> rewrite(10);
+  for (size_t i = 0; i < target.size(); ++i) {
+    target[i].gp[x64asm::rax].get_fixed_quad(0) = 0xfffffff0 + i;
+    rewrite[i].gp[x64asm::rcx].get_fixed_quad(0) = 3*i;
+  }
+  StateColumns data(target, rewrite);
+
+  Variable rax(x64asm::rax, false);
+  Variable eax(x64asm::eax, false);
+  Variable rcx(x64asm::rcx, true);
+  rcx.coefficient = -2;
+  for (auto& v : { rax, eax, rcx }) {
+    auto& column = data.get(v);
+    ASSERT_EQ(target.size(), column.size());
+    for (size_t i = 0; i < target.size(); ++i)
+      EXPECT_EQ(v.from_state(target[i], rewrite[i]), column[i]);
+  }
+}
+
+TEST(StateColumnsTest, Kernels) {
+  uint64_t value;
+  EXPECT_TRUE(StateColumns::is_constant({ 4, 4, 4 }, value));
+  EXPECT_EQ(4ul, value);
+  EXPECT_FALSE(StateColumns::is_constant({ 4, 4, 5 }, value));
+
+  uint64_t diff;
+  EXPECT_TRUE(StateColumns::constant_difference({ 5, 7, 0 }, { 2, 4, (uint64_t)-3 }, diff));
+  EXPECT_EQ(3ul, diff);
+  EXPECT_FALSE(StateColumns::constant_difference({ 5, 7 }, { 2, 5 }, diff));
+
+  uint64_t ratio;
+  bool a_bigger;
+  EXPECT_TRUE(StateColumns::constant_ratio({ 0, 2, 6 }, { 0, 8, 24 }, ratio, a_bigger));
+  EXPECT_EQ(4ul, ratio);
+  EXPECT_FALSE(a_bigger);
+  EXPECT_FALSE(StateColumns::constant_ratio({ 0, 2 }, { 1, 8 }, ratio, a_bigger));
+  EXPECT_FALSE(StateColumns::constant_ratio({ 3, 2 }, { 9, 8 }, ratio, a_bigger));
+  // no row to find the ratio from
+  EXPECT_FALSE(StateColumns::constant_ratio({ 0, 0 }, { 0, 0 }, ratio, a_bigger));
+
+  EXPECT_TRUE(StateColumns::all_nonzero({ 1, (uint64_t)-1 }));
+  EXPECT_FALSE(StateColumns::all_nonzero({ 1, 0 }));
+
+  EXPECT_EQ(6ul, StateColumns::difference_gcd({ 5, 11, 17, 23 }));
+  EXPECT_EQ(0ul, StateColumns::difference_gcd({ 5, 5 }));
+
+  uint64_t min;
+  uint64_t max;
+  size_t min_count;
+  size_t max_count;
+  StateColumns::range({ 3, 9, 3, 0, 9, 0, 0 }, min, min_count, max, max_count);
+  EXPECT_EQ(0ul, min);
+  EXPECT_EQ(3ul, min_count);
+  EXPECT_EQ(9ul, max);
+  EXPECT_EQ(2ul, max_count);
+}
+
+} //namespace stoke
@@ -0,0 +1,105 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdio>
+#include <unistd.h>
+
+#include "src/validator/strategy_selector.h"
+
+namespace stoke {
+
+class StrategySelectorTest : public ::testing::Test {
+
+protected:
+
+  void SetUp() {
+    arms_ = {
+      StrategySelector::Arm(Solver::Z3, ObligationChecker::AliasStrategy::FLAT),
+      StrategySelector::Arm(Solver::CVC4, ObligationChecker::AliasStrategy::ARM)
+    };
+    features_.target_length = 4;
+    features_.rewrite_length = 3;
+    features_.dereferences = 1;
+    features_.memory_equality = true;
+    features_.multiply_divide = false;
+  }
+
+  ObligationChecker::Result make_result(bool verified, uint64_t us) {
+    ObligationChecker::Result result;
+    result.verified = verified;
+    result.has_ceg = false;
+    result.has_error = false;
+    result.gen_time_microseconds = 0;
+    result.smt_time_microseconds = us;
+    return result;
+  }
+
+  std::vector<StrategySelector::Arm> arms_;
+  StrategySelector::Features features_;
+};
+
+TEST_F(StrategySelectorTest, UntriedArmsComeFirst) {
+  StrategySelector selector(arms_);
+  selector.set_exploration(0);
+  selector.record(features_, 0, make_result(true, 100));
+
+  EXPECT_EQ(-1, selector.predict(features_, 1));
+  EXPECT_EQ(1ul, selector.rank(features_)[0]);
+}
+
+TEST_F(StrategySelectorTest, FastestArmComesFirst) {
+  StrategySelector selector(arms_);
+  selector.set_exploration(0);
+  selector.record(features_, 0, make_result(true, 5000));
+  selector.record(features_, 1, make_result(true, 100));
+  selector.record(features_, 1, make_result(true, 300));
+
+  EXPECT_EQ(200, selector.predict(features_, 1));
+  EXPECT_EQ(std::vector<size_t>({ 1, 0 }), selector.rank(features_));
+
+  // other shapes have their own statistics
+  auto other = features_;
+  other.target_length = 100;
+  EXPECT_EQ(-1, selector.predict(other, 0));
+}
+
+TEST_F(StrategySelectorTest, NoAnswerIsPenalized) {
+  StrategySelector selector(arms_);
+  selector.set_exploration(0).set_failure_penalty(1000000);
+  selector.record(features_, 0, make_result(false, 10));
+  selector.record(features_, 1, make_result(true, 5000));
+
+  EXPECT_EQ(1000010, selector.predict(features_, 0));
+  EXPECT_EQ(1ul, selector.rank(features_)[0]);
+}
+
+TEST_F(StrategySelectorTest, LogIsReloaded) {
+  char path[] = "/tmp/stoke_selector_XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_NE(-1, fd);
+  close(fd);
+
+  {
+    StrategySelector selector(arms_, path);
+    selector.record(features_, 1, make_result(true, 700));
+  }
+
+  StrategySelector selector(arms_, path);
+  EXPECT_EQ(-1, selector.predict(features_, 0));
+  EXPECT_EQ(700, selector.predict(features_, 1));
+
+  remove(path);
+}
+
+} //namespace stoke
@@ -0,0 +1,85 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "src/validator/ddec.h"
+
+namespace stoke {
+
+class SuccessorPairsTest : public ::testing::Test {
+
+protected:
+
+  typedef std::pair<size_t, size_t> Pair;
+
+  static bool below(const Pair& a, const Pair& b) {
+    return a != b && a.first <= b.first && a.second <= b.second;
+  }
+
+  /** Every pair after the k-th within the bounds, with nothing in between. */
+  static std::vector<Pair> brute_force(const std::vector<Pair>& pairs, size_t k, size_t tb, size_t rb) {
+    std::vector<Pair> result;
+    auto first = pairs[k];
+    for (auto second : pairs) {
+      if (!below(first, second))
+        continue;
+      if (second.first - first.first > tb || second.second - first.second > rb)
+        continue;
+      bool between = false;
+      for (auto third : pairs)
+        between |= below(first, third) && below(third, second);
+      if (!between)
+        result.push_back(second);
+    }
+    return result;
+  }
+
+};
+
+TEST_F(SuccessorPairsTest, StepsAlongDiagonal) {
+  std::vector<Pair> pairs = { {0, 0}, {1, 1}, {2, 2}, {3, 3} };
+  EXPECT_EQ(std::vector<Pair>({ {1, 1} }), DdecValidator::get_successor_pairs(pairs, 0, 5, 5));
+  EXPECT_EQ(std::vector<Pair>({ }), DdecValidator::get_successor_pairs(pairs, 3, 5, 5));
+}
+
+TEST_F(SuccessorPairsTest, RespectsBounds) {
+  std::vector<Pair> pairs = { {0, 0}, {4, 1}, {4, 4} };
+  EXPECT_EQ(std::vector<Pair>({ {4, 1} }), DdecValidator::get_successor_pairs(pairs, 0, 5, 2));
+  EXPECT_EQ(std::vector<Pair>({ }), DdecValidator::get_successor_pairs(pairs, 0, 3, 2));
+}
+
+TEST_F(SuccessorPairsTest, SameAsBruteForce) {
+  std::default_random_engine gen(4);
+  std::uniform_int_distribution<size_t> coord(0, 15);
+
+  for (size_t round = 0; round < 200; ++round) {
+    std::set<Pair> unique;
+    unique.insert({0, 0});
+    size_t count = coord(gen) * 3;
+    for (size_t i = 0; i < count; ++i)
+      unique.insert({coord(gen), coord(gen)});
+    std::vector<Pair> pairs(unique.begin(), unique.end());
+
+    size_t tb = coord(gen) / 2;
+    size_t rb = coord(gen) / 2;
+    for (size_t k = 0; k < pairs.size(); ++k)
+      EXPECT_EQ(brute_force(pairs, k, tb, rb), DdecValidator::get_successor_pairs(pairs, k, tb, rb));
+  }
+}
+
+} //namespace stoke
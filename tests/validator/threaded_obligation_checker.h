@@ -0,0 +1,127 @@
+// Copyright 2013-2019 Stanford University
+//
+// Licensed under the Apache License, Version 2.0 (the License);
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an AS IS BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <thread>
+
+#include "src/sandbox/sandbox.h"
+#include "src/solver/z3solver.h"
+#include "src/stategen/stategen.h"
+#include "src/validator/demo_obligation_checker.h"
+#include "src/validator/filters/default.h"
+#include "src/validator/handlers/combo_handler.h"
+#include "src/validator/invariants/state_equality.h"
+#include "src/validator/invariants/true.h"
+#include "src/validator/smt_obligation_checker.h"
+#include "src/validator/threaded_obligation_checker.h"
+
+namespace stoke {
+
+class ThreadedObligationCheckerTest : public ::testing::Test { };
+
+TEST_F(ThreadedObligationCheckerTest, CallbacksRunOnCallerThread) {
+  std::stringstream ss;
+  ss << ".foo:" << std::endl;
+  ss << "retq" << std::endl;
+  x64asm::Code code;
+  ss >> code;
+  Cfg cfg(code, x64asm::RegSet::universe(), x64asm::RegSet::universe());
+
+  DemoObligationChecker a, b, c;
+  std::vector<ObligationChecker*> children = { &a, &b, &c };
+  ThreadedObligationChecker checker(children);
+
+  auto caller = std::this_thread::get_id();
+  std::vector<size_t> seen;
+  ObligationChecker::Callback callback = [&] (ObligationChecker::Result& result, void* optional) {
+    EXPECT_EQ(caller, std::this_thread::get_id());
+    seen.push_back((size_t)optional);
+  };
+
+  auto inv = std::make_shared<TrueInvariant>();
+  std::vector<std::pair<CpuState, CpuState>> testcases;
+  for (size_t i = 0; i < 20; ++i)
+    checker.check(cfg, cfg, cfg.get_exit(), cfg.get_exit(), { }, { }, inv, inv, testcases,
+                  callback, false, (void*)i);
+
+  checker.block_until_complete();
+  ASSERT_EQ(20ul, seen.size());
+  std::sort(seen.begin(), seen.end());
+  for (size_t i = 0; i < 20; ++i)
+    EXPECT_EQ(i, seen[i]);
+
+  seen.clear();
+  checker.delete_all();
+  checker.block_until_complete();
+  EXPECT_EQ(0ul, seen.size());
+}
+
+TEST_F(ThreadedObligationCheckerTest, SmtWorkersRunTheSandbox) {
+  auto make_cfg = [] (const std::string& body) {
+    std::stringstream ss;
+    ss << ".foo:" << std::endl;
+    ss << body;
+    ss << "retq" << std::endl;
+    x64asm::Code code;
+    ss >> code;
+    return Cfg(code, x64asm::RegSet::universe(), x64asm::RegSet::universe());
+  };
+  // the division faults on some start states, on every worker at once
+  auto target = make_cfg("divl %ecx\nincq %rsi\n");
+  auto rewrite = make_cfg("divl %ecx\naddq $0x2, %rsi\n");
+  CfgPath path = { target.get_entry() + 1 };
+
+  Sandbox sb;
+  StateGen sg(&sb);
+  CpuState faults;
+  sg.get(faults);
+  faults.gp[x64asm::rcx].get_fixed_quad(0) = 0;
+  CpuState runs = faults;
+  runs.gp[x64asm::rcx].get_fixed_quad(0) = 7;
+  runs.gp[x64asm::rdx].get_fixed_quad(0) = 0;
+  std::vector<std::pair<CpuState, CpuState>> testcases = {
+    { faults, faults }, { runs, runs }
+  };
+
+  auto regs = x64asm::RegSet::empty() + x64asm::rax + x64asm::rcx + x64asm::rdx + x64asm::rsi;
+  auto assume = std::make_shared<StateEqualityInvariant>(regs);
+  auto prove = std::make_shared<StateEqualityInvariant>(x64asm::RegSet::empty() + x64asm::rsi);
+
+  ComboHandler handler_a, handler_b;
+  DefaultFilter filter_a(handler_a), filter_b(handler_b);
+  Z3Solver solver_a, solver_b;
+  SmtObligationChecker a(solver_a, filter_a), b(solver_b, filter_b);
+  std::vector<ObligationChecker*> children = { &a, &b };
+  ThreadedObligationChecker checker(children);
+
+  size_t refuted = 0;
+  size_t calls = 0;
+  ObligationChecker::Callback callback = [&] (ObligationChecker::Result& result, void*) {
+    calls++;
+    EXPECT_FALSE(result.has_error) << result.error_message;
+    EXPECT_FALSE(result.verified);
+    if (result.has_ceg)
+      refuted++;
+  };
+
+  for (size_t i = 0; i < 8; ++i)
+    checker.check(target, rewrite, target.get_exit(), rewrite.get_exit(), path, path,
+                  assume, prove, testcases, callback, false, NULL);
+  checker.block_until_complete();
+
+  EXPECT_EQ(8ul, calls);
+  EXPECT_EQ(8ul, refuted);
+}
+
+} //namespace stoke
@@ -40,6 +40,7 @@
 #include "src/state/cpu_states.h"
 #include "src/stategen/stategen.h"
 #include "src/validator/line_info.h"
+#include "src/validator/local_queue.h"
 #include "src/validator/path_unroller.h"
 
 #define MAX_JOB_COUNT 256
@@ -533,20 +534,22 @@ void report_result(connection& c, ObligationQueueEntry& qe, ObligationChecker::R
 
 }
 
-void discharge_problem(const ObligationQueueEntry& qe, ObligationChecker::Callback& callback, bool debug_problem = false) {
+void discharge_problem(const string& text, const string& hash,
+                       const string& solver_name, const string& strategy,
+                       ObligationChecker::Callback& callback, bool debug_problem = false) {
 
   if (verbose_arg.value()) {
-    cout << "Problem text is: " << endl << qe.text << endl << endl;
+    cout << "Problem text is: " << endl << text << endl << endl;
   }
 
   // Parse the problem
-  stringstream ss(qe.text);
+  stringstream ss(text);
   ObligationChecker::Obligation oblig;
   oblig.read_text(ss);
   if (ss.bad() || ss.fail()) {
     cout << __FILE__ << ":" << __LINE__
          << ": stringstream in bad state when parsing problem with hash "
-         << qe.hash << endl;
+         << hash << endl;
     exit(1);
   }
 
@@ -581,7 +584,7 @@ void discharge_problem(const ObligationQueueEntry& qe, ObligationChecker::Callba
 
   // Setup the solver
   SMTSolver* solver;
-  if (strcmp(qe.solver, "cvc4") == 0)
+  if (solver_name == "cvc4")
     solver = static_cast<SMTSolver*>(new Cvc4Solver());
   else
     solver = static_cast<SMTSolver*>(new Z3Solver());
@@ -593,7 +596,7 @@ void discharge_problem(const ObligationQueueEntry& qe, ObligationChecker::Callba
   if (force_separate_stack.value())
     oc.set_separate_stack(true);
 
-  if (strcmp(qe.strategy, "arm") == 0)
+  if (strategy == "arm")
     oc.set_alias_strategy(ObligationChecker::AliasStrategy::ARM);
   else
     oc.set_alias_strategy(ObligationChecker::AliasStrategy::FLAT);
@@ -603,6 +606,10 @@ void discharge_problem(const ObligationQueueEntry& qe, ObligationChecker::Callba
   oc.block_until_complete();
 }
 
+void discharge_problem(const ObligationQueueEntry& qe, ObligationChecker::Callback& callback, bool debug_problem = false) {
+  discharge_problem(qe.text, qe.hash, qe.solver, qe.strategy, callback, debug_problem);
+}
+
 
 template <typename T>
 pid_t spawn_worker(T* item) {
@@ -884,6 +891,106 @@ void main_loop() {
   }
 }
 
+/** Record that a job from the local queue didn't finish. */
+void report_local_timeout(LocalQueue& queue, const LocalQueue::Job& job, uint64_t time_taken_s, string error = "TIMEOUT") {
+  ObligationChecker::Result result;
+  result.verified = false;
+  result.has_ceg = false;
+  result.has_error = true;
+  result.error_message = error;
+  result.gen_time_microseconds = 0;
+  result.smt_time_microseconds = time_taken_s*1000*1000;
+  result.solver = (job.solver == "cvc4" ? Solver::CVC4 : Solver::Z3);
+  result.strategy = (job.strategy == "arm" ? ObligationChecker::AliasStrategy::ARM :
+                     ObligationChecker::AliasStrategy::FLAT);
+  result.source_version = version_info;
+  if (!queue.finish(job, result))
+    cerr << getpid() << ": " << queue.get_error() << endl;
+}
+
+/** Like spawn_worker, for a job claimed from the local queue. */
+pid_t spawn_local_worker(LocalQueue& queue, const LocalQueue::Job& job) {
+
+  pid_t pid = fork();
+  if (pid)
+    return pid;
+
+  cout << getpid() << ": [worker] got job " << job.hash << " "
+       << job.solver << " " << job.strategy << endl;
+
+  uint64_t start_time = time(0);
+  pid_t child = fork();
+  if (!child) {
+    ObligationChecker::Callback callback = [&] (ObligationChecker::Result& result, void* optional) {
+      cout << getpid() << ": got answer!" << endl;
+      if (!queue.finish(job, result))
+        cerr << getpid() << ": " << queue.get_error() << endl;
+      exit(0);
+    };
+
+    alarm(worker_timeout_arg.value()+1);
+    discharge_problem(job.problem, job.hash, job.solver, job.strategy, callback);
+    exit(0);
+  }
+
+  int status;
+  pid_t result;
+  do {
+    result = waitpid(child, &status, 0);
+  } while (result <= 0 || (!WIFEXITED(status) && !WIFSIGNALED(status)));
+
+  uint64_t diff = time(0) - start_time;
+  if (WIFSIGNALED(status) && diff > worker_timeout_arg.value()) {
+    cout << getpid() << ": Detected timeout!" << endl;
+    report_local_timeout(queue, job, diff);
+  } else if (WIFSIGNALED(status)) {
+    stringstream ss;
+    ss << "SIGNAL-" << WTERMSIG(status);
+    cout << getpid() << ": Detected crash!  " << ss.str() << endl;
+    report_local_timeout(queue, job, diff, ss.str());
+  }
+  exit(0);
+}
+
+/** Drain a local queue with up to --workers processes at a time.  Instead of
+  polling a database, we sleep on inotify until a job is queued. */
+void local_main_loop(const string& dir) {
+
+  LocalQueue queue(dir);
+  if (queue.has_error()) {
+    cerr << queue.get_error() << endl;
+    exit(1);
+  }
+
+  /** Jobs left behind by workers that died go back on the queue */
+  size_t requeued = queue.requeue_abandoned();
+  if (requeued)
+    cout << "[local_main_loop] requeued " << requeued << " abandoned jobs" << endl;
+
+  size_t running_workers = 0;
+  while (true) {
+    int status;
+    while (running_workers > 0 && waitpid(-1, &status, WNOHANG) > 0)
+      running_workers--;
+
+    if (running_workers >= workers_arg.value()) {
+      if (waitpid(-1, &status, 0) > 0)
+        running_workers--;
+      continue;
+    }
+
+    LocalQueue::Job job;
+    if (queue.claim(job)) {
+      spawn_local_worker(queue, job);
+      running_workers++;
+      continue;
+    }
+
+    queue.wait_for_jobs(1000);
+    queue.requeue_abandoned();
+  }
+}
+
 bool debug_hash_obligation(string hash) {
 
   connection c(postgres_arg.value());
@@ -980,7 +1087,15 @@ int main(int argc, char** argv) {
   CommandLineConfig::strict_with_convenience(argc, argv);
   prctl(PR_SET_PDEATHSIG, SIGHUP);
 
-  if (debug_hash_arg.value() == "") {
+  string queue_dir;
+  if (queue_arg.value() != "" && !LocalQueue::parse_spec(queue_arg.value(), queue_dir)) {
+    cerr << "Unrecognized queue \"" << queue_arg.value() << "\"; expected local:<path>" << endl;
+    return 1;
+  }
+
+  if (queue_dir != "") {
+    local_main_loop(queue_dir);
+  } else if (debug_hash_arg.value() == "") {
     main_loop();
   } else {
     bool b = debug_hash_obligation(debug_hash_arg.value());
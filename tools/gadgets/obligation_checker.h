@@ -15,10 +15,12 @@
 #ifndef STOKE_TOOLS_GADGETS_OBLIGATION_CHECKER_H
 #define STOKE_TOOLS_GADGETS_OBLIGATION_CHECKER_H
 
+#include <algorithm>
 #include <functional>
 #include <iostream>
 #include <ostream>
 #include <istream>
+#include <sstream>
 #include <vector>
 #include <string>
 #include <thread>
@@ -27,10 +29,18 @@
 #include "gtest/gtest_prod.h"
 
 #include "src/solver/smtsolver.h"
+#include "src/validator/caching_obligation_checker.h"
 #include "src/validator/demo_obligation_checker.h"
+#include "src/validator/forking_obligation_checker.h"
+#include "src/validator/limited_obligation_checker.h"
+#include "src/validator/local_queue_obligation_checker.h"
 #include "src/validator/obligation_checker.h"
 #include "src/validator/smt_obligation_checker.h"
 #include "src/validator/postgres_obligation_checker.h"
+#include "src/validator/result_store.h"
+#include "src/validator/selecting_obligation_checker.h"
+#include "src/validator/strategy_selector.h"
+#include "src/validator/threaded_obligation_checker.h"
 #include "src/validator/filters/bound_away.h"
 #include "src/validator/handlers/combo_handler.h"
 
@@ -44,14 +54,49 @@ class ObligationCheckerGadget : public ObligationChecker {
 
 public:
 
-  ObligationCheckerGadget() : solver_(NULL), child_(NULL), handler_(NULL), filter_(NULL)
+  ObligationCheckerGadget() : solver_(NULL), child_(NULL), handler_(NULL), filter_(NULL),
+    store_(NULL), inner_(NULL), selector_(NULL)
   {
     auto oc_type = obligation_checker_arg.value();
-    if (oc_type == "smt" || oc_type == "postgres") {
+    auto selecting = selector_log_arg.value() != "";
+    if (oc_type == "smt" && (selecting || parse_alias() == AliasStrategy::ARMS_RACE)) {
+      // Race every solver with both memory models, each in its own process,
+      // or pick one from the timings of past obligations
+      handler_ = new ComboHandler();
+      filter_ = new BoundAwayFilter(*handler_, (uint64_t)0x1000, (uint64_t)(-0x1000));
+      std::vector<SMTSolver*> solvers = { new Z3Solver() };
+#ifndef NOCVC4
+      solvers.push_back(new Cvc4Solver());
+#endif
+      std::vector<StrategySelector::Arm> arms;
+      for (auto solver : solvers) {
+        solver->set_timeout(timeout_arg);
+        solver->set_incremental(solver_incremental_arg.value());
+        worker_solvers_.push_back(solver);
+        for (auto as : { AliasStrategy::FLAT, AliasStrategy::ARM }) {
+          auto checker = new SmtObligationChecker(*solver, *filter_);
+          checker->set_alias_strategy(as);
+          workers_.push_back(checker);
+          arms.push_back(StrategySelector::Arm(solver->get_enum(), as));
+        }
+      }
+      if (selecting) {
+        selector_ = new StrategySelector(arms, selector_log_arg.value());
+        selector_->set_exploration(selector_explore_arg.value());
+        selector_->set_seed(std::random_device()());
+        child_ = new SelectingObligationChecker(workers_, *selector_);
+      } else {
+        auto procs = std::max(process_count_arg.value(), (size_t)1);
+        child_ = new ForkingObligationChecker(workers_, procs*workers_.size());
+      }
+    } else if (oc_type == "smt" || oc_type == "postgres") {
       handler_ = new ComboHandler();
       filter_ = new BoundAwayFilter(*handler_, (uint64_t)0x1000, (uint64_t)(-0x1000));
       solver_ = new SolverGadget();
-      child_ = new SmtObligationChecker(*solver_, *filter_);
+      if (oc_type == "smt")
+        child_ = make_limited(*filter_);
+      if (!child_)
+        child_ = new SmtObligationChecker(*solver_, *filter_);
       set_separate_stack(!stack_out_arg.value());
     }
     if (oc_type == "postgres") {
@@ -70,9 +115,56 @@ public:
       SmtObligationChecker smt_checker = *static_cast<SmtObligationChecker*>(child_);
       child_ = new PostgresObligationChecker(postgres_arg.value(), smt_checker);
     }
+    if (oc_type == "threaded") {
+      if (parse_alias() == AliasStrategy::ARMS_RACE) {
+        std::cerr << "The arms_race alias strategy needs --obligation_checker smt" << std::endl;
+        exit(1);
+      }
+      // The limits fork a child per obligation, which isn't safe with threads
+      if (escalation_arg.value() != "" || obligation_timeout_arg.value() ||
+          obligation_memory_arg.value()) {
+        std::cerr << "--escalation, --obligation_timeout and --obligation_memory need "
+                  << "--obligation_checker smt" << std::endl;
+        exit(1);
+      }
+      // Every worker gets its own solver, handler and filter
+      solver_ = new SolverGadget();
+      for (size_t i = 0; i < std::max(threads_arg.value(), (size_t)1); ++i) {
+        auto handler = new ComboHandler();
+        auto filter = new BoundAwayFilter(*handler, (uint64_t)0x1000, (uint64_t)(-0x1000));
+        auto solver = solver_->clone();
+        worker_handlers_.push_back(handler);
+        worker_filters_.push_back(filter);
+        worker_solvers_.push_back(solver);
+        workers_.push_back(new SmtObligationChecker(*solver, *filter));
+      }
+      child_ = new ThreadedObligationChecker(workers_);
+    }
+    if (oc_type == "local") {
+      std::string dir;
+      if (!LocalQueue::parse_spec(queue_arg.value(), dir)) {
+        std::cerr << "--obligation_checker local needs --queue local:<path>" << std::endl;
+        exit(1);
+      }
+      auto local = new LocalQueueObligationChecker(dir);
+      if (local->has_error()) {
+        std::cerr << local->get_error() << std::endl;
+        exit(1);
+      }
+      child_ = local;
+    }
     if (oc_type == "demo") {
       child_ = new DemoObligationChecker();
     }
+    if (result_store_arg.value() != "") {
+      store_ = new ResultStore(result_store_arg.value());
+      if (store_->has_error()) {
+        std::cerr << store_->get_error() << std::endl;
+        exit(1);
+      }
+      inner_ = child_;
+      child_ = new CachingObligationChecker(*inner_, *store_, solver_arg.value());
+    }
 
     set_alias_strategy(parse_alias());
     set_fixpoint_up(false);
@@ -89,6 +181,22 @@ public:
   ~ObligationCheckerGadget() {
     if (child_)
       delete child_;
+    if (inner_)
+      delete inner_;
+    if (store_)
+      delete store_;
+    if (selector_)
+      delete selector_;
+    for (auto it : workers_)
+      delete it;
+    for (auto it : rungs_)
+      delete it;
+    for (auto it : worker_solvers_)
+      delete it;
+    for (auto it : worker_filters_)
+      delete it;
+    for (auto it : worker_handlers_)
+      delete it;
     if (handler_)
       delete handler_;
     if (filter_)
@@ -143,6 +251,17 @@ public:
     child_->check(target, rewrite, target_block, rewrite_block, p, q, assume, prove, testcases, callback, override_separate_stack, optional);
   }
 
+  virtual void check_batch(const Cfg& target, const Cfg& rewrite,
+                           Cfg::id_type target_block, Cfg::id_type rewrite_block,
+                           const CfgPath& p, const CfgPath& q,
+                           std::shared_ptr<Invariant> assume, std::shared_ptr<ConjunctionInvariant> prove,
+                           const std::vector<std::pair<CpuState, CpuState>>& testcases,
+                           Callback& callback,
+                           bool override_separate_stack,
+                           const std::vector<void*>& optionals) override {
+    child_->check_batch(target, rewrite, target_block, rewrite_block, p, q, assume, prove, testcases, callback, override_separate_stack, optionals);
+  }
+
   /** Blocks until all the checking has done and the callbacks have been called. */
   virtual void block_until_complete() override {
     child_->block_until_complete();
@@ -164,8 +283,71 @@ public:
 
 private:
 
+  /** Build a checker that runs each obligation under --obligation_timeout and
+    --obligation_memory, escalating through the --escalation ladder if there
+    is one.  Returns NULL when no limit is set. */
+  ObligationChecker* make_limited(Filter& filter) {
+    auto ladder = escalation_arg.value();
+    auto timeout = obligation_timeout_arg.value();
+    auto memory = obligation_memory_arg.value();
+    if (ladder == "" && timeout == 0 && memory == 0)
+      return NULL;
+
+    std::vector<LimitedObligationChecker::Rung> rungs;
+    if (ladder == "") {
+      auto solver = new SolverGadget();
+      worker_solvers_.push_back(solver);
+      auto checker = new SmtObligationChecker(*solver, filter);
+      checker->set_alias_strategy(parse_alias());
+      rungs_.push_back(checker);
+      rungs.push_back({checker, timeout, memory});
+      return new LimitedObligationChecker(rungs);
+    }
+
+    // each rung is <strategy>/<solver>/<timeout ms>
+    std::stringstream ss(ladder);
+    std::string rung;
+    while (getline(ss, rung, ',')) {
+      std::stringstream rs(rung);
+      std::string alias, solver_name;
+      uint64_t rung_timeout = 0;
+      getline(rs, alias, '/');
+      getline(rs, solver_name, '/');
+      rs >> rung_timeout;
+      if (rs.fail()) {
+        std::cerr << "Could not parse escalation rung \"" << rung << "\"" << std::endl;
+        exit(1);
+      }
+
+      SMTSolver* solver = NULL;
+      if (solver_name == "z3") {
+        solver = new Z3Solver();
+#ifndef NOCVC4
+      } else if (solver_name == "cvc4") {
+        solver = new Cvc4Solver();
+#endif
+      } else {
+        std::cerr << "Unrecognized solver \"" << solver_name << "\" in escalation ladder" << std::endl;
+        exit(1);
+      }
+      // the solver gives up on its own first, if it can
+      solver->set_timeout(rung_timeout ? rung_timeout : timeout_arg.value());
+      solver->set_incremental(solver_incremental_arg.value());
+      worker_solvers_.push_back(solver);
+
+      auto checker = new SmtObligationChecker(*solver, filter);
+      checker->set_alias_strategy(parse_alias(alias));
+      rungs_.push_back(checker);
+      rungs.push_back({checker, rung_timeout, memory});
+    }
+    return new LimitedObligationChecker(rungs);
+  }
+
   ObligationChecker::AliasStrategy parse_alias() {
-    std::string alias = alias_strategy_arg.value();
+    return parse_alias(alias_strategy_arg.value());
+  }
+
+  ObligationChecker::AliasStrategy parse_alias(const std::string& alias) {
 
     if (alias == "flat" || alias == "array") {
       return ObligationChecker::AliasStrategy::FLAT;
@@ -185,6 +367,19 @@ private:
   ObligationChecker* child_;
   Handler* handler_;
   Filter* filter_;
+  ResultStore* store_;
+  /** The checker wrapped by the result store, if any. */
+  ObligationChecker* inner_;
+  /** Picks among the workers when --selector_log is given. */
+  StrategySelector* selector_;
+
+  /** Per-thread state of the threaded checker, or the racers of the arms race. */
+  std::vector<ObligationChecker*> workers_;
+  std::vector<SMTSolver*> worker_solvers_;
+  std::vector<Filter*> worker_filters_;
+  std::vector<Handler*> worker_handlers_;
+  /** Checkers on the rungs of escalation ladders. */
+  std::vector<ObligationChecker*> rungs_;
 
 };
 
@@ -52,6 +52,7 @@ public:
     }
 
     set_timeout(timeout_arg);
+    set_incremental(solver_incremental_arg.value());
   }
 
   SMTSolver* clone() const {
@@ -62,9 +63,25 @@ public:
     solver_->set_timeout(ms);
     return *this;
   }
+  SMTSolver& set_incremental(bool b) {
+    solver_->set_incremental(b);
+    return *this;
+  }
+  bool get_incremental() const {
+    return solver_->get_incremental();
+  }
   bool is_sat(const std::vector<SymBool>& constraints) {
     return solver_->is_sat(constraints);
   }
+  void start_session(const std::vector<SymBool>& constraints) {
+    solver_->start_session(constraints);
+  }
+  bool is_sat_assuming(const SymBool& assumption) {
+    return solver_->is_sat_assuming(assumption);
+  }
+  void end_session() {
+    solver_->end_session();
+  }
   bool has_model() const {
     return solver_->has_model();
   }
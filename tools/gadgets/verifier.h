@@ -173,10 +173,20 @@ private:
       add_assumptions(*bv);
       return bv;
     } else if (s == "ddec") {
+      // A forked child has none of the threaded checker's workers, so it
+      // would wait on its obligations forever
+      if (parallel_predicates_arg.value() > 1 && obligation_checker_arg.value() == "threaded") {
+        std::cerr << "--parallel_predicates needs an obligation checker other than threaded" << std::endl;
+        exit(1);
+      }
       oc_ = new ObligationCheckerGadget();
       auto ddec = new DdecValidator(*oc_, sandbox, inv);
       ddec->set_bound(target_bound_arg.value(), rewrite_bound_arg.value());
       ddec->set_training_set_size(training_set_size_arg.value());
+      ddec->set_obligation_window(obligation_window_arg.value());
+      ddec->set_parallel_predicates(parallel_predicates_arg.value());
+      ddec->set_alignment_prefilter(!no_alignment_prefilter_arg.value());
+      ddec->set_trace_cache_dir(trace_cache_dir_arg.value());
       auto align_pred = alignment_predicate_arg.value();
       if (align_pred.size()) {
         auto expr = ExprInvariant::parse(align_pred);